@@ -12,6 +12,7 @@
 #  include <config.h>
 #  include "base.h"
 #  include <limits.h>
+#  include <stddef.h>
 #  include <sys/stat.h>
 #  include <cups/dnssd.h>
 #  include <cups/oauth.h>
@@ -21,12 +22,14 @@
 #    include "win32-gettimeofday.h"
 #    include "win32-socket.h"
 #    define getuid()	0
+#    define fsync	_commit
 #  else // !_WIN32
 #    include <time.h>
 #    include <sys/time.h>
 #    include <grp.h>
 #    include <poll.h>
 #    include <sys/fcntl.h>
+#    include <sys/mman.h>
 #    include <sys/wait.h>
 extern char **environ;
 #    define O_BINARY	0		// I hate Windows...
@@ -70,6 +73,25 @@ extern char **environ;
 #    define IPP_NUM_CAST (size_t)
 #  endif // CUPS_VERSION_MAJOR < 3
 
+// The cupsFile output functions return `bool` in CUPS v3 and an integer
+// (`0` or a count on success, `-1` on error) in CUPS v2, so use these to check
+// for errors with both...
+#  if CUPS_VERSION_MAJOR < 3
+#    define _papplFileClose(fp)	(cupsFileClose(fp) == 0)
+#    define _papplFilePrintf(...)	(cupsFilePrintf(__VA_ARGS__) >= 0)
+#    define _papplFilePutChar(fp,c)	(cupsFilePutChar(fp,c) >= 0)
+#    define _papplFilePutConf(fp,d,v)	(cupsFilePutConf(fp,d,v) >= 0)
+#    define _papplFilePuts(fp,s)	(cupsFilePuts(fp,s) >= 0)
+#    define _papplFileWrite(fp,b,n)	(cupsFileWrite(fp,b,n) >= 0)
+#  else
+#    define _papplFileClose(fp)	cupsFileClose(fp)
+#    define _papplFilePrintf(...)	cupsFilePrintf(__VA_ARGS__)
+#    define _papplFilePutChar(fp,c)	cupsFilePutChar(fp,c)
+#    define _papplFilePutConf(fp,d,v)	cupsFilePutConf(fp,d,v)
+#    define _papplFilePuts(fp,s)	cupsFilePuts(fp,s)
+#    define _papplFileWrite(fp,b,n)	cupsFileWrite(fp,b,n)
+#  endif // CUPS_VERSION_MAJOR < 3
+
 
 //
 // Macros...
@@ -100,6 +122,23 @@ extern char **environ;
 #  define _PAPPL_FIB_VALUE(v) (v & 255)
 
 
+//
+// Macros for lock-free access to counters that are updated while printing.
+// Aligned loads and stores are atomic on all supported Windows targets so
+// only the add needs an interlocked function there...
+//
+
+#  if _WIN32
+#    define _papplAtomicAdd(ptr,v) (void)(sizeof(*(ptr)) == 8 ? InterlockedExchangeAdd64((volatile LONG64 *)(ptr), (LONG64)(v)) : InterlockedExchangeAdd((volatile LONG *)(ptr), (LONG)(v)))
+#    define _papplAtomicGet(ptr) (*(ptr))
+#    define _papplAtomicSet(ptr,v) (*(ptr) = (v))
+#  else
+#    define _papplAtomicAdd(ptr,v) (void)__atomic_fetch_add(ptr, v, __ATOMIC_RELAXED)
+#    define _papplAtomicGet(ptr) __atomic_load_n(ptr, __ATOMIC_RELAXED)
+#    define _papplAtomicSet(ptr,v) __atomic_store_n(ptr, v, __ATOMIC_RELAXED)
+#  endif // _WIN32
+
+
 
 //
 // Types and structures...
@@ -128,6 +167,21 @@ typedef struct _pappl_link_s		// Web interface navigation link
 typedef struct _pappl_odevice_s _pappl_odevice_t;
 					// Output device
 
+typedef struct _pappl_heap_s _pappl_heap_t;
+					// Binary (priority) heap
+
+typedef int (*_pappl_heap_cb_t)(void *a, void *b, void *data);
+					// Heap comparison callback
+
+typedef enum _pappl_slab_e		// Slab allocator object types
+{
+  _PAPPL_SLAB_CLIENT,				// Client (`pappl_client_t`)
+  _PAPPL_SLAB_DOCUMENT,				// Single document (`_pappl_doc_t`)
+  _PAPPL_SLAB_JOB,				// Job (`pappl_job_t`)
+  _PAPPL_SLAB_SUBSCRIPTION,			// Subscription (`pappl_subscription_t`)
+  _PAPPL_SLAB_MAX				// Number of slab allocators
+} _pappl_slab_t;
+
 
 //
 // Utility functions...
@@ -136,10 +190,26 @@ typedef struct _pappl_odevice_s _pappl_odevice_t;
 extern ipp_t		*_papplContactExport(pappl_contact_t *contact) _PAPPL_PRIVATE;
 extern void		_papplContactImport(ipp_t *col, pappl_contact_t *contact) _PAPPL_PRIVATE;
 extern void		_papplCopyAttributes(ipp_t *to, ipp_t *from, cups_array_t *ra, ipp_tag_t group_tag, bool quickcopy) _PAPPL_PRIVATE;
+extern bool		_papplHeapAdd(_pappl_heap_t *heap, void *element) _PAPPL_PRIVATE;
+extern _pappl_heap_t	*_papplHeapCreate(_pappl_heap_cb_t cb, void *cbdata, size_t index_offset) _PAPPL_PRIVATE;
+extern void		_papplHeapDelete(_pappl_heap_t *heap) _PAPPL_PRIVATE;
+extern size_t		_papplHeapGetCount(_pappl_heap_t *heap) _PAPPL_PRIVATE;
+extern void		*_papplHeapGetElement(_pappl_heap_t *heap, size_t n) _PAPPL_PRIVATE;
+extern void		*_papplHeapGetFirst(_pappl_heap_t *heap) _PAPPL_PRIVATE;
+extern bool		_papplHeapRemove(_pappl_heap_t *heap, void *element) _PAPPL_PRIVATE;
+extern void		*_papplHeapRemoveFirst(_pappl_heap_t *heap) _PAPPL_PRIVATE;
+extern void		_papplHeapUpdate(_pappl_heap_t *heap, void *element) _PAPPL_PRIVATE;
+extern bool		_papplIPPReadBuffer(ipp_t *ipp, const ipp_uchar_t *data, size_t datalen) _PAPPL_PRIVATE;
 extern bool		_papplIsEqual(const char *a, const char *b) _PAPPL_PRIVATE;
 extern const char	*_papplLookupString(unsigned bit, size_t num_strings, const char * const *strings) _PAPPL_PRIVATE;
 extern size_t		_papplLookupStrings(unsigned value, size_t max_keywords, char *keywords[], size_t num_strings, const char * const *strings) _PAPPL_PRIVATE;
 extern unsigned		_papplLookupValue(const char *keyword, size_t num_strings, const char * const *strings) _PAPPL_PRIVATE;
+extern void		*_papplSlabAlloc(_pappl_slab_t type) _PAPPL_PRIVATE;
+extern void		_papplSlabFree(_pappl_slab_t type, void *obj) _PAPPL_PRIVATE;
+extern size_t		_papplSlabGetStats(_pappl_slab_t type, size_t *num_allocs) _PAPPL_PRIVATE;
+extern const char	*_papplStrAlloc(const char *s) _PAPPL_PRIVATE;
+extern void		_papplStrFree(const char *s) _PAPPL_PRIVATE;
+extern size_t		_papplStrGetStats(size_t *num_allocs) _PAPPL_PRIVATE;
 
 
 #endif // !_PAPPL_BASE_PRIVATE_H_
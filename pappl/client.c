@@ -58,7 +58,7 @@ _papplClientCreate(
   pappl_client_t	*client;	// Client
 
 
-  if ((client = calloc(1, sizeof(pappl_client_t))) == NULL)
+  if ((client = (pappl_client_t *)_papplSlabAlloc(_PAPPL_SLAB_CLIENT)) == NULL)
   {
     papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for client connection: %s", strerror(errno));
     return (NULL);
@@ -74,7 +74,7 @@ _papplClientCreate(
   if ((client->http = httpAcceptConnection(sock, 1)) == NULL)
   {
     papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to accept client connection: %s", strerror(errno));
-    free(client);
+    _papplSlabFree(_PAPPL_SLAB_CLIENT, client);
     return (NULL);
   }
 
@@ -164,7 +164,7 @@ _papplClientDelete(
   ippDelete(client->request);
   ippDelete(client->response);
 
-  free(client);
+  _papplSlabFree(_PAPPL_SLAB_CLIENT, client);
 
   // Update the number of active clients...
   cupsMutexLock(&system->clients_mutex);
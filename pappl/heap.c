@@ -0,0 +1,301 @@
+//
+// Priority heap functions for the Printer Application Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+//
+// Include necessary headers...
+//
+
+#include "base-private.h"
+
+
+//
+// Types...
+//
+
+struct _pappl_heap_s			// Binary heap
+{
+  _pappl_heap_cb_t	cb;			// Comparison callback
+  void			*cbdata;		// Callback data
+  size_t		index_offset;		// Offset of element index
+  size_t		num_elements,		// Number of elements
+			alloc_elements;		// Allocated elements
+  void			**elements;		// Elements
+};
+
+
+//
+// Local functions...
+//
+
+static size_t	*heap_index(_pappl_heap_t *heap, void *element);
+static void	heap_move(_pappl_heap_t *heap, size_t i, void *element);
+static void	heap_sift(_pappl_heap_t *heap, size_t i);
+
+
+//
+// '_papplHeapAdd()' - Add an element to a heap.
+//
+// Elements that are already in the heap are repositioned instead.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplHeapAdd(_pappl_heap_t *heap,	// I - Heap
+              void          *element)	// I - Element
+{
+  if (!heap || !element)
+    return (false);
+
+  if (*heap_index(heap, element))
+  {
+    // Already in the heap...
+    _papplHeapUpdate(heap, element);
+    return (true);
+  }
+
+  if (heap->num_elements >= heap->alloc_elements)
+  {
+    // Grow the heap...
+    size_t	alloc_elements = heap->alloc_elements ? 2 * heap->alloc_elements : 16;
+					// New allocation
+    void	**elements;		// New elements
+
+    if ((elements = realloc(heap->elements, alloc_elements * sizeof(void *))) == NULL)
+      return (false);
+
+    heap->alloc_elements = alloc_elements;
+    heap->elements       = elements;
+  }
+
+  heap_move(heap, heap->num_elements ++, element);
+  heap_sift(heap, heap->num_elements - 1);
+
+  return (true);
+}
+
+
+//
+// '_papplHeapCreate()' - Create a heap.
+//
+// The comparison callback returns a negative value when the first element
+// should be removed before the second element.  The "index_offset" argument
+// specifies the offset of a `size_t` member in each element that is used to
+// track the element's position in the heap - it must be `0` for elements that
+// are not in a heap.
+//
+
+_pappl_heap_t *				// O - Heap or `NULL` on error
+_papplHeapCreate(
+    _pappl_heap_cb_t cb,		// I - Comparison callback
+    void             *cbdata,		// I - Callback data
+    size_t           index_offset)	// I - Offset of index member in elements
+{
+  _pappl_heap_t	*heap;			// Heap
+
+
+  if (!cb || (heap = (_pappl_heap_t *)calloc(1, sizeof(_pappl_heap_t))) == NULL)
+    return (NULL);
+
+  heap->cb           = cb;
+  heap->cbdata       = cbdata;
+  heap->index_offset = index_offset;
+
+  return (heap);
+}
+
+
+//
+// '_papplHeapDelete()' - Delete a heap.
+//
+// The elements themselves are not freed.
+//
+
+void
+_papplHeapDelete(_pappl_heap_t *heap)	// I - Heap
+{
+  size_t	i;			// Looping var
+
+
+  if (!heap)
+    return;
+
+  for (i = 0; i < heap->num_elements; i ++)
+    *heap_index(heap, heap->elements[i]) = 0;
+
+  free(heap->elements);
+  free(heap);
+}
+
+
+//
+// '_papplHeapGetCount()' - Get the number of elements in a heap.
+//
+
+size_t					// O - Number of elements
+_papplHeapGetCount(_pappl_heap_t *heap)	// I - Heap
+{
+  return (heap ? heap->num_elements : 0);
+}
+
+
+//
+// '_papplHeapGetElement()' - Get an element from a heap.
+//
+// Elements are returned in heap (not sorted) order.
+//
+
+void *					// O - Element or `NULL`
+_papplHeapGetElement(
+    _pappl_heap_t *heap,		// I - Heap
+    size_t        n)			// I - Element number (`0` based)
+{
+  return (heap && n < heap->num_elements ? heap->elements[n] : NULL);
+}
+
+
+//
+// '_papplHeapGetFirst()' - Get the first element in a heap.
+//
+
+void *					// O - First element or `NULL` if empty
+_papplHeapGetFirst(_pappl_heap_t *heap)	// I - Heap
+{
+  return (heap && heap->num_elements > 0 ? heap->elements[0] : NULL);
+}
+
+
+//
+// '_papplHeapRemove()' - Remove an element from a heap.
+//
+
+bool					// O - `true` if removed, `false` if not in heap
+_papplHeapRemove(_pappl_heap_t *heap,	// I - Heap
+                 void          *element)// I - Element
+{
+  size_t	*index,			// Pointer to element index
+		i;			// Position in heap
+
+
+  if (!heap || !element || !*(index = heap_index(heap, element)))
+    return (false);
+
+  i      = *index - 1;
+  *index = 0;
+
+  if (i < -- heap->num_elements)
+  {
+    // Move the last element into this position and restore the heap order...
+    heap_move(heap, i, heap->elements[heap->num_elements]);
+    heap_sift(heap, i);
+  }
+
+  return (true);
+}
+
+
+//
+// '_papplHeapRemoveFirst()' - Remove the first element from a heap.
+//
+
+void *					// O - First element or `NULL` if empty
+_papplHeapRemoveFirst(
+    _pappl_heap_t *heap)		// I - Heap
+{
+  void	*element;			// First element
+
+
+  if ((element = _papplHeapGetFirst(heap)) != NULL)
+    _papplHeapRemove(heap, element);
+
+  return (element);
+}
+
+
+//
+// '_papplHeapUpdate()' - Restore the heap order after an element changes.
+//
+
+void
+_papplHeapUpdate(_pappl_heap_t *heap,	// I - Heap
+                 void          *element)// I - Element
+{
+  size_t	index;			// Element index
+
+
+  if (heap && element && (index = *heap_index(heap, element)) > 0)
+    heap_sift(heap, index - 1);
+}
+
+
+//
+// 'heap_index()' - Get a pointer to the index member of an element.
+//
+
+static size_t *				// O - Pointer to index
+heap_index(_pappl_heap_t *heap,		// I - Heap
+           void          *element)	// I - Element
+{
+  return ((size_t *)((char *)element + heap->index_offset));
+}
+
+
+//
+// 'heap_move()' - Store an element at a position in the heap.
+//
+
+static void
+heap_move(_pappl_heap_t *heap,		// I - Heap
+          size_t        i,		// I - Position
+          void          *element)	// I - Element
+{
+  heap->elements[i]          = element;
+  *heap_index(heap, element) = i + 1;
+}
+
+
+//
+// 'heap_sift()' - Move an element up or down to restore the heap order.
+//
+
+static void
+heap_sift(_pappl_heap_t *heap,		// I - Heap
+          size_t        i)		// I - Position
+{
+  void		*element = heap->elements[i];
+					// Element to move
+  size_t	parent,			// Parent position
+		child;			// Child position
+
+
+  // Move up while the element comes before its parent...
+  while (i > 0)
+  {
+    parent = (i - 1) / 2;
+
+    if ((heap->cb)(element, heap->elements[parent], heap->cbdata) >= 0)
+      break;
+
+    heap_move(heap, i, heap->elements[parent]);
+    i = parent;
+  }
+
+  // Then move down while a child comes before the element...
+  while ((child = 2 * i + 1) < heap->num_elements)
+  {
+    if ((child + 1) < heap->num_elements && (heap->cb)(heap->elements[child + 1], heap->elements[child], heap->cbdata) < 0)
+      child ++;
+
+    if ((heap->cb)(heap->elements[child], element, heap->cbdata) >= 0)
+      break;
+
+    heap_move(heap, i, heap->elements[child]);
+    i = child;
+  }
+
+  heap_move(heap, i, element);
+}
@@ -52,6 +52,12 @@ static const char * const pappl_jreasons[] =
 // This function gets the named IPP attribute from a job.  The returned
 // attribute can be examined using the `ippGetXxx` functions.
 //
+// > Note: The attributes of completed jobs beyond the printer's resident job
+// > limit are saved to the spool directory and freed when they have not been
+// > accessed for a minute, so the returned attribute must not be used after
+// > that time.  Call this function again to get a fresh copy of the
+// > attribute.
+//
 
 ipp_attribute_t *			// O - Attribute or `NULL` if not found
 papplJobGetAttribute(pappl_job_t *job,	// I - Job
@@ -61,6 +67,8 @@ papplJobGetAttribute(pappl_job_t *job,	// I - Job
 
   if (job)
   {
+    _papplJobLoadAttrs(job);
+
     _papplRWLockRead(job);
     attr = ippFindAttribute(job->attrs, name, IPP_TAG_ZERO);
     _papplRWUnlock(job);
@@ -104,17 +112,7 @@ int					// O - Number of completed copies
 papplJobGetCopiesCompleted(
     pappl_job_t *job)			// I - Job
 {
-  int	ret = 0;			// Return value
-
-
-  if (job)
-  {
-    _papplRWLockRead(job);
-    ret = job->copcompleted;
-    _papplRWUnlock(job);
-  }
-
-  return (ret);
+  return (job ? _papplAtomicGet(&job->copcompleted) : 0);
 }
 
 
@@ -157,8 +155,10 @@ papplJobGetDocumentAttribute(
 {
   if (!job || doc_number < 1 || doc_number > job->num_documents)
     return (NULL);
-  else
-    return (ippFindAttribute(job->documents[doc_number - 1].attrs, name, IPP_TAG_ZERO));
+
+  _papplJobLoadAttrs(job);
+
+  return (ippFindAttribute(job->documents[doc_number - 1].attrs, name, IPP_TAG_ZERO));
 }
 
 
@@ -231,6 +231,8 @@ papplJobGetDocumentName(
   if (!job)
     return (NULL);
 
+  _papplJobLoadAttrs(job);
+
   _papplRWLockRead(job);
   if (doc_number >= 1 && doc_number <= job->num_documents)
     ret = ippGetString(ippFindAttribute(job->documents[doc_number - 1].attrs, "document-name", IPP_TAG_NAME), 0, NULL);
@@ -289,17 +291,7 @@ int					// O - Number of completed impressions in job
 papplJobGetImpressionsCompleted(
     pappl_job_t *job)			// I - Job
 {
-  int	ret = 0;			// Return value
-
-
-  if (job)
-  {
-    _papplRWLockRead(job);
-    ret = job->impcompleted;
-    _papplRWUnlock(job);
-  }
-
-  return (ret);
+  return (job ? _papplAtomicGet(&job->impcompleted) : 0);
 }
 
 
@@ -555,7 +547,7 @@ papplJobIsCanceled(pappl_job_t *job)	// I - Job
   if (job)
   {
     _papplRWLockRead(job);
-    ret = job->is_canceled || job->state == IPP_JSTATE_CANCELED || job->state == IPP_JSTATE_ABORTED;
+    ret = job->is_canceled || job->state == IPP_JSTATE_CANCELED || job->state == IPP_JSTATE_ABORTED || job->prerip_state == _PAPPL_PRERIP_DISCARD;
     _papplRWUnlock(job);
   }
 
@@ -602,11 +594,20 @@ papplJobSetCopiesCompleted(
     pappl_job_t *job,			// I - Job
     int         add)			// I - Number of copies to add
 {
+  _pappl_prerip_t	prerip_state;		// Look-ahead state
+
+
   if (job)
   {
-    _papplRWLockWrite(job);
-    job->copcompleted += add;
-    _papplRWUnlock(job);
+    // Progress made during look-ahead processing is applied when the job is
+    // printed.  The counters are updated without locking since this gets
+    // called for every page...
+    prerip_state = _papplAtomicGet(&job->prerip_state);
+
+    if (prerip_state == _PAPPL_PRERIP_RUNNING || prerip_state == _PAPPL_PRERIP_DISCARD)
+      _papplAtomicAdd(&job->prerip_copcompleted, add);
+    else
+      _papplAtomicAdd(&job->copcompleted, add);
   }
 }
 
@@ -658,11 +659,20 @@ papplJobSetImpressionsCompleted(
     pappl_job_t *job,			// I - Job
     int         add)			// I - Number of impressions/sides to add
 {
+  _pappl_prerip_t	prerip_state;		// Look-ahead state
+
+
   if (job)
   {
-    _papplRWLockWrite(job);
-    job->impcompleted += add;
-    _papplRWUnlock(job);
+    // Progress made during look-ahead processing is applied when the job is
+    // printed.  The counters are updated without locking since this gets
+    // called for every page...
+    prerip_state = _papplAtomicGet(&job->prerip_state);
+
+    if (prerip_state == _PAPPL_PRERIP_RUNNING || prerip_state == _PAPPL_PRERIP_DISCARD)
+      _papplAtomicAdd(&job->prerip_impcompleted, add);
+    else
+      _papplAtomicAdd(&job->impcompleted, add);
   }
 }
 
@@ -11,6 +11,7 @@
 #include "pappl.h"
 #include "job-private.h"
 #include "printer-private.h"
+#include "raster-private.h"
 #include "system-private.h"
 #ifdef HAVE_LIBJPEG
 #  include <setjmp.h>
@@ -24,10 +25,55 @@
 #endif // HAVE_PDFIO
 
 
+//
+// Local constants...
+//
+
+#define _PAPPL_IMAGE_BAND	32	// Number of lines in a rotated image band
+
+
 //
 // Local types...
 //
 
+typedef struct _pappl_image_s		// Image being filtered
+{
+  const unsigned char	*pixels;		// Image pixels or `NULL`
+  int			width,			// Width in columns
+			height,			// Height in lines
+			depth;			// Bytes per pixel
+  ipp_orient_t		orientation;		// Orientation of image on page
+  _pappl_image_cb_t	cb;			// Row callback, if any
+  void			*cbdata;		// Row callback data
+  unsigned char		*band;			// Band of rotated rows or row buffer
+  unsigned		band_y,			// First row in band
+			band_count,		// Number of rows in band
+			band_max;		// Maximum number of rows in band
+  size_t		band_rowsize;		// Bytes per row in band
+} _pappl_image_t;
+
+typedef struct _pappl_image_worker_s	// Image rendering worker
+{
+  _pappl_image_t	image;			// Image being filtered
+  _pappl_rscale_t	*scale;			// Image scaler
+  unsigned char		*gray;			// Grayscale line for dithering
+} _pappl_image_worker_t;
+
+typedef struct _pappl_image_render_s	// Image rendering state
+{
+  pappl_job_t		*job;			// Job
+  pappl_device_t	*device;		// Device
+  pappl_pr_options_t	*options;		// Print options
+  cups_page_header_t	*header;		// Page header
+  int			depth,			// Bytes per image pixel
+			bpp,			// Bytes per output pixel
+			xfirst,			// First output column
+			count,			// Number of output columns
+			ystart;			// Y start position
+  unsigned char		white;			// White color
+  _pappl_image_worker_t	*workers;		// Workers
+} _pappl_image_render_t;
+
 #ifdef HAVE_LIBJPEG
 typedef struct _pappl_jpeg_err_s	// JPEG error manager extension
 {
@@ -35,21 +81,59 @@ typedef struct _pappl_jpeg_err_s	// JPEG error manager extension
   jmp_buf	retbuf;				// setjmp() return buffer
   char		message[JMSG_LENGTH_MAX];	// Last error message
 } _pappl_jpeg_err_t;
+
+typedef struct _pappl_jpeg_rows_s	// JPEG row callback data
+{
+  pappl_job_t		*job;			// Job
+  const char		*filename;		// JPEG filename
+  FILE			*fp;			// JPEG file
+  struct jpeg_decompress_struct	*dinfo;		// Decompressor info
+  _pappl_jpeg_err_t	*jerr;			// Error handler info
+  J_COLOR_SPACE		color_space;		// Output color space
+  unsigned		scale_num;		// Scaling numerator
+} _pappl_jpeg_rows_t;
 #endif // HAVE_LIBJPEG
+#ifdef HAVE_LIBPNG
+typedef struct _pappl_png_rows_s	// PNG decoding state
+{
+  pappl_job_t	*job;			// Job
+  const char	*filename;		// PNG filename
+  FILE		*fp;			// PNG file
+  png_structp	pp;			// PNG read pointer
+  png_infop	info;			// PNG info pointer
+  int		width,			// Width in columns
+		height,			// Height in lines
+		depth,			// Bytes per pixel
+		passes,			// Number of interlace passes
+		y;			// Next row to decode (non-interlaced)
+  size_t	rowsize;		// Bytes per row
+  unsigned char	*band;			// Band of decoded rows (interlaced)
+  int		band_y,			// First row in band
+		band_count,		// Number of rows in band
+		band_max;		// Maximum number of rows in band
+} _pappl_png_rows_t;
+#endif // HAVE_LIBPNG
 
 
 //
 // Local functions...
 //
 
+static const unsigned char *image_get_row(_pappl_image_t *image, unsigned y);
+static bool	image_render_band(_pappl_image_render_t *render, unsigned worker, unsigned y, unsigned count, unsigned char *lines);
+static bool	image_write_band(_pappl_image_render_t *render, unsigned y, unsigned count, const unsigned char *lines);
 #ifdef HAVE_LIBJPEG
 static void	jpeg_error_handler(j_common_ptr p) _PAPPL_NORETURN;
+static bool	jpeg_read_row(_pappl_jpeg_rows_t *rows, int y, unsigned char *row);
+static void	jpeg_setup(struct jpeg_decompress_struct *dinfo, J_COLOR_SPACE color_space, unsigned scale_num);
 #endif // HAVE_LIBJPEG
 #ifdef HAVE_PDFIO
 static bool	pdf_error_cb(pdfio_file_t *pdf, const char *message, void *cb_data);
 #endif // HAVE_PDFIO
 #ifdef HAVE_LIBPNG
 static void	png_error_func(png_structp pp, png_const_charp message);
+static bool	png_read_band(_pappl_png_rows_t *rows, int y, unsigned char *row);
+static bool	png_setup(_pappl_png_rows_t *rows);
 static void	png_warning_func(png_structp pp, png_const_charp message);
 #endif // HAVE_LIBPNG
 static const char *raster_type(cups_page_header_t *header);
@@ -84,28 +168,58 @@ papplJobFilterImage(
     int                 depth,		// I - Bytes per pixel (`1` for grayscale or `3` for sRGB)
     int                 ppi,		// I - Pixels per inch (`0` for unknown)
     bool		smoothing)	// I - `true` to smooth/interpolate the image, `false` for nearest-neighbor sampling
+{
+  return (_papplJobFilterImage(job, device, options, pixels, width, height, depth, ppi, smoothing, /*cb*/NULL, /*cbdata*/NULL));
+}
+
+
+//
+// '_papplJobFilterImage()' - Filter an image in memory or from a row callback.
+//
+// This function implements @link papplJobFilterImage@.  When a row callback
+// is supplied the image rows are requested in increasing order for each copy,
+// skipping rows as needed, so that the whole image need not be in memory.  The
+// first row is requested again for each additional copy.  Only portrait
+// orientation is supported with a row callback.
+//
+// The image is scaled using offsets and weights that are computed once per
+// page, with bilinear interpolation (enlarging) or box filtering (reducing)
+// when "smoothing" is `true`.  Images in memory are scaled and dithered in
+// bands by up to @link papplSystemGetMaxImageThreads@ worker threads, while
+// the driver's `rwriteband_cb` or `rwriteline_cb` function is always called
+// from the current thread with the lines in order.
+//
+
+bool					// O - `true` on success, `false` otherwise
+_papplJobFilterImage(
+    pappl_job_t         *job,		// I - Job
+    pappl_device_t      *device,	// I - Device
+    pappl_pr_options_t  *options,	// I - Print options
+    const unsigned char *pixels,	// I - Pointer to the top-left corner of the image data or `NULL`
+    int                 width,		// I - Width in columns
+    int                 height,		// I - Height in lines
+    int                 depth,		// I - Bytes per pixel (`1` for grayscale or `3` for sRGB)
+    int                 ppi,		// I - Pixels per inch (`0` for unknown)
+    bool		smoothing,	// I - `true` to smooth/interpolate the image, `false` for nearest-neighbor sampling
+    _pappl_image_cb_t   cb,		// I - Row callback or `NULL` for image data
+    void                *cbdata)	// I - Row callback data
 {
   pappl_pr_driver_data_t driver_data;	// Printer driver data
   cups_page_header_t	*header;	// Page header
-  const unsigned char	*dither;	// Dither line
   int			ileft,		// Imageable left margin
 			itop,		// Imageable top margin
 			iwidth,		// Imageable width
 			iheight;	// Imageable length/height
-  unsigned char		white,		// White color
-			*line = NULL,	// Output line
-			*lineptr,	// Pointer in line
-			byte,		// Byte in line
-			bit;		// Current bit
-  const unsigned char	*pixbase,	// Pointer to first pixel
-			*pixline,	// Pointer to start of current line
-			*pixptr,	// Pointer into image
-			*pixend;	// End of image
-  int			pixel0,		// Temporary pixel value
-			pixel1,		// ...
-			img_width,	// Rotated image width
+  unsigned char		*blank = NULL;	// Band of blank lines
+  _pappl_image_t	image;		// Image being filtered
+  _pappl_image_render_t	render;		// Image rendering state
+  _pappl_image_worker_t	*worker;	// Current worker
+  _pappl_rbands_t	*bands = NULL;	// Band renderer
+  size_t		i,		// Looping var
+			num_workers = 0;// Number of workers
+  int			img_width,	// Rotated image width
 			img_height,	// Rotated image height
-			x,		// X position
+			xfirst,		// First output column
 			xsize,		// Scaled width
 			xstart,		// X start position
 			xend,		// X end position
@@ -113,14 +227,6 @@ papplJobFilterImage(
 			ysize,		// Scaled height
 			ystart,		// Y start position
 			yend;		// Y end position
-  int			xdir,		// X direction
-			xerr,		// X error accumulator
-			xmod,		// X modulus
-			xstep,		// X step
-			yerr,		// Y error accumulator
-			ymod,		// Y modulus
-			ystep,		// Y step
-			ydir;		// Y direction
   unsigned		copy;		// Current copy
 
 
@@ -209,11 +315,8 @@ papplJobFilterImage(
   {
     default :
     case IPP_ORIENT_PORTRAIT :
-        pixbase    = pixels;
         img_width  = width;
         img_height = height;
-        xdir       = (int)depth;
-        ydir       = (int)depth * (int)width;
 
         if (options->print_scaling == PAPPL_SCALING_NONE)
         {
@@ -236,11 +339,8 @@ papplJobFilterImage(
 	break;
 
     case IPP_ORIENT_REVERSE_PORTRAIT :
-        pixbase    = pixels + depth * width * height - depth;
         img_width  = width;
         img_height = height;
-        xdir       = -(int)depth;
-        ydir       = -(int)depth * (int)width;
 
         if (options->print_scaling == PAPPL_SCALING_NONE)
         {
@@ -263,11 +363,8 @@ papplJobFilterImage(
 	break;
 
     case IPP_ORIENT_LANDSCAPE : // 90 counter-clockwise
-        pixbase    = pixels + depth * width - depth;
         img_width  = height;
         img_height = width;
-        xdir       = (int)depth * (int)width;
-        ydir       = -(int)depth;
 
         if (options->print_scaling == PAPPL_SCALING_NONE)
         {
@@ -290,11 +387,8 @@ papplJobFilterImage(
 	break;
 
     case IPP_ORIENT_REVERSE_LANDSCAPE : // 90 clockwise
-        pixbase    = pixels + depth * (height - 1) * width;
         img_width  = height;
         img_height = width;
-        xdir       = -(int)depth * (int)width;
-        ydir       = (int)depth;
 
         if (options->print_scaling == PAPPL_SCALING_NONE)
         {
@@ -317,28 +411,46 @@ papplJobFilterImage(
         break;
   }
 
+  if (cb && options->orientation_requested != IPP_ORIENT_PORTRAIT)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to rotate streamed image.");
+    return (false);
+  }
+
+  image.pixels      = pixels;
+  image.width       = width;
+  image.height      = height;
+  image.depth       = depth;
+  image.orientation = options->orientation_requested;
+  image.cb          = cb;
+  image.cbdata      = cbdata;
+  image.band        = NULL;
+  image.band_y      = 0;
+  image.band_count  = 0;
+
   // Don't rotate in the driver...
   options->orientation_requested = IPP_ORIENT_PORTRAIT;
 
+  if (xsize < 1)
+    xsize = 1;
+  if (ysize < 1)
+    ysize = 1;
+
   xstart = ileft + (iwidth - xsize) / 2;
   xend   = xstart + xsize;
   ystart = itop + (iheight - ysize) / 2;
   yend   = ystart + ysize;
 
-  xmod   = (int)(img_width % xsize);
-  xstep  = (int)(img_width / xsize) * xdir;
-
-  ymod   = (int)(img_height % ysize);
-  ystep  = (int)(img_height / ysize) * ydir;
-
   if (xend > (int)options->header.cupsWidth)
     xend = (int)options->header.cupsWidth;
 
   if (yend > (int)options->header.cupsHeight)
     yend = (int)options->header.cupsHeight;
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "xsize=%d, xstart=%d, xend=%d, xdir=%d, xmod=%d, xstep=%d", xsize, xstart, xend, xdir, xmod, xstep);
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "ysize=%d, ystart=%d, yend=%d, ydir=%d, ymod=%d, ystep=%d", ysize, ystart, yend, ydir, ymod, ystep);
+  xfirst = xstart < 0 ? 0 : xstart;
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "xsize=%d, xstart=%d, xend=%d", xsize, xstart, xend);
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "ysize=%d, ystart=%d, yend=%d", ysize, ystart, yend);
 
   papplPrinterGetDriverData(papplJobGetPrinter(job), &driver_data);
 
@@ -347,20 +459,79 @@ papplJobFilterImage(
   else
     header = &options->mono_header;
 
-  if ((line = malloc(header->cupsBytesPerLine)) == NULL)
+  memset(&render, 0, sizeof(render));
+
+  render.job         = job;
+  render.device      = device;
+  render.options     = options;
+  render.header      = header;
+  render.depth       = depth;
+  render.bpp         = (int)header->cupsBitsPerPixel / 8;
+  render.xfirst      = xfirst;
+  render.count       = xend - xfirst;
+  render.ystart      = ystart;
+
+  if (header->cupsColorSpace == CUPS_CSPACE_K || header->cupsColorSpace == CUPS_CSPACE_CMYK)
+    render.white = 0x00;
+  else
+    render.white = 0xff;
+
+  // Rotated images are copied a band of rows at a time so that the image
+  // pixels are read sequentially...
+  image.band_rowsize = (size_t)img_width * (size_t)depth;
+
+  if (cb)
+    image.band_max = 1;
+  else if (image.orientation != IPP_ORIENT_PORTRAIT)
+    image.band_max = img_height < _PAPPL_IMAGE_BAND ? (unsigned)img_height : _PAPPL_IMAGE_BAND;
+  else
+    image.band_max = 0;
+
+  // Images from a row callback are rendered by the current thread since the
+  // rows must be read in order, otherwise each worker thread gets its own
+  // image rows and scaler...
+  if (xend <= xfirst)
+    num_workers = 0;
+  else if (cb)
+    num_workers = 1;
+  else
+    num_workers = papplSystemGetMaxImageThreads(job->system);
+
+  if ((blank = malloc(_PAPPL_RASTER_BAND * header->cupsBytesPerLine)) == NULL || (num_workers > 0 && (render.workers = calloc(num_workers, sizeof(_pappl_image_worker_t))) == NULL))
   {
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for raster line.");
     goto abort_job;
   }
 
-  // Start the page...
-  if (header->cupsColorSpace == CUPS_CSPACE_K || header->cupsColorSpace == CUPS_CSPACE_CMYK)
-    white = 0x00;
-  else
-    white = 0xff;
+  for (i = 0, worker = render.workers; i < num_workers; i ++, worker ++)
+  {
+    worker->image = image;
 
-  pixend = pixels + width * height * depth;
+    if ((header->cupsBitsPerPixel == 1 && depth > 1 && (worker->gray = malloc(header->cupsWidth)) == NULL) || (image.band_max > 0 && (worker->image.band = malloc(image.band_max * image.band_rowsize)) == NULL))
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for raster line.");
+      goto abort_job;
+    }
 
+    // Create the scaler for the visible part of the image...
+    if ((worker->scale = _papplRasterScaleCreate((unsigned)depth, (unsigned)img_width, (unsigned)img_height, (unsigned)xsize, (unsigned)ysize, (unsigned)(xfirst - xstart), (unsigned)(xend - xfirst), smoothing, (_pappl_rscale_cb_t)image_get_row, &worker->image)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for image scaling.");
+      goto abort_job;
+    }
+  }
+
+  // Start the worker threads once for all copies...
+  if (num_workers > 0 && (bands = _papplRasterBandsCreate((unsigned)num_workers, _PAPPL_RASTER_BAND, header->cupsBytesPerLine, (_pappl_rrender_cb_t)image_render_band, (_pappl_rwrite_cb_t)image_write_band, &render)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for raster bands.");
+    goto abort_job;
+  }
+
+  if (num_workers > 1)
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Rendering image using %u threads.", (unsigned)num_workers);
+
+  // Start the page...
   if (job->printer->driver_data.copies_supported < (int)header->NumCopies)
     copy = header->NumCopies - 1;
   else
@@ -378,192 +549,30 @@ papplJobFilterImage(
     }
 
     // Leading blank space...
-    memset(line, white, header->cupsBytesPerLine);
-    for (y = 0; y < ystart; y ++)
-    {
-      if (!(driver_data.rwriteline_cb)(job, options, device, (unsigned)y, line))
-      {
-	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
-	goto abort_job;
-      }
-    }
+    memset(blank, render.white, _PAPPL_RASTER_BAND * header->cupsBytesPerLine);
 
-    if (ystart < 0)
-    {
-      pixline = pixbase - (ystart * ymod / ysize) * ydir;
-      yerr    = -ymod / 2 - (ystart * ymod) % ysize;
-    }
-    else
+    if (ystart > 0 && !_papplJobSkipLines(job, options, device, 0, (unsigned)ystart, header->cupsBytesPerLine, blank))
     {
-      pixline = pixbase;
-      yerr    = -ymod / 2;
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster lines 0 to %d.", ystart - 1);
+      goto abort_job;
     }
 
+    y = ystart > 0 ? ystart : 0;
+
     // Now RIP the image...
-    for (; y < yend && !job->is_canceled; y ++)
+    if (y < yend && num_workers > 0)
     {
-      pixptr = pixline;
-
-      if (xstart < 0)
-      {
-	pixptr -= (xstart * xmod / xsize) * xdir;
-	x    = 0;
-	xerr = -xmod / 2 - (xstart * xmod) % xsize;
-      }
-      else
-      {
-	x    = xstart;
-	xerr = -xmod / 2;
-      }
-
-      if (header->cupsBitsPerPixel == 1)
-      {
-	// Need to dither the image to 1-bit black...
-	dither = options->dither[y & 15];
-
-	for (lineptr = line + x / 8, bit = 128 >> (x & 7), byte = 0; x < xend; x ++)
-	{
-	  // Dither the current pixel...
-	  if (*pixptr <= dither[x & 15])
-	    byte |= bit;
-
-	  // Advance to the next pixel...
-	  pixptr += xstep;
-	  xerr += xmod;
-	  if (xerr >= (int)xsize)
-	  {
-	    // Accumulated error has overflowed, advance another pixel...
-	    xerr -= xsize;
-	    pixptr += xdir;
-	  }
-
-	  // and the next bit
-	  if (bit == 1)
-	  {
-	    // Current byte is "full", save it...
-	    *lineptr++ = byte;
-	    byte = 0;
-	    bit  = 128;
-	  }
-	  else
-	    bit /= 2;
-	}
-
-	if (bit < 128)
-	  *lineptr = byte;
-      }
-      else if (header->cupsColorSpace == CUPS_CSPACE_K)
-      {
-	// Need to invert the image...
-	for (lineptr = line + x; x < xend; x ++)
-	{
-	  // Copy an inverted grayscale pixel...
-	  if (smoothing && yerr >= 0 && xerr >= 0)
-	  {
-	    const unsigned char	*rt = pixptr + xdir,
-				*dn = pixptr + ydir,
-				*dnrt = pixptr + xdir + ydir;
-					// Pointers to adjacent pixels
-
-	    if (rt < pixels || rt >= pixend)
-	      rt = pixptr;
-	    if (dn < pixels || dn >= pixend)
-	      dn = pixptr;
-	    if (dnrt < pixels || dnrt >= pixend)
-	      dnrt = pixptr;
-
-	    pixel0     = ((xsize - xerr) * *pixptr + xerr * *rt) / xsize;
-	    pixel1     = ((xsize - xerr) * *dn + xerr * *dnrt) / xsize;
-	    *lineptr++ = (unsigned char)(255 - ((ysize - yerr) * pixel0 + yerr * pixel1) / ysize);
-	  }
-	  else
-	  {
-	    *lineptr++ = (unsigned char)~*pixptr;
-	  }
-
-	  // Advance to the next pixel...
-	  pixptr += xstep;
-	  xerr += xmod;
-	  if (xerr >= (int)xsize)
-	  {
-	    // Accumulated error has overflowed, advance another pixel...
-	    xerr -= xsize;
-	    pixptr += xdir;
-	  }
-	}
-      }
-      else
-      {
-	// Need to copy the image...
-	int bpp = (int)header->cupsBitsPerPixel / 8;
+      if (!_papplRasterBandsRender(bands, (unsigned)y, (unsigned)(yend - y)) && !job->is_canceled)
+        goto abort_job;
 
-	for (lineptr = line + x * bpp; x < xend; x ++)
-	{
-	  // Copy a grayscale or RGB pixel...
-	  if (smoothing && yerr >= 0 && xerr >= 0)
-	  {
-	    int			j;	// Looping var
-	    const unsigned char	*rt = pixptr + xdir,
-				*dn = pixptr + ydir,
-				*dnrt = pixptr + xdir + ydir;
-					// Pointers to adjacent pixels
-
-	    if (rt < pixels || rt >= pixend)
-	      rt = pixptr;
-	    if (dn < pixels || dn >= pixend)
-	      dn = pixptr;
-	    if (dnrt < pixels || dnrt >= pixend)
-	      dnrt = pixptr;
-
-	    for (j = 0; j < bpp; j ++)
-	    {
-	      pixel0     = ((xsize - xerr) * pixptr[j] + xerr * rt[j]) / xsize;
-	      pixel1     = ((xsize - xerr) * dn[j] + xerr * dnrt[j]) / xsize;
-	      *lineptr++ = (unsigned char)(((ysize - yerr) * pixel0 + yerr * pixel1) / ysize);
-	    }
-	  }
-	  else
-	  {
-	    memcpy(lineptr, pixptr, (unsigned)bpp);
-	    lineptr += bpp;
-	  }
-
-	  // Advance to the next pixel...
-	  pixptr += xstep;
-	  xerr += xmod;
-	  if (xerr >= (int)xsize)
-	  {
-	    // Accumulated error has overflowed, advance another pixel...
-	    xerr -= xsize;
-	    pixptr += xdir;
-	  }
-	}
-      }
-
-      if (!(driver_data.rwriteline_cb)(job, options, device, (unsigned)y, line))
-      {
-	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
-	goto abort_job;
-      }
-
-      pixline += ystep;
-      yerr += ymod;
-      if (yerr >= ysize)
-      {
-	pixline += ydir;
-	yerr -= ysize;
-      }
+      y = yend;
     }
 
     // Trailing blank space...
-    memset(line, white, header->cupsBytesPerLine);
-    for (; y < (int)header->cupsHeight; y ++)
+    if (y < (int)header->cupsHeight && !_papplJobSkipLines(job, options, device, (unsigned)y, header->cupsHeight - (unsigned)y, header->cupsBytesPerLine, blank))
     {
-      if (!(driver_data.rwriteline_cb)(job, options, device, (unsigned)y, line))
-      {
-	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
-	goto abort_job;
-      }
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster lines %d to %u.", y, header->cupsHeight - 1);
+      goto abort_job;
     }
 
     // End the page...
@@ -577,14 +586,34 @@ papplJobFilterImage(
   }
 
   // Free memory and return...
-  free(line);
+  _papplRasterBandsDelete(bands);
+
+  for (i = 0, worker = render.workers; i < num_workers && worker; i ++, worker ++)
+  {
+    _papplRasterScaleDelete(worker->scale);
+    free(worker->gray);
+    free(worker->image.band);
+  }
+
+  free(render.workers);
+  free(blank);
 
   return (true);
 
   // Abort the job...
   abort_job:
 
-  free(line);
+  _papplRasterBandsDelete(bands);
+
+  for (i = 0, worker = render.workers; i < num_workers && worker; i ++, worker ++)
+  {
+    _papplRasterScaleDelete(worker->scale);
+    free(worker->gray);
+    free(worker->image.band);
+  }
+
+  free(render.workers);
+  free(blank);
 
   return (false);
 }
@@ -609,6 +638,11 @@ _papplJobFilterJPEG(
   int			xdpi,		// X pixels per inch
 			ydpi;		// Y pixels per inch
   _pappl_jpeg_err_t	jerr;		// Error handler info
+  _pappl_jpeg_rows_t	rows;		// Row callback data
+  J_COLOR_SPACE		color_space;	// Output color space
+  unsigned		scale_num,	// Scaling numerator
+			pwidth,		// Page width in pixels
+			pheight;	// Page height in pixels
   unsigned char		*pixels = NULL;	// Image pixels
   JSAMPROW		row;		// Sample row pointer
   bool			ret = false;	// Return value
@@ -642,47 +676,22 @@ _papplJobFilterJPEG(
   jpeg_read_header(&dinfo, TRUE);
 
   // Request the image data in the format we need...
-  dinfo.quantize_colors = FALSE;
-
   if (options->print_color_mode == PAPPL_COLOR_MODE_MONOCHROME || dinfo.num_components == 1)
-  {
-    dinfo.out_color_space      = JCS_GRAYSCALE;
-    dinfo.out_color_components = 1;
-    dinfo.output_components    = 1;
-  }
+    color_space = JCS_GRAYSCALE;
   else
-  {
-    dinfo.out_color_space      = JCS_RGB;
-    dinfo.out_color_components = 3;
-    dinfo.output_components    = 3;
-  }
+    color_space = JCS_RGB;
 
-  jpeg_calc_output_dimensions(&dinfo);
+  jpeg_setup(&dinfo, color_space, 8);
 
   papplLogJob(job, PAPPL_LOGLEVEL_INFO, "JPEG image dimensions are %ux%ux%d", dinfo.output_width, dinfo.output_height, dinfo.output_components);
 
-  if (dinfo.output_width < 1 || dinfo.output_width > (JDIMENSION)job->system->max_image_width || dinfo.output_height < 1 || dinfo.output_height > (JDIMENSION)job->system->max_image_height || ((size_t)dinfo.output_width * (size_t)dinfo.output_height * (size_t)dinfo.output_components) > job->system->max_image_size)
+  if (dinfo.output_width < 1 || dinfo.output_width > (JDIMENSION)job->system->max_image_width || dinfo.output_height < 1 || dinfo.output_height > (JDIMENSION)job->system->max_image_height)
   {
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "JPEG image is too large to print.");
     papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
     goto finish_jpeg;
   }
 
-  if ((pixels = (unsigned char *)malloc((size_t)dinfo.output_width * (size_t)dinfo.output_height * (size_t)dinfo.output_components)) == NULL)
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for %ux%ux%d JPEG image.", dinfo.output_width, dinfo.output_height, dinfo.output_components);
-    papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
-    goto finish_jpeg;
-  }
-
-  jpeg_start_decompress(&dinfo);
-
-  while (dinfo.output_scanline < dinfo.output_height)
-  {
-    row = (JSAMPROW)(pixels + (size_t)dinfo.output_scanline * (size_t)dinfo.output_width * (size_t)dinfo.output_components);
-    jpeg_read_scanlines(&dinfo, &row, 1);
-  }
-
   switch (dinfo.density_unit)
   {
     default :
@@ -707,9 +716,101 @@ _papplJobFilterJPEG(
     goto finish_jpeg;
   }
 
-  ret = papplJobFilterImage(job, device, options, pixels, (int)dinfo.output_width, (int)dinfo.output_height, dinfo.output_components, xdpi, true);
+  // Figure out the orientation so we know which way the image will be read...
+  if (options->orientation_requested == IPP_ORIENT_NONE)
+  {
+    if (dinfo.output_width > dinfo.output_height && options->header.cupsWidth < options->header.cupsHeight)
+    {
+      options->orientation_requested = IPP_ORIENT_LANDSCAPE;
+      papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Auto-orientation: landscape");
+    }
+    else
+    {
+      options->orientation_requested = IPP_ORIENT_PORTRAIT;
+      papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Auto-orientation: portrait");
+    }
+  }
+
+  if (options->orientation_requested == IPP_ORIENT_LANDSCAPE || options->orientation_requested == IPP_ORIENT_REVERSE_LANDSCAPE)
+  {
+    pwidth  = options->header.cupsHeight;
+    pheight = options->header.cupsWidth;
+  }
+  else
+  {
+    pwidth  = options->header.cupsWidth;
+    pheight = options->header.cupsHeight;
+  }
+
+  // Use the smallest DCT scaling that still covers the page at the printer
+  // resolution, or the printer resolution at the image resolution when the
+  // image is printed at its natural size...
+  for (scale_num = 1; scale_num < 8; scale_num ++)
+  {
+    if ((dinfo.output_width * scale_num / 8) < pwidth || (dinfo.output_height * scale_num / 8) < pheight)
+      continue;
 
-  jpeg_finish_decompress(&dinfo);
+    if (options->print_scaling == PAPPL_SCALING_NONE && (xdpi <= 0 || (int)scale_num * xdpi < 8 * options->printer_resolution[0]))
+      continue;
+
+    break;
+  }
+
+  if (scale_num < 8)
+  {
+    JDIMENSION width = dinfo.output_width;
+					// Full width of image
+
+    jpeg_setup(&dinfo, color_space, scale_num);
+
+    xdpi = (int)((JDIMENSION)xdpi * dinfo.output_width / width);
+
+    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Decoding JPEG image at %u/8 scale (%ux%u).", scale_num, dinfo.output_width, dinfo.output_height);
+  }
+
+  jpeg_start_decompress(&dinfo);
+
+  if (options->orientation_requested == IPP_ORIENT_PORTRAIT)
+  {
+    // Decode the image one row at a time...
+    rows.job         = job;
+    rows.filename    = filename;
+    rows.fp          = fp;
+    rows.dinfo       = &dinfo;
+    rows.jerr        = &jerr;
+    rows.color_space = color_space;
+    rows.scale_num   = scale_num;
+
+    ret = _papplJobFilterImage(job, device, options, /*pixels*/NULL, (int)dinfo.output_width, (int)dinfo.output_height, dinfo.output_components, xdpi, true, (_pappl_image_cb_t)jpeg_read_row, &rows);
+  }
+  else
+  {
+    // Rotated images are decoded into memory, which is bounded by the page
+    // size thanks to the DCT scaling above...
+    if (((size_t)dinfo.output_width * (size_t)dinfo.output_height * (size_t)dinfo.output_components) > job->system->max_image_size)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "JPEG image is too large to print.");
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
+      goto finish_jpeg;
+    }
+
+    if ((pixels = (unsigned char *)malloc((size_t)dinfo.output_width * (size_t)dinfo.output_height * (size_t)dinfo.output_components)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for %ux%ux%d JPEG image.", dinfo.output_width, dinfo.output_height, dinfo.output_components);
+      papplJobSetReasons(job, PAPPL_JREASON_ERRORS_DETECTED, PAPPL_JREASON_NONE);
+      goto finish_jpeg;
+    }
+
+    while (dinfo.output_scanline < dinfo.output_height)
+    {
+      row = (JSAMPROW)(pixels + (size_t)dinfo.output_scanline * (size_t)dinfo.output_width * (size_t)dinfo.output_components);
+      jpeg_read_scanlines(&dinfo, &row, 1);
+    }
+
+    jpeg_finish_decompress(&dinfo);
+
+    ret = papplJobFilterImage(job, device, options, pixels, (int)dinfo.output_width, (int)dinfo.output_height, dinfo.output_components, xdpi, true);
+  }
 
   finish_jpeg:
 
@@ -791,8 +892,14 @@ _papplJobInspectJPEG(
 //
 // '_papplJobFilterPNG()' - Process a PNG image file.
 //
+// Non-interlaced PNG images printed in portrait orientation are decoded one
+// row at a time.  Other PNG images are decoded into memory if they fit in the
+// system's image memory budget.  Larger interlaced images printed in portrait
+// orientation are decoded in bands that fit in the budget, while larger
+// rotated images are decoded into memory subject to the maximum image size.
+//
 
-bool					// O - `true` on success and `false` otherwise
+bool					// O - `true` on success, `false` otherwise
 _papplJobFilterPNG(
     pappl_job_t        *job,		// I - Job
     int                doc_number,	// I - Document number (`1` based)
@@ -802,17 +909,13 @@ _papplJobFilterPNG(
 {
   const char		*filename;	// Job filename
   FILE			*fp;		// PNG file
-  png_structp		pp = NULL;	// PNG read pointer
-  png_infop		info = NULL;	// PNG info pointers
-  png_bytep		*rows = NULL;	// PNG row pointers
-  png_color_16		bg;		// Background color
+  _pappl_png_rows_t	rows;		// PNG decoding state
   int			i,		// Looping var
-			color_type,	// PNG color mode
-			width,		// Width in columns
-			height,		// Height in lines
-			depth,		// Bytes per pixel
+			pass,		// Current interlace pass
 			xdpi,		// X resolution
 			ydpi;		// Y resolution
+  size_t		max_memory,	// Image memory budget
+			image_size;	// Size of decoded image
   unsigned char		*pixels = NULL;	// Image pixels
   bool			ret = false;	// Return value
 
@@ -827,60 +930,30 @@ _papplJobFilterPNG(
     return (false);
   }
 
-  // Setup PNG data structures...
-  if ((pp = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)job, png_error_func, png_warning_func)) == NULL)
-  {
-    papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG file '%s': %s", filename, strerror(errno));
-    goto finish_png;
-  }
+  // Setup PNG data structures and get the image dimensions and depth...
+  memset(&rows, 0, sizeof(rows));
 
-  if ((info = png_create_info_struct(pp)) == NULL)
-  {
-    papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG file '%s': %s", filename, strerror(errno));
-    goto finish_png;
-  }
+  rows.job      = job;
+  rows.filename = filename;
+  rows.fp       = fp;
 
-  if (setjmp(png_jmpbuf(pp)))
+  if (!png_setup(&rows))
   {
-    // If we get here, PNG loading failed and any errors/warnings were logged
-    // via the corresponding callback functions...
     papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
     goto finish_png;
   }
 
-  // Start reading...
-  png_init_io(pp, fp);
-
-#  if defined(PNG_SKIP_sRGB_CHECK_PROFILE) && defined(PNG_SET_OPTION_SUPPORTED)
-  // Don't throw errors with "invalid" sRGB profiles produced by Adobe apps.
-  png_set_option(pp, PNG_SKIP_sRGB_CHECK_PROFILE, PNG_OPTION_ON);
-#  endif // PNG_SKIP_sRGB_CHECK_PROFILE && PNG_SET_OPTION_SUPPORTED
-
-  // Get the image dimensions and depth...
-  png_read_info(pp, info);
-
-  width      = (int)png_get_image_width(pp, info);
-  height     = (int)png_get_image_height(pp, info);
-  color_type = png_get_color_type(pp, info);
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "PNG image dimensions are %dx%dx%d", rows.width, rows.height, rows.depth);
 
-  if (color_type & PNG_COLOR_MASK_COLOR)
-    depth = 3;
-  else
-    depth = 1;
-
-  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "PNG image dimensions are %dx%dx%d", width, height, depth);
-
-  if (width < 1 || width > job->system->max_image_width || height < 1 || height > job->system->max_image_height || (size_t)(width * height * depth) > job->system->max_image_size)
+  if (rows.width < 1 || rows.width > job->system->max_image_width || rows.height < 1 || rows.height > job->system->max_image_height)
   {
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "PNG image is too large to print.");
     papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
     goto finish_png;
   }
 
-  xdpi = (int)png_get_x_pixels_per_inch(pp, info);
-  ydpi = (int)png_get_y_pixels_per_inch(pp, info);
+  xdpi = (int)png_get_x_pixels_per_inch(rows.pp, rows.info);
+  ydpi = (int)png_get_y_pixels_per_inch(rows.pp, rows.info);
 
   papplLogJob(job, PAPPL_LOGLEVEL_INFO, "PNG image resolution is %dx%ddpi", xdpi, ydpi);
 
@@ -891,77 +964,87 @@ _papplJobFilterPNG(
     goto finish_png;
   }
 
-  // Set decoding options...
-  if (png_get_valid(pp, info, PNG_INFO_tRNS))
+  // Figure out the orientation so we know which way the image will be read...
+  if (options->orientation_requested == IPP_ORIENT_NONE)
   {
-    // Map transparency to alpha
-    png_set_tRNS_to_alpha(pp);
-    color_type |= PNG_COLOR_MASK_ALPHA;
+    if (rows.width > rows.height && options->header.cupsWidth < options->header.cupsHeight)
+    {
+      options->orientation_requested = IPP_ORIENT_LANDSCAPE;
+      papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Auto-orientation: landscape");
+    }
+    else
+    {
+      options->orientation_requested = IPP_ORIENT_PORTRAIT;
+      papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Auto-orientation: portrait");
+    }
   }
 
-#ifdef PNG_TRANSFORM_SCALE_16
-  if (png_get_bit_depth(pp, info) > 8)
-  {
-    // Scale 16-bit values to 8-bit gamma-corrected ones
-    png_set_scale_16(pp);
-    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Scaling 16-bit PNG data to 8-bits.");
-  }
-#else
-  if (png_get_bit_depth(pp, info) > 8)
-  {
-    // Strip the bottom bits of 16-bit values
-    png_set_strip_16(pp);
-    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Stripping 16-bit PNG data to 8-bits.");
-  }
-#endif // PNG_TRANSFORM_SCALE_16
+  max_memory = job->system->max_image_memory;
+  image_size = rows.rowsize * (size_t)rows.height;
 
-  if (png_get_bit_depth(pp, info) < 8)
+  if (options->orientation_requested == IPP_ORIENT_PORTRAIT && rows.passes == 1)
   {
-    // Expand 1, 2, and 4-bit values to 8 bits
-    if (depth == 1)
-      png_set_expand_gray_1_2_4_to_8(pp);
-    else
-      png_set_packing(pp);
+    // Decode the image one row at a time...
+    ret = _papplJobFilterImage(job, device, options, /*pixels*/NULL, rows.width, rows.height, rows.depth, xdpi, false, (_pappl_image_cb_t)png_read_band, &rows);
   }
-  if (color_type & PNG_COLOR_MASK_PALETTE)
+  else if (options->orientation_requested == IPP_ORIENT_PORTRAIT && (image_size > max_memory || image_size > job->system->max_image_size))
   {
-    // Convert indexed images to RGB...
-    png_set_palette_to_rgb(pp);
-  }
+    // Decode the interlaced image in bands that fit in the memory budget...
+    if ((rows.band_max = (int)(max_memory / rows.rowsize)) < 1)
+      rows.band_max = 1;
+    else if (rows.band_max > rows.height)
+      rows.band_max = rows.height;
 
-  // Remove alpha by compositing over white...
-  bg.red = bg.green = bg.blue = 65535;
-  png_set_background(pp, &bg, PNG_BACKGROUND_GAMMA_SCREEN, 0, 1);
+    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Decoding interlaced PNG image in bands of %d lines.", rows.band_max);
 
-  // Allocate memory for the image...
-  if ((pixels = (unsigned char *)calloc(1, (size_t)(width * height * depth))) == NULL)
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG image: %s", strerror(errno));
-    papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
-    goto finish_png;
-  }
+    if ((rows.band = (unsigned char *)malloc((size_t)(rows.band_max + 1) * rows.rowsize)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG image: %s", strerror(errno));
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
+      goto finish_png;
+    }
 
-  if ((rows = (png_bytep *)calloc((size_t)height, sizeof(png_bytep))) == NULL)
-  {
-    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG image: %s", strerror(errno));
-    papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
-    goto finish_png;
+    ret = _papplJobFilterImage(job, device, options, /*pixels*/NULL, rows.width, rows.height, rows.depth, xdpi, false, (_pappl_image_cb_t)png_read_band, &rows);
   }
+  else
+  {
+    // Decode the whole image into memory...
+    if (image_size > job->system->max_image_size)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "PNG image is too large to print.");
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
+      goto finish_png;
+    }
 
-  for (i = 0; i < height; i ++)
-    rows[i] = pixels + i * width * depth;
+    if ((pixels = (unsigned char *)calloc(1, image_size)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG image: %s", strerror(errno));
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_UNPRINTABLE_ERROR, PAPPL_JREASON_NONE);
+      goto finish_png;
+    }
 
-  // Read the image...
-  for (i = png_set_interlace_handling(pp); i > 0; i --)
-    png_read_rows(pp, rows, NULL, (png_uint_32)height);
+    if (setjmp(png_jmpbuf(rows.pp)))
+    {
+      // If we get here, PNG loading failed and any errors/warnings were logged
+      // via the corresponding callback functions...
+      papplJobSetReasons(job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+      goto finish_png;
+    }
 
-  // Print the image...
-  ret = papplJobFilterImage(job, device, options, pixels, width, height, depth, (int)png_get_x_pixels_per_inch(pp, info), false);
+    for (pass = 0; pass < rows.passes; pass ++)
+    {
+      for (i = 0; i < rows.height; i ++)
+        png_read_row(rows.pp, pixels + (size_t)i * rows.rowsize, NULL);
+    }
+
+    // Print the image...
+    ret = papplJobFilterImage(job, device, options, pixels, rows.width, rows.height, rows.depth, xdpi, false);
+  }
 
   // Finish up...
   finish_png:
 
-  png_destroy_read_struct(&pp, &info, NULL);
+  png_destroy_read_struct(&rows.pp, &rows.info, NULL);
 
   fclose(fp);
   fp = NULL;
@@ -969,8 +1052,8 @@ _papplJobFilterPNG(
   free(pixels);
   pixels = NULL;
 
-  free(rows);
-  rows = NULL;
+  free(rows.band);
+  rows.band = NULL;
 
   return (ret);
 }
@@ -1080,8 +1163,12 @@ _papplJobFilterRIP(
   cups_raster_t		*ras = NULL;	// Raster stream
   cups_page_header_t	header;		// Current page header
   unsigned		page = 0,	// Current page number
+			count,		// Number of lines in band
 			y;		// Current line
-  unsigned char		*line = NULL;	// Line from stream
+  unsigned char		*band = NULL,	// Band of lines from stream
+			white;		// White color
+  size_t		band_size = 0,	// Size of band buffer
+			band_needed;	// Size needed for current page
 
 
   (void)data;
@@ -1104,37 +1191,51 @@ _papplJobFilterRIP(
   {
     page ++;
 
-    if ((line = malloc(header.cupsBytesPerLine)) == NULL)
+    // Only grow the band buffer when a page has longer lines...
+    if ((band_needed = _PAPPL_RASTER_BAND * header.cupsBytesPerLine) > band_size)
     {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate %u bytes for raster lines from ipptransform: %s", header.cupsBytesPerLine, strerror(errno));
-      goto done;
+      unsigned char *temp;		// New band buffer
+
+      if ((temp = realloc(band, band_needed)) == NULL)
+      {
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate %u bytes for raster lines from ipptransform: %s", (unsigned)band_needed, strerror(errno));
+	goto done;
+      }
+
+      band      = temp;
+      band_size = band_needed;
     }
 
+    if (header.cupsColorSpace == CUPS_CSPACE_K || header.cupsColorSpace == CUPS_CSPACE_CMYK)
+      white = 0x00;
+    else
+      white = 0xff;
+
     if (!(driver_data.rstartpage_cb)(job, options, device, page))
       goto done;
 
-    for (y = 0; y < header.cupsHeight; y ++)
+    for (y = 0; y < header.cupsHeight; y += count)
     {
-      if (cupsRasterReadPixels(ras, line, header.cupsBytesPerLine) != header.cupsBytesPerLine)
+      // Read a band of lines...
+      if ((count = header.cupsHeight - y) > _PAPPL_RASTER_BAND)
+        count = _PAPPL_RASTER_BAND;
+
+      if (cupsRasterReadPixels(ras, band, count * header.cupsBytesPerLine) != (count * header.cupsBytesPerLine))
       {
-	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read page %u line %u from ipptransform.", page, y);
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read page %u lines %u to %u from ipptransform.", page, y, y + count - 1);
 	break;
       }
 
-      if (!(driver_data.rwriteline_cb)(job, options, device, y, line))
+      if (!_papplJobWriteBand(job, options, device, y, count, header.cupsBytesPerLine, band, white))
         break;
     }
 
     if (y < header.cupsHeight)
     {
       // Send blank lines for the rest of the page...
-      if (header.cupsColorSpace == CUPS_CSPACE_K || header.cupsColorSpace == CUPS_CSPACE_CMYK)
-        memset(line, 0, header.cupsBytesPerLine);
-      else
-        memset(line, 255, header.cupsBytesPerLine);
+      memset(band, white, _PAPPL_RASTER_BAND * header.cupsBytesPerLine);
 
-      for (unsigned y2 = y; y2 < header.cupsHeight; y2 ++)
-        (driver_data.rwriteline_cb)(job, options, device, y2, line);
+      _papplJobSkipLines(job, options, device, y, header.cupsHeight - y, header.cupsBytesPerLine, band);
     }
 
     if (!(driver_data.rendpage_cb)(job, options, device, page))
@@ -1142,9 +1243,6 @@ _papplJobFilterRIP(
 
     if (y < header.cupsHeight)
       goto done;
-
-    free(line);
-    line = NULL;
   }
 
   // Completed successfully...
@@ -1156,7 +1254,7 @@ _papplJobFilterRIP(
   if (!ret || papplJobIsCanceled(job))
     papplSystemStopExtCommand(job->system, xform_number);
 
-  free(line);
+  free(band);
   cupsRasterClose(ras);
   close(xform_fd);
 
@@ -1393,6 +1491,147 @@ _papplJobInspectText(
 }
 
 
+//
+// 'image_get_row()' - Get a row of the rotated image.
+//
+
+static const unsigned char *		// O - Row pixels or `NULL` on error
+image_get_row(_pappl_image_t *image,	// I - Image being filtered
+              unsigned       y)		// I - Row in rotated image
+{
+  if (image->cb)
+  {
+    // Get the row from the callback...
+    if ((image->cb)(image->cbdata, (int)y, image->band))
+      return (image->band);
+    else
+      return (NULL);
+  }
+  else if (image->orientation == IPP_ORIENT_PORTRAIT)
+  {
+    // Use the row in memory...
+    return (image->pixels + y * (size_t)image->width * (size_t)image->depth);
+  }
+
+  if (y < image->band_y || y >= (image->band_y + image->band_count))
+  {
+    // Copy the next band of rotated rows...
+    image->band_y     = y;
+    image->band_count = image->band_max;
+
+    if (image->orientation == IPP_ORIENT_LANDSCAPE || image->orientation == IPP_ORIENT_REVERSE_LANDSCAPE)
+    {
+      if (image->band_count > ((unsigned)image->width - y))
+        image->band_count = (unsigned)image->width - y;
+    }
+    else if (image->band_count > ((unsigned)image->height - y))
+    {
+      image->band_count = (unsigned)image->height - y;
+    }
+
+    _papplRasterRotate(image->band, image->pixels, (unsigned)image->width, (unsigned)image->height, (unsigned)image->depth, image->orientation, y, image->band_count);
+  }
+
+  return (image->band + (y - image->band_y) * image->band_rowsize);
+}
+
+
+//
+// 'image_render_band()' - Scale and convert a band of image lines.
+//
+
+static bool				// O - `true` on success, `false` on error
+image_render_band(
+    _pappl_image_render_t *render,	// I - Image rendering state
+    unsigned              worker,	// I - Worker number
+    unsigned              y,		// I - First line
+    unsigned              count,	// I - Number of lines
+    unsigned char         *lines)	// I - Lines in band
+{
+  _pappl_image_worker_t	*w = render->workers + worker;
+					// Worker
+  cups_page_header_t	*header = render->header;
+					// Page header
+  const unsigned char	*pixptr;	// Pointer into scaled line
+  unsigned char		*lineptr;	// Pointer into line
+  int			x,		// X position
+			depth = render->depth,
+					// Bytes per image pixel
+			bpp = render->bpp;
+					// Bytes per output pixel
+
+
+  for (; count > 0; count --, y ++, lines += header->cupsBytesPerLine)
+  {
+    if (render->job->is_canceled)
+      return (false);
+
+    if ((pixptr = _papplRasterScaleGetLine(w->scale, y - (unsigned)render->ystart)) == NULL)
+    {
+      papplLogJob(render->job, PAPPL_LOGLEVEL_ERROR, "Unable to read image line %d.", (int)y - render->ystart);
+      return (false);
+    }
+
+    memset(lines, render->white, header->cupsBytesPerLine);
+
+    if (header->cupsBitsPerPixel == 1)
+    {
+      // Need to dither the image to 1-bit black...
+      if (depth > 1)
+      {
+	// Use the first component of each pixel...
+	for (x = 0; x < render->count; x ++)
+	  w->gray[x] = pixptr[x * depth];
+
+	pixptr = w->gray;
+      }
+
+      _papplRasterDitherLine(lines, pixptr, (unsigned)render->xfirst, (unsigned)render->count, render->options->dither[y & 15], false);
+    }
+    else if (header->cupsColorSpace == CUPS_CSPACE_K)
+    {
+      // Need to invert the image...
+      for (x = 0, lineptr = lines + render->xfirst; x < render->count; x ++, pixptr += depth)
+	*lineptr++ = (unsigned char)~*pixptr;
+    }
+    else if (bpp == depth)
+    {
+      // Need to copy the image...
+      memcpy(lines + render->xfirst * bpp, pixptr, (size_t)(render->count * bpp));
+    }
+    else
+    {
+      // Need to copy the image one pixel at a time...
+      for (x = 0, lineptr = lines + render->xfirst * bpp; x < render->count; x ++, lineptr += bpp, pixptr += depth)
+	memcpy(lineptr, pixptr, (size_t)bpp);
+    }
+  }
+
+  return (true);
+}
+
+
+//
+// 'image_write_band()' - Write a band of image lines to the driver.
+//
+
+static bool				// O - `true` on success, `false` on error
+image_write_band(
+    _pappl_image_render_t *render,	// I - Image rendering state
+    unsigned              y,		// I - First line
+    unsigned              count,	// I - Number of lines
+    const unsigned char   *lines)	// I - Lines in band
+{
+  if (!_papplJobWriteBand(render->job, render->options, render->device, y, count, render->header->cupsBytesPerLine, lines, render->white))
+  {
+    papplLogJob(render->job, PAPPL_LOGLEVEL_ERROR, "Unable to write raster line %u.", y);
+    return (false);
+  }
+
+  return (true);
+}
+
+
 #ifdef HAVE_LIBJPEG
 //
 // 'jpeg_error_handler()' - Handle JPEG errors by not exiting.
@@ -1411,6 +1650,75 @@ jpeg_error_handler(j_common_ptr p)	// I - JPEG data
   // Return to the point we called setjmp()...
   longjmp(jerr->retbuf, 1);
 }
+
+
+//
+// 'jpeg_read_row()' - Read a row from a JPEG image.
+//
+// Rows are decoded sequentially, so reading an earlier row restarts the
+// decompressor from the beginning of the file.
+//
+
+static bool				// O - `true` on success, `false` on error
+jpeg_read_row(_pappl_jpeg_rows_t *rows,	// I - Row callback data
+              int                y,	// I - Row number
+              unsigned char      *row)	// I - Row buffer
+{
+  struct jpeg_decompress_struct *dinfo = rows->dinfo;
+					// Decompressor info
+  JSAMPROW		rowptr = (JSAMPROW)row;
+					// Sample row pointer
+
+
+  if (setjmp(rows->jerr->retbuf))
+  {
+    // JPEG library errors are directed to this point...
+    papplJobSetReasons(rows->job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+    papplLogJob(rows->job, PAPPL_LOGLEVEL_ERROR, "Unable to read JPEG file '%s': %s", rows->filename, rows->jerr->message);
+    return (false);
+  }
+
+  if ((JDIMENSION)y < dinfo->output_scanline)
+  {
+    // Restart from the beginning of the image...
+    jpeg_abort_decompress(dinfo);
+    rewind(rows->fp);
+
+    jpeg_stdio_src(dinfo, rows->fp);
+    jpeg_read_header(dinfo, TRUE);
+    jpeg_setup(dinfo, rows->color_space, rows->scale_num);
+    jpeg_start_decompress(dinfo);
+  }
+
+  // Decode up to and including the requested row...
+  while (dinfo->output_scanline <= (JDIMENSION)y && dinfo->output_scanline < dinfo->output_height)
+    jpeg_read_scanlines(dinfo, &rowptr, 1);
+
+  return ((JDIMENSION)y < dinfo->output_scanline);
+}
+
+
+//
+// 'jpeg_setup()' - Set the output color space and scaling for a JPEG image.
+//
+
+static void
+jpeg_setup(
+    struct jpeg_decompress_struct *dinfo,// I - Decompressor info
+    J_COLOR_SPACE                 color_space,
+					// I - Output color space
+    unsigned                      scale_num)
+					// I - Scaling numerator (denominator is 8)
+{
+  dinfo->quantize_colors      = FALSE;
+  dinfo->out_color_space      = color_space;
+  dinfo->out_color_components = color_space == JCS_GRAYSCALE ? 1 : 3;
+  dinfo->output_components    = dinfo->out_color_components;
+  dinfo->scale_num            = scale_num;
+  dinfo->scale_denom          = 8;
+
+  jpeg_calc_output_dimensions(dinfo);
+}
 #endif // HAVE_LIBJPEG
 
 
@@ -1452,6 +1760,211 @@ png_error_func(
 }
 
 
+//
+// 'png_read_band()' - Read a row from a PNG image.
+//
+// Rows of non-interlaced images are decoded sequentially, so reading an earlier
+// row restarts decoding from the beginning of the file.  Interlaced images are
+// decoded a band of rows at a time, with all of the interlace passes being read
+// for each band.
+//
+
+static bool				// O - `true` on success, `false` on error
+png_read_band(_pappl_png_rows_t *rows,	// I - PNG decoding state
+              int               y,	// I - Row number
+              unsigned char     *row)	// I - Row buffer
+{
+  int		i,			// Looping var
+		pass,			// Current interlace pass
+		band_end;		// End of band
+  unsigned char	*scratch;		// Scratch row outside band
+
+
+  if (y < 0 || y >= rows->height)
+    return (false);
+
+  if (rows->passes == 1)
+  {
+    // Non-interlaced image, restart if we need an earlier row...
+    if (y < rows->y)
+    {
+      png_destroy_read_struct(&rows->pp, &rows->info, NULL);
+      rewind(rows->fp);
+
+      if (!png_setup(rows))
+        goto read_error;
+    }
+
+    if (setjmp(png_jmpbuf(rows->pp)))
+      goto read_error;
+
+    // Decode up to and including the requested row...
+    while (rows->y <= y)
+    {
+      png_read_row(rows->pp, row, NULL);
+      rows->y ++;
+    }
+
+    return (true);
+  }
+
+  if (y < rows->band_y || y >= (rows->band_y + rows->band_count))
+  {
+    // Decode a new band of rows starting at the requested row...
+    png_destroy_read_struct(&rows->pp, &rows->info, NULL);
+    rewind(rows->fp);
+
+    if (!png_setup(rows))
+      goto read_error;
+
+    if (setjmp(png_jmpbuf(rows->pp)))
+    {
+      rows->band_count = 0;
+      goto read_error;
+    }
+
+    rows->band_y     = y;
+    rows->band_count = rows->height - y;
+    if (rows->band_count > rows->band_max)
+      rows->band_count = rows->band_max;
+
+    band_end = y + rows->band_count;
+    scratch  = rows->band + (size_t)rows->band_max * rows->rowsize;
+
+    for (pass = 0; pass < rows->passes; pass ++)
+    {
+      for (i = 0; i < rows->height; i ++)
+      {
+        if (i >= y && i < band_end)
+          png_read_row(rows->pp, rows->band + (size_t)(i - y) * rows->rowsize, NULL);
+        else if (pass < (rows->passes - 1) || i < band_end)
+          png_read_row(rows->pp, scratch, NULL);
+        else
+          break;			// No need to read past the band in the last pass
+      }
+    }
+  }
+
+  memcpy(row, rows->band + (size_t)(y - rows->band_y) * rows->rowsize, rows->rowsize);
+
+  return (true);
+
+  // If we get here, PNG loading failed and any errors/warnings were logged
+  // via the corresponding callback functions...
+  read_error:
+
+  papplJobSetReasons(rows->job, PAPPL_JREASON_DOCUMENT_FORMAT_ERROR, PAPPL_JREASON_NONE);
+
+  return (false);
+}
+
+
+//
+// 'png_setup()' - Start reading a PNG image.
+//
+// This function creates the PNG read structures, reads the image header, and
+// sets the decoding options to produce 8-bit grayscale or sRGB pixels.
+//
+
+static bool				// O - `true` on success, `false` on error
+png_setup(_pappl_png_rows_t *rows)	// I - PNG decoding state
+{
+  pappl_job_t	*job = rows->job;	// Job
+  int		color_type;		// PNG color mode
+  png_color_16	bg;			// Background color
+
+
+  // Setup PNG data structures...
+  if ((rows->pp = png_create_read_struct(PNG_LIBPNG_VER_STRING, (png_voidp)job, png_error_func, png_warning_func)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG file '%s': %s", rows->filename, strerror(errno));
+    return (false);
+  }
+
+  if ((rows->info = png_create_info_struct(rows->pp)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for PNG file '%s': %s", rows->filename, strerror(errno));
+    return (false);
+  }
+
+  if (setjmp(png_jmpbuf(rows->pp)))
+  {
+    // If we get here, PNG loading failed and any errors/warnings were logged
+    // via the corresponding callback functions...
+    return (false);
+  }
+
+  // Start reading...
+  png_init_io(rows->pp, rows->fp);
+
+#  if defined(PNG_SKIP_sRGB_CHECK_PROFILE) && defined(PNG_SET_OPTION_SUPPORTED)
+  // Don't throw errors with "invalid" sRGB profiles produced by Adobe apps.
+  png_set_option(rows->pp, PNG_SKIP_sRGB_CHECK_PROFILE, PNG_OPTION_ON);
+#  endif // PNG_SKIP_sRGB_CHECK_PROFILE && PNG_SET_OPTION_SUPPORTED
+
+  // Get the image dimensions and depth...
+  png_read_info(rows->pp, rows->info);
+
+  rows->width  = (int)png_get_image_width(rows->pp, rows->info);
+  rows->height = (int)png_get_image_height(rows->pp, rows->info);
+  color_type   = png_get_color_type(rows->pp, rows->info);
+
+  if (color_type & PNG_COLOR_MASK_COLOR)
+    rows->depth = 3;
+  else
+    rows->depth = 1;
+
+  rows->rowsize = (size_t)rows->width * (size_t)rows->depth;
+  rows->y       = 0;
+
+  // Set decoding options...
+  if (png_get_valid(rows->pp, rows->info, PNG_INFO_tRNS))
+  {
+    // Map transparency to alpha
+    png_set_tRNS_to_alpha(rows->pp);
+    color_type |= PNG_COLOR_MASK_ALPHA;
+  }
+
+#ifdef PNG_TRANSFORM_SCALE_16
+  if (png_get_bit_depth(rows->pp, rows->info) > 8)
+  {
+    // Scale 16-bit values to 8-bit gamma-corrected ones
+    png_set_scale_16(rows->pp);
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Scaling 16-bit PNG data to 8-bits.");
+  }
+#else
+  if (png_get_bit_depth(rows->pp, rows->info) > 8)
+  {
+    // Strip the bottom bits of 16-bit values
+    png_set_strip_16(rows->pp);
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Stripping 16-bit PNG data to 8-bits.");
+  }
+#endif // PNG_TRANSFORM_SCALE_16
+
+  if (png_get_bit_depth(rows->pp, rows->info) < 8)
+  {
+    // Expand 1, 2, and 4-bit values to 8 bits
+    if (rows->depth == 1)
+      png_set_expand_gray_1_2_4_to_8(rows->pp);
+    else
+      png_set_packing(rows->pp);
+  }
+  if (color_type & PNG_COLOR_MASK_PALETTE)
+  {
+    // Convert indexed images to RGB...
+    png_set_palette_to_rgb(rows->pp);
+  }
+
+  // Remove alpha by compositing over white...
+  bg.red = bg.green = bg.blue = 65535;
+  png_set_background(rows->pp, &bg, PNG_BACKGROUND_GAMMA_SCREEN, 0, 1);
+
+  rows->passes = png_set_interlace_handling(rows->pp);
+
+  return (true);
+}
+
+
 //
 // 'png_warning_func()' - PNG warning message function.
 //
@@ -46,7 +46,34 @@ _papplJobCopyAttributesNoLock(
     cups_array_t   *ra,			// I - requested-attributes
     bool           include_status)	// I - Include Job Status attributes?
 {
-  _papplCopyAttributes(client->response, job->attrs, ra, IPP_TAG_JOB, false);
+  if (job->is_evicted)
+  {
+    // Copy the attributes saved in the spool directory...
+    ipp_t	*attrs;			// Job attributes
+
+    if ((attrs = _papplJobReadAttrsNoLock(job, /*doc_number*/0)) != NULL)
+    {
+      _papplCopyAttributes(client->response, attrs, ra, IPP_TAG_JOB, false);
+      ippDelete(attrs);
+    }
+    else
+    {
+      if (!ra || cupsArrayFind(ra, "job-id"))
+	ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-id", job->job_id);
+      if (!ra || cupsArrayFind(ra, "job-name"))
+	ippAddString(client->response, IPP_TAG_JOB, IPP_TAG_NAME, "job-name", NULL, job->name);
+      if (!ra || cupsArrayFind(ra, "job-originating-user-name"))
+	ippAddString(client->response, IPP_TAG_JOB, IPP_TAG_NAME, "job-originating-user-name", NULL, job->username);
+      if (!ra || cupsArrayFind(ra, "job-printer-uri"))
+	ippAddString(client->response, IPP_TAG_JOB, IPP_TAG_URI, "job-printer-uri", NULL, job->printer_uri);
+      if (!ra || cupsArrayFind(ra, "job-uri"))
+	ippAddString(client->response, IPP_TAG_JOB, IPP_TAG_URI, "job-uri", NULL, job->uri);
+    }
+  }
+  else
+  {
+    _papplCopyAttributes(client->response, job->attrs, ra, IPP_TAG_JOB, false);
+  }
 
   if (include_status)
   {
@@ -86,11 +113,11 @@ _papplJobCopyAttributesNoLock(
   }
 
   if (include_status && (!ra || cupsArrayFind(ra, "job-impressions-completed")))
-    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", job->impcompleted);
+    ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", _papplAtomicGet(&job->impcompleted));
 
   if (!ra || cupsArrayFind(ra, "job-k-octets"))
   {
-    off_t k_octets = (job->k_octets + 1023) / 1024;
+    off_t k_octets = (_papplAtomicGet(&job->k_octets) + 1023) / 1024;
 					// Scale the value down
 
     ippAddInteger(client->response, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-k-octets", k_octets > INT_MAX ? INT_MAX : (int)k_octets);
@@ -130,10 +157,10 @@ _papplJobCopyDocumentData(
     const char     *format,		// I - Document format
     bool           last_document)	// I - Last document?
 {
-  char			filename[1024],	// Filename buffer
-			buffer[4096];	// Copy buffer
-  ssize_t		bytes,		// Bytes read
-			total = 0;	// Total bytes copied
+  _pappl_spool_t	spool;		// Spool file
+  char			*buffer;	// Spool buffer
+  size_t		bufsize;	// Free space in spool buffer
+  ssize_t		bytes;		// Bytes read
   cups_array_t		*ra;		// Attributes to send in response
 
 
@@ -141,18 +168,18 @@ _papplJobCopyDocumentData(
   // Printer, process it directly or return server-error-busy...
   if (!job->printer->output_devices && (!strcmp(format, "image/pwg-raster") || !strcmp(format, "image/urf")))
   {
-    _papplRWLockRead(job->printer);
+    _papplRWLockWrite(job->printer);
 
     // TODO: Spool raster when multiple document jobs are enabled
-    if (job->printer->processing_job)
+    if (job->printer->hold_new_jobs)
     {
-      papplClientRespondIPP(client, IPP_STATUS_ERROR_BUSY, "Currently printing another job.");
+      papplClientRespondIPP(client, IPP_STATUS_ERROR_NOT_ACCEPTING_JOBS, "Currently holding new jobs.");
       _papplRWUnlock(job->printer);
       goto abort_job;
     }
-    else if (job->printer->hold_new_jobs)
+    else if (job->printer->pool_members ? !_papplPrinterReservePoolMemberNoLock(job->printer, job) : job->printer->processing_job != NULL)
     {
-      papplClientRespondIPP(client, IPP_STATUS_ERROR_NOT_ACCEPTING_JOBS, "Currently holding new jobs.");
+      papplClientRespondIPP(client, IPP_STATUS_ERROR_BUSY, "Currently printing another job.");
       _papplRWUnlock(job->printer);
       goto abort_job;
     }
@@ -170,66 +197,54 @@ _papplJobCopyDocumentData(
   }
 
   // Create a file for the request data...
-  if ((job->fd = papplJobOpenFile(job, job->num_documents + 1, filename, sizeof(filename), client->system->directory, NULL, format, "w")) < 0)
+  if (!_papplJobSpoolOpen(&spool, job, job->num_documents + 1, format, httpIsChunked(client->http) ? 0 : (size_t)httpGetRemaining(client->http)))
   {
     papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to create print file: %s", strerror(errno));
-    papplLogClient(client, PAPPL_LOGLEVEL_DEBUG, "Print filename is '%s'.", filename);
+    papplLogClient(client, PAPPL_LOGLEVEL_DEBUG, "Print filename is '%s'.", spool.filename);
     goto abort_job;
   }
 
-  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Created job file \"%s\", format \"%s\".", filename, format);
-
-  while ((bytes = httpRead(client->http, buffer, sizeof(buffer))) > 0)
+  // Read the document data directly into the spool buffer...
+  for (;;)
   {
-    if (write(job->fd, buffer, (size_t)bytes) < bytes)
+    if ((buffer = _papplJobSpoolGetBuffer(&spool, &bufsize)) == NULL)
     {
       int error = errno;		// Write error
 
-      close(job->fd);
-      job->fd = -1;
-
-      unlink(filename);
+      _papplJobSpoolAbort(&spool);
 
       papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to write print file: %s", strerror(error));
 
       goto abort_job;
     }
 
-    total += (size_t)bytes;
+    if ((bytes = httpRead(client->http, buffer, bufsize)) <= 0)
+      break;
+
+    _papplJobSpoolCommit(&spool, (size_t)bytes);
   }
 
   if (bytes < 0)
   {
     // Got an error while reading the print data, so abort this job.
-    close(job->fd);
-    job->fd = -1;
-
-    unlink(filename);
+    _papplJobSpoolAbort(&spool);
 
     papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to read print file.");
 
     goto abort_job;
   }
 
-  if (close(job->fd))
+  if (!_papplJobSpoolClose(&spool))
   {
-    int error = errno;			// Write error
-
-    job->fd = -1;
-
-    unlink(filename);
-
-    papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to write print file: %s", strerror(error));
+    papplClientRespondIPP(client, IPP_STATUS_ERROR_INTERNAL, "Unable to write print file: %s", strerror(errno));
 
     goto abort_job;
   }
 
-  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Received %lu bytes of document data.", (unsigned long)total);
-
-  job->fd = -1;
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Received %lu bytes of document data.", (unsigned long)spool.total);
 
   // Submit the job for processing...
-  _papplJobSubmitFile(job, filename, format, client->request, last_document);
+  _papplJobSubmitFile(job, spool.filename, format, client->request, last_document);
 
   complete_job:
 
@@ -266,10 +281,7 @@ _papplJobCopyDocumentData(
   cupsArrayRemove(client->printer->active_jobs, job);
   cupsArrayAdd(client->printer->completed_jobs, job);
 
-  _papplRWLockWrite(client->system);
-  if (!client->system->clean_time)
-    client->system->clean_time = time(NULL) + 60;
-  _papplRWUnlock(client->system);
+  _papplPrinterNeedCleanNoLock(client->printer);
 
   _papplRWUnlock(job);
   _papplRWUnlock(client->printer);
@@ -741,11 +753,11 @@ copy_doc_attributes_no_lock(
   }
 
   if (!ra || cupsArrayFind(ra, "impressions-completed"))
-    ippAddInteger(client->response, IPP_TAG_DOCUMENT, IPP_TAG_INTEGER, "impressions-completed", doc->impcompleted);
+    ippAddInteger(client->response, IPP_TAG_DOCUMENT, IPP_TAG_INTEGER, "impressions-completed", _papplAtomicGet(&doc->impcompleted));
 
   if (!ra || cupsArrayFind(ra, "k-octets"))
   {
-    off_t k_octets = (doc->k_octets + 1023) / 1024;
+    off_t k_octets = (_papplAtomicGet(&doc->k_octets) + 1023) / 1024;
 					// Scale the value down
 
     ippAddInteger(client->response, IPP_TAG_DOCUMENT, IPP_TAG_INTEGER, "k-octets", k_octets > INT_MAX ? INT_MAX : (int)k_octets);
@@ -1220,25 +1232,26 @@ ipp_fetch_document(
       // Send the HTTP header and document data...
       if (papplClientRespond(client, HTTP_STATUS_OK, /*compression*/NULL, "application/ipp", /*last_modified*/0, /*length*/0))
       {
-	// Open the document file and copy it to the client...
-	int		fd;		// File descriptor
+	// Open the document file and copy it to the client, decompressing
+	// documents that have been compressed in the spool directory...
+	cups_file_t	*fp;		// Document file
 	char		buffer[16384];	// Buffer
 	ssize_t	bytes;		// Bytes read
 
-	if ((fd = open(doc->filename, O_RDONLY | O_BINARY)) >= 0)
+	if ((fp = cupsFileOpen(doc->filename, "r")) != NULL)
 	{
-	  _PAPPL_DEBUG("ipp_fetch_document: open(\"%s\")=%d\n", doc->filename, fd);
+	  _PAPPL_DEBUG("ipp_fetch_document: cupsFileOpen(\"%s\")=%p\n", doc->filename, fp);
 
 	  if (!strcmp(compression, "gzip"))
 	    httpSetField(client->http, HTTP_FIELD_CONTENT_ENCODING, "gzip");
 
-	  while ((bytes = read(fd, buffer, sizeof(buffer))) > 0)
+	  while ((bytes = cupsFileRead(fp, buffer, sizeof(buffer))) > 0)
 	  {
 	    papplLogClient(client, PAPPL_LOGLEVEL_DEBUG, "Writing %ld bytes of document data.", (long)bytes);
 	    (void)httpWrite(client->http, buffer, (size_t)bytes);
 	  }
 
-	  close(fd);
+	  cupsFileClose(fp);
 	}
 
 	// Send a 0-length chunk...
@@ -1340,6 +1353,8 @@ ipp_get_document_attributes(
     return;
   }
 
+  _papplJobLoadAttrs(job);
+
   _papplRWLockRead(job);
 
   if ((doc_number = ippGetInteger(attr, 0)) < 1 || doc_number > job->num_documents)
@@ -1383,6 +1398,8 @@ ipp_get_documents(
     return;
   }
 
+  _papplJobLoadAttrs(job);
+
   _papplRWLockRead(job);
 
   if ((limit = ippGetInteger(ippFindAttribute(client->request, "limit", IPP_TAG_INTEGER), 0)) <= 0)
@@ -1693,7 +1710,7 @@ ipp_update_document_status(
 	  }
 	  else
 	  {
-	    doc->impcompleted = ippGetInteger(attr, 0);
+	    _papplAtomicSet(&doc->impcompleted, ippGetInteger(attr, 0));
 	    events |= PAPPL_EVENT_DOCUMENT_STATE_CHANGED;
 	  }
         }
@@ -1803,7 +1820,7 @@ ipp_update_job_status(
 	}
 	else
 	{
-	  job->impcompleted = ippGetInteger(attr, 0);
+	  _papplAtomicSet(&job->impcompleted, ippGetInteger(attr, 0));
 	  events |= PAPPL_EVENT_JOB_STATE_CHANGED;
 	}
       }
@@ -1826,6 +1843,11 @@ ipp_update_job_status(
 
 	  if (!printer->max_preserved_jobs && !job->retain_until)
 	    _papplJobRemoveFiles(job);
+	  else
+	  {
+	    _papplJobSpillFilesNoLock(job);
+	    _papplJobQueueCompressNoLock(job);
+	  }
 
 	  if (printer->is_stopped)
 	  {
@@ -1844,10 +1866,9 @@ ipp_update_job_status(
 	  cupsArrayRemove(printer->active_jobs, job);
 	  cupsArrayAdd(printer->completed_jobs, job);
 
-	  printer->impcompleted += job->impcompleted;
+	  _papplAtomicAdd(&printer->impcompleted, _papplAtomicGet(&job->impcompleted));
 
-	  if (!job->system->clean_time)
-	    job->system->clean_time = time(NULL) + 60;
+	  _papplPrinterNeedCleanNoLock(printer);
 
 	  events |= PAPPL_EVENT_JOB_COMPLETED;
 	}
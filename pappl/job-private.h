@@ -13,6 +13,7 @@
 #  include "base-private.h"
 #  include "job.h"
 #  include "log.h"
+#  include "system.h"
 
 
 //
@@ -20,28 +21,80 @@
 //
 
 #  define _PAPPL_MAX_DOCUMENTS	1000	// Maximum number of documents per job
+#  define _PAPPL_RASTER_BAND	16	// Number of lines in a raster band
+#  define _PAPPL_SPOOL_ALIGN	4096	// Alignment of spool write buffers
+#  define _PAPPL_SPOOL_BUFSIZE	262144	// Size of spool write buffers
 
 
 //
 // Types and structures...
 //
 
+typedef enum _pappl_prerip_e		// Look-ahead (pre-RIP) states
+{
+  _PAPPL_PRERIP_NONE,				// No look-ahead output
+  _PAPPL_PRERIP_RUNNING,			// Look-ahead processing in progress
+  _PAPPL_PRERIP_READY,				// Look-ahead output is ready to print
+  _PAPPL_PRERIP_DISCARD,			// Discard look-ahead output when done
+  _PAPPL_PRERIP_FAILED				// Look-ahead processing failed
+} _pappl_prerip_t;
+
 typedef struct _pappl_doc_s		// Document data
 {
   ipp_t			*attrs;			// Template/Description attributes
+  const ipp_uchar_t	*attrs_data;		// Encoded attributes in binary state file, if not yet loaded
+  size_t		attrs_datalen;		// Length of encoded attributes
   char			*filename;		// Filename
-  const char		*format;		// "document-format" value (from attrs)
+  const char		*format;		// "document-format" value (pooled)
   ipp_dstate_t		state;			// "document-state" value
   pappl_jreason_t	state_reasons;		// "document-state-reasons" values
   int			impressions,		// "impressions" value
 			impcolor,		// "impressions-col.full-color" value
-			impcompleted;		// "impressions-completed" value
-  off_t			k_octets;		// "k-octets" value
+			impcompleted;		// "impressions-completed" value (atomic)
+  off_t			k_octets;		// "k-octets" value (atomic)
   time_t		created,		// "[date-]time-at-creation" value
 			processing,		// "[date-]time-at-processing" value
 			completed;		// "[date-]time-at-completed" value
 } _pappl_doc_t;
 
+typedef bool (*_pappl_image_cb_t)(void *cbdata, int y, unsigned char *row);
+					// Image row callback
+
+typedef struct _pappl_sfile_s		// Shared (content-addressed) document file
+{
+  char			*filename;		// Filename
+  char			*format;		// Document format
+  uint64_t		hash;			// Hash of document data
+  size_t		length,			// Length of document data
+			refcount;		// Number of references
+  bool			hashed,			// Is the hash valid?
+			inspected;		// Have the impressions been counted?
+  int			impressions,		// "impressions" value
+			impcolor;		// "impressions-col.full-color" value
+} _pappl_sfile_t;
+
+typedef struct _pappl_spool_s		// Document spool file
+{
+  pappl_job_t		*job;			// Job
+  int			doc_number;		// Document number
+  const char		*format;		// Document format
+  int			fd;			// Spool file descriptor
+  bool			in_memory;		// Is the file in the memory spool directory?
+  size_t		memmax;			// Maximum size of memory spool file
+  pappl_spool_sync_t	sync;			// Synchronization policy
+  char			*buffer;		// Write buffer
+  size_t		bufused;		// Bytes in write buffer
+  size_t		total,			// Total bytes received
+			written;		// Bytes written to the spool file
+  int			pipefds[2];		// Pipe for splice(), if any
+  bool			no_splice;		// Don't use splice()?
+  uint64_t		hash;			// Hash of document data
+  unsigned char		hashbuf[8];		// Partial word for hash
+  size_t		hashlen;		// Bytes in partial word
+  bool			no_hash;		// Data not seen (spliced), don't hash
+  char			filename[1024];		// Spool filename
+} _pappl_spool_t;
+
 struct _pappl_job_s			// Job data
 {
   cups_rwlock_t		rwlock;			// Reader/writer lock
@@ -49,13 +102,19 @@ struct _pappl_job_s			// Job data
   pappl_printer_t	*printer;		// Containing printer
   int			job_id;			// "job-id" value
   _pappl_odevice_t	*output_device;		// "output-device-assigned" value
-  const char		*name,			// "job-name" value
-			*username,		// "job-originating-user-name" value
-			*uri,			// "job-uri" value
-			*printer_uri;		// "job-printer-uri" value
+  pappl_printer_t	*pool_member;		// Pool member printing the job, if any
+  char			*name;			// "job-name" value
+  const char		*username;		// "job-originating-user-name" value (pooled)
+  char			*uri;			// "job-uri" value
+  const char		*printer_uri;		// "job-printer-uri" value (pooled)
   char			*log_prefix;		// Log message prefix
   ipp_jstate_t		state;			// "job-state" value
   pappl_jreason_t	state_reasons;		// "job-state-reasons" values
+  int			priority;		// "job-priority" value
+  size_t		sched_index;		// Position in scheduling heap, if any
+  time_t		timer_time;		// Time of next hold/retain timer, if any
+  size_t		timer_index;		// Position in timer heap, if any
+  size_t		state_changes;		// Change number of last saved state change
   bool			is_canceled;		// Has this job been canceled?
   char			*message;		// "job-state-message" value
   pappl_loglevel_t	msglevel;		// "job-state-message" log level
@@ -65,22 +124,31 @@ struct _pappl_job_s			// Job data
 			hold_until,		// "job-hold-until[-time]" value
 			retain_until;		// "job-retain-until[-interval,-time]" value
   int			copies,			// "copies" value
-			copcompleted,		// "copies-completed" value
+			copcompleted,		// "copies-completed" value (atomic)
 			impressions,		// "job-impressions" value
 			impcolor,		// "job-impressions-col.full-color" value
-			impcompleted;		// "job-impressions-completed" value
-  off_t			k_octets;		// "job-k-octets" value
+			impcompleted;		// "job-impressions-completed" value (atomic)
+  off_t			k_octets;		// "job-k-octets" value (atomic)
   bool			is_color;		// Do the pages contain color data?
   ipp_t			*attrs;			// Static attributes
-  int			num_documents;		// Number of documents
-  _pappl_doc_t		documents[_PAPPL_MAX_DOCUMENTS];
-						// Documents
+  bool			is_evicted;		// Are the attributes saved in the spool directory?
+  time_t		access_time;		// Time attributes were last accessed (atomic)
+  int			num_documents,		// Number of documents
+			alloc_documents;	// Allocated documents
+  _pappl_doc_t		*documents;		// Documents
   int			fd;			// Print file descriptor
   bool			streaming;		// Streaming job?
   void			*data;			// Per-job driver data
   cups_mutex_t		proxy_mutex;		// Mutex for proxy connectio9
   http_t		*proxy_http;		// Connection to Infrastructure Printer for status updates
   char			*proxy_resource;	// Resource path for connection
+  _pappl_prerip_t	prerip_state;		// Look-ahead state
+  cups_mutex_t		prerip_mutex;		// Mutex for look-ahead state changes
+  cups_cond_t		prerip_cond;		// Condition for look-ahead state changes
+  char			*prerip_filename;	// Look-ahead (device-ready) output file
+  off_t			prerip_size;		// Size of look-ahead output file
+  int			prerip_copcompleted,	// Copies completed by look-ahead processing (atomic)
+			prerip_impcompleted;	// Impressions completed by look-ahead processing (atomic)
 };
 
 
@@ -88,6 +156,7 @@ struct _pappl_job_s			// Job data
 // Functions...
 //
 
+extern _pappl_doc_t	*_papplJobAddDocumentNoLock(pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		_papplJobCancelNoLock(pappl_job_t *job) _PAPPL_PRIVATE;
 extern int		_papplJobCompareActive(pappl_job_t *a, pappl_job_t *b) _PAPPL_PRIVATE;
 extern int		_papplJobCompareAll(pappl_job_t *a, pappl_job_t *b) _PAPPL_PRIVATE;
@@ -98,6 +167,9 @@ extern void		_papplJobCopyStateNoLock(pappl_job_t *job, ipp_tag_t group_tag, ipp
 extern void		_papplJobCopyStateReasonsNoLock(pappl_job_t *job, ipp_t *ipp, ipp_tag_t group_tag, const char *attrname, ipp_jstate_t state, pappl_jreason_t state_reasons) _PAPPL_PRIVATE;
 extern pappl_job_t	*_papplJobCreate(pappl_printer_t *printer, int job_id, const char *username, const char *job_name, ipp_t *attrs) _PAPPL_PRIVATE;
 extern void		_papplJobDelete(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobDiscardPreRIPNoLock(pappl_job_t *job) _PAPPL_PRIVATE;
+extern bool		_papplJobEvictNoLock(pappl_job_t *job) _PAPPL_PRIVATE;
+extern bool		_papplJobFilterImage(pappl_job_t *job, pappl_device_t *device, pappl_pr_options_t *options, const unsigned char *pixels, int width, int height, int depth, int ppi, bool smoothing, _pappl_image_cb_t cb, void *cbdata) _PAPPL_PRIVATE;
 #  ifdef HAVE_LIBJPEG
 extern bool		_papplJobFilterJPEG(pappl_job_t *job, int doc_number, pappl_pr_options_t *options, pappl_device_t *device, void *data) _PAPPL_PRIVATE;
 #  endif // HAVE_LIBJPEG
@@ -106,6 +178,8 @@ extern bool		_papplJobFilterPNG(pappl_job_t *job, int doc_number, pappl_pr_optio
 #  endif // HAVE_LIBPNG
 extern bool		_papplJobFilterRIP(pappl_job_t *job, int doc_number, pappl_pr_options_t *options, pappl_device_t *device, void *data) _PAPPL_PRIVATE;
 extern bool		_papplJobFilterTransform(pappl_job_t *job, int doc_number, pappl_pr_options_t *options, pappl_device_t *device, const char *outformat) _PAPPL_PRIVATE;
+extern void		_papplJobFree(pappl_job_t *job) _PAPPL_PRIVATE;
+extern bool		_papplJobGetSharedImpressions(pappl_job_t *job, const char *filename, int *impressions, int *impcolor) _PAPPL_PRIVATE;
 extern bool		_papplJobHoldNoLock(pappl_job_t *job, const char *username, const char *until, time_t until_time) _PAPPL_PRIVATE;
 #  ifdef HAVE_LIBJPEG
 extern bool		_papplJobInspectJPEG(pappl_job_t *job, int doc_number, int *total_pages, int *color_pages, void *data);
@@ -115,19 +189,40 @@ extern bool		_papplJobInspectPDF(pappl_job_t *job, int doc_number, int *total_pa
 extern bool		_papplJobInspectPNG(pappl_job_t *job, int doc_number, int *total_pages, int *color_pages, void *data);
 #  endif // HAVE_LIBPNG
 extern bool		_papplJobInspectText(pappl_job_t *job, int doc_number, int *total_pages, int *color_pages, void *data);
+extern void		_papplJobLoadAttrs(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		*_papplJobPreRIP(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobPreRIPDone(pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		*_papplJobProcess(pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		_papplJobProcessIPP(pappl_client_t *client) _PAPPL_PRIVATE;
 extern void		_papplJobProcessRaster(pappl_job_t *job, pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplJobQueueCompressNoLock(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobQueueFree(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobQueueRemove(pappl_job_t *job, const char *filename) _PAPPL_PRIVATE;
+extern ipp_t		*_papplJobReadAttrsNoLock(pappl_job_t *job, int doc_number) _PAPPL_PRIVATE;
 extern const char	*_papplJobReasonString(pappl_jreason_t reason) _PAPPL_PRIVATE;
 extern pappl_jreason_t	_papplJobReasonValue(const char *reason) _PAPPL_PRIVATE;
 extern void		_papplJobReleaseNoLock(pappl_job_t *job, const char *username) _PAPPL_PRIVATE;
+extern bool		_papplJobReleaseSharedFile(pappl_job_t *job, const char *filename) _PAPPL_PRIVATE;
 extern void		_papplJobRemoveFiles(pappl_job_t *job) _PAPPL_PRIVATE;
+extern bool		_papplJobRemoveMemoryFile(pappl_job_t *job, const char *filename) _PAPPL_PRIVATE;
 extern bool		_papplJobRetainNoLock(pappl_job_t *job, const char *username, const char *until, int until_interval, time_t until_time) _PAPPL_PRIVATE;
+extern void		_papplJobRetainSharedFile(pappl_job_t *job, const char *filename) _PAPPL_PRIVATE;
 extern void		_papplJobSetRetainNoLock(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobSetSharedImpressions(pappl_job_t *job, const char *filename, int impressions, int impcolor) _PAPPL_PRIVATE;
 extern void		_papplJobSetState(pappl_job_t *job, ipp_jstate_t state) _PAPPL_PRIVATE;
 extern void		_papplJobSetStateNoLock(pappl_job_t *job, ipp_jstate_t state) _PAPPL_PRIVATE;
+extern bool		_papplJobSkipLines(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, unsigned count, size_t bytes_per_line, const unsigned char *blank) _PAPPL_PRIVATE;
+extern bool		_papplJobSpillFilesNoLock(pappl_job_t *job) _PAPPL_PRIVATE;
+extern void		_papplJobSpoolAbort(_pappl_spool_t *spool) _PAPPL_PRIVATE;
+extern bool		_papplJobSpoolClose(_pappl_spool_t *spool) _PAPPL_PRIVATE;
+extern void		_papplJobSpoolCommit(_pappl_spool_t *spool, size_t bytes) _PAPPL_PRIVATE;
+extern char		*_papplJobSpoolGetBuffer(_pappl_spool_t *spool, size_t *bufsize) _PAPPL_PRIVATE;
+extern bool		_papplJobSpoolOpen(_pappl_spool_t *spool, pappl_job_t *job, int doc_number, const char *format, size_t length) _PAPPL_PRIVATE;
+extern ssize_t		_papplJobSpoolRecv(_pappl_spool_t *spool, int sock, size_t bytes) _PAPPL_PRIVATE;
+extern bool		_papplJobSpoolWrite(_pappl_spool_t *spool, const void *data, size_t bytes) _PAPPL_PRIVATE;
 extern void		_papplJobSubmitFile(pappl_job_t *job, const char *filename, const char *format, ipp_t *attrs, bool last_document) _PAPPL_PRIVATE;
 extern bool		_papplJobValidateDocumentAttributes(pappl_client_t *client, const char **format) _PAPPL_PRIVATE;
+extern bool		_papplJobWriteBand(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, unsigned count, size_t bytes_per_line, const unsigned char *lines, unsigned char white) _PAPPL_PRIVATE;
 
 
 #endif // !_PAPPL_JOB_PRIVATE_H_
@@ -17,7 +17,10 @@
 static const char *cups_cspace_string(cups_cspace_t cspace);
 static bool	filter_raw(pappl_job_t *job, int doc_number, pappl_pr_options_t *options, pappl_device_t *device);
 static void	finish_job(pappl_job_t *job);
+static bool	print_prerip(pappl_job_t *job, pappl_device_t *device);
+static bool	render_job(pappl_job_t *job, pappl_device_t *device, bool prerip);
 static bool	start_job(pappl_job_t *job);
+static bool	write_lines(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, unsigned count, size_t bytes_per_line, const unsigned char *lines);
 
 
 //
@@ -61,6 +64,8 @@ papplJobCreatePrintOptions(
   if (!job || doc_number < 0 || doc_number > job->num_documents)
     return (NULL);
 
+  _papplJobLoadAttrs(job);
+
   papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Getting options for num_pages=%u, color=%s", num_pages, color ? "true" : "false");
 
   // Clear all options...
@@ -545,139 +550,163 @@ papplJobDeletePrintOptions(
 
 
 //
-// '_papplJobProcess()' - Process a print job.
+// '_papplJobPreRIP()' - Process a pending job ahead of time.
+//
+// This function runs the inspectors and filters for a pending job, saving the
+// device-ready output to a spool file that is later sent to the printer by
+// `_papplJobProcess`.
 //
 
 void *					// O - Thread exit status
-_papplJobProcess(pappl_job_t *job)	// I - Job
+_papplJobPreRIP(pappl_job_t *job)	// I - Job
 {
-  bool			started = false;// Have we started the job?
-  int			copy,		// Current (collated) copy
-			doc_number;	// Current document number
-  _pappl_doc_t		*doc;		// Current document
-  _pappl_mime_filter_t	*filter;	// Filter for printing
-  _pappl_mime_inspector_t *inspector;	// Inspector for file format
-  pappl_pr_driver_data_t driver_data;	// Printer driver data
-  pappl_pr_options_t	*options[_PAPPL_MAX_DOCUMENTS + 1];
-					// Print options
-
+  pappl_printer_t	*printer = job->printer;
+					// Printer
+  bool			ret = false;	// Did processing succeed?
+  int			fd;		// Output file descriptor
+  char			filename[1024] = "",
+					// Output filename
+			uri[1024];	// Output device URI
+  pappl_device_t	*device;	// Output device
+  struct stat		fileinfo;	// Output file information
 
-  memset(options, 0, sizeof(options));
 
-  // Start processing the job...
-  if (start_job(job))
+  // Create the output file and open it as a device...
+  if ((fd = papplJobOpenFile(job, 0, filename, sizeof(filename), /*directory*/NULL, "rip", /*format*/NULL, "w")) < 0)
   {
-    // Get driver data...
-    papplPrinterGetDriverData(papplJobGetPrinter(job), &driver_data);
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create look-ahead file: %s", strerror(errno));
+  }
+  else
+  {
+    close(fd);
 
-    // Prepare options...
-    for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+    httpAssembleURI(HTTP_URI_CODING_ALL, uri, sizeof(uri), "file", /*userpass*/NULL, /*host*/NULL, 0, filename);
+
+    if ((device = papplDeviceOpen(uri, job, papplLogDevice, job->system)) != NULL)
     {
-      if (!doc->impressions && (inspector = _papplSystemFindMIMEInspector(job->system, doc->format)) != NULL)
-	(inspector->cb)(job, doc_number, &doc->impressions, &doc->impcolor, inspector->cbdata);
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Starting look-ahead processing.");
 
-      options[doc_number] = papplJobCreatePrintOptions(job, doc_number, (unsigned)doc->impressions, doc->impcolor >= doc->impressions);
+      ret = render_job(job, device, true);
 
-      if (doc->impcolor >= doc->impressions)
-        job->is_color = true;
+      papplDeviceClose(device);
     }
 
-    options[0] = papplJobCreatePrintOptions(job, 0, (unsigned)job->impressions, job->is_color);
+    if (stat(filename, &fileinfo))
+      ret = false;
+  }
 
-    if (!(driver_data.rstartjob_cb)(job, options[0], job->printer->device))
-    {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start raster job.");
-      goto abort_job;
-    }
+  // Keep or discard the output...
+  _papplRWLockWrite(printer);
+  _papplRWLockWrite(job);
 
-    started = true;
+  if (ret && job->prerip_state == _PAPPL_PRERIP_RUNNING && !job->is_canceled && (job->state == IPP_JSTATE_PENDING || job->state == IPP_JSTATE_PROCESSING) && !printer->is_deleted)
+  {
+    size_t	size = 0;		// Disk space used by other look-ahead output
+    pappl_job_t	*next;			// Next job
 
-    for (copy = 0; copy < options[0]->copies; copy ++)
+    for (next = (pappl_job_t *)cupsArrayGetFirst(printer->active_jobs); next; next = (pappl_job_t *)cupsArrayGetNext(printer->active_jobs))
     {
-      for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents && job->state != IPP_JSTATE_ABORTED; doc_number ++, doc ++)
-      {
-        // Skip canceled documents...
-        if (doc->state >= IPP_DSTATE_CANCELED)
-          continue;
-
-        if (!doc->processing)
-          doc->processing = time(NULL);
-
-        doc->state = IPP_DSTATE_PROCESSING;
-
-        _papplPrinterUpdateProxyDocument(job->printer, job, doc_number);
-
-	// Do file-specific conversions...
-	papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Processing document %d/%d...", doc_number, job->num_documents);
-
-	if ((filter = _papplSystemFindMIMEFilter(job->system, doc->format, job->printer->driver_data.format)) == NULL)
-	  filter =_papplSystemFindMIMEFilter(job->system, doc->format, "image/pwg-raster");
-
-	if (filter)
-	{
-	  // Filter as needed...
-	  if (!(filter->cb)(job, doc_number, options[doc_number], job->printer->device, filter->cbdata))
-	    goto abort_job;
-	}
-	else if (job->printer->driver_data.format && job->printer->driver_data.printfile_cb && !strcmp(doc->format, job->printer->driver_data.format))
-	{
-	  // Send file raw...
-	  if (!filter_raw(job, doc_number, options[doc_number], job->printer->device))
-	    goto abort_job;
-	}
-	else
-	{
-	  // Abort a job we can't process...
-	  papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to process job with format '%s'.", doc->format);
-	  goto abort_job;
-	}
-
-	// TODO: Send blank page when options->handling is PAPPL_HANDLING_SINGLE_DOCUMENT_NEW_SHEET and we have an odd number of sheets
-      }
-
-      papplJobSetCopiesCompleted(job, 1);
+      if (next->prerip_state == _PAPPL_PRERIP_READY)
+        size += (size_t)next->prerip_size;
     }
 
-    // End the job...
-    started = false;
-    if (!(driver_data.rendjob_cb)(job, options[0], job->printer->device))
+    if (printer->lookahead_size > 0 && (size + (size_t)fileinfo.st_size) > printer->lookahead_size)
     {
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to end raster job.");
-      goto abort_job;
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Look-ahead output (%ld bytes) exceeds the disk limit.", (long)fileinfo.st_size);
+      ret = false;
     }
-
-    // Free options and set document states...
-    for (doc_number = 0, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+    else
     {
-      papplJobDeletePrintOptions(options[doc_number]);
-      doc->state     = IPP_DSTATE_COMPLETED;
-      doc->completed = time(NULL);
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Look-ahead output (%ld bytes) is ready.", (long)fileinfo.st_size);
 
-      _papplPrinterUpdateProxyDocument(job->printer, job, doc_number);
+      job->prerip_filename = strdup(filename);
+      job->prerip_size     = fileinfo.st_size;
+      job->prerip_state    = _PAPPL_PRERIP_READY;
     }
   }
+  else
+  {
+    ret = false;
+  }
 
-  // Move the job to a completed state...
-  finish_job(job);
+  if (!ret)
+  {
+    // Discard the output, the job will be processed normally...
+    if (filename[0])
+      unlink(filename);
+
+    job->prerip_state        = job->prerip_state == _PAPPL_PRERIP_DISCARD ? _PAPPL_PRERIP_NONE : _PAPPL_PRERIP_FAILED;
+    job->prerip_copcompleted = 0;
+    job->prerip_impcompleted = 0;
+  }
+
+  _papplRWUnlock(job);
+
+  _papplJobPreRIPDone(job);
+
+  printer->lookahead_job = NULL;
+
+  // Start the next job as needed...
+  _papplPrinterCheckJobsNoLock(printer);
+
+  _papplRWUnlock(printer);
 
   return (NULL);
+}
 
-  // If we get here something went wrong...
-  abort_job:
 
-  job->state = IPP_JSTATE_ABORTED;
+//
+// '_papplJobPreRIPDone()' - Wake up threads waiting for look-ahead processing
+//                           of a job to finish.
+//
+// This function must be called after changing the look-ahead state from
+// `_PAPPL_PRERIP_RUNNING` or `_PAPPL_PRERIP_DISCARD` to any other state.
+//
 
-  if (started)
-    (driver_data.rendjob_cb)(job, options[0], job->printer->device);
+void
+_papplJobPreRIPDone(pappl_job_t *job)	// I - Job
+{
+  cupsMutexLock(&job->prerip_mutex);
+  cupsCondBroadcast(&job->prerip_cond);
+  cupsMutexUnlock(&job->prerip_mutex);
+}
 
-  // Free options and set document states...
-  for (doc_number = 0, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+
+//
+// '_papplJobProcess()' - Process a print job.
+//
+
+void *					// O - Thread exit status
+_papplJobProcess(pappl_job_t *job)	// I - Job
+{
+  bool		prerip;			// Do we have look-ahead output?
+  _pappl_prerip_t prerip_state;		// Look-ahead state
+  pappl_device_t *device;		// Output device
+
+
+  // Start processing the job...
+  if (start_job(job))
   {
-    papplJobDeletePrintOptions(options[doc_number]);
-    doc->state     = IPP_DSTATE_ABORTED;
-    doc->completed = time(NULL);
+    // Pool jobs are printed using the member printer's device, which uses the
+    // same driver as the pool printer...
+    device = job->pool_member ? job->pool_member->device : job->printer->device;
 
-    _papplPrinterUpdateProxyDocument(job->printer, job, doc_number);
+    // Wait for any look-ahead processing of this job to finish...
+    cupsMutexLock(&job->prerip_mutex);
+
+    while ((prerip_state = _papplAtomicGet(&job->prerip_state)) == _PAPPL_PRERIP_RUNNING || prerip_state == _PAPPL_PRERIP_DISCARD)
+      cupsCondWait(&job->prerip_cond, &job->prerip_mutex, 0.0);
+
+    cupsMutexUnlock(&job->prerip_mutex);
+
+    _papplRWLockRead(job);
+    prerip = job->prerip_state == _PAPPL_PRERIP_READY;
+    _papplRWUnlock(job);
+
+    if (prerip)
+      print_prerip(job, device);
+    else
+      render_job(job, device, false);
   }
 
   // Move the job to a completed state...
@@ -698,23 +727,31 @@ _papplJobProcessRaster(
 {
   pappl_printer_t	*printer = job->printer;
 					// Printer for job
-  pappl_pr_options_t	*options = NULL;// Job options
+  pappl_pr_options_t	*options = NULL,// Job options for current page
+			*job_options[2] = { NULL, NULL };
+					// Job options for grayscale and color pages
   cups_raster_t		*ras = NULL;	// Raster stream
   cups_page_header_t	header;		// Page header
   unsigned		header_pages;	// Number of pages from page header
-  const unsigned char	*dither;	// Dither line
-  unsigned char		*pixels,	// Incoming pixel line
-			*pixptr,	// Pixel pointer in line
-			*line,		// Output (bitmap) line
-			*lineptr,	// Pointer in line
-			byte,		// Byte in line
-			bit;		// Current bit
+  unsigned char		*scratch = NULL,// Scratch buffer for lines
+			*pixels,	// Incoming pixel line
+			*band,		// Band of output lines
+			*bandline,	// Current line in band
+			white;		// White color
+  size_t		bpl,		// Bytes per output line
+			scratch_size = 0,
+					// Size of scratch buffer
+			scratch_needed;	// Size needed for current page
+  bool			color,		// Is the current page in color?
+			dither;		// Dither to 1-bit?
   unsigned		page = 0,	// Current page
-			x,		// Current column
+			width,		// Width of dithered line
+			count,		// Number of lines in band
 			y;		// Current line
   int			job_pages_per_set;
 					// "job-pages-per-set" value, if any
   unsigned		next_copy;	// Next copy boundary
+  pappl_device_t	*device;	// Output device
 
 
   // Start processing the job...
@@ -723,6 +760,8 @@ _papplJobProcessRaster(
   if (!start_job(job))
     goto complete_job;
 
+  device = job->pool_member ? job->pool_member->device : printer->device;
+
   // Open the raster stream...
   if ((ras = cupsRasterOpenIO((cups_raster_cb_t)httpRead, client->http, CUPS_RASTER_READ)) == NULL)
   {
@@ -756,14 +795,20 @@ _papplJobProcessRaster(
   if ((header_pages = header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]) > 0 && job_pages_per_set == 0)
     papplJobSetImpressions(job, (int)header.cupsInteger[CUPS_RASTER_PWG_TotalPageCount]);
 
-  if ((options = papplJobCreatePrintOptions(job, 0, (unsigned)job->impressions, header.cupsBitsPerPixel > 8)) == NULL)
+  // The print options only depend on the job and whether a page is in color,
+  // so they are created once for each and copied for every page...
+  color = header.cupsBitsPerPixel > 8;
+
+  if ((job_options[color] = papplJobCreatePrintOptions(job, 0, (unsigned)job->impressions, color)) == NULL || (options = malloc(sizeof(pappl_pr_options_t))) == NULL)
   {
     papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create options for job.");
     job->state = IPP_JSTATE_ABORTED;
     goto complete_job;
   }
 
-  if (!(printer->driver_data.rstartjob_cb)(job, options, job->printer->device))
+  *options = *job_options[color];
+
+  if (!(printer->driver_data.rstartjob_cb)(job, options, device))
   {
     job->state = IPP_JSTATE_ABORTED;
     goto complete_job;
@@ -782,8 +827,16 @@ _papplJobProcessRaster(
     papplSystemAddEvent(printer->system, printer, job, PAPPL_EVENT_JOB_PROGRESS, NULL);
 
     // Set options for this page...
-    papplJobDeletePrintOptions(options);
-    options = papplJobCreatePrintOptions(job, 0, (unsigned)job->impressions, header.cupsBitsPerPixel > 8);
+    color = header.cupsBitsPerPixel > 8;
+
+    if (!job_options[color] && (job_options[color] = papplJobCreatePrintOptions(job, 0, (unsigned)job->impressions, color)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create options for job.");
+      job->state = IPP_JSTATE_ABORTED;
+      break;
+    }
+
+    *options = *job_options[color];
 
     if (header.cupsWidth == 0 || header.cupsHeight == 0 || (header.cupsBitsPerColor != 1 && header.cupsBitsPerColor != 8) || header.cupsColorOrder != CUPS_ORDER_CHUNKED || (header.cupsBytesPerLine != ((header.cupsWidth * header.cupsBitsPerPixel + 7) / 8)))
     {
@@ -804,109 +857,89 @@ _papplJobProcessRaster(
     if (options->header.cupsBitsPerPixel >= 8 && header.cupsBitsPerPixel >= 8)
       options->header = header;		// Use page header from client
 
-    if (!(printer->driver_data.rstartpage_cb)(job, options, job->printer->device, page))
+    if (!(printer->driver_data.rstartpage_cb)(job, options, device, page))
     {
       job->state = IPP_JSTATE_ABORTED;
       break;
     }
 
-    if (options->header.cupsBytesPerLine > header.cupsBytesPerLine)
-    {
-      // Allocate enough space for the entire output line and clear to white
-      if ((pixels = malloc(options->header.cupsBytesPerLine)) == NULL)
-      {
-        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
-	job->state = IPP_JSTATE_ABORTED;
-	break;
-      }
+    // Allocate a band of output lines and clear it to white...
+    bpl    = options->header.cupsBytesPerLine;
+    dither = header.cupsBitsPerPixel == 8 && options->header.cupsBitsPerPixel == 1;
 
-      if (options->header.cupsColorSpace == CUPS_CSPACE_K)
-        memset(pixels, 0, options->header.cupsBytesPerLine);
-      else
-        memset(pixels, 255, options->header.cupsBytesPerLine);
-    }
+    if (dither)
+      white = 0x00;
+    else if (header.cupsColorSpace == CUPS_CSPACE_K || header.cupsColorSpace == CUPS_CSPACE_CMYK)
+      white = 0x00;
     else
+      white = 0xff;
+
+    // The input line and output band are kept in a scratch buffer that is
+    // only reallocated when a page needs more memory...
+    scratch_needed = header.cupsBytesPerLine + _PAPPL_RASTER_BAND * bpl;
+
+    if (scratch_needed > scratch_size)
     {
-      // The input raster is at least as wide as the output raster...
-      if ((pixels = malloc(header.cupsBytesPerLine)) == NULL)
+      unsigned char *temp;		// New scratch buffer
+
+      if ((temp = realloc(scratch, scratch_needed)) == NULL)
       {
-        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
 	job->state = IPP_JSTATE_ABORTED;
 	break;
       }
+
+      scratch      = temp;
+      scratch_size = scratch_needed;
     }
 
-    if ((line = malloc(options->header.cupsBytesPerLine)) == NULL)
-    {
-      free(pixels);
+    pixels = scratch;
+    band   = scratch + header.cupsBytesPerLine;
 
-      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate raster line.");
-      job->state = IPP_JSTATE_ABORTED;
-      break;
-    }
+    memset(band, white, _PAPPL_RASTER_BAND * bpl);
 
-    for (y = 0; !job->is_canceled && y < header.cupsHeight && y < options->header.cupsHeight; y ++)
+    if ((width = header.cupsWidth) > options->header.cupsWidth)
+      width = options->header.cupsWidth;
+
+    // Read lines into the band and send full bands to the driver...
+    for (y = 0, count = 0; !job->is_canceled && y < header.cupsHeight && y < options->header.cupsHeight; y ++)
     {
-      if (cupsRasterReadPixels(ras, pixels, header.cupsBytesPerLine))
+      bandline = band + count * bpl;
+
+      if (dither)
       {
-        if (header.cupsBitsPerPixel == 8 && options->header.cupsBitsPerPixel == 1)
-        {
-          // Dither the line...
-	  dither = options->dither[y & 15];
-	  memset(line, 0, options->header.cupsBytesPerLine);
+        // Dither the line...
+        if (!cupsRasterReadPixels(ras, pixels, header.cupsBytesPerLine))
+          break;
 
-          if (header.cupsColorSpace == CUPS_CSPACE_K)
-          {
-            // Black...
-	    for (x = 0, lineptr = line, pixptr = pixels, bit = 128, byte = 0; x < header.cupsWidth; x ++, pixptr ++)
-	    {
-	      if (*pixptr > dither[x & 15])
-	        byte |= bit;
-
-	      if (bit == 1)
-	      {
-	        *lineptr++ = byte;
-	        byte       = 0;
-	        bit        = 128;
-	      }
-	      else
-	        bit /= 2;
-	    }
-
-	    if (bit < 128)
-	      *lineptr = byte;
-	  }
-	  else
-	  {
-	    // Grayscale to black...
-	    for (x = 0, lineptr = line, pixptr = pixels, bit = 128, byte = 0; x < header.cupsWidth; x ++, pixptr ++)
-	    {
-	      if (*pixptr <= dither[x & 15])
-	        byte |= bit;
-
-	      if (bit == 1)
-	      {
-	        *lineptr++ = byte;
-	        byte       = 0;
-	        bit        = 128;
-	      }
-	      else
-	        bit /= 2;
-	    }
-
-	    if (bit < 128)
-	      *lineptr = byte;
-	  }
-
-          (printer->driver_data.rwriteline_cb)(job, options, job->printer->device, y, line);
-        }
-        else
-          (printer->driver_data.rwriteline_cb)(job, options, job->printer->device, y, pixels);
+	memset(bandline + (width + 7) / 8, 0, bpl - (width + 7) / 8);
+
+        _papplRasterDitherLine(bandline, pixels, 0, width, options->dither[y & 15], header.cupsColorSpace == CUPS_CSPACE_K);
       }
-      else
+      else if (header.cupsBytesPerLine > bpl)
+      {
+        // Copy the part of the line that fits...
+        if (!cupsRasterReadPixels(ras, pixels, header.cupsBytesPerLine))
+          break;
+
+        memcpy(bandline, pixels, bpl);
+      }
+      else if (!cupsRasterReadPixels(ras, bandline, header.cupsBytesPerLine))
+      {
+        // The rest of the output line stays white...
         break;
+      }
+
+      if ((++ count) == _PAPPL_RASTER_BAND)
+      {
+        _papplJobWriteBand(job, options, device, y + 1 - count, count, bpl, band, white);
+        count = 0;
+      }
     }
 
+    if (count > 0)
+      _papplJobWriteBand(job, options, device, y - count, count, bpl, band, white);
+
     if (!job->is_canceled && y < header.cupsHeight)
     {
       // Discard excess lines from client...
@@ -919,35 +952,16 @@ _papplJobProcessRaster(
     else
     {
       // Pad missing lines with whitespace...
-      if (header.cupsBitsPerPixel == 8 && options->header.cupsBitsPerPixel == 1)
+      if (y < options->header.cupsHeight)
       {
-        memset(line, 0, options->header.cupsBytesPerLine);
+        memset(band, white, _PAPPL_RASTER_BAND * bpl);
 
-        while (y < options->header.cupsHeight)
-        {
-	  (printer->driver_data.rwriteline_cb)(job, options, job->printer->device, y, line);
-          y ++;
-        }
-      }
-      else
-      {
-        if (header.cupsColorSpace == CUPS_CSPACE_K || header.cupsColorSpace == CUPS_CSPACE_CMYK)
-          memset(pixels, 0x00, header.cupsBytesPerLine);
-	else
-          memset(pixels, 0xff, header.cupsBytesPerLine);
-
-        while (y < options->header.cupsHeight)
-        {
-	  (printer->driver_data.rwriteline_cb)(job, options, job->printer->device, y, pixels);
-          y ++;
-        }
+        _papplJobSkipLines(job, options, device, y, options->header.cupsHeight - y, bpl, band);
+        y = options->header.cupsHeight;
       }
     }
 
-    free(pixels);
-    free(line);
-
-    if (!(printer->driver_data.rendpage_cb)(job, options, job->printer->device, page))
+    if (!(printer->driver_data.rendpage_cb)(job, options, device, page))
     {
       job->state = IPP_JSTATE_ABORTED;
       break;
@@ -981,14 +995,17 @@ _papplJobProcessRaster(
     papplJobSetCopiesCompleted(job, 1);
   }
 
-  if (!(printer->driver_data.rendjob_cb)(job, options, job->printer->device))
+  if (!(printer->driver_data.rendjob_cb)(job, options, device))
     job->state = IPP_JSTATE_ABORTED;
   else if (header_pages == 0 && job_pages_per_set == 0)
     papplJobSetImpressions(job, (int)page);
 
   complete_job:
 
-  papplJobDeletePrintOptions(options);
+  papplJobDeletePrintOptions(job_options[0]);
+  papplJobDeletePrintOptions(job_options[1]);
+  free(options);
+  free(scratch);
 
   if (httpGetState(client->http) == HTTP_STATE_POST_RECV)
   {
@@ -1030,11 +1047,54 @@ papplJobResume(pappl_job_t     *job,	// I - Job
   _papplRWUnlock(job);
 
   _papplRWLockWrite(job->printer);
+  _papplPrinterQueueJobNoLock(job->printer, job);
   _papplPrinterCheckJobsNoLock(job->printer);
   _papplRWUnlock(job->printer);
 }
 
 
+//
+// '_papplJobSkipLines()' - Skip blank raster lines using the driver callbacks.
+//
+// This function calls the driver's `rskiplines_cb` function when provided and
+// otherwise writes the lines using the "blank" band, which must contain
+// `_PAPPL_RASTER_BAND` blank lines.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplJobSkipLines(
+    pappl_job_t         *job,		// I - Job
+    pappl_pr_options_t  *options,	// I - Print options
+    pappl_device_t      *device,	// I - Output device
+    unsigned            y,		// I - First line
+    unsigned            count,		// I - Number of lines
+    size_t              bytes_per_line,	// I - Bytes per line
+    const unsigned char *blank)		// I - Band of blank lines
+{
+  pappl_pr_driver_data_t *data = &job->printer->driver_data;
+					// Printer driver data
+  unsigned		n;		// Number of lines in band
+
+
+  if (count == 0)
+    return (true);
+
+  if (data->rskiplines_cb)
+    return ((data->rskiplines_cb)(job, options, device, y, count));
+
+  for (; count > 0; count -= n, y += n)
+  {
+    if ((n = count) > _PAPPL_RASTER_BAND)
+      n = _PAPPL_RASTER_BAND;
+
+    if (!write_lines(job, options, device, y, n, bytes_per_line, blank))
+      return (false);
+  }
+
+  return (true);
+}
+
+
 //
 // 'papplJobSuspend()' - Temporarily stop processing of a job.
 //
@@ -1060,6 +1120,64 @@ papplJobSuspend(pappl_job_t     *job,	// I - Job
 }
 
 
+//
+// '_papplJobWriteBand()' - Write a band of raster lines using the driver callbacks.
+//
+// This function calls the driver's `rwriteband_cb` function when provided and
+// otherwise calls the `rwriteline_cb` function for each line in the band.
+// When the driver provides a `rskiplines_cb` function, runs of blank lines are
+// passed to it instead.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplJobWriteBand(
+    pappl_job_t         *job,		// I - Job
+    pappl_pr_options_t  *options,	// I - Print options
+    pappl_device_t      *device,	// I - Output device
+    unsigned            y,		// I - First line
+    unsigned            count,		// I - Number of lines
+    size_t              bytes_per_line,	// I - Bytes per line
+    const unsigned char *lines,		// I - Lines in band
+    unsigned char       white)		// I - White value
+{
+  pappl_pr_driver_data_t *data = &job->printer->driver_data;
+					// Printer driver data
+  unsigned		i,		// Current line
+			first;		// First line in run
+  bool			blank = false,	// Is the current run blank?
+			line_blank;	// Is the current line blank?
+
+
+  if (!data->rskiplines_cb)
+    return (write_lines(job, options, device, y, count, bytes_per_line, lines));
+
+  // Write runs of non-blank lines and skip runs of blank lines...
+  for (i = 0, first = 0; i <= count; i ++)
+  {
+    line_blank = i < count && _papplRasterIsBlank(lines + i * bytes_per_line, bytes_per_line, white);
+
+    if (i > first && (i == count || line_blank != blank))
+    {
+      if (blank)
+      {
+        if (!(data->rskiplines_cb)(job, options, device, y + first, i - first))
+          return (false);
+      }
+      else if (!write_lines(job, options, device, y + first, i - first, bytes_per_line, lines + first * bytes_per_line))
+      {
+        return (false);
+      }
+
+      first = i;
+    }
+
+    blank = line_blank;
+  }
+
+  return (true);
+}
+
+
 //
 // 'cups_cspace_string()' - Get a string corresponding to a cupsColorSpace enum value.
 //
@@ -1174,6 +1292,10 @@ finish_job(pappl_job_t  *job)		// I - Job
 {
   pappl_printer_t *printer = job->printer;
 					// Printer
+  pappl_printer_t *dprinter = job->pool_member ? job->pool_member : printer;
+					// Printer with the output device
+  bool		delete_printer,	// Delete the printer?
+		delete_dprinter;	// Delete the output printer?
   static const char * const job_states[] =
   {
     "Pending",
@@ -1187,6 +1309,8 @@ finish_job(pappl_job_t  *job)		// I - Job
 
 
   _papplRWLockWrite(printer);
+  if (dprinter != printer)
+    _papplRWLockWrite(dprinter);
   _papplRWLockWrite(job);
 
   if (job->is_canceled)
@@ -1194,7 +1318,7 @@ finish_job(pappl_job_t  *job)		// I - Job
   else if (job->state == IPP_JSTATE_PROCESSING)
     job->state = IPP_JSTATE_COMPLETED;
 
-  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "%s, job-impressions-completed=%d.", job_states[job->state - IPP_JSTATE_PENDING], job->impcompleted);
+  papplLogJob(job, PAPPL_LOGLEVEL_INFO, "%s, job-impressions-completed=%d.", job_states[job->state - IPP_JSTATE_PENDING], _papplAtomicGet(&job->impcompleted));
 
   if (job->state >= IPP_JSTATE_CANCELED)
     job->completed = time(NULL);
@@ -1213,37 +1337,66 @@ finish_job(pappl_job_t  *job)		// I - Job
 
   _papplJobSetRetainNoLock(job);
 
-  printer->processing_job = NULL;
+  dprinter->processing_job = NULL;
 
   if (job->state >= IPP_JSTATE_CANCELED && !printer->max_preserved_jobs && !job->retain_until)
     _papplJobRemoveFiles(job);
+  else if (job->state >= IPP_JSTATE_CANCELED)
+  {
+    // Keep the documents in the spool directory, compressed...
+    _papplJobSpillFilesNoLock(job);
+    _papplJobQueueCompressNoLock(job);
+  }
 
   _papplSystemAddEventNoLock(job->system, job->printer, job, PAPPL_EVENT_JOB_COMPLETED, NULL);
 
-  if (printer->is_stopped)
+  if (dprinter->is_stopped)
   {
     // New printer-state is 'stopped'...
-    printer->state      = IPP_PSTATE_STOPPED;
-    printer->is_stopped = false;
+    dprinter->state      = IPP_PSTATE_STOPPED;
+    dprinter->is_stopped = false;
   }
   else
   {
     // New printer-state is 'idle'...
-    printer->state = IPP_PSTATE_IDLE;
+    dprinter->state = IPP_PSTATE_IDLE;
   }
 
-  printer->state_time = time(NULL);
+  dprinter->state_time = time(NULL);
 
+  if (dprinter != printer)
+  {
+    // Update the pool state based on the remaining members...
+    printer->pool_processing --;
+
+    if (printer->state != IPP_PSTATE_STOPPED)
+    {
+      printer->state      = printer->pool_processing > 0 ? IPP_PSTATE_PROCESSING : IPP_PSTATE_IDLE;
+      printer->state_time = time(NULL);
+    }
+
+    job->pool_member = NULL;
+  }
+
+  _papplPrinterUnqueueJobNoLock(printer, job);
   cupsArrayRemove(printer->active_jobs, job);
   cupsArrayAdd(printer->completed_jobs, job);
 
-  printer->impcompleted += job->impcompleted;
+  _papplAtomicAdd(&printer->impcompleted, _papplAtomicGet(&job->impcompleted));
 
-  if (!job->system->clean_time)
-    job->system->clean_time = time(NULL) + 60;
+  _papplPrinterNeedCleanNoLock(printer);
 
   _papplRWUnlock(job);
 
+  delete_printer  = printer->is_deleted && printer->pool_processing == 0;
+  delete_dprinter = dprinter != printer && dprinter->is_deleted;
+
+  if (dprinter != printer)
+  {
+    _papplSystemAddEventNoLock(dprinter->system, dprinter, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED, NULL);
+    _papplRWUnlock(dprinter);
+  }
+
   _papplSystemAddEventNoLock(printer->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED, NULL);
 
 // TODO: Is this necessary since we do it from the main loop?
@@ -1252,30 +1405,52 @@ finish_job(pappl_job_t  *job)		// I - Job
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
+  _papplSystemObjectChanged(printer->system, &job->state_changes);
 
-  if (papplPrinterIsDeleted(printer))
+  if (delete_printer)
   {
     papplPrinterDelete(printer);
+
+    if (dprinter == printer)
+      dprinter = NULL;
+
     printer = NULL;
   }
-  else if (!strncmp(printer->device_uri, "file:", 5) || cupsArrayGetCount(printer->active_jobs) == 0 || !printer->driver_data.keep_device_open)
+
+  if (dprinter && !delete_dprinter && (!strncmp(dprinter->device_uri, "file:", 5) || papplPrinterGetNumberOfActiveJobs(printer) == 0 || !dprinter->driver_data.keep_device_open))
   {
     // Close device and report IO metrics...
     pappl_devmetrics_t	metrics;	// Metrics for device IO
 
-    _papplRWLockWrite(printer);
+    _papplRWLockWrite(dprinter);
 
-    papplDeviceGetMetrics(printer->device, &metrics);
+    papplDeviceGetMetrics(dprinter->device, &metrics);
     papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Device read metrics: %lu requests, %lu bytes, %lu msecs", (unsigned long)metrics.read_requests, (unsigned long)metrics.read_bytes, (unsigned long)metrics.read_msecs);
     papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Device write metrics: %lu requests, %lu bytes, %lu msecs", (unsigned long)metrics.write_requests, (unsigned long)metrics.write_bytes, (unsigned long)metrics.write_msecs);
 
-//    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Closing device for job %d.", job->job_id);
+//    papplLogPrinter(dprinter, PAPPL_LOGLEVEL_DEBUG, "Closing device for job %d.", job->job_id);
 
-    papplDeviceClose(printer->device);
-    printer->device = NULL;
+    papplDeviceClose(dprinter->device);
+    dprinter->device = NULL;
 
-    _papplRWUnlock(printer);
+    _papplRWUnlock(dprinter);
+  }
+
+  if (dprinter && dprinter != printer)
+  {
+    // Delete the pool member as needed, otherwise let it process its own
+    // jobs...
+    if (delete_dprinter)
+    {
+      papplPrinterDelete(dprinter);
+    }
+    else if (papplPrinterGetNumberOfActiveJobs(dprinter) > 0)
+    {
+      _papplRWLockWrite(dprinter);
+      _papplPrinterCheckJobsNoLock(dprinter);
+      _papplRWUnlock(dprinter);
+    }
   }
 
   if (papplPrinterGetNumberOfActiveJobs(printer) > 0)
@@ -1284,6 +1459,247 @@ finish_job(pappl_job_t  *job)		// I - Job
     _papplPrinterCheckJobsNoLock(printer);
     _papplRWUnlock(printer);
   }
+
+  // Let the pool (if any) use this printer...
+  if (printer && dprinter == printer)
+    _papplPrinterCheckPoolJobs(printer);
+}
+
+
+//
+// 'print_prerip()' - Send look-ahead output for a job to the printer.
+//
+
+static bool				// O - `true` on success, `false` otherwise
+print_prerip(pappl_job_t    *job,	// I - Job
+             pappl_device_t *device)	// I - Output device
+{
+  bool		ret = true;		// Return value
+  int		fd;			// Look-ahead file
+  ssize_t	bytes;			// Bytes read
+  char		buffer[65536];		// Copy buffer
+  int		doc_number;		// Current document number
+  _pappl_doc_t	*doc;			// Current document
+
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Sending look-ahead output to printer.");
+
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    if (doc->state >= IPP_DSTATE_CANCELED)
+      continue;
+
+    doc->processing = time(NULL);
+    doc->state      = IPP_DSTATE_PROCESSING;
+
+    _papplPrinterUpdateProxyDocument(job->printer, job, doc_number);
+  }
+
+  if ((fd = open(job->prerip_filename, O_RDONLY | O_NOFOLLOW | O_CLOEXEC | O_BINARY)) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open look-ahead file: %s", strerror(errno));
+    ret = false;
+  }
+  else
+  {
+    while (!papplJobIsCanceled(job) && (bytes = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+      if (papplDeviceWrite(device, buffer, (size_t)bytes) < 0)
+      {
+        papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to send look-ahead output to printer.");
+        ret = false;
+        break;
+      }
+    }
+
+    close(fd);
+
+    papplDeviceFlush(device);
+  }
+
+  // Apply the progress from the look-ahead processing and remove the output...
+  _papplRWLockWrite(job);
+
+  if (ret)
+  {
+    _papplAtomicAdd(&job->copcompleted, _papplAtomicGet(&job->prerip_copcompleted));
+    _papplAtomicAdd(&job->impcompleted, _papplAtomicGet(&job->prerip_impcompleted));
+  }
+  else
+  {
+    job->state = IPP_JSTATE_ABORTED;
+  }
+
+  unlink(job->prerip_filename);
+  free(job->prerip_filename);
+
+  job->prerip_filename     = NULL;
+  job->prerip_size         = 0;
+  job->prerip_copcompleted = 0;
+  job->prerip_impcompleted = 0;
+  job->prerip_state        = _PAPPL_PRERIP_NONE;
+
+  _papplRWUnlock(job);
+
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    if (doc->state >= IPP_DSTATE_CANCELED)
+      continue;
+
+    doc->state     = ret ? IPP_DSTATE_COMPLETED : IPP_DSTATE_ABORTED;
+    doc->completed = time(NULL);
+
+    _papplPrinterUpdateProxyDocument(job->printer, job, doc_number);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'render_job()' - Inspect and filter the documents in a job.
+//
+// When "prerip" is `true`, the job and document states are left alone so that
+// the output can be produced ahead of time.
+//
+
+static bool				// O - `true` on success, `false` otherwise
+render_job(pappl_job_t    *job,		// I - Job
+           pappl_device_t *device,	// I - Output device
+           bool           prerip)	// I - Look-ahead processing?
+{
+  bool			ret = false,	// Return value
+			started = false;// Have we started the job?
+  int			copy,		// Current (collated) copy
+			doc_number;	// Current document number
+  _pappl_doc_t		*doc;		// Current document
+  _pappl_mime_filter_t	*filter;	// Filter for printing
+  _pappl_mime_inspector_t *inspector;	// Inspector for file format
+  pappl_pr_driver_data_t driver_data;	// Printer driver data
+  pappl_pr_options_t	*options[_PAPPL_MAX_DOCUMENTS + 1];
+					// Print options
+
+
+  memset(options, 0, sizeof(options));
+
+  // Get driver data...
+  papplPrinterGetDriverData(papplJobGetPrinter(job), &driver_data);
+
+  // Prepare options...
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    if (!doc->impressions && !_papplJobGetSharedImpressions(job, doc->filename, &doc->impressions, &doc->impcolor) && (inspector = _papplSystemFindMIMEInspector(job->system, doc->format)) != NULL)
+    {
+      // Inspect the document and save the results for other jobs that share
+      // the same document file...
+      if ((inspector->cb)(job, doc_number, &doc->impressions, &doc->impcolor, inspector->cbdata))
+        _papplJobSetSharedImpressions(job, doc->filename, doc->impressions, doc->impcolor);
+    }
+
+    options[doc_number] = papplJobCreatePrintOptions(job, doc_number, (unsigned)doc->impressions, doc->impcolor >= doc->impressions);
+
+    if (doc->impcolor >= doc->impressions)
+      job->is_color = true;
+  }
+
+  options[0] = papplJobCreatePrintOptions(job, 0, (unsigned)job->impressions, job->is_color);
+
+  if (!(driver_data.rstartjob_cb)(job, options[0], device))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to start raster job.");
+    goto done;
+  }
+
+  started = true;
+
+  for (copy = 0; copy < options[0]->copies; copy ++)
+  {
+    for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents && job->state != IPP_JSTATE_ABORTED; doc_number ++, doc ++)
+    {
+      // Skip canceled documents...
+      if (doc->state >= IPP_DSTATE_CANCELED)
+	continue;
+
+      if (prerip && papplJobIsCanceled(job))
+        goto done;
+
+      if (!prerip)
+      {
+	if (!doc->processing)
+	  doc->processing = time(NULL);
+
+	doc->state = IPP_DSTATE_PROCESSING;
+
+	_papplPrinterUpdateProxyDocument(job->printer, job, doc_number);
+      }
+
+      // Do file-specific conversions...
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Processing document %d/%d...", doc_number, job->num_documents);
+
+      if ((filter = _papplSystemFindMIMEFilter(job->system, doc->format, job->printer->driver_data.format)) == NULL)
+	filter =_papplSystemFindMIMEFilter(job->system, doc->format, "image/pwg-raster");
+
+      if (filter)
+      {
+	// Filter as needed...
+	if (!(filter->cb)(job, doc_number, options[doc_number], device, filter->cbdata))
+	  goto done;
+      }
+      else if (job->printer->driver_data.format && job->printer->driver_data.printfile_cb && !strcmp(doc->format, job->printer->driver_data.format))
+      {
+	// Send file raw...
+	if (!filter_raw(job, doc_number, options[doc_number], device))
+	  goto done;
+      }
+      else
+      {
+	// Abort a job we can't process...
+	papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to process job with format '%s'.", doc->format);
+	goto done;
+      }
+
+      // TODO: Send blank page when options->handling is PAPPL_HANDLING_SINGLE_DOCUMENT_NEW_SHEET and we have an odd number of sheets
+    }
+
+    papplJobSetCopiesCompleted(job, 1);
+  }
+
+  // End the job...
+  started = false;
+  if (!(driver_data.rendjob_cb)(job, options[0], device))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to end raster job.");
+    goto done;
+  }
+
+  ret = true;
+
+  // Clean up, aborting the job if something went wrong...
+  done:
+
+  if (!ret && !prerip)
+    job->state = IPP_JSTATE_ABORTED;
+
+  if (started)
+    (driver_data.rendjob_cb)(job, options[0], device);
+
+  // Free options and set document states...
+  papplJobDeletePrintOptions(options[0]);
+
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    papplJobDeletePrintOptions(options[doc_number]);
+
+    if (!prerip)
+    {
+      doc->state     = ret ? IPP_DSTATE_COMPLETED : IPP_DSTATE_ABORTED;
+      doc->completed = time(NULL);
+
+      _papplPrinterUpdateProxyDocument(job->printer, job, doc_number);
+    }
+  }
+
+  return (ret);
 }
 
 
@@ -1297,6 +1713,8 @@ start_job(pappl_job_t *job)		// I - Job
   bool		ret = false;		// Return value
   pappl_printer_t *printer = job->printer;
 					// Printer
+  pappl_printer_t *dprinter = job->pool_member ? job->pool_member : printer;
+					// Printer with the output device
   bool		first_open = true;	// Is this the first time we try to open the device?
 
 
@@ -1306,9 +1724,11 @@ start_job(pappl_job_t *job)		// I - Job
 
   papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Starting print job.");
 
-  job->state              = IPP_JSTATE_PROCESSING;
-  job->processing         = time(NULL);
-  printer->processing_job = job;
+  job->state      = IPP_JSTATE_PROCESSING;
+  job->processing = time(NULL);
+
+  if (dprinter == printer)
+    printer->processing_job = job;	// Pool members are reserved by the pool
 
   if (printer->proxy_infra_uri && ippFindAttribute(job->attrs, "parent-job-id", IPP_TAG_INTEGER))
   {
@@ -1338,46 +1758,61 @@ start_job(pappl_job_t *job)		// I - Job
 
   _papplRWUnlock(job);
 
+  if (dprinter != printer)
+  {
+    // Open the pool member's device without holding the pool lock so that
+    // other members can start jobs...
+    papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Printing on '%s'.", dprinter->name);
+
+    printer->state      = IPP_PSTATE_PROCESSING;
+    printer->state_time = time(NULL);
+
+    _papplSystemAddEventNoLock(printer->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED, NULL);
+
+    _papplRWUnlock(printer);
+    _papplRWLockWrite(dprinter);
+  }
+
   // Open the output device...
-  if (printer->device_in_use)
+  if (dprinter->device_in_use)
   {
     papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Waiting for device to become available.");
 
-    while (printer->device_in_use && !printer->is_deleted && !job->is_canceled && papplSystemIsRunning(printer->system))
+    while (dprinter->device_in_use && !dprinter->is_deleted && !job->is_canceled && papplSystemIsRunning(dprinter->system))
     {
-      _papplRWUnlock(printer);
+      _papplRWUnlock(dprinter);
       sleep(1);
-      _papplRWLockWrite(printer);
+      _papplRWLockWrite(dprinter);
     }
   }
 
-  while (!printer->device && !printer->is_deleted && !job->is_canceled && papplSystemIsRunning(printer->system))
+  while (!dprinter->device && !dprinter->is_deleted && !job->is_canceled && papplSystemIsRunning(dprinter->system))
   {
-    printer->device = papplDeviceOpen(printer->device_uri, job, papplLogDevice, job->system);
+    dprinter->device = papplDeviceOpen(dprinter->device_uri, job, papplLogDevice, job->system);
 
-    if (!printer->device && !printer->is_deleted && !job->is_canceled)
+    if (!dprinter->device && !dprinter->is_deleted && !job->is_canceled)
     {
       // Log that the printer is unavailable then sleep for 5 seconds to retry.
       if (first_open)
       {
-        papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to open device '%s', pausing queue until printer becomes available.", printer->device_uri);
+        papplLogPrinter(dprinter, PAPPL_LOGLEVEL_ERROR, "Unable to open device '%s', pausing queue until printer becomes available.", dprinter->device_uri);
         first_open = false;
 
-	printer->state      = IPP_PSTATE_STOPPED;
-	printer->state_time = time(NULL);
+	dprinter->state      = IPP_PSTATE_STOPPED;
+	dprinter->state_time = time(NULL);
       }
       else
       {
-        papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Still unable to open device.");
+        papplLogPrinter(dprinter, PAPPL_LOGLEVEL_DEBUG, "Still unable to open device.");
       }
 
-      _papplRWUnlock(printer);
+      _papplRWUnlock(dprinter);
       sleep(5);
-      _papplRWLockWrite(printer);
+      _papplRWLockWrite(dprinter);
     }
   }
 
-  if (!papplSystemIsRunning(printer->system))
+  if (!papplSystemIsRunning(dprinter->system))
   {
     job->state = IPP_JSTATE_PENDING;
 
@@ -1385,24 +1820,66 @@ start_job(pappl_job_t *job)		// I - Job
     _papplSystemAddEventNoLock(job->system, job->printer, job, PAPPL_EVENT_JOB_STATE_CHANGED, NULL);
     _papplRWUnlock(job);
 
-    if (printer->device)
+    if (dprinter->device)
     {
-      papplDeviceClose(printer->device);
-      printer->device = NULL;
+      papplDeviceClose(dprinter->device);
+      dprinter->device = NULL;
     }
   }
 
-  if (printer->device)
+  if (dprinter->device)
   {
     // Move the printer to the 'processing' state...
-    printer->state      = IPP_PSTATE_PROCESSING;
-    printer->state_time = time(NULL);
-    ret                 = true;
+    dprinter->state      = IPP_PSTATE_PROCESSING;
+    dprinter->state_time = time(NULL);
+    ret                  = true;
+
+    // Start processing the next pending job ahead of time, as needed...
+    if (dprinter == printer)
+      _papplPrinterCheckLookAheadNoLock(printer);
   }
 
-  _papplSystemAddEventNoLock(printer->system, printer, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED, NULL);
+  _papplSystemAddEventNoLock(dprinter->system, dprinter, NULL, PAPPL_EVENT_PRINTER_STATE_CHANGED, NULL);
 
-  _papplRWUnlock(printer);
+  _papplRWUnlock(dprinter);
+
+  if (ret && dprinter != printer)
+  {
+    _papplRWLockWrite(printer);
+    _papplPrinterCheckLookAheadNoLock(printer);
+    _papplRWUnlock(printer);
+  }
 
   return (ret);
 }
+
+
+//
+// 'write_lines()' - Write raster lines using the driver's band or line callback.
+//
+
+static bool				// O - `true` on success, `false` on error
+write_lines(
+    pappl_job_t         *job,		// I - Job
+    pappl_pr_options_t  *options,	// I - Print options
+    pappl_device_t      *device,	// I - Output device
+    unsigned            y,		// I - First line
+    unsigned            count,		// I - Number of lines
+    size_t              bytes_per_line,	// I - Bytes per line
+    const unsigned char *lines)		// I - Lines
+{
+  pappl_pr_driver_data_t *data = &job->printer->driver_data;
+					// Printer driver data
+
+
+  if (data->rwriteband_cb)
+    return ((data->rwriteband_cb)(job, options, device, y, count, lines));
+
+  for (; count > 0; count --, y ++, lines += bytes_per_line)
+  {
+    if (!(data->rwriteline_cb)(job, options, device, y, lines))
+      return (false);
+  }
+
+  return (true);
+}
@@ -0,0 +1,1757 @@
+//
+// Job spool functions for the Printer Application Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "pappl-private.h"
+
+
+//
+// Local functions...
+//
+
+static bool	can_compress(pappl_system_t *system, _pappl_doc_t *doc);
+static int	compare_hashes(_pappl_sfile_t *a, _pappl_sfile_t *b, void *data);
+static int	compare_names(_pappl_sfile_t *a, _pappl_sfile_t *b, void *data);
+static bool	compress_file(pappl_system_t *system, const char *srcfile, const char *dstfile);
+static bool	copy_file(int dstfd, const char *srcfile, size_t length);
+static bool	flush_buffer(_pappl_spool_t *spool);
+static void	free_buffers(_pappl_spool_t *spool);
+static void	free_sfile(_pappl_sfile_t *sfile, void *data);
+static void	hash_data(_pappl_spool_t *spool, const char *data, size_t bytes);
+static uint64_t	hash_word(uint64_t hash, const unsigned char *word);
+static bool	init_shared(pappl_system_t *system);
+static bool	queue_file(pappl_system_t *system, const char *filename);
+static void	reap_queued(pappl_system_t *system);
+static void	release_memory(pappl_system_t *system, size_t bytes);
+static bool	reserve_memory(pappl_system_t *system, size_t bytes);
+static bool	same_contents(_pappl_spool_t *spool, const char *filename);
+static void	share_file(_pappl_spool_t *spool);
+static bool	spill_file(pappl_job_t *job, int doc_number, _pappl_doc_t *doc);
+static bool	spool_disk(_pappl_spool_t *spool);
+static bool	sync_file(_pappl_spool_t *spool, bool closing);
+static bool	unshare_file(pappl_system_t *system, const char *filename);
+static bool	write_all(int fd, const void *data, size_t bytes);
+
+
+//
+// '_papplJobGetSharedImpressions()' - Get the impressions for a shared document file.
+//
+// This function gets the impression counts saved for a shared document file
+// by a previous job so that the document does not need to be inspected again.
+// `false` is returned if the file is not shared or has not been inspected.
+//
+
+bool					// O - `true` if the impressions are known, `false` otherwise
+_papplJobGetSharedImpressions(
+    pappl_job_t *job,			// I - Job
+    const char  *filename,		// I - Document filename
+    int         *impressions,		// O - Number of impressions
+    int         *impcolor)		// O - Number of color impressions
+{
+  bool		ret = false;		// Return value
+  pappl_system_t *system = job->system;	// System
+  _pappl_sfile_t key,			// Search key
+		*sfile;			// Shared file
+
+
+  if (!filename)
+    return (false);
+
+  key.filename = (char *)filename;
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->spool_files && (sfile = (_pappl_sfile_t *)cupsArrayFind(system->spool_files, &key)) != NULL && sfile->inspected)
+  {
+    *impressions = sfile->impressions;
+    *impcolor    = sfile->impcolor;
+    ret          = true;
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  return (ret);
+}
+
+
+//
+// '_papplJobQueueCompressNoLock()' - Queue a job's documents for compression.
+//
+// This function is called for jobs that keep their documents after printing.
+// The documents are compressed by the background spool thread while the
+// system is running.
+//
+
+void
+_papplJobQueueCompressNoLock(
+    pappl_job_t *job)			// I - Job
+{
+  pappl_system_t	*system = job->system;
+					// System
+  _pappl_spool_work_t	*work;		// Work item
+
+
+  if (job->num_documents == 0)
+    return;
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->spool_running && (work = (_pappl_spool_work_t *)calloc(1, sizeof(_pappl_spool_work_t))) != NULL)
+  {
+    work->printer_id = job->printer->printer_id;
+    work->job_id     = job->job_id;
+
+    cupsArrayAdd(system->spool_queue, work);
+    cupsCondBroadcast(&system->spool_cond);
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+}
+
+
+//
+// '_papplJobQueueFree()' - Queue a deleted job to be freed.
+//
+// This function is called by @link _papplJobDelete@ after the job has been
+// removed from the printer.  The job is freed by the background spool thread
+// while the system is running and immediately otherwise.
+//
+
+void
+_papplJobQueueFree(pappl_job_t *job)	// I - Job
+{
+  pappl_system_t *system = job->system;	// System
+  bool		queued = false;		// Queued for the spool thread?
+
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->spool_running && (system->spool_reap_jobs || (system->spool_reap_jobs = cupsArrayNew(/*cb*/NULL, /*cbdata*/NULL, /*hash_cb*/NULL, /*hashsize*/0, /*copy_cb*/NULL, /*free_cb*/NULL)) != NULL))
+    queued = cupsArrayAdd(system->spool_reap_jobs, job);
+
+  if (queued)
+    cupsCondBroadcast(&system->spool_cond);
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  if (!queued)
+    _papplJobFree(job);
+}
+
+
+//
+// '_papplJobQueueRemove()' - Queue a job file to be removed.
+//
+// The file is removed by the background spool thread while the system is
+// running and immediately otherwise.
+//
+
+void
+_papplJobQueueRemove(
+    pappl_job_t *job,			// I - Job
+    const char  *filename)		// I - Filename
+{
+  pappl_system_t *system = job->system;	// System
+  bool		queued;			// Queued for the spool thread?
+
+
+  cupsMutexLock(&system->config_mutex);
+  queued = queue_file(system, filename);
+  cupsMutexUnlock(&system->config_mutex);
+
+  if (!queued)
+    unlink(filename);
+}
+
+
+//
+// '_papplJobReleaseSharedFile()' - Release a reference to a shared document file.
+//
+// This function drops a job's reference to a shared document file, removing
+// the file when the last reference is released.  `false` is returned for any
+// other file, which is not removed.
+//
+
+bool					// O - `true` if the file is shared, `false` otherwise
+_papplJobReleaseSharedFile(
+    pappl_job_t *job,			// I - Job
+    const char  *filename)		// I - Document filename
+{
+  bool		ret = false;		// Return value
+  pappl_system_t *system = job->system;	// System
+  _pappl_sfile_t key,			// Search key
+		*sfile;			// Shared file
+
+
+  if (!filename)
+    return (false);
+
+  key.filename = (char *)filename;
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->spool_files && (sfile = (_pappl_sfile_t *)cupsArrayFind(system->spool_files, &key)) != NULL)
+  {
+    ret = true;
+
+    if (sfile->refcount > 1)
+    {
+      sfile->refcount --;
+    }
+    else
+    {
+      // Last reference, remove the file...
+      if (!queue_file(system, sfile->filename))
+        unlink(sfile->filename);
+
+      if (sfile->hashed)
+        cupsArrayRemove(system->spool_hashes, sfile);
+
+      cupsArrayRemove(system->spool_files, sfile);
+    }
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  return (ret);
+}
+
+
+//
+// '_papplJobRemoveMemoryFile()' - Remove a file in the memory spool directory.
+//
+// This function removes the named file and releases its memory if it is in the
+// memory spool directory.  `false` is returned for any other file, which is not
+// removed.
+//
+
+bool					// O - `true` if the file was in the memory spool, `false` otherwise
+_papplJobRemoveMemoryFile(
+    pappl_job_t *job,			// I - Job
+    const char  *filename)		// I - Filename
+{
+  const char	*memdir = job->system->spool_memdir;
+					// Memory spool directory
+  size_t	memdirlen;		// Length of memory spool directory
+  struct stat	fileinfo;		// File information
+
+
+  if (!memdir || !filename)
+    return (false);
+
+  memdirlen = strlen(memdir);
+
+  if (strncmp(filename, memdir, memdirlen) || filename[memdirlen] != '/')
+    return (false);
+
+  if (!stat(filename, &fileinfo) && !unlink(filename))
+    release_memory(job->system, (size_t)fileinfo.st_size);
+
+  return (true);
+}
+
+
+//
+// '_papplJobRetainSharedFile()' - Add a reference to a document file.
+//
+// This function is used when loading the system state to count the jobs that
+// share a document file in the spool directory, so that the file is only
+// removed with the last job.
+//
+
+void
+_papplJobRetainSharedFile(
+    pappl_job_t *job,			// I - Job
+    const char  *filename)		// I - Document filename
+{
+  pappl_system_t *system = job->system;	// System
+  size_t	dirlen = strlen(system->directory);
+					// Length of spool directory
+  _pappl_sfile_t key,			// Search key
+		*sfile;			// Shared file
+
+
+  if (!filename || strncmp(filename, system->directory, dirlen) || filename[dirlen] != '/')
+    return;
+
+  key.filename = (char *)filename;
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (init_shared(system))
+  {
+    if ((sfile = (_pappl_sfile_t *)cupsArrayFind(system->spool_files, &key)) != NULL)
+    {
+      sfile->refcount ++;
+    }
+    else if ((sfile = (_pappl_sfile_t *)calloc(1, sizeof(_pappl_sfile_t))) != NULL)
+    {
+      // The hash is not known until the document is received again...
+      if ((sfile->filename = strdup(filename)) != NULL)
+      {
+        sfile->refcount = 1;
+        cupsArrayAdd(system->spool_files, sfile);
+      }
+      else
+      {
+        free(sfile);
+      }
+    }
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+}
+
+
+//
+// '_papplJobSetSharedImpressions()' - Save the impressions for a shared document file.
+//
+
+void
+_papplJobSetSharedImpressions(
+    pappl_job_t *job,			// I - Job
+    const char  *filename,		// I - Document filename
+    int         impressions,		// I - Number of impressions
+    int         impcolor)		// I - Number of color impressions
+{
+  pappl_system_t *system = job->system;	// System
+  _pappl_sfile_t key,			// Search key
+		*sfile;			// Shared file
+
+
+  if (!filename)
+    return;
+
+  key.filename = (char *)filename;
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->spool_files && (sfile = (_pappl_sfile_t *)cupsArrayFind(system->spool_files, &key)) != NULL)
+  {
+    sfile->impressions = impressions;
+    sfile->impcolor    = impcolor;
+    sfile->inspected   = true;
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+}
+
+
+//
+// '_papplJobSpillFilesNoLock()' - Move document files from the memory spool to the spool directory.
+//
+// This function is called for jobs that keep their documents after printing
+// and for pending jobs when the system is shutdown.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplJobSpillFilesNoLock(
+    pappl_job_t *job)			// I - Job
+{
+  bool		ret = true,		// Return value
+		changed = false;	// Did any filenames change?
+  int		doc_number;		// Document number
+  _pappl_doc_t	*doc;			// Current document
+  const char	*memdir = job->system->spool_memdir;
+					// Memory spool directory
+  size_t	memdirlen;		// Length of memory spool directory
+
+
+  if (!memdir)
+    return (true);
+
+  memdirlen = strlen(memdir);
+
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    if (!doc->filename || strncmp(doc->filename, memdir, memdirlen) || doc->filename[memdirlen] != '/')
+      continue;
+
+    if (spill_file(job, doc_number, doc))
+      changed = true;
+    else
+      ret = false;
+  }
+
+  if (changed)
+    _papplSystemObjectChanged(job->system, &job->state_changes);
+
+  return (ret);
+}
+
+
+//
+// '_papplJobSpoolAbort()' - Abort a document spool file.
+//
+// This function closes and removes the spool file and frees the write buffer.
+//
+
+void
+_papplJobSpoolAbort(
+    _pappl_spool_t *spool)		// I - Spool file
+{
+  if (spool->fd >= 0)
+  {
+    close(spool->fd);
+    spool->fd = spool->job->fd = -1;
+
+    unlink(spool->filename);
+
+    if (spool->in_memory)
+      release_memory(spool->job->system, spool->written);
+  }
+
+  spool->in_memory = false;
+
+  free_buffers(spool);
+}
+
+
+//
+// '_papplJobSpoolClose()' - Close a document spool file.
+//
+// This function writes any buffered data and closes the spool file, flushing
+// it to disk as required by the system's spool synchronization policy.  On
+// success the "filename" member contains the name of the spool file.  On
+// failure the spool file is removed and `errno` contains the error.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplJobSpoolClose(
+    _pappl_spool_t *spool)		// I - Spool file
+{
+  if (!flush_buffer(spool) || (!spool->in_memory && spool->sync != PAPPL_SPOOL_SYNC_NONE && !sync_file(spool, true)) || close(spool->fd))
+  {
+    int error = errno;			// Write error
+
+    _papplJobSpoolAbort(spool);
+
+    errno = error;
+    return (false);
+  }
+
+  spool->fd = spool->job->fd = -1;
+
+  // Share the file with other jobs that printed the same document...
+  if (!spool->no_hash && spool->total > 0)
+    share_file(spool);
+
+  free_buffers(spool);
+
+  papplLogJob(spool->job, PAPPL_LOGLEVEL_DEBUG, "Spooled %lu bytes to %s file \"%s\".", (unsigned long)spool->total, spool->in_memory ? "memory" : "job", spool->filename);
+
+  return (true);
+}
+
+
+//
+// '_papplJobSpoolCommit()' - Add data in the write buffer to a spool file.
+//
+// This function adds "bytes" bytes that were copied to the buffer returned by
+// @link _papplJobSpoolGetBuffer@.
+//
+
+void
+_papplJobSpoolCommit(
+    _pappl_spool_t *spool,		// I - Spool file
+    size_t         bytes)		// I - Number of bytes
+{
+  if (!spool->no_hash)
+    hash_data(spool, spool->buffer + spool->bufused, bytes);
+
+  spool->bufused += bytes;
+  spool->total   += bytes;
+}
+
+
+//
+// '_papplJobSpoolGetBuffer()' - Get the free space in the write buffer.
+//
+// This function returns a pointer to the free space in the write buffer of a
+// spool file, writing the buffer to the spool file as needed.  Data is copied
+// or read directly into the buffer and then added using the
+// @link _papplJobSpoolCommit@ function.  `NULL` is returned on error with the
+// error in `errno`.
+//
+
+char *					// O - Pointer to free space or `NULL` on error
+_papplJobSpoolGetBuffer(
+    _pappl_spool_t *spool,		// I - Spool file
+    size_t         *bufsize)		// O - Number of free bytes
+{
+  if (spool->bufused >= _PAPPL_SPOOL_BUFSIZE || (spool->in_memory && spool->total > spool->memmax))
+  {
+    // Write the buffer or move a large document to the spool directory...
+    if (!flush_buffer(spool))
+    {
+      *bufsize = 0;
+      return (NULL);
+    }
+  }
+
+  *bufsize = _PAPPL_SPOOL_BUFSIZE - spool->bufused;
+
+  return (spool->buffer + spool->bufused);
+}
+
+
+//
+// '_papplJobSpoolOpen()' - Open a document spool file.
+//
+// This function creates a new document spool file.  When the memory spool is
+// enabled, documents start in the memory spool directory and are moved to the
+// spool directory when they grow larger than the memory spool limit or the
+// total memory spool limit is reached.  Documents for printers that preserve
+// jobs after printing and documents whose "length" is larger than the memory
+// spool limit always use the spool directory.  On failure `errno` contains the
+// error.
+//
+// When the "length" is known, space for the document is reserved in the spool
+// directory so that large documents are not fragmented and a full disk is
+// detected early.
+//
+// The job's file descriptor is set to the spool file descriptor so that the
+// job reports "job-incoming" while the document is spooled.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplJobSpoolOpen(
+    _pappl_spool_t *spool,		// I - Spool file
+    pappl_job_t    *job,		// I - Job
+    int            doc_number,		// I - Document number (`0` for single document jobs)
+    const char     *format,		// I - Document format or `NULL` for default
+    size_t         length)		// I - Length of document or `0` if unknown
+{
+  pappl_system_t *system = job->system;	// System
+
+
+  memset(spool, 0, sizeof(_pappl_spool_t));
+
+  spool->job        = job;
+  spool->doc_number = doc_number;
+  spool->format     = format;
+  spool->fd         = -1;
+  spool->pipefds[0] = -1;
+  spool->pipefds[1] = -1;
+  spool->hash       = 0xcbf29ce484222325ULL;
+
+  // Allocate an aligned write buffer...
+#if _WIN32
+  if ((spool->buffer = _aligned_malloc(_PAPPL_SPOOL_BUFSIZE, _PAPPL_SPOOL_ALIGN)) == NULL)
+    return (false);
+#else
+  if ((errno = posix_memalign((void **)&spool->buffer, _PAPPL_SPOOL_ALIGN, _PAPPL_SPOOL_BUFSIZE)) != 0)
+  {
+    spool->buffer = NULL;
+    return (false);
+  }
+#endif // _WIN32
+
+  // See if the document can start in the memory spool...
+  cupsMutexLock(&system->config_mutex);
+  if (system->spool_memdir && system->spool_memused < system->spool_memtotal && length <= system->spool_memmax)
+    spool->memmax = system->spool_memmax;
+  spool->sync = system->spool_sync;
+  cupsMutexUnlock(&system->config_mutex);
+
+  if (spool->memmax > 0)
+  {
+    // Preserved jobs keep their documents after printing...
+    _papplRWLockRead(job->printer);
+    if (job->printer->max_preserved_jobs > 0)
+      spool->memmax = 0;
+    _papplRWUnlock(job->printer);
+  }
+
+  if (spool->memmax > 0 && (spool->fd = papplJobOpenFile(job, doc_number, spool->filename, sizeof(spool->filename), system->spool_memdir, /*ext*/NULL, format, "w")) >= 0)
+  {
+    spool->in_memory = true;
+  }
+  else if ((spool->fd = papplJobOpenFile(job, doc_number, spool->filename, sizeof(spool->filename), system->directory, /*ext*/NULL, format, "w")) >= 0)
+  {
+#ifdef __linux
+    // Reserve space for the document without changing the file size...
+    if (length > 0)
+      fallocate(spool->fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)length);
+#endif // __linux
+  }
+  else
+  {
+    int error = errno;			// Open error
+
+    free_buffers(spool);
+
+    errno = error;
+    return (false);
+  }
+
+  job->fd = spool->fd;
+
+  return (true);
+}
+
+
+//
+// '_papplJobSpoolRecv()' - Receive document data from a socket.
+//
+// This function receives up to "bytes" bytes of document data from a socket.
+// On Linux, data for documents in the spool directory is moved from the socket
+// to the spool file using `splice` so that it is not copied through the
+// process.  `0` is returned at the end of the data and `-1` on error with the
+// error in `errno`.
+//
+
+ssize_t					// O - Number of bytes received, `0` on EOF, or `-1` on error
+_papplJobSpoolRecv(
+    _pappl_spool_t *spool,		// I - Spool file
+    int            sock,		// I - Socket
+    size_t         bytes)		// I - Maximum number of bytes
+{
+  ssize_t	count;			// Bytes received
+  char		*ptr;			// Pointer into write buffer
+  size_t	bufsize;		// Free space in write buffer
+
+
+#ifdef __linux
+  if (!spool->in_memory && !spool->no_splice)
+  {
+    // Write any buffered data before moving data directly to the file...
+    if (!flush_buffer(spool))
+      return (-1);
+
+    if (spool->pipefds[0] < 0)
+    {
+      if (pipe2(spool->pipefds, O_CLOEXEC))
+      {
+        spool->pipefds[0] = spool->pipefds[1] = -1;
+        spool->no_splice  = true;
+      }
+      else
+      {
+        // Use a larger pipe buffer to move more data with each call...
+        fcntl(spool->pipefds[1], F_SETPIPE_SZ, _PAPPL_SPOOL_BUFSIZE);
+      }
+    }
+
+    if (!spool->no_splice)
+    {
+      if (bytes > _PAPPL_SPOOL_BUFSIZE)
+        bytes = _PAPPL_SPOOL_BUFSIZE;
+
+      while ((count = splice(sock, NULL, spool->pipefds[1], NULL, bytes, SPLICE_F_MOVE | SPLICE_F_MORE)) < 0 && errno == EINTR);
+
+      if (count > 0)
+      {
+        // Move the data from the pipe to the spool file...
+        ssize_t	moved,			// Bytes moved
+		remaining = count;	// Bytes remaining in the pipe
+
+        while (remaining > 0)
+        {
+          if ((moved = splice(spool->pipefds[0], NULL, spool->fd, NULL, (size_t)remaining, SPLICE_F_MOVE | SPLICE_F_MORE)) < 0)
+          {
+            if (errno == EINTR)
+              continue;
+
+            return (-1);
+          }
+          else if (moved == 0)
+          {
+            errno = EIO;
+            return (-1);
+          }
+
+          remaining -= moved;
+        }
+
+        spool->total   += (size_t)count;
+        spool->written += (size_t)count;
+        spool->no_hash = true;
+
+        if (spool->sync == PAPPL_SPOOL_SYNC_WRITE && !sync_file(spool, false))
+          return (-1);
+
+        return (count);
+      }
+      else if (count == 0 || (errno != EINVAL && errno != ENOSYS))
+      {
+        return (count);
+      }
+
+      // Socket or filesystem doesn't support splice(), so read into the buffer
+      spool->no_splice = true;
+    }
+  }
+#endif // __linux
+
+  if ((ptr = _papplJobSpoolGetBuffer(spool, &bufsize)) == NULL)
+    return (-1);
+
+  if (bufsize > bytes)
+    bufsize = bytes;
+
+  if ((count = recv(sock, ptr, bufsize, 0)) > 0)
+    _papplJobSpoolCommit(spool, (size_t)count);
+
+  return (count);
+}
+
+
+//
+// '_papplJobSpoolWrite()' - Write document data to a spool file.
+//
+// This function copies document data to the write buffer of the spool file.
+// On failure `errno` contains the error.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplJobSpoolWrite(
+    _pappl_spool_t *spool,		// I - Spool file
+    const void     *data,		// I - Document data
+    size_t         bytes)		// I - Number of bytes
+{
+  const char	*dataptr = (const char *)data;
+					// Pointer into document data
+  char		*ptr;			// Pointer into write buffer
+  size_t	bufsize;		// Free space in write buffer
+
+
+  while (bytes > 0)
+  {
+    if ((ptr = _papplJobSpoolGetBuffer(spool, &bufsize)) == NULL)
+      return (false);
+
+    if (bufsize > bytes)
+      bufsize = bytes;
+
+    memcpy(ptr, dataptr, bufsize);
+    _papplJobSpoolCommit(spool, bufsize);
+
+    dataptr += bufsize;
+    bytes   -= bufsize;
+  }
+
+  return (true);
+}
+
+
+//
+// '_papplSystemCompressJob()' - Compress the documents of a completed job.
+//
+// This function compresses the documents a completed job keeps in the spool
+// directory using gzip, replacing the original files.  Documents that are
+// already compressed, are shared with other jobs, or don't get at least 10%
+// smaller are left alone.  Compressed documents are read using the
+// `cupsFileOpen` function, which decompresses them on the fly.
+//
+// No locks are held while the documents are compressed, so the printer and
+// job are looked up by their IDs.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplSystemCompressJob(
+    pappl_system_t *system,		// I - System
+    int            printer_id,		// I - Printer ID
+    int            job_id)		// I - Job ID
+{
+  bool			ret = true;	// Return value
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		*job;		// Job
+  int			i,		// Looping var
+			doc_number,	// Document number
+			num_files = 0;	// Number of files to compress
+  _pappl_doc_t		*doc;		// Current document
+  char			*filenames[_PAPPL_MAX_DOCUMENTS],
+					// Files to compress
+			gzfilename[1024];
+					// Compressed filename
+  bool			replaced;	// Was the document file replaced?
+
+
+  if ((printer = papplSystemFindPrinter(system, NULL, printer_id, NULL)) == NULL)
+    return (false);
+
+  // Get the documents to compress...
+  _papplRWLockRead(printer);
+
+  if ((job = _papplPrinterFindJobNoLock(printer, job_id)) != NULL)
+  {
+    _papplRWLockRead(job);
+
+    if (job->state >= IPP_JSTATE_CANCELED)
+    {
+      for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+      {
+        if (can_compress(system, doc) && (filenames[num_files] = strdup(doc->filename)) != NULL)
+          num_files ++;
+      }
+    }
+
+    _papplRWUnlock(job);
+  }
+
+  _papplRWUnlock(printer);
+
+  for (i = 0; i < num_files; i ++)
+  {
+    // Don't compress files that other jobs are using...
+    if (!unshare_file(system, filenames[i]))
+    {
+      free(filenames[i]);
+      continue;
+    }
+
+    snprintf(gzfilename, sizeof(gzfilename), "%s.gz", filenames[i]);
+
+    if (!compress_file(system, filenames[i], gzfilename))
+    {
+      free(filenames[i]);
+      continue;
+    }
+
+    // Replace the document file, unless the job or document has been removed
+    // in the meantime...
+    replaced = false;
+
+    _papplRWLockRead(printer);
+
+    if ((job = _papplPrinterFindJobNoLock(printer, job_id)) != NULL)
+    {
+      _papplRWLockWrite(job);
+
+      for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+      {
+        if (doc->filename && !strcmp(doc->filename, filenames[i]))
+        {
+          char *newfilename = strdup(gzfilename);
+					// New document filename
+
+          if (newfilename)
+          {
+            free(doc->filename);
+            doc->filename = newfilename;
+            replaced      = true;
+
+            _papplSystemObjectChanged(system, &job->state_changes);
+          }
+          else
+          {
+            ret = false;
+          }
+          break;
+        }
+      }
+
+      _papplRWUnlock(job);
+    }
+
+    _papplRWUnlock(printer);
+
+    if (replaced)
+      unlink(filenames[i]);
+    else
+      unlink(gzfilename);
+
+    free(filenames[i]);
+  }
+
+  return (ret);
+}
+
+
+//
+// '_papplSystemRunSpool()' - Run the background spool thread.
+//
+// This thread removes the files and frees the jobs queued by the
+// @link _papplJobQueueRemove@ and @link _papplJobQueueFree@ functions, and
+// compresses the documents of jobs queued by the
+// @link _papplJobQueueCompressNoLock@ function, until the system is shutdown.
+// Queued files and jobs are processed in batches before any compression work.
+//
+
+void *					// O - Thread exit status
+_papplSystemRunSpool(
+    pappl_system_t *system)		// I - System
+{
+  _pappl_spool_work_t	*work;		// Work item
+
+
+  cupsMutexLock(&system->config_mutex);
+
+  while (system->spool_running)
+  {
+    if (system->spool_reap_files || system->spool_reap_jobs)
+    {
+      // Remove files and free jobs...
+      reap_queued(system);
+      continue;
+    }
+    else if ((work = (_pappl_spool_work_t *)cupsArrayGetFirst(system->spool_queue)) == NULL)
+    {
+      // Wait for work...
+      cupsCondWait(&system->spool_cond, &system->config_mutex, 0.0);
+      continue;
+    }
+
+    cupsArrayRemove(system->spool_queue, work);
+    cupsMutexUnlock(&system->config_mutex);
+
+    _papplSystemCompressJob(system, work->printer_id, work->job_id);
+    free(work);
+
+    cupsMutexLock(&system->config_mutex);
+  }
+
+  // Remove any files and free any jobs that were queued before shutdown...
+  while (system->spool_reap_files || system->spool_reap_jobs)
+    reap_queued(system);
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'can_compress()' - Determine whether a document file can be compressed.
+//
+// Only uncompressed files in the spool directory are compressed.
+//
+
+static bool				// O - `true` if the file can be compressed, `false` otherwise
+can_compress(pappl_system_t *system,	// I - System
+             _pappl_doc_t   *doc)	// I - Document
+{
+  size_t	dirlen = strlen(system->directory),
+					// Length of spool directory
+		fnlen;			// Length of filename
+  static const char * const formats[] =	// Formats that are already compressed
+  {
+    "image/jpeg",
+    "image/png"
+  };
+  size_t	i;			// Looping var
+
+
+  if (!doc->filename || strncmp(doc->filename, system->directory, dirlen) || doc->filename[dirlen] != '/')
+    return (false);
+
+  if ((fnlen = strlen(doc->filename)) > 3 && !strcmp(doc->filename + fnlen - 3, ".gz"))
+    return (false);
+
+  for (i = 0; doc->format && i < (sizeof(formats) / sizeof(formats[0])); i ++)
+  {
+    if (!strcmp(doc->format, formats[i]))
+      return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'compare_hashes()' - Compare the hashes of two shared files.
+//
+
+static int				// O - Result of comparison
+compare_hashes(_pappl_sfile_t *a,	// I - First file
+               _pappl_sfile_t *b,	// I - Second file
+               void           *data)	// I - Callback data (unused)
+{
+  (void)data;
+
+  if (a->hash < b->hash)
+    return (-1);
+  else if (a->hash > b->hash)
+    return (1);
+  else if (a->length < b->length)
+    return (-1);
+  else if (a->length > b->length)
+    return (1);
+  else
+    return (strcmp(a->format, b->format));
+}
+
+
+//
+// 'compare_names()' - Compare the filenames of two shared files.
+//
+
+static int				// O - Result of comparison
+compare_names(_pappl_sfile_t *a,	// I - First file
+              _pappl_sfile_t *b,	// I - Second file
+              void           *data)	// I - Callback data (unused)
+{
+  (void)data;
+
+  return (strcmp(a->filename, b->filename));
+}
+
+
+//
+// 'compress_file()' - Compress a document file.
+//
+// The compressed file is only kept if it is at least 10% smaller.
+//
+
+static bool				// O - `true` if compressed, `false` otherwise
+compress_file(pappl_system_t *system,	// I - System
+              const char     *srcfile,	// I - Document file
+              const char     *dstfile)	// I - Compressed file
+{
+  int		srcfd,			// Document file
+		dstfd;			// Compressed file
+  cups_file_t	*dstfp;			// Compressed file
+  char		*buffer;		// Copy buffer
+  ssize_t	bytes;			// Bytes read
+  bool		ret = true;		// Return value
+  struct stat	srcinfo,		// Document file information
+		dstinfo;		// Compressed file information
+
+
+  if ((buffer = malloc(_PAPPL_SPOOL_BUFSIZE)) == NULL)
+    return (false);
+
+  if ((srcfd = open(srcfile, O_RDONLY | O_NOFOLLOW | O_CLOEXEC | O_BINARY)) < 0 || fstat(srcfd, &srcinfo))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to open document file \"%s\": %s", srcfile, strerror(errno));
+    if (srcfd >= 0)
+      close(srcfd);
+    free(buffer);
+    return (false);
+  }
+
+  if ((dstfd = open(dstfile, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC | O_BINARY, 0600)) < 0 || (dstfp = cupsFileOpenFd(dstfd, "w6")) == NULL)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create compressed document file \"%s\": %s", dstfile, strerror(errno));
+    if (dstfd >= 0)
+    {
+      close(dstfd);
+      unlink(dstfile);
+    }
+    close(srcfd);
+    free(buffer);
+    return (false);
+  }
+
+  while ((bytes = read(srcfd, buffer, _PAPPL_SPOOL_BUFSIZE)) != 0)
+  {
+    if (bytes < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      ret = false;
+      break;
+    }
+
+    if (!_papplFileWrite(dstfp, buffer, (size_t)bytes))
+    {
+      ret = false;
+      break;
+    }
+  }
+
+  close(srcfd);
+  free(buffer);
+
+  if (!_papplFileClose(dstfp))
+    ret = false;
+
+  if (!ret)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to compress document file \"%s\": %s", srcfile, strerror(errno));
+  }
+  else if (stat(dstfile, &dstinfo) || dstinfo.st_size > (srcinfo.st_size - srcinfo.st_size / 10))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Not compressing document file \"%s\".", srcfile);
+    ret = false;
+  }
+  else
+  {
+    papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Compressed document file \"%s\" from %ld to %ld bytes.", srcfile, (long)srcinfo.st_size, (long)dstinfo.st_size);
+  }
+
+  if (!ret)
+    unlink(dstfile);
+
+  return (ret);
+}
+
+
+//
+// 'copy_file()' - Copy a spool file.
+//
+
+static bool				// O - `true` on success, `false` on error
+copy_file(int        dstfd,		// I - Destination file
+          const char *srcfile,		// I - Source filename
+          size_t     length)		// I - Number of bytes to copy
+{
+  int		srcfd;			// Source file
+  ssize_t	bytes;			// Bytes read
+  char		buffer[32768];		// Copy buffer
+
+
+  if ((srcfd = open(srcfile, O_RDONLY | O_NOFOLLOW | O_CLOEXEC | O_BINARY)) < 0)
+    return (false);
+
+  while (length > 0 && (bytes = read(srcfd, buffer, length < sizeof(buffer) ? length : sizeof(buffer))) > 0)
+  {
+    if (!write_all(dstfd, buffer, (size_t)bytes))
+      break;
+
+    length -= (size_t)bytes;
+  }
+
+  close(srcfd);
+
+  return (length == 0);
+}
+
+
+//
+// 'flush_buffer()' - Write the buffered data to the spool file.
+//
+
+static bool				// O - `true` on success, `false` on error
+flush_buffer(_pappl_spool_t *spool)	// I - Spool file
+{
+  if (spool->bufused == 0)
+    return (true);
+
+  if (spool->in_memory)
+  {
+    if ((spool->written + spool->bufused) <= spool->memmax && reserve_memory(spool->job->system, spool->bufused))
+    {
+      if (write_all(spool->fd, spool->buffer, spool->bufused))
+      {
+        spool->written += spool->bufused;
+        spool->bufused = 0;
+
+        return (true);
+      }
+
+      // Memory spool filesystem is full...
+      release_memory(spool->job->system, spool->bufused);
+    }
+
+    // Move the document to the spool directory...
+    if (!spool_disk(spool))
+      return (false);
+  }
+
+  if (!write_all(spool->fd, spool->buffer, spool->bufused))
+    return (false);
+
+  spool->written += spool->bufused;
+  spool->bufused = 0;
+
+  if (spool->sync == PAPPL_SPOOL_SYNC_WRITE)
+    return (sync_file(spool, false));
+  else
+    return (true);
+}
+
+
+//
+// 'free_buffers()' - Free the write buffer and splice pipe of a spool file.
+//
+
+static void
+free_buffers(_pappl_spool_t *spool)	// I - Spool file
+{
+  if (spool->buffer)
+  {
+#if _WIN32
+    _aligned_free(spool->buffer);
+#else
+    free(spool->buffer);
+#endif // _WIN32
+
+    spool->buffer  = NULL;
+    spool->bufused = 0;
+  }
+
+  if (spool->pipefds[0] >= 0)
+  {
+    close(spool->pipefds[0]);
+    close(spool->pipefds[1]);
+
+    spool->pipefds[0] = spool->pipefds[1] = -1;
+  }
+}
+
+
+//
+// 'free_sfile()' - Free a shared file.
+//
+
+static void
+free_sfile(_pappl_sfile_t *sfile,	// I - Shared file
+           void           *data)	// I - Callback data (unused)
+{
+  (void)data;
+
+  free(sfile->filename);
+  free(sfile->format);
+  free(sfile);
+}
+
+
+//
+// 'hash_data()' - Add document data to the hash of a spool file.
+//
+// The data is hashed a 64-bit word at a time, keeping any partial word for
+// the next call so the hash does not depend on how the data was received.
+//
+
+static void
+hash_data(_pappl_spool_t *spool,	// I - Spool file
+          const char     *data,		// I - Document data
+          size_t         bytes)		// I - Number of bytes
+{
+  uint64_t	hash = spool->hash;	// Current hash
+
+
+  if (spool->hashlen > 0)
+  {
+    // Finish the partial word from last time...
+    while (spool->hashlen < sizeof(spool->hashbuf) && bytes > 0)
+    {
+      spool->hashbuf[spool->hashlen ++] = (unsigned char)*data++;
+      bytes --;
+    }
+
+    if (spool->hashlen < sizeof(spool->hashbuf))
+      return;
+
+    hash           = hash_word(hash, spool->hashbuf);
+    spool->hashlen = 0;
+  }
+
+  for (; bytes >= 8; bytes -= 8, data += 8)
+    hash = hash_word(hash, (const unsigned char *)data);
+
+  if (bytes > 0)
+  {
+    // Save the partial word...
+    memcpy(spool->hashbuf, data, bytes);
+    spool->hashlen = bytes;
+  }
+
+  spool->hash = hash;
+}
+
+
+//
+// 'hash_word()' - Add a 64-bit word to a hash.
+//
+
+static uint64_t				// O - New hash
+hash_word(uint64_t            hash,	// I - Current hash
+          const unsigned char *word)	// I - 8-byte word
+{
+  uint64_t	value;			// Word value
+
+
+  memcpy(&value, word, sizeof(value));
+
+  hash = (hash ^ value) * 0x9e3779b97f4a7c15ULL;
+
+  return (hash ^ (hash >> 29));
+}
+
+
+//
+// 'init_shared()' - Create the shared file arrays.
+//
+// The caller must hold the system's "config_mutex".
+//
+
+static bool				// O - `true` on success, `false` on error
+init_shared(pappl_system_t *system)	// I - System
+{
+  if (!system->spool_files)
+  {
+    system->spool_files  = cupsArrayNew((cups_array_cb_t)compare_names, NULL, NULL, 0, NULL, (cups_afree_cb_t)free_sfile);
+    system->spool_hashes = cupsArrayNew((cups_array_cb_t)compare_hashes, NULL, NULL, 0, NULL, NULL);
+  }
+
+  return (system->spool_files != NULL && system->spool_hashes != NULL);
+}
+
+
+//
+// 'queue_file()' - Queue a file to be removed by the spool thread.
+//
+// The caller must hold the configuration mutex.  `false` is returned if the
+// spool thread is not running, in which case the caller removes the file.
+//
+
+static bool				// O - `true` if queued, `false` otherwise
+queue_file(pappl_system_t *system,	// I - System
+           const char     *filename)	// I - Filename
+{
+  if (!system->spool_running)
+    return (false);
+
+  if (!system->spool_reap_files && (system->spool_reap_files = cupsArrayNew(/*cb*/NULL, /*cbdata*/NULL, /*hash_cb*/NULL, /*hashsize*/0, (cups_acopy_cb_t)strdup, (cups_afree_cb_t)free)) == NULL)
+    return (false);
+
+  if (!cupsArrayAdd(system->spool_reap_files, (void *)filename))
+    return (false);
+
+  cupsCondBroadcast(&system->spool_cond);
+
+  return (true);
+}
+
+
+//
+// 'reap_queued()' - Remove the queued files and free the queued jobs.
+//
+// The caller must hold the configuration mutex, which is released while the
+// current batch of files and jobs is processed.
+//
+
+static void
+reap_queued(pappl_system_t *system)	// I - System
+{
+  cups_array_t	*files = system->spool_reap_files,
+					// Files to remove
+		*jobs = system->spool_reap_jobs;
+					// Jobs to free
+  const char	*filename;		// Current file
+  pappl_job_t	*job;			// Current job
+
+
+  // Take the current batch so that new files and jobs can be queued while we
+  // are working...
+  system->spool_reap_files = NULL;
+  system->spool_reap_jobs  = NULL;
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  for (filename = (const char *)cupsArrayGetFirst(files); filename; filename = (const char *)cupsArrayGetNext(files))
+    unlink(filename);
+
+  for (job = (pappl_job_t *)cupsArrayGetFirst(jobs); job; job = (pappl_job_t *)cupsArrayGetNext(jobs))
+    _papplJobFree(job);
+
+  cupsArrayDelete(files);
+  cupsArrayDelete(jobs);
+
+  cupsMutexLock(&system->config_mutex);
+}
+
+
+//
+// 'release_memory()' - Release memory spool space.
+//
+
+static void
+release_memory(pappl_system_t *system,	// I - System
+               size_t         bytes)	// I - Number of bytes
+{
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->spool_memused > bytes)
+    system->spool_memused -= bytes;
+  else
+    system->spool_memused = 0;
+
+  cupsMutexUnlock(&system->config_mutex);
+}
+
+
+//
+// 'reserve_memory()' - Reserve memory spool space.
+//
+
+static bool				// O - `true` if reserved, `false` if over the limit
+reserve_memory(pappl_system_t *system,	// I - System
+               size_t         bytes)	// I - Number of bytes
+{
+  bool	ret = false;			// Return value
+
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->spool_memdir && (system->spool_memused + bytes) <= system->spool_memtotal)
+  {
+    system->spool_memused += bytes;
+    ret = true;
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'same_contents()' - Compare a spool file with another file.
+//
+// The spool file's write buffer is used to read both files.
+//
+
+static bool				// O - `true` if the files are the same, `false` otherwise
+same_contents(_pappl_spool_t *spool,	// I - Spool file
+              const char     *filename)	// I - Other file
+{
+  bool		ret = false;		// Return value
+  int		fd1,			// Spool file
+		fd2;			// Other file
+  char		*buf1 = spool->buffer,	// Spool file data
+		*buf2 = spool->buffer + _PAPPL_SPOOL_BUFSIZE / 2;
+					// Other file data
+  ssize_t	bytes;			// Bytes read
+
+
+  if ((fd1 = open(spool->filename, O_RDONLY | O_CLOEXEC | O_BINARY)) < 0)
+    return (false);
+
+  if ((fd2 = open(filename, O_RDONLY | O_CLOEXEC | O_BINARY)) < 0)
+  {
+    close(fd1);
+    return (false);
+  }
+
+  for (;;)
+  {
+    if ((bytes = read(fd1, buf1, _PAPPL_SPOOL_BUFSIZE / 2)) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    else if (bytes == 0)
+    {
+      // At the end of the spool file, the other file must end too...
+      ret = read(fd2, buf2, 1) == 0;
+      break;
+    }
+
+    if (read(fd2, buf2, (size_t)bytes) != bytes || memcmp(buf1, buf2, (size_t)bytes))
+      break;
+  }
+
+  close(fd1);
+  close(fd2);
+
+  return (ret);
+}
+
+
+//
+// 'share_file()' - Share a spool file with other jobs.
+//
+// This function looks for an existing document file with the same contents as
+// a newly spooled document.  If found, the new file is removed and the spool
+// filename is replaced with the existing file so that the document is only
+// stored and inspected once.  Otherwise documents in the spool directory are
+// added so later jobs can share them.
+//
+
+static void
+share_file(_pappl_spool_t *spool)	// I - Spool file
+{
+  pappl_job_t	*job = spool->job;	// Job
+  pappl_system_t *system = job->system;	// System
+  _pappl_sfile_t key,			// Search key
+		*sfile = NULL;		// Shared file
+  unsigned char	word[8];		// Last partial word
+  uint64_t	length;			// Length of document
+
+
+  // Finish the hash with the last partial word and the length...
+  key.hash = spool->hash;
+
+  if (spool->hashlen > 0)
+  {
+    memset(word, 0, sizeof(word));
+    memcpy(word, spool->hashbuf, spool->hashlen);
+    key.hash = hash_word(key.hash, word);
+  }
+
+  length   = (uint64_t)spool->total;
+  memcpy(word, &length, sizeof(word));
+  key.hash   = hash_word(key.hash, word);
+  key.length = spool->total;
+  key.format = (char *)(spool->format ? spool->format : "");
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (!init_shared(system))
+  {
+    cupsMutexUnlock(&system->config_mutex);
+    return;
+  }
+
+  if ((sfile = (_pappl_sfile_t *)cupsArrayFind(system->spool_hashes, &key)) != NULL)
+  {
+    // Hold a reference while comparing the files...
+    sfile->refcount ++;
+  }
+  else if (!spool->in_memory && (sfile = (_pappl_sfile_t *)calloc(1, sizeof(_pappl_sfile_t))) != NULL)
+  {
+    // Add the new file...
+    sfile->filename = strdup(spool->filename);
+    sfile->format   = strdup(key.format);
+    sfile->hash     = key.hash;
+    sfile->length   = key.length;
+    sfile->refcount = 1;
+    sfile->hashed   = true;
+
+    if (sfile->filename && sfile->format)
+    {
+      cupsArrayAdd(system->spool_files, sfile);
+      cupsArrayAdd(system->spool_hashes, sfile);
+    }
+    else
+    {
+      free_sfile(sfile, NULL);
+    }
+
+    sfile = NULL;
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  if (!sfile)
+    return;
+
+  // Make sure the contents are the same (and not just the hash)...
+  if (same_contents(spool, sfile->filename))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Document is the same as \"%s\".", sfile->filename);
+
+    if (!_papplJobRemoveMemoryFile(job, spool->filename))
+      unlink(spool->filename);
+
+    cupsCopyString(spool->filename, sfile->filename, sizeof(spool->filename));
+  }
+  else
+  {
+    _papplJobReleaseSharedFile(job, sfile->filename);
+  }
+}
+
+
+//
+// 'spill_file()' - Move a document file from the memory spool to the spool directory.
+//
+
+static bool				// O - `true` on success, `false` on error
+spill_file(pappl_job_t  *job,		// I - Job
+           int          doc_number,	// I - Document number
+           _pappl_doc_t *doc)		// I - Document
+{
+  int		fd;			// Spool directory file
+  char		filename[1024],		// Spool directory filename
+		*newfilename;		// Copy of filename
+  struct stat	fileinfo;		// Memory spool file information
+
+
+  if (stat(doc->filename, &fileinfo))
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to access print file \"%s\": %s", doc->filename, strerror(errno));
+    return (false);
+  }
+
+  if ((fd = papplJobOpenFile(job, doc_number, filename, sizeof(filename), job->system->directory, /*ext*/NULL, doc->format, "w")) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create print file: %s", strerror(errno));
+    return (false);
+  }
+
+  if (!copy_file(fd, doc->filename, (size_t)fileinfo.st_size))
+  {
+    close(fd);
+    fd = -1;
+  }
+
+  if (fd < 0 || close(fd) || (newfilename = strdup(filename)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write print file \"%s\": %s", filename, strerror(errno));
+    unlink(filename);
+    return (false);
+  }
+
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Moved memory file \"%s\" to \"%s\".", doc->filename, filename);
+
+  _papplJobRemoveMemoryFile(job, doc->filename);
+
+  free(doc->filename);
+  doc->filename = newfilename;
+
+  return (true);
+}
+
+
+//
+// 'spool_disk()' - Move a document from the memory spool to the spool directory.
+//
+
+static bool				// O - `true` on success, `false` on error
+spool_disk(_pappl_spool_t *spool)	// I - Spool file
+{
+  pappl_job_t	*job = spool->job;	// Job
+  int		fd;			// Spool directory file
+  char		filename[1024];		// Spool directory filename
+
+
+  if ((fd = papplJobOpenFile(job, spool->doc_number, filename, sizeof(filename), job->system->directory, /*ext*/NULL, spool->format, "w")) < 0)
+  {
+    int error = errno;			// Open error
+
+    _papplJobSpoolAbort(spool);
+
+    errno = error;
+    return (false);
+  }
+
+  // Copy the data written so far...
+  if (!copy_file(fd, spool->filename, spool->written))
+  {
+    int error = errno;			// Copy error
+
+    close(fd);
+    unlink(filename);
+
+    _papplJobSpoolAbort(spool);
+
+    errno = error;
+    return (false);
+  }
+
+  // Then remove the memory spool file...
+  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Moved memory file \"%s\" to \"%s\".", spool->filename, filename);
+
+  close(spool->fd);
+  unlink(spool->filename);
+  release_memory(job->system, spool->written);
+
+  cupsCopyString(spool->filename, filename, sizeof(spool->filename));
+
+  spool->fd        = job->fd = fd;
+  spool->in_memory = false;
+
+  return (true);
+}
+
+
+//
+// 'sync_file()' - Flush a spool file to disk.
+//
+// The spool directory is also flushed when the file is closed so that the new
+// file survives a power failure.
+//
+
+static bool				// O - `true` on success, `false` on error
+sync_file(_pappl_spool_t *spool,	// I - Spool file
+          bool           closing)	// I - Closing the file?
+{
+#ifdef __linux
+  if (fdatasync(spool->fd))
+#else
+  if (fsync(spool->fd))
+#endif // __linux
+    return (false);
+
+#if !_WIN32
+  if (closing)
+  {
+    int	dirfd;				// Spool directory
+
+    if ((dirfd = open(spool->job->system->directory, O_RDONLY | O_CLOEXEC)) >= 0)
+    {
+      fsync(dirfd);
+      close(dirfd);
+    }
+  }
+#else
+  (void)closing;
+#endif // !_WIN32
+
+  return (true);
+}
+
+
+//
+// 'unshare_file()' - Stop sharing a document file.
+//
+// This function removes a document file that is only used by one job from the
+// shared files so that it can be replaced.
+//
+
+static bool				// O - `true` if the file is not used by other jobs, `false` otherwise
+unshare_file(pappl_system_t *system,	// I - System
+             const char     *filename)	// I - Document filename
+{
+  bool		ret = true;		// Return value
+  _pappl_sfile_t key,			// Search key
+		*sfile;			// Shared file
+
+
+  key.filename = (char *)filename;
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->spool_files && (sfile = (_pappl_sfile_t *)cupsArrayFind(system->spool_files, &key)) != NULL)
+  {
+    if (sfile->refcount > 1)
+    {
+      ret = false;
+    }
+    else
+    {
+      if (sfile->hashed)
+        cupsArrayRemove(system->spool_hashes, sfile);
+
+      cupsArrayRemove(system->spool_files, sfile);
+    }
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'write_all()' - Write all of a buffer to a file.
+//
+
+static bool				// O - `true` on success, `false` on error
+write_all(int        fd,		// I - File descriptor
+          const void *data,		// I - Data
+          size_t     bytes)		// I - Number of bytes
+{
+  const char	*ptr = (const char *)data;
+					// Pointer into data
+  ssize_t	written;		// Bytes written
+
+
+  while (bytes > 0)
+  {
+    if ((written = write(fd, ptr, bytes)) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      return (false);
+    }
+
+    ptr   += written;
+    bytes -= (size_t)written;
+  }
+
+  return (true);
+}
@@ -11,6 +11,86 @@
 #include "pappl-private.h"
 
 
+//
+// Local functions...
+//
+
+static void		add_removed_job(pappl_printer_t *printer, pappl_job_t *job);
+static int		compare_printer_timers(pappl_printer_t *a, pappl_printer_t *b, void *data);
+static int		compare_sched_jobs(pappl_job_t *a, pappl_job_t *b, pappl_printer_t *printer);
+static int		compare_share_pass(_pappl_share_t *a, _pappl_share_t *b, void *data);
+static int		compare_shares(_pappl_share_t *a, _pappl_share_t *b, void *data);
+static int		compare_timer_jobs(pappl_job_t *a, pappl_job_t *b, void *data);
+static void		free_share(_pappl_share_t *share, void *data);
+static void		make_filename(pappl_job_t *job, int doc_number, char *fname, size_t fnamesize, const char *directory, const char *ext, const char *format);
+static void		remove_file(pappl_job_t *job, int doc_number, const char *ext);
+static pappl_job_t	*sched_pop(pappl_printer_t *printer, double *pass);
+static void		sched_push(pappl_printer_t *printer, pappl_job_t *job, double pass);
+static void		start_job_thread(pappl_printer_t *printer, pappl_job_t *job);
+static void		update_job_timer(pappl_printer_t *printer, pappl_job_t *job);
+static void		update_printer_timer(pappl_printer_t *printer);
+
+
+//
+// '_papplJobAddDocumentNoLock()' - Add a document to a job.
+//
+// This function returns a cleared document after the last document in the job,
+// growing the document array as needed.  The first document uses the document
+// slab allocator since most jobs only have a single document.  The caller must
+// hold the job write lock and increment the number of documents once the
+// document is filled in.
+//
+
+_pappl_doc_t *				// O - Document or `NULL` on error
+_papplJobAddDocumentNoLock(
+    pappl_job_t *job)			// I - Job
+{
+  _pappl_doc_t	*doc;			// Document
+
+
+  if (job->num_documents >= _PAPPL_MAX_DOCUMENTS)
+    return (NULL);
+
+  if (job->num_documents >= job->alloc_documents)
+  {
+    // Grow the document array...
+    int	alloc_documents;		// New allocation
+
+    if (job->alloc_documents == 0)
+    {
+      if ((doc = (_pappl_doc_t *)_papplSlabAlloc(_PAPPL_SLAB_DOCUMENT)) == NULL)
+        return (NULL);
+
+      alloc_documents = 1;
+    }
+    else
+    {
+      if ((alloc_documents = 2 * job->alloc_documents) > _PAPPL_MAX_DOCUMENTS)
+        alloc_documents = _PAPPL_MAX_DOCUMENTS;
+
+      if ((doc = (_pappl_doc_t *)malloc((size_t)alloc_documents * sizeof(_pappl_doc_t))) == NULL)
+        return (NULL);
+
+      memcpy(doc, job->documents, (size_t)job->num_documents * sizeof(_pappl_doc_t));
+
+      if (job->alloc_documents == 1)
+        _papplSlabFree(_PAPPL_SLAB_DOCUMENT, job->documents);
+      else
+        free(job->documents);
+    }
+
+    job->documents       = doc;
+    job->alloc_documents = alloc_documents;
+  }
+
+  doc = job->documents + job->num_documents;
+
+  memset(doc, 0, sizeof(_pappl_doc_t));
+
+  return (doc);
+}
+
+
 //
 // 'papplJobCancel()' - Cancel a job.
 //
@@ -51,15 +131,17 @@ _papplJobCancelNoLock(pappl_job_t *job)	// I - Job
     job->state     = IPP_JSTATE_CANCELED;
     job->completed = time(NULL);
 
+    _papplJobDiscardPreRIPNoLock(job);
     _papplJobRemoveFiles(job);
 
+    _papplPrinterUnqueueJobNoLock(job->printer, job);
+    _papplPrinterUpdateJobTimerNoLock(job->printer, job);
     cupsArrayRemove(job->printer->active_jobs, job);
     cupsArrayAdd(job->printer->completed_jobs, job);
+    _papplPrinterNeedCleanNoLock(job->printer);
   }
 
-  if (!job->system->clean_time)
-    job->system->clean_time = time(NULL) + 60;
-
+  _papplSystemObjectChanged(job->system, &job->state_changes);
   _papplSystemAddEventNoLock(job->system, job->printer, job, PAPPL_EVENT_JOB_COMPLETED, /*message*/NULL);
 }
 
@@ -94,7 +176,7 @@ _papplJobCreate(
   }
 
   // Allocate and initialize the job object...
-  if ((job = calloc(1, sizeof(pappl_job_t))) == NULL)
+  if ((job = (pappl_job_t *)_papplSlabAlloc(_PAPPL_SLAB_JOB)) == NULL)
   {
     papplLog(printer->system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for job: %s", strerror(errno));
     _papplRWUnlock(printer);
@@ -103,15 +185,18 @@ _papplJobCreate(
 
   cupsRWInit(&job->rwlock);
   cupsMutexInit(&job->proxy_mutex);
+  cupsMutexInit(&job->prerip_mutex);
+  cupsCondInit(&job->prerip_cond);
 
   job->attrs   = ippNew();
   job->fd      = -1;
-  job->name    = job_name;
+  job->name    = strdup(job_name);
   job->printer = printer;
   job->state   = IPP_JSTATE_HELD;
   job->system  = printer->system;
   job->created = time(NULL);
   job->copies  = 1;
+  job->priority = 50;
 
   if (attrs)
   {
@@ -130,6 +215,9 @@ _papplJobCreate(
     if ((attr = ippFindAttribute(job->attrs, "copies", IPP_TAG_INTEGER)) != NULL)
       job->copies = ippGetInteger(attr, 0);
 
+    if ((attr = ippFindAttribute(job->attrs, "job-priority", IPP_TAG_INTEGER)) != NULL)
+      job->priority = ippGetInteger(attr, 0);
+
     hold_until      = ippGetString(ippFindAttribute(attrs, "job-hold-until", IPP_TAG_KEYWORD), 0, NULL);
     hold_until_time = ippDateToTime(ippGetDate(ippFindAttribute(attrs, "job-hold-until-time", IPP_TAG_DATE), 0));
 
@@ -154,7 +242,7 @@ _papplJobCreate(
   }
 
   if ((attr = ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_NAME, "job-originating-user-name", NULL, username)) != NULL)
-    job->username = ippGetString(attr, 0, NULL);
+    job->username = _papplStrAlloc(ippGetString(attr, 0, NULL));
 
   if ((attr = ippFindAttribute(attrs, "job-impressions", IPP_TAG_INTEGER)) != NULL)
     job->impressions = ippGetInteger(attr, 0);
@@ -178,9 +266,15 @@ _papplJobCreate(
   _papplSystemMakeUUID(printer->system, printer->name, job->job_id, job_uuid, sizeof(job_uuid));
 
   ippAddInteger(job->attrs, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-id", job->job_id);
-  job->uri = ippGetString(ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_URI, "job-uri", NULL, job_uri), 0, NULL);
+  ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_URI, "job-uri", NULL, job_uri);
   ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_URI, "job-uuid", NULL, job_uuid);
-  job->printer_uri = ippGetString(ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_URI, "job-printer-uri", NULL, job_printer_uri), 0, NULL);
+  ippAddString(job->attrs, IPP_TAG_JOB, IPP_TAG_URI, "job-printer-uri", NULL, job_printer_uri);
+
+  // Keep copies of the strings that are used after the attributes are saved to
+  // the spool directory, sharing the printer URI with the printer's other
+  // jobs...
+  job->uri         = strdup(job_uri);
+  job->printer_uri = _papplStrAlloc(job_printer_uri);
 
   cupsArrayAdd(printer->all_jobs, job);
 
@@ -191,7 +285,8 @@ _papplJobCreate(
 
   papplSystemAddEvent(printer->system, printer, job, PAPPL_EVENT_JOB_CREATED, NULL);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
+  _papplSystemObjectChanged(printer->system, &job->state_changes);
 
   return (job);
 }
@@ -251,39 +346,200 @@ papplJobCreateWithFile(
 //
 // '_papplJobDelete()' - Remove a job from the system and free its memory.
 //
+// The job's files are removed and its memory is freed by the background spool
+// thread while the system is running, so the caller's locks are not held
+// while the files are unlinked and the attributes are freed.
+//
 
 void
 _papplJobDelete(pappl_job_t *job)	// I - Job
 {
   papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Removing job from history.");
 
+  if (job->is_evicted)
+  {
+    // Remove the saved job attributes...
+    remove_file(job, /*doc_number*/0, "attrs");
+  }
+
+  // Only remove the job file (document) if the job is in a terminating state...
+  if (job->state >= IPP_JSTATE_CANCELED)
+    _papplJobRemoveFiles(job);
+
+  // Free the rest of the job...
+  _papplJobQueueFree(job);
+}
+
+
+//
+// '_papplJobDiscardPreRIPNoLock()' - Discard any look-ahead output for a job.
+//
+// If look-ahead processing is still running, the output is discarded when it
+// finishes.
+//
+
+void
+_papplJobDiscardPreRIPNoLock(
+    pappl_job_t *job)			// I - Job
+{
+  switch (job->prerip_state)
+  {
+    case _PAPPL_PRERIP_RUNNING :
+        job->prerip_state = _PAPPL_PRERIP_DISCARD;
+        break;
+
+    case _PAPPL_PRERIP_READY :
+        papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Discarding look-ahead output.");
+
+        unlink(job->prerip_filename);
+        free(job->prerip_filename);
+
+        job->prerip_filename     = NULL;
+        job->prerip_size         = 0;
+        job->prerip_copcompleted = 0;
+        job->prerip_impcompleted = 0;
+        job->prerip_state        = _PAPPL_PRERIP_NONE;
+        break;
+
+    case _PAPPL_PRERIP_FAILED :
+        job->prerip_state = _PAPPL_PRERIP_NONE;
+        break;
+
+    default :
+        break;
+  }
+}
+
+
+//
+// '_papplJobEvictNoLock()' - Save the attributes of a completed job to the
+//                            spool directory and free them.
+//
+// Only the job ID, name, user, state, times, and counters stay in memory.  The
+// document attributes are saved to the same files used by the text state file
+// and the job attributes are saved to a separate "attrs" file.  The attributes
+// are loaded again as needed by the @link _papplJobLoadAttrs@ and
+// @link _papplJobReadAttrsNoLock@ functions.
+//
+// The caller must hold the job write lock.
+//
+
+bool					// O - `true` on success, `false` on failure
+_papplJobEvictNoLock(pappl_job_t *job)	// I - Job
+{
+  int		doc_number;		// Document number
+  _pappl_doc_t	*doc;			// Current document
+  int		fd;			// Attribute file descriptor
+  char		filename[1024];		// Attribute filename
+
+
+  if (job->is_evicted)
+    return (true);
+  else if (job->state < IPP_JSTATE_CANCELED)
+    return (false);
+
+  // Save the document attributes that are in memory...
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    if (!doc->attrs)
+      continue;
+
+    if ((fd = papplJobOpenFile(job, doc_number, filename, sizeof(filename), job->system->directory, "ipp", /*format*/NULL, "w")) < 0)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create '%s' for document attributes: %s", filename, strerror(errno));
+      return (false);
+    }
+
+    if (ippWriteFile(fd, doc->attrs) != IPP_STATE_DATA)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write '%s': %s", filename, strerror(errno));
+      close(fd);
+      return (false);
+    }
+
+    close(fd);
+  }
+
+  // Then the job attributes...
+  if ((fd = papplJobOpenFile(job, /*doc_number*/0, filename, sizeof(filename), job->system->directory, "attrs", /*format*/NULL, "w")) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create '%s' for job attributes: %s", filename, strerror(errno));
+    return (false);
+  }
+
+  if (ippWriteFile(fd, job->attrs) != IPP_STATE_DATA)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write '%s': %s", filename, strerror(errno));
+    close(fd);
+    unlink(filename);
+    return (false);
+  }
+
+  close(fd);
+
+  // Free the attributes...
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    ippDelete(doc->attrs);
+    doc->attrs = NULL;
+  }
+
+  ippDelete(job->attrs);
+  job->attrs      = NULL;
+  job->is_evicted = true;
+
+  return (true);
+}
+
+
+//
+// '_papplJobFree()' - Free the memory used by a job.
+//
+// This function is called for jobs that have been deleted with the
+// @link _papplJobDelete@ function and are no longer referenced by the printer.
+//
+
+void
+_papplJobFree(pappl_job_t *job)		// I - Job
+{
+  int		doc_number;		// Document number
+  _pappl_doc_t	*doc;			// Current document
+
+
   cupsRWDestroy(&job->rwlock);
+  cupsCondDestroy(&job->prerip_cond);
+  cupsMutexDestroy(&job->prerip_mutex);
 
   ippDelete(job->attrs);
 
   free(job->message);
   free(job->log_prefix);
 
-  // Only remove the job file (document) if the job is in a terminating state...
-  if (job->state >= IPP_JSTATE_CANCELED)
+  if (job->prerip_filename)
   {
-    _papplJobRemoveFiles(job);
+    unlink(job->prerip_filename);
+    free(job->prerip_filename);
   }
-  else
-  {
-    // Otherwise free memory...
-    int			doc_number;	// Document number
-    _pappl_doc_t	*doc;		// Current document
 
-    for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
-    {
-      free(doc->filename);
-      ippDelete(doc->attrs);
-    }
+  // Free any documents that are kept in the spool directory...
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    free(doc->filename);
+    _papplStrFree(doc->format);
+    ippDelete(doc->attrs);
   }
 
+  if (job->alloc_documents == 1)
+    _papplSlabFree(_PAPPL_SLAB_DOCUMENT, job->documents);
+  else
+    free(job->documents);
+
   // Free the rest of the job...
-  free(job);
+  free(job->name);
+  _papplStrFree(job->username);
+  free(job->uri);
+  _papplStrFree(job->printer_uri);
+  _papplSlabFree(_PAPPL_SLAB_JOB, job);
 }
 
 
@@ -307,7 +563,7 @@ papplJobHold(pappl_job_t *job,		// I - Job
     return (false);
 
   // Lock the printer and job so we can change it...
-  _papplRWLockRead(job->printer);
+  _papplRWLockWrite(job->printer);
   _papplRWLockWrite(job);
 
   // Only hold jobs that haven't entered the processing state...
@@ -340,6 +596,9 @@ _papplJobHoldNoLock(
 
   job->state = IPP_JSTATE_HELD;
 
+  _papplJobDiscardPreRIPNoLock(job);
+  _papplPrinterUnqueueJobNoLock(job->printer, job);
+
   if (until)
   {
     // Hold until the specified time period...
@@ -435,6 +694,10 @@ _papplJobHoldNoLock(
       ippDeleteAttribute(job->attrs, attr);
   }
 
+  // Schedule the release of the job as needed...
+  _papplPrinterUpdateJobTimerNoLock(job->printer, job);
+  _papplSystemObjectChanged(job->system, &job->state_changes);
+
   if (username)
   {
     _papplSystemAddEventNoLock(job->system, job->printer, job, PAPPL_EVENT_JOB_STATE_CHANGED, "Job held by '%s'.", username);
@@ -444,6 +707,87 @@ _papplJobHoldNoLock(
 }
 
 
+//
+// '_papplJobLoadAttrs()' - Load job and document attributes that are not in
+//                          memory.
+//
+// Jobs loaded from a binary state file leave their document attributes in the
+// (memory-mapped) state file until they are first needed, and completed jobs
+// beyond the printer's resident job limit have their attributes saved to the
+// spool directory.  This function must be called without holding the job lock.
+//
+// Calling this function also marks the attributes as in use so that they are
+// not saved and freed for at least a minute.
+//
+
+void
+_papplJobLoadAttrs(pappl_job_t *job)	// I - Job
+{
+  int		doc_number;		// Document number
+  _pappl_doc_t	*doc;			// Current document
+  bool		loaded;			// Are all attributes loaded?
+  char		filename[1024];		// Job attributes file
+
+
+  // Keep the attributes in memory while they are being used...
+  _papplAtomicSet(&job->access_time, time(NULL));
+
+  // See if any attributes need to be loaded...
+  _papplRWLockRead(job);
+
+  loaded = !job->is_evicted;
+
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    if (doc->attrs_data)
+    {
+      loaded = false;
+      break;
+    }
+  }
+
+  _papplRWUnlock(job);
+
+  if (loaded)
+    return;
+
+  // Load the attributes...
+  _papplRWLockWrite(job);
+
+  if (job->is_evicted)
+  {
+    if ((job->attrs = _papplJobReadAttrsNoLock(job, /*doc_number*/0)) == NULL)
+      job->attrs = ippNew();
+
+    for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+    {
+      if (!doc->attrs && !doc->attrs_data && (doc->attrs = _papplJobReadAttrsNoLock(job, doc_number)) == NULL)
+        doc->attrs = ippNew();
+    }
+
+    papplJobOpenFile(job, /*doc_number*/0, filename, sizeof(filename), job->system->directory, "attrs", /*format*/NULL, /*mode*/"x");
+
+    job->is_evicted = false;
+  }
+
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    if (!doc->attrs_data)
+      continue;
+
+    doc->attrs = ippNew();
+
+    if (!_papplIPPReadBuffer(doc->attrs, doc->attrs_data, doc->attrs_datalen))
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to load attributes for document %d.", doc_number);
+
+    doc->attrs_data    = NULL;
+    doc->attrs_datalen = 0;
+  }
+
+  _papplRWUnlock(job);
+}
+
+
 //
 // 'papplJobOpenFile()' - Create or open a file for the document in a job.
 //
@@ -470,11 +814,6 @@ papplJobOpenFile(
     const char  *format,		// I - MIME media type (`NULL` for default)
     const char  *mode)			// I - Open mode - "r" for reading or "w" for writing
 {
-  char			name[64],	// "Safe" filename
-			*nameptr;	// Pointer into filename
-  const char		*job_name;	// job-name value
-
-
   // Range check input...  "idx" must allow == (num_documents + 1) for job queueing to work
   if (!job || !fname || fnamesize < 256 || !mode || doc_number > (job->num_documents + 1))
   {
@@ -494,59 +833,8 @@ papplJobOpenFile(
     return (-1);
   }
 
-  // Make a name from the job-name attribute...
-  if ((job_name = ippGetString(ippFindAttribute(job->attrs, "job-name", IPP_TAG_NAME), 0, NULL)) == NULL)
-    job_name = "untitled";
-
-  if ((nameptr = strrchr(job_name, '/')) != NULL && nameptr[1])
-    job_name = nameptr + 1;
-
-  for (nameptr = name; *job_name && nameptr < (name + sizeof(name) - 1); job_name ++)
-  {
-    if (isalnum(*job_name & 255) || *job_name == '-')
-    {
-      *nameptr++ = (char)tolower(*job_name & 255);
-    }
-    else
-    {
-      *nameptr++ = '_';
-
-      while (job_name[1] && !isalnum(job_name[1] & 255) && job_name[1] != '-')
-        job_name ++;
-    }
-  }
-
-  *nameptr = '\0';
-
-  // Figure out the extension...
-  if (!ext)
-  {
-    if (!format)
-      format = job->documents[doc_number - 1].format;
-    if (!format)
-      format = "application/octet-stream";
-
-    if (!strcasecmp(format, "image/jpeg"))
-      ext = "jpg";
-    else if (!strcasecmp(format, "image/png"))
-      ext = "png";
-    else if (!strcasecmp(format, "image/pwg-raster"))
-      ext = "pwg";
-    else if (!strcasecmp(format, "image/urf"))
-      ext = "urf";
-    else if (!strcasecmp(format, "application/pdf"))
-      ext = "pdf";
-    else if (!strcasecmp(format, "application/postscript"))
-      ext = "ps";
-    else
-      ext = "prn";
-  }
-
   // Create a filename with the job-id, job-name, and document-format (extension)...
-  if ((job->system->options & PAPPL_SOPTIONS_MULTI_DOCUMENT_JOBS) && doc_number > 0)
-    snprintf(fname, fnamesize, "%s/p%05dj%09dd%04d-%s.%s", directory, job->printer->printer_id, job->job_id, doc_number, name, ext);
-  else
-    snprintf(fname, fnamesize, "%s/p%05dj%09d-%s.%s", directory, job->printer->printer_id, job->job_id, name, ext);
+  make_filename(job, doc_number, fname, fnamesize, directory, ext, format);
 
   if (!strcmp(mode, "r"))
     return (open(fname, O_RDONLY | O_NOFOLLOW | O_CLOEXEC | O_BINARY));
@@ -560,22 +848,62 @@ papplJobOpenFile(
 
 
 //
-// 'papplJobRelease()' - Release a job for printing.
+// '_papplJobReadAttrsNoLock()' - Read job or document attributes saved in the
+//                                spool directory.
 //
-// This function releases a held job for printing.
+// This function reads the attributes saved by @link _papplJobEvictNoLock@
+// without making them resident.  The caller must hold the job lock and free
+// the returned attributes with `ippDelete`.
 //
 
-bool					// O - `true` on success, `false` on failure
-papplJobRelease(pappl_job_t *job,	// I - Job
-                const char  *username)	// I - User that released the job or `NULL` for none/system
+ipp_t *					// O - Attributes or `NULL` on error
+_papplJobReadAttrsNoLock(
+    pappl_job_t *job,			// I - Job
+    int         doc_number)		// I - Document number (`1` based) or `0` for the job attributes
 {
-  bool ret = false;			// Return value
+  int		fd;			// Attribute file descriptor
+  char		filename[1024];		// Attribute filename
+  ipp_t		*attrs;			// Attributes
 
 
-  // Range check input
-  if (!job)
-    return (false);
-
+  if ((fd = papplJobOpenFile(job, doc_number, filename, sizeof(filename), job->system->directory, doc_number > 0 ? "ipp" : "attrs", /*format*/NULL, "r")) < 0)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to open '%s': %s", filename, strerror(errno));
+    return (NULL);
+  }
+
+  attrs = ippNew();
+
+  if (ippReadFile(fd, attrs) != IPP_STATE_DATA)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to read '%s'.", filename);
+    ippDelete(attrs);
+    attrs = NULL;
+  }
+
+  close(fd);
+
+  return (attrs);
+}
+
+
+//
+// 'papplJobRelease()' - Release a job for printing.
+//
+// This function releases a held job for printing.
+//
+
+bool					// O - `true` on success, `false` on failure
+papplJobRelease(pappl_job_t *job,	// I - Job
+                const char  *username)	// I - User that released the job or `NULL` for none/system
+{
+  bool ret = false;			// Return value
+
+
+  // Range check input
+  if (!job)
+    return (false);
+
   // Lock the job and printer...
   _papplRWLockWrite(job->printer);
   _papplRWLockWrite(job);
@@ -615,6 +943,7 @@ _papplJobReleaseNoLock(
   // related to job-hold-until...
   job->state         = IPP_JSTATE_PENDING;
   job->state_reasons &= (pappl_jreason_t)~(PAPPL_JREASON_JOB_HOLD_UNTIL_SPECIFIED | PAPPL_JREASON_JOB_RELEASE_WAIT);
+  job->hold_until    = 0;
 
   if ((attr = ippFindAttribute(job->attrs, "job-hold-until", IPP_TAG_KEYWORD)) != NULL)
     ippDeleteAttribute(job->attrs, attr);
@@ -625,6 +954,10 @@ _papplJobReleaseNoLock(
   if ((attr = ippFindAttribute(job->attrs, "job-release-action", IPP_TAG_KEYWORD)) != NULL)
     ippDeleteAttribute(job->attrs, attr);
 
+  _papplPrinterUpdateJobTimerNoLock(job->printer, job);
+  _papplPrinterQueueJobNoLock(job->printer, job);
+  _papplSystemObjectChanged(job->system, &job->state_changes);
+
   if (username)
     _papplSystemAddEventNoLock(job->system, job->printer, job, PAPPL_EVENT_JOB_STATE_CHANGED, "Job released by '%s'.", username);
 }
@@ -644,31 +977,36 @@ _papplJobRemoveFiles(pappl_job_t *job)	// I - Job
   const char *tempdir = papplGetTempDir();
 					// Location of temporary files
   size_t templen = strlen(tempdir);	// Length of temporary directory
-  char		filename[1024];		// Document attributes file
 
 
   _PAPPL_DEBUG("**** _papplJobRemoveFiles(job=%p(%d)) ****\n", job, job->job_id);
 
   for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
   {
-    // Only remove the file if it is in spool or temporary directory...
-    if (doc->filename)
+    // Only remove the file if it is not shared with other jobs and is in the
+    // memory spool, spool, or temporary directory...
+    if (doc->filename && !_papplJobReleaseSharedFile(job, doc->filename) && !_papplJobRemoveMemoryFile(job, doc->filename))
     {
       if ((!strncmp(doc->filename, job->system->directory, dirlen) && doc->filename[dirlen] == '/') || (!strncmp(doc->filename, tempdir, templen) && doc->filename[templen] == '/'))
-	unlink(doc->filename);
+	_papplJobQueueRemove(job, doc->filename);
     }
 
     free(doc->filename);
+    _papplStrFree(doc->format);
     doc->filename = NULL;
     doc->format   = NULL;
 
     ippDelete(doc->attrs);
-    doc->attrs = NULL;
+    doc->attrs         = NULL;
+    doc->attrs_data    = NULL;
+    doc->attrs_datalen = 0;
 
-    papplJobOpenFile(job, doc_number, filename, sizeof(filename), job->system->directory, "ipp", /*format*/NULL, /*mode*/"x");
+    remove_file(job, doc_number, "ipp");
   }
 
   job->num_documents = 0;
+
+  _papplSystemObjectChanged(job->system, &job->state_changes);
 }
 
 
@@ -692,7 +1030,7 @@ papplJobRetain(
     return (false);
 
   // Lock the printer and job so we can change it...
-  _papplRWLockRead(job->printer);
+  _papplRWLockWrite(job->printer);
   _papplRWLockWrite(job);
 
   // Only hold jobs that haven't entered the processing state...
@@ -841,6 +1179,9 @@ _papplJobSetRetainNoLock(
   {
     job->retain_until = ippDateToTime(ippGetDate(attr, 0));
   }
+
+  // Schedule the removal of the document data as needed...
+  _papplPrinterUpdateJobTimerNoLock(job->printer, job);
 }
 
 
@@ -934,9 +1275,13 @@ _papplJobSubmitFile(
   }
 
   // Save the print file information...
-  doc = job->documents + job->num_documents;
+  if ((doc = _papplJobAddDocumentNoLock(job)) == NULL)
+  {
+    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate document information.");
+    goto abort_job;
+  }
 
-  if ((doc->filename = strdup(filename)) != NULL && (doc->format = strdup(format)) != NULL)
+  if ((doc->filename = strdup(filename)) != NULL && (doc->format = _papplStrAlloc(format)) != NULL)
   {
     ipp_attribute_t	*attr;		// Attribute
     pappl_event_t	event = PAPPL_EVENT_JOB_STATE_CHANGED;
@@ -956,8 +1301,8 @@ _papplJobSubmitFile(
 
     if (!stat(filename, &fileinfo))
     {
-      doc->k_octets = fileinfo.st_size;
-      job->k_octets += doc->k_octets;
+      _papplAtomicSet(&doc->k_octets, fileinfo.st_size);
+      _papplAtomicAdd(&job->k_octets, fileinfo.st_size);
     }
 
     doc->state = IPP_DSTATE_PENDING;
@@ -966,6 +1311,8 @@ _papplJobSubmitFile(
 
     job->num_documents ++;
 
+    _papplSystemObjectChanged(job->system, &job->state_changes);
+
     if (!job->printer->hold_new_jobs && !(job->state_reasons & PAPPL_JREASON_JOB_HOLD_UNTIL_SPECIFIED) && last_document)
     {
       // Process the job...
@@ -1003,6 +1350,7 @@ _papplJobSubmitFile(
 
       _papplRWUnlock(job);
       _papplRWLockWrite(job->printer);
+      _papplPrinterQueueJobNoLock(job->printer, job);
       _papplPrinterCheckJobsNoLock(job->printer);
       _papplRWUnlock(job->printer);
       return;
@@ -1029,16 +1377,14 @@ _papplJobSubmitFile(
 
   _papplRWUnlock(job);
 
-  if (!strncmp(filename, job->system->directory, dirlen) && filename[dirlen] == '/')
+  if (!_papplJobReleaseSharedFile(job, filename) && !_papplJobRemoveMemoryFile(job, filename) && !strncmp(filename, job->system->directory, dirlen) && filename[dirlen] == '/')
     unlink(filename);
 
   _papplRWLockWrite(job->printer);
   cupsArrayRemove(job->printer->active_jobs, job);
   cupsArrayAdd(job->printer->completed_jobs, job);
+  _papplPrinterNeedCleanNoLock(job->printer);
   _papplRWUnlock(job->printer);
-
-  if (!job->system->clean_time)
-    job->system->clean_time = time(NULL) + 60;
 }
 
 
@@ -1064,11 +1410,13 @@ _papplPrinterCheckJobsNoLock(
   if (printer->device_in_use)
   {
     papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is in use.");
+    _papplPrinterCheckLookAheadNoLock(printer);
     return;
   }
   else if (printer->processing_job)
   {
     papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Printer is already processing job %d.", printer->processing_job->job_id);
+    _papplPrinterCheckLookAheadNoLock(printer);
     return;
   }
   else if (printer->is_deleted)
@@ -1082,88 +1430,265 @@ _papplPrinterCheckJobsNoLock(
     return;
   }
 
-  // Enumerate the jobs.  Since we have a writer (exclusive) lock, we are the
-  // only thread enumerating and can use cupsArrayGetFirst/Last...
-  for (job = (pappl_job_t *)cupsArrayGetFirst(printer->active_jobs); job; job = (pappl_job_t *)cupsArrayGetNext(printer->active_jobs))
+  // Start the next job in scheduling order (held jobs are released by their
+  // timers).  Pools start a job on each idle member printer...
+  if (printer->pool_members && cupsArrayGetCount(printer->pool_members) > 0)
   {
-    if (job->state == IPP_JSTATE_HELD && job->hold_until && job->hold_until >= time(NULL))
+    pappl_job_t	*next;			// Next job
+    size_t	count = 0;		// Number of jobs started
+
+    while (_papplPrinterGetNextJobsNoLock(printer, 1, &next) == 1 && _papplPrinterReservePoolMemberNoLock(printer, next))
     {
-      // Release job when the hold time arrives...
-      _papplRWLockWrite(job);
-      _papplJobReleaseNoLock(job, NULL);
-      _papplRWUnlock(job);
+      job = _papplPrinterDequeueJobNoLock(printer);
+
+      papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Starting job %d on '%s'.", job->job_id, job->pool_member->name);
+      start_job_thread(printer, job);
+      count ++;
     }
 
-    if (job->state == IPP_JSTATE_PENDING && !(job->state_reasons & PAPPL_JREASON_JOB_FETCHABLE))
-    {
-      cups_thread_t	t;		// Thread
+    if (count == 0)
+      papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "No jobs to process at this time.");
 
-      papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Starting job %d.", job->job_id);
+    _papplPrinterCheckLookAheadNoLock(printer);
+  }
+  else if ((job = _papplPrinterDequeueJobNoLock(printer)) != NULL)
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Starting job %d.", job->job_id);
+    start_job_thread(printer, job);
+  }
+  else
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "No jobs to process at this time.");
+  }
+}
 
-      if ((t = cupsThreadCreate((void *(*)(void *))_papplJobProcess, job)) == CUPS_THREAD_INVALID)
-      {
-	job->state     = IPP_JSTATE_ABORTED;
-	job->completed = time(NULL);
 
-	cupsArrayRemove(printer->active_jobs, job);
-	cupsArrayAdd(printer->completed_jobs, job);
+//
+// '_papplPrinterCheckLookAheadNoLock()' - Start look-ahead processing of the
+//                                         next pending job, if needed.
+//
 
-	if (!printer->system->clean_time)
-	  printer->system->clean_time = time(NULL) + 60;
-      }
-      else
-      {
-	cupsThreadDetach(t);
-      }
-      break;
-    }
+void
+_papplPrinterCheckLookAheadNoLock(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_job_t	**jobs,			// Next pending jobs
+		*job,			// Current job
+		*next = NULL;		// Next job to process ahead of time
+  size_t	i,			// Looping var
+		count,			// Number of pending jobs
+		size = 0;		// Disk space used by look-ahead output
+  cups_thread_t	t;			// Thread
+
+
+  if (printer->lookahead_jobs <= 0 || printer->lookahead_job || printer->output_devices || printer->is_deleted || !papplSystemIsRunning(printer->system))
+    return;
+
+  // Find the first of the next N pending jobs without look-ahead output, in
+  // the same order as _papplPrinterCheckJobsNoLock will start them...
+  if ((jobs = calloc((size_t)printer->lookahead_jobs, sizeof(pappl_job_t *))) == NULL)
+    return;
+
+  count = _papplPrinterGetNextJobsNoLock(printer, (size_t)printer->lookahead_jobs, jobs);
+
+  for (i = 0; i < count; i ++)
+  {
+    job = jobs[i];
+
+    if (job->num_documents == 0)
+      continue;
+
+    if (job->prerip_state == _PAPPL_PRERIP_READY)
+      size += (size_t)job->prerip_size;
+    else if (job->prerip_state == _PAPPL_PRERIP_NONE && !next)
+      next = job;
   }
 
-  if (!job)
-    papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "No jobs to process at this time.");
+  free(jobs);
+
+  if (!next || (printer->lookahead_size > 0 && size >= printer->lookahead_size))
+    return;
+
+  papplLogPrinter(printer, PAPPL_LOGLEVEL_DEBUG, "Starting look-ahead processing of job %d.", next->job_id);
+
+  _papplRWLockWrite(next);
+  next->prerip_state = _PAPPL_PRERIP_RUNNING;
+  _papplRWUnlock(next);
+
+  printer->lookahead_job = next;
+
+  if ((t = cupsThreadCreate((void *(*)(void *))_papplJobPreRIP, next)) == CUPS_THREAD_INVALID)
+  {
+    _papplRWLockWrite(next);
+    next->prerip_state = _PAPPL_PRERIP_FAILED;
+    _papplRWUnlock(next);
+
+    _papplJobPreRIPDone(next);
+
+    printer->lookahead_job = NULL;
+  }
+  else
+  {
+    cupsThreadDetach(t);
+  }
+}
+
+
+//
+// '_papplPrinterCheckPoolJobs()' - Check for new jobs to process on a member
+//                                  printer's pool.
+//
+// This function is called when a pool member printer becomes idle.  The caller
+// must not hold any printer locks.
+//
+
+void
+_papplPrinterCheckPoolJobs(
+    pappl_printer_t *printer)		// I - Member printer
+{
+  pappl_printer_t	*pool;		// Pool printer
+
+
+  _papplRWLockRead(printer);
+  pool = printer->pool;
+  _papplRWUnlock(printer);
+
+  if (pool)
+  {
+    _papplRWLockWrite(pool);
+    _papplPrinterCheckJobsNoLock(pool);
+    _papplRWUnlock(pool);
+  }
 }
 
 
 //
 // '_papplPrinterCleanJobsNoLock()' - Clean completed jobs for a printer.
 //
+// Completed jobs are removed, oldest first, while there are more than the
+// maximum number of completed jobs.  Jobs that completed within the last 60
+// seconds are kept and the clean is rescheduled for when they become eligible.
+// The attributes of completed jobs beyond the maximum number of resident jobs
+// are then saved to the spool directory and freed, once they have not been
+// used for 60 seconds.
+//
 
 void
 _papplPrinterCleanJobsNoLock(
     pappl_printer_t *printer)		// I - Printer
 {
-  time_t	cleantime;		// Clean time
+  time_t	curtime,		// Current time
+		cleantime,		// Clean time
+		access_time;		// Last use of job attributes
   pappl_job_t	*job;			// Current job
-  size_t	preserved;		// Number of preserved jobs
+  size_t	preserved,		// Number of preserved jobs
+		resident;		// Number of resident jobs
 
 
-  if (cupsArrayGetCount(printer->completed_jobs) == 0 || (printer->max_preserved_jobs == 0 && printer->max_completed_jobs <= 0))
+  printer->clean_time = 0;
+
+  if (cupsArrayGetCount(printer->completed_jobs) == 0 || (printer->max_preserved_jobs == 0 && printer->max_completed_jobs <= 0 && printer->max_resident_jobs == 0))
+  {
+    update_printer_timer(printer);
     return;
+  }
+
+  curtime   = time(NULL);
+  cleantime = curtime - 60;
 
-  // Enumerate the jobs.  Since we have a writer (exclusive) lock, we are the
+  // Completed jobs are sorted by descending job ID, so the oldest jobs are at
+  // the end of the array.  Since we have a writer (exclusive) lock, we are the
   // only thread enumerating and can use cupsArrayGetFirst/Last...
-  for (job = (pappl_job_t *)cupsArrayGetFirst(printer->completed_jobs), cleantime = time(NULL) - 60, preserved = 0; job; job = (pappl_job_t *)cupsArrayGetNext(printer->completed_jobs))
+  if (printer->max_completed_jobs > 0)
   {
-    if (job->completed && job->completed < cleantime && printer->max_completed_jobs > 0 && cupsArrayGetCount(printer->completed_jobs) > printer->max_completed_jobs)
+    while (cupsArrayGetCount(printer->completed_jobs) > printer->max_completed_jobs && (job = (pappl_job_t *)cupsArrayGetLast(printer->completed_jobs)) != NULL)
     {
+      if (job == printer->lookahead_job)
+      {
+        // Try again once the look-ahead thread is done with the job...
+        printer->clean_time = curtime + 1;
+        break;
+      }
+      else if (job->completed >= cleantime)
+      {
+        // Try again once the job is old enough...
+        printer->clean_time = job->completed + 61;
+        break;
+      }
+
+      add_removed_job(printer, job);
+      _papplHeapRemove(printer->timer_jobs, job);
       cupsArrayRemove(printer->completed_jobs, job);
       cupsArrayRemove(printer->all_jobs, job);
     }
-    else if (printer->max_preserved_jobs > 0)
+  }
+
+  // Then remove the document data for preserved jobs over the limit, newest
+  // first...
+  if (printer->max_preserved_jobs > 0)
+  {
+    for (job = (pappl_job_t *)cupsArrayGetFirst(printer->completed_jobs), preserved = 0; job; job = (pappl_job_t *)cupsArrayGetNext(printer->completed_jobs))
     {
-      if (job->num_documents > 0)
+      if (job->num_documents > 0 && (preserved ++) >= printer->max_preserved_jobs)
       {
-	if ((preserved + 1) > printer->max_preserved_jobs || (job->retain_until && time(NULL) > job->retain_until))
-	  _papplJobRemoveFiles(job);
-	else
-	  preserved ++;
+        _papplJobRemoveFiles(job);
+        update_job_timer(printer, job);
       }
     }
-    else
+  }
+
+  // Finally save the attributes of older jobs to the spool directory...
+  if (printer->max_resident_jobs > 0)
+  {
+    for (job = (pappl_job_t *)cupsArrayGetFirst(printer->completed_jobs), resident = 0; job; job = (pappl_job_t *)cupsArrayGetNext(printer->completed_jobs))
     {
-      break;
+      if ((resident ++) < printer->max_resident_jobs || job->is_evicted || job == printer->lookahead_job)
+        continue;
+
+      // Jobs that completed or had their attributes used within the last 60
+      // seconds stay in memory...
+      if ((access_time = _papplAtomicGet(&job->access_time)) < job->completed)
+        access_time = job->completed;
+
+      if (access_time >= cleantime)
+      {
+        // Try again once the job is old enough...
+        if (!printer->clean_time || printer->clean_time > (access_time + 61))
+          printer->clean_time = access_time + 61;
+        continue;
+      }
+
+      _papplRWLockWrite(job);
+      _papplJobEvictNoLock(job);
+      _papplRWUnlock(job);
     }
   }
+
+  update_printer_timer(printer);
+}
+
+
+//
+// '_papplPrinterDequeueJobNoLock()' - Remove the next job to process from the
+//                                     scheduling queue.
+//
+// The caller must hold the printer write lock.
+//
+
+pappl_job_t *				// O - Next job or `NULL` if none
+_papplPrinterDequeueJobNoLock(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_job_t	*job;			// Next job
+  double	pass;			// Fair-share pass value for job
+
+
+  // Advance the fair-share virtual time to the start of this job so that idle
+  // users don't accumulate credit...
+  if ((job = sched_pop(printer, &pass)) != NULL && printer->fair_share)
+    printer->share_pass = pass;
+
+  return (job);
 }
 
 
@@ -1210,42 +1735,927 @@ _papplPrinterFindJobNoLock(
 
 
 //
-// 'papplSystemCleanJobs()' - Clean out old (completed) jobs.
+// '_papplPrinterGetNextJobsNoLock()' - Get the next jobs to process without
+//                                      removing them from the scheduling queue.
 //
-// This function deletes all old (completed) jobs above the limit set by the
-// @link papplPrinterSetMaxCompletedJobs@ function.  The level may temporarily
-// exceed this limit if the jobs were completed within the last 60 seconds.
+// The caller must hold the printer write lock.
 //
-// > Note: This function is normally called automatically from the
-// > @link papplSystemRun@ function.
+
+size_t					// O - Number of jobs
+_papplPrinterGetNextJobsNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    size_t          max_jobs,		// I - Maximum number of jobs
+    pappl_job_t     **jobs)		// O - Jobs in processing order
+{
+  size_t	i,			// Looping var
+		count;			// Number of jobs
+  double	*passes;		// Fair-share pass values
+
+
+  if (max_jobs == 0 || (passes = calloc(max_jobs, sizeof(double))) == NULL)
+    return (0);
+
+  // Remove the jobs in order and then put them back in reverse order, which
+  // restores the fair-share pass values...
+  for (count = 0; count < max_jobs; count ++)
+  {
+    if ((jobs[count] = sched_pop(printer, passes + count)) == NULL)
+      break;
+  }
+
+  for (i = count; i > 0; i --)
+    sched_push(printer, jobs[i - 1], passes[i - 1]);
+
+  free(passes);
+
+  return (count);
+}
+
+
+//
+// '_papplPrinterGetShareNoLock()' - Find or create a fair-share user.
+//
+// The caller must hold the printer write lock when "create" is `true`.
+//
+
+_pappl_share_t *			// O - Fair-share user or `NULL`
+_papplPrinterGetShareNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    const char      *username,		// I - Username
+    bool            create)		// I - Create user as needed?
+{
+  _pappl_share_t	key,		// Search key
+			*share;		// Fair-share user
+
+
+  key.username = (char *)(username ? username : "anonymous");
+
+  if ((share = (_pappl_share_t *)cupsArrayFind(printer->shares, &key)) != NULL || !create)
+    return (share);
+
+  if (!printer->shares && (printer->shares = cupsArrayNew((cups_array_cb_t)compare_shares, NULL, NULL, 0, NULL, (cups_afree_cb_t)free_share)) == NULL)
+    return (NULL);
+
+  if (!printer->share_heap && (printer->share_heap = _papplHeapCreate((_pappl_heap_cb_t)compare_share_pass, NULL, offsetof(_pappl_share_t, index))) == NULL)
+    return (NULL);
+
+  if ((share = (_pappl_share_t *)calloc(1, sizeof(_pappl_share_t))) == NULL)
+    return (NULL);
+
+  share->username = strdup(key.username);
+  share->weight   = 1;
+  share->pass     = printer->share_pass;
+  share->jobs     = _papplHeapCreate((_pappl_heap_cb_t)compare_sched_jobs, printer, offsetof(pappl_job_t, sched_index));
+
+  if (!share->username || !share->jobs)
+  {
+    free_share(share, NULL);
+    return (NULL);
+  }
+
+  cupsArrayAdd(printer->shares, share);
+
+  return (share);
+}
+
+
+//
+// '_papplPrinterNeedCleanNoLock()' - Schedule pruning of completed jobs.
+//
+// The caller must hold the printer write lock.
 //
 
 void
-papplSystemCleanJobs(
-    pappl_system_t *system)		// I - System
+_papplPrinterNeedCleanNoLock(
+    pappl_printer_t *printer)		// I - Printer
 {
-  size_t		i,		// Looping var
-			count;		// Number of printers
-  pappl_printer_t	*printer;	// Current printer
+  if (printer->clean_time)
+    return;
+
+  if ((printer->max_completed_jobs > 0 && cupsArrayGetCount(printer->completed_jobs) > printer->max_completed_jobs) || (printer->max_resident_jobs > 0 && cupsArrayGetCount(printer->completed_jobs) > printer->max_resident_jobs) || printer->max_preserved_jobs > 0)
+  {
+    printer->clean_time = time(NULL) + 60;
+    update_printer_timer(printer);
+  }
+}
 
 
-  _papplRWLockRead(system);
+//
+// '_papplPrinterQueueJobNoLock()' - Add a pending job to the scheduling queue.
+//
+// The caller must hold the printer write lock.  Jobs that are not pending or
+// that are already queued are ignored.
+//
 
-  // Loop through the printers.
-  //
-  // Note: Cannot use cupsArrayGetFirst/Last since other threads might be
-  // enumerating the printers array.
+void
+_papplPrinterQueueJobNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
+{
+  _pappl_share_t	*share;		// Fair-share user
 
-  for (i = 0, count = cupsArrayGetCount(system->printers); i < count; i ++)
+
+  // Infrastructure Printers don't schedule jobs - the Proxy fetches them...
+  if (printer->output_devices || job->sched_index || job->state != IPP_JSTATE_PENDING || (job->state_reasons & PAPPL_JREASON_JOB_FETCHABLE))
+    return;
+
+  if (!printer->fair_share)
   {
-    printer = (pappl_printer_t *)cupsArrayGetElement(system->printers, i);
+    // Simple priority queue...
+    if (!printer->pending_jobs && (printer->pending_jobs = _papplHeapCreate((_pappl_heap_cb_t)compare_sched_jobs, printer, offsetof(pappl_job_t, sched_index))) == NULL)
+      return;
 
-    _papplRWLockWrite(printer);
-    _papplPrinterCleanJobsNoLock(printer);
-    _papplRWUnlock(printer);
+    _papplHeapAdd(printer->pending_jobs, job);
+    return;
   }
 
-  system->clean_time = 0;
+  // Weighted fair-share queue - a user that has been idle starts at the
+  // current pass value rather than using the credit they would have accrued...
+  if ((share = _papplPrinterGetShareNoLock(printer, job->username, true)) == NULL)
+    return;
+
+  if (!share->index && share->pass < printer->share_pass)
+    share->pass = printer->share_pass;
 
-  _papplRWUnlock(system);
+  _papplHeapAdd(share->jobs, job);
+  _papplHeapAdd(printer->share_heap, share);
+}
+
+
+//
+// '_papplPrinterRebuildQueueNoLock()' - Rebuild the scheduling queue.
+//
+// This function is called after changing the scheduling parameters.  The
+// caller must hold the printer write lock.
+//
+
+void
+_papplPrinterRebuildQueueNoLock(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_job_t		*job;		// Current job
+  _pappl_share_t	*share;		// Current fair-share user
+
+
+  // Clear the existing queues...
+  _papplHeapDelete(printer->pending_jobs);
+  printer->pending_jobs = NULL;
+
+  _papplHeapDelete(printer->share_heap);
+  printer->share_heap = NULL;
+
+  for (share = (_pappl_share_t *)cupsArrayGetFirst(printer->shares); share; share = (_pappl_share_t *)cupsArrayGetNext(printer->shares))
+  {
+    _papplHeapDelete(share->jobs);
+    share->jobs = _papplHeapCreate((_pappl_heap_cb_t)compare_sched_jobs, printer, offsetof(pappl_job_t, sched_index));
+  }
+
+  // Then add the pending jobs back...
+  for (job = (pappl_job_t *)cupsArrayGetFirst(printer->active_jobs); job; job = (pappl_job_t *)cupsArrayGetNext(printer->active_jobs))
+    _papplPrinterQueueJobNoLock(printer, job);
+}
+
+
+//
+// '_papplPrinterReservePoolMemberNoLock()' - Reserve an idle pool member for a
+//                                            job.
+//
+// This function assigns the job to the first member printer that is not
+// processing a job, in use, or stopped.  The caller must hold the pool
+// printer's write lock.
+//
+
+bool					// O - `true` if reserved, `false` if no member is idle
+_papplPrinterReservePoolMemberNoLock(
+    pappl_printer_t *printer,		// I - Pool printer
+    pappl_job_t     *job)		// I - Job
+{
+  size_t		i,		// Looping var
+			count;		// Number of members
+  pappl_printer_t	*member;	// Member printer
+
+
+  for (i = 0, count = cupsArrayGetCount(printer->pool_members); i < count; i ++)
+  {
+    member = (pappl_printer_t *)cupsArrayGetElement(printer->pool_members, i);
+
+    _papplRWLockWrite(member);
+
+    if (!member->processing_job && !member->device_in_use && !member->is_deleted && !member->is_stopped && member->state != IPP_PSTATE_STOPPED)
+    {
+      member->processing_job = job;
+      job->pool_member       = member;
+
+      _papplRWUnlock(member);
+
+      printer->pool_processing ++;
+      return (true);
+    }
+
+    _papplRWUnlock(member);
+  }
+
+  return (false);
+}
+
+
+//
+// '_papplPrinterRunTimersNoLock()' - Run expired job timers for a printer.
+//
+// Held jobs are released when their "job-hold-until" time arrives, document
+// data is removed when a completed job's "job-retain-until" time passes, and
+// completed jobs are pruned.  The caller must hold the printer write lock.
+//
+
+void
+_papplPrinterRunTimersNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    time_t          curtime)		// I - Current time
+{
+  pappl_job_t	*job;			// Current job
+  bool		released = false;	// Were any jobs released?
+
+
+  while ((job = (pappl_job_t *)_papplHeapGetFirst(printer->timer_jobs)) != NULL && job->timer_time <= curtime)
+  {
+    _papplHeapRemove(printer->timer_jobs, job);
+    job->timer_time = 0;
+
+    _papplRWLockWrite(job);
+
+    if (job->state == IPP_JSTATE_HELD && job->hold_until && job->hold_until <= curtime)
+    {
+      // Release job when the hold time arrives...
+      papplLogJob(job, PAPPL_LOGLEVEL_INFO, "Releasing held job.");
+      _papplJobReleaseNoLock(job, NULL);
+      _papplSystemAddEventNoLock(job->system, printer, job, PAPPL_EVENT_JOB_STATE_CHANGED, "Job released.");
+      released = true;
+    }
+    else if (job->state >= IPP_JSTATE_CANCELED && job->num_documents > 0 && job->retain_until && job->retain_until < curtime)
+    {
+      // Remove document data when the retention time has passed...
+      papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Removing document data after retention time.");
+      _papplJobRemoveFiles(job);
+    }
+
+    update_job_timer(printer, job);
+
+    _papplRWUnlock(job);
+  }
+
+  if (printer->clean_time && printer->clean_time <= curtime)
+    _papplPrinterCleanJobsNoLock(printer);
+
+  if (released)
+    _papplPrinterCheckJobsNoLock(printer);
+
+  update_printer_timer(printer);
+}
+
+
+//
+// '_papplPrinterUnqueueJobNoLock()' - Remove a job from the scheduling queue.
+//
+// The caller must hold the printer write lock.
+//
+
+void
+_papplPrinterUnqueueJobNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
+{
+  _pappl_share_t	*share;		// Fair-share user
+
+
+  if (!job->sched_index)
+    return;
+
+  if (!printer->fair_share)
+  {
+    _papplHeapRemove(printer->pending_jobs, job);
+  }
+  else if ((share = _papplPrinterGetShareNoLock(printer, job->username, false)) != NULL && _papplHeapRemove(share->jobs, job) && _papplHeapGetCount(share->jobs) == 0)
+  {
+    _papplHeapRemove(printer->share_heap, share);
+  }
+}
+
+
+//
+// '_papplPrinterUpdateJobTimerNoLock()' - Update the hold/retain timer for a job.
+//
+// The caller must hold the printer write lock.
+//
+
+void
+_papplPrinterUpdateJobTimerNoLock(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
+{
+  update_job_timer(printer, job);
+  update_printer_timer(printer);
+}
+
+
+//
+// 'papplSystemCleanJobs()' - Clean out old (completed) jobs.
+//
+// This function deletes all old (completed) jobs above the limit set by the
+// @link papplPrinterSetMaxCompletedJobs@ function.  The level may temporarily
+// exceed this limit if the jobs were completed within the last 60 seconds.
+//
+// > Note: This function is normally called automatically from the
+// > @link papplSystemRun@ function.
+//
+
+void
+papplSystemCleanJobs(
+    pappl_system_t *system)		// I - System
+{
+  size_t		i,		// Looping var
+			count;		// Number of printers
+  pappl_printer_t	*printer;	// Current printer
+
+
+  _papplRWLockRead(system);
+
+  // Loop through the printers.
+  //
+  // Note: Cannot use cupsArrayGetFirst/Last since other threads might be
+  // enumerating the printers array.
+
+  for (i = 0, count = cupsArrayGetCount(system->printers); i < count; i ++)
+  {
+    printer = (pappl_printer_t *)cupsArrayGetElement(system->printers, i);
+
+    _papplRWLockWrite(printer);
+    _papplPrinterCleanJobsNoLock(printer);
+    _papplRWUnlock(printer);
+  }
+
+  _papplRWUnlock(system);
+}
+
+
+//
+// '_papplSystemRunJobTimers()' - Run expired job timers for all printers.
+//
+
+void
+_papplSystemRunJobTimers(
+    pappl_system_t *system,		// I - System
+    time_t         curtime)		// I - Current time
+{
+  pappl_printer_t	*printer;	// Current printer
+
+
+  // Printers cannot be removed from the system while we hold the system lock,
+  // so any printer we pull from the timer heap stays valid...
+  _papplRWLockRead(system);
+  cupsMutexLock(&system->job_timer_mutex);
+
+  while ((printer = (pappl_printer_t *)_papplHeapGetFirst(system->job_timers)) != NULL && printer->timer_time <= curtime)
+  {
+    _papplHeapRemove(system->job_timers, printer);
+    printer->timer_time = 0;
+
+    cupsMutexUnlock(&system->job_timer_mutex);
+
+    _papplRWLockWrite(printer);
+    _papplPrinterRunTimersNoLock(printer, curtime);
+    _papplRWUnlock(printer);
+
+    cupsMutexLock(&system->job_timer_mutex);
+  }
+
+  cupsMutexUnlock(&system->job_timer_mutex);
+  _papplRWUnlock(system);
+}
+
+
+//
+// '_papplSystemSetWakeTime()' - Set the next wakeup time for the run loop.
+//
+// This function returns the earlier of "next" and the next job timer, and
+// records it so that earlier job timers can wake up the run loop.
+//
+
+time_t					// O - Next wakeup time
+_papplSystemSetWakeTime(
+    pappl_system_t *system,		// I - System
+    time_t         next)		// I - Next wakeup time for other work
+{
+  pappl_printer_t	*printer;	// First printer with a timer
+
+
+  cupsMutexLock(&system->job_timer_mutex);
+
+  if ((printer = (pappl_printer_t *)_papplHeapGetFirst(system->job_timers)) != NULL && printer->timer_time < next)
+    next = printer->timer_time;
+
+  system->wake_time = next;
+
+  cupsMutexUnlock(&system->job_timer_mutex);
+
+  return (next);
+}
+
+
+//
+// '_papplSystemUpdateJobTimer()' - Update the job timer for a printer.
+//
+// The caller must hold the printer write lock.
+//
+
+void
+_papplSystemUpdateJobTimer(
+    pappl_system_t  *system,		// I - System
+    pappl_printer_t *printer,		// I - Printer
+    time_t          timer_time)		// I - Time of next timer or `0` for none
+{
+  bool	wake = false;			// Wake up the run loop?
+
+
+  cupsMutexLock(&system->job_timer_mutex);
+
+  if (timer_time)
+  {
+    if (!system->job_timers)
+      system->job_timers = _papplHeapCreate((_pappl_heap_cb_t)compare_printer_timers, NULL, offsetof(pappl_printer_t, timer_index));
+
+    printer->timer_time = timer_time;
+
+    if (_papplHeapAdd(system->job_timers, printer) && system->wake_time && timer_time < system->wake_time)
+    {
+      // Only wake the run loop once...
+      system->wake_time = 0;
+      wake              = true;
+    }
+  }
+  else
+  {
+    _papplHeapRemove(system->job_timers, printer);
+    printer->timer_time = 0;
+  }
+
+  cupsMutexUnlock(&system->job_timer_mutex);
+
+#if !_WIN32
+  if (wake && system->wake_pipe[1] >= 0)
+  {
+    // Wake up the run loop so the timer runs on time...
+    char	ch = 0;			// Wakeup byte
+
+    if (write(system->wake_pipe[1], &ch, 1) < 0)
+      papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Unable to wake up run loop: %s", strerror(errno));
+  }
+#endif // !_WIN32
+}
+
+
+//
+// 'add_removed_job()' - Record a job that was removed from the job history.
+//
+// The list of removed jobs is written to the state journal on the next save.
+//
+
+static void
+add_removed_job(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
+{
+  pappl_system_t	*system = printer->system;
+					// System
+
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->is_running)
+  {
+    if (printer->num_removed_jobs >= printer->alloc_removed_jobs)
+    {
+      size_t	alloc_removed_jobs = printer->alloc_removed_jobs ? 2 * printer->alloc_removed_jobs : 16;
+					// New allocation
+      int	*removed_jobs;		// New array
+
+      if ((removed_jobs = realloc(printer->removed_jobs, alloc_removed_jobs * sizeof(int))) == NULL)
+      {
+        // Write a full snapshot on the next save instead...
+        system->state_changes = ++ system->config_changes;
+        cupsCondBroadcast(&system->save_cond);
+        cupsMutexUnlock(&system->config_mutex);
+        return;
+      }
+
+      printer->alloc_removed_jobs = alloc_removed_jobs;
+      printer->removed_jobs       = removed_jobs;
+    }
+
+    printer->removed_jobs[printer->num_removed_jobs ++] = job->job_id;
+
+    system->config_time    = time(NULL);
+    printer->state_changes = ++ system->config_changes;
+
+    cupsCondBroadcast(&system->save_cond);
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+}
+
+
+//
+// 'compare_printer_timers()' - Compare two printers by job timer.
+//
+
+static int				// O - Result of comparison
+compare_printer_timers(
+    pappl_printer_t *a,			// I - First printer
+    pappl_printer_t *b,			// I - Second printer
+    void            *data)		// I - Callback data (unused)
+{
+  (void)data;
+
+  if (a->timer_time < b->timer_time)
+    return (-1);
+  else if (a->timer_time > b->timer_time)
+    return (1);
+  else
+    return (a->printer_id - b->printer_id);
+}
+
+
+//
+// 'compare_sched_jobs()' - Compare two jobs for scheduling.
+//
+// Jobs with a higher "job-priority" value come first, followed by older jobs.
+// When priority aging is enabled, a job's priority increases by one for every
+// "priority_aging" seconds it waits, which gives the same order as comparing
+// "priority * priority_aging - created" and keeps the heap order stable over
+// time.
+//
+
+static int				// O - Result of comparison
+compare_sched_jobs(
+    pappl_job_t     *a,			// I - First job
+    pappl_job_t     *b,			// I - Second job
+    pappl_printer_t *printer)		// I - Printer
+{
+  time_t	akey,			// Scheduling key for first job
+		bkey;			// Scheduling key for second job
+
+
+  if (printer->priority_aging > 0)
+  {
+    akey = (time_t)a->priority * printer->priority_aging - a->created;
+    bkey = (time_t)b->priority * printer->priority_aging - b->created;
+  }
+  else
+  {
+    akey = a->priority;
+    bkey = b->priority;
+  }
+
+  if (akey > bkey)
+    return (-1);
+  else if (akey < bkey)
+    return (1);
+  else
+    return (a->job_id - b->job_id);
+}
+
+
+//
+// 'compare_share_pass()' - Compare two fair-share users by pass value.
+//
+
+static int				// O - Result of comparison
+compare_share_pass(
+    _pappl_share_t *a,			// I - First user
+    _pappl_share_t *b,			// I - Second user
+    void           *data)		// I - Callback data (unused)
+{
+  (void)data;
+
+  if (a->pass < b->pass)
+    return (-1);
+  else if (a->pass > b->pass)
+    return (1);
+  else
+    return (strcmp(a->username, b->username));
+}
+
+
+//
+// 'compare_shares()' - Compare two fair-share users by name.
+//
+
+static int				// O - Result of comparison
+compare_shares(_pappl_share_t *a,	// I - First user
+               _pappl_share_t *b,	// I - Second user
+               void           *data)	// I - Callback data (unused)
+{
+  (void)data;
+
+  return (strcmp(a->username, b->username));
+}
+
+
+//
+// 'compare_timer_jobs()' - Compare two jobs by timer.
+//
+
+static int				// O - Result of comparison
+compare_timer_jobs(
+    pappl_job_t *a,			// I - First job
+    pappl_job_t *b,			// I - Second job
+    void        *data)			// I - Callback data (unused)
+{
+  (void)data;
+
+  if (a->timer_time < b->timer_time)
+    return (-1);
+  else if (a->timer_time > b->timer_time)
+    return (1);
+  else
+    return (a->job_id - b->job_id);
+}
+
+
+//
+// 'free_share()' - Free a fair-share user.
+//
+
+static void
+free_share(_pappl_share_t *share,	// I - Fair-share user
+           void           *data)	// I - Callback data (unused)
+{
+  (void)data;
+
+  _papplHeapDelete(share->jobs);
+  free(share->username);
+  free(share);
+}
+
+
+//
+// 'make_filename()' - Make the filename for a job file.
+//
+
+static void
+make_filename(pappl_job_t *job,		// I - Job
+              int         doc_number,	// I - Document number (`1` based)
+              char        *fname,	// I - Filename buffer
+              size_t      fnamesize,	// I - Size of filename buffer
+              const char  *directory,	// I - Directory
+              const char  *ext,		// I - Extension (`NULL` for default)
+              const char  *format)	// I - MIME media type (`NULL` for default)
+{
+  char			name[64],	// "Safe" filename
+			*nameptr;	// Pointer into filename
+  const char		*job_name;	// job-name value
+
+
+  // Make a name from the job-name attribute...
+  if ((job_name = job->name) == NULL)
+    job_name = "untitled";
+
+  if ((nameptr = strrchr(job_name, '/')) != NULL && nameptr[1])
+    job_name = nameptr + 1;
+
+  for (nameptr = name; *job_name && nameptr < (name + sizeof(name) - 1); job_name ++)
+  {
+    if (isalnum(*job_name & 255) || *job_name == '-')
+    {
+      *nameptr++ = (char)tolower(*job_name & 255);
+    }
+    else
+    {
+      *nameptr++ = '_';
+
+      while (job_name[1] && !isalnum(job_name[1] & 255) && job_name[1] != '-')
+        job_name ++;
+    }
+  }
+
+  *nameptr = '\0';
+
+  // Figure out the extension...
+  if (!ext)
+  {
+    if (!format && doc_number > 0 && doc_number <= job->num_documents)
+      format = job->documents[doc_number - 1].format;
+    if (!format)
+      format = "application/octet-stream";
+
+    if (!strcasecmp(format, "image/jpeg"))
+      ext = "jpg";
+    else if (!strcasecmp(format, "image/png"))
+      ext = "png";
+    else if (!strcasecmp(format, "image/pwg-raster"))
+      ext = "pwg";
+    else if (!strcasecmp(format, "image/urf"))
+      ext = "urf";
+    else if (!strcasecmp(format, "application/pdf"))
+      ext = "pdf";
+    else if (!strcasecmp(format, "application/postscript"))
+      ext = "ps";
+    else
+      ext = "prn";
+  }
+
+  // Create a filename with the job-id, job-name, and document-format (extension)...
+  if ((job->system->options & PAPPL_SOPTIONS_MULTI_DOCUMENT_JOBS) && doc_number > 0)
+    snprintf(fname, fnamesize, "%s/p%05dj%09dd%04d-%s.%s", directory, job->printer->printer_id, job->job_id, doc_number, name, ext);
+  else
+    snprintf(fname, fnamesize, "%s/p%05dj%09d-%s.%s", directory, job->printer->printer_id, job->job_id, name, ext);
+
+}
+
+
+//
+// 'remove_file()' - Remove an attribute file for a job.
+//
+
+static void
+remove_file(pappl_job_t *job,		// I - Job
+            int         doc_number,	// I - Document number (`1` based) or `0` for the job
+            const char  *ext)		// I - Extension
+{
+  char	filename[1024];			// Attribute filename
+
+
+  make_filename(job, doc_number, filename, sizeof(filename), job->system->directory, ext, /*format*/NULL);
+  _papplJobQueueRemove(job, filename);
+}
+
+
+//
+// 'sched_pop()' - Remove the next pending job from the scheduling queue.
+//
+// Jobs that are no longer pending are silently dropped.
+//
+
+static pappl_job_t *			// O - Next job or `NULL` if none
+sched_pop(pappl_printer_t *printer,	// I - Printer
+          double          *pass)	// O - Fair-share pass value before job
+{
+  pappl_job_t		*job;		// Next job
+  _pappl_share_t	*share;		// Next fair-share user
+  bool			valid;		// Is the job still pending?
+
+
+  *pass = printer->share_pass;
+
+  if (!printer->fair_share)
+  {
+    while ((job = (pappl_job_t *)_papplHeapRemoveFirst(printer->pending_jobs)) != NULL)
+    {
+      if (job->state == IPP_JSTATE_PENDING && !(job->state_reasons & PAPPL_JREASON_JOB_FETCHABLE))
+        return (job);
+    }
+
+    return (NULL);
+  }
+
+  while ((share = (_pappl_share_t *)_papplHeapGetFirst(printer->share_heap)) != NULL)
+  {
+    job   = (pappl_job_t *)_papplHeapRemoveFirst(share->jobs);
+    valid = job && job->state == IPP_JSTATE_PENDING && !(job->state_reasons & PAPPL_JREASON_JOB_FETCHABLE);
+
+    if (valid)
+    {
+      // Charge the user for this job...
+      *pass       = share->pass;
+      share->pass += 1.0 / share->weight;
+    }
+
+    if (_papplHeapGetCount(share->jobs) > 0)
+      _papplHeapUpdate(printer->share_heap, share);
+    else
+      _papplHeapRemove(printer->share_heap, share);
+
+    if (valid)
+      return (job);
+  }
+
+  return (NULL);
+}
+
+
+//
+// 'sched_push()' - Put a job back into the scheduling queue.
+//
+
+static void
+sched_push(pappl_printer_t *printer,	// I - Printer
+           pappl_job_t     *job,	// I - Job
+           double          pass)	// I - Fair-share pass value before job
+{
+  _pappl_share_t	*share;		// Fair-share user
+
+
+  if (!printer->fair_share)
+  {
+    _papplHeapAdd(printer->pending_jobs, job);
+  }
+  else if ((share = _papplPrinterGetShareNoLock(printer, job->username, true)) != NULL)
+  {
+    share->pass = pass;
+
+    _papplHeapAdd(share->jobs, job);
+    _papplHeapAdd(printer->share_heap, share);
+  }
+}
+
+
+//
+// 'start_job_thread()' - Start a thread to process a job.
+//
+
+static void
+start_job_thread(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
+{
+  cups_thread_t	t;			// Thread
+
+
+  if ((t = cupsThreadCreate((void *(*)(void *))_papplJobProcess, job)) == CUPS_THREAD_INVALID)
+  {
+    job->state     = IPP_JSTATE_ABORTED;
+    job->completed = time(NULL);
+
+    if (job->pool_member)
+    {
+      // Release the pool member...
+      _papplRWLockWrite(job->pool_member);
+      job->pool_member->processing_job = NULL;
+      _papplRWUnlock(job->pool_member);
+
+      job->pool_member = NULL;
+      printer->pool_processing --;
+    }
+
+    cupsArrayRemove(printer->active_jobs, job);
+    cupsArrayAdd(printer->completed_jobs, job);
+
+    _papplPrinterNeedCleanNoLock(printer);
+  }
+  else
+  {
+    cupsThreadDetach(t);
+  }
+}
+
+
+//
+// 'update_job_timer()' - Add, update, or remove the hold/retain timer for a job.
+//
+
+static void
+update_job_timer(
+    pappl_printer_t *printer,		// I - Printer
+    pappl_job_t     *job)		// I - Job
+{
+  time_t	timer_time = 0;		// Time of next timer
+
+
+  if (job->state == IPP_JSTATE_HELD)
+    timer_time = job->hold_until;
+  else if (job->state >= IPP_JSTATE_CANCELED && job->num_documents > 0 && job->retain_until)
+    timer_time = job->retain_until + 1;
+
+  if (timer_time)
+  {
+    if (!printer->timer_jobs && (printer->timer_jobs = _papplHeapCreate((_pappl_heap_cb_t)compare_timer_jobs, NULL, offsetof(pappl_job_t, timer_index))) == NULL)
+      return;
+
+    job->timer_time = timer_time;
+    _papplHeapAdd(printer->timer_jobs, job);
+  }
+  else
+  {
+    _papplHeapRemove(printer->timer_jobs, job);
+    job->timer_time = 0;
+  }
+}
+
+
+//
+// 'update_printer_timer()' - Update the system timer for a printer.
+//
+
+static void
+update_printer_timer(
+    pappl_printer_t *printer)		// I - Printer
+{
+  pappl_job_t	*job;			// First job with a timer
+  time_t	timer_time = printer->clean_time;
+					// Time of next timer
+
+
+  if ((job = (pappl_job_t *)_papplHeapGetFirst(printer->timer_jobs)) != NULL && (!timer_time || job->timer_time < timer_time))
+    timer_time = job->timer_time;
+
+  _papplSystemUpdateJobTimer(printer->system, printer, timer_time);
 }
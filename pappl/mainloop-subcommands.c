@@ -1634,12 +1634,16 @@ default_system_cb(
     {
       if (!strcmp(valptr, "none") || !strncmp(valptr, "none,", 5))
         soptions = PAPPL_SOPTIONS_NONE;
+      else if (!strcmp(valptr, "binary-state") || !strncmp(valptr, "binary-state,", 13))
+        soptions |= PAPPL_SOPTIONS_BINARY_STATE;
       else if (!strcmp(valptr, "dnssd-host") || !strncmp(valptr, "dnssd-host,", 11))
         soptions |= PAPPL_SOPTIONS_DNSSD_HOST;
       else if (!strcmp(valptr, "no-multi-queue") || !strncmp(valptr, "no-multi-queue,", 15))
         soptions &= (pappl_soptions_t)~PAPPL_SOPTIONS_MULTI_QUEUE;
       else if (!strcmp(valptr, "raw-socket") || !strncmp(valptr, "raw-socket,", 11))
         soptions |= PAPPL_SOPTIONS_RAW_SOCKET;
+      else if (!strcmp(valptr, "sync-state") || !strncmp(valptr, "sync-state,", 11))
+        soptions |= PAPPL_SOPTIONS_SYNC_STATE;
       else if (!strcmp(valptr, "usb-printer") || !strncmp(valptr, "usb-printer,", 12))
         soptions |= PAPPL_SOPTIONS_USB_PRINTER;
       else if (!strcmp(valptr, "no-web-interface") || !strncmp(valptr, "no-web-interface,", 17))
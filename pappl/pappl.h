@@ -14,6 +14,7 @@
 #  include "client.h"
 #  include "printer.h"
 #  include "job.h"
+#  include "raster.h"
 #  include "loc.h"
 #  include "log.h"
 #  include "mainloop.h"
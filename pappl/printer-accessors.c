@@ -65,6 +65,64 @@ papplPrinterAddInfraProxy(
 }
 
 
+//
+// 'papplPrinterAddPoolMember()' - Add a member printer to a printer pool.
+//
+// This function adds a member printer to a printer pool.  Jobs submitted to
+// the pool printer are printed on the first available member printer, allowing
+// several printers to share a single queue.  Member printers continue to
+// accept and print their own jobs.
+//
+// A printer can only belong to a single pool, and pools cannot be members of
+// other pools.  Infrastructure printers cannot be pools or pool members.
+// Since pool jobs are processed using the pool printer's driver, member
+// printers must use the same driver as the pool printer.
+//
+
+bool					// O - `true` on success, `false` on failure
+papplPrinterAddPoolMember(
+    pappl_printer_t *printer,		// I - Pool printer
+    pappl_printer_t *member)		// I - Member printer
+{
+  bool	ret = false;			// Return value
+
+
+  // Range check input...
+  if (!printer || !member || printer == member || printer->system != member->system)
+    return (false);
+
+  // Add the member...
+  _papplRWLockWrite(printer);
+  _papplRWLockWrite(member);
+
+  if (!printer->driver_name || !member->driver_name || strcmp(printer->driver_name, member->driver_name))
+  {
+    papplLogPrinter(printer, PAPPL_LOGLEVEL_ERROR, "Unable to add '%s' to pool because it uses a different driver.", member->name);
+  }
+  else if (!printer->pool && !printer->output_devices && !member->pool && !member->pool_members && !member->output_devices)
+  {
+    if (!printer->pool_members)
+      printer->pool_members = cupsArrayNew(NULL, NULL, NULL, 0, NULL, NULL);
+
+    if ((ret = cupsArrayAdd(printer->pool_members, member)) == true)
+      member->pool = printer;
+  }
+
+  _papplRWUnlock(member);
+
+  // Start any pending jobs on the new member...
+  if (ret)
+    _papplPrinterCheckJobsNoLock(printer);
+
+  _papplRWUnlock(printer);
+
+  if (ret)
+    _papplSystemObjectChanged(printer->system, &printer->state_changes);
+
+  return (ret);
+}
+
+
 //
 // 'papplPrinterCloseDevice()' - Close the device associated with the printer.
 //
@@ -97,6 +155,9 @@ papplPrinterCloseDevice(
   }
 
   _papplRWUnlock(printer);
+
+  // Let the pool (if any) use this printer...
+  _papplPrinterCheckPoolJobs(printer);
 }
 
 
@@ -224,6 +285,53 @@ papplPrinterGetDNSSDName(
 }
 
 
+//
+// 'papplPrinterGetFairShare()' - Get whether weighted fair-share scheduling is
+//                                enabled.
+//
+// This function returns whether pending jobs are scheduled using weighted
+// fair-share scheduling, as configured by the @link papplPrinterSetFairShare@
+// function.
+//
+
+bool					// O - `true` if enabled, `false` otherwise
+papplPrinterGetFairShare(
+    pappl_printer_t *printer)		// I - Printer
+{
+  return (printer ? printer->fair_share : false);
+}
+
+
+//
+// 'papplPrinterGetFairShareWeight()' - Get the fair-share weight for a user.
+//
+// This function returns the relative share of the printer given to the named
+// user, as configured by the @link papplPrinterSetFairShareWeight@ function.
+//
+
+int					// O - Weight, `1` by default
+papplPrinterGetFairShareWeight(
+    pappl_printer_t *printer,		// I - Printer
+    const char      *username)		// I - Username
+{
+  int			weight = 1;	// Weight
+  _pappl_share_t	*share;		// Fair-share user
+
+
+  if (!printer || !username)
+    return (0);
+
+  _papplRWLockRead(printer);
+
+  if ((share = _papplPrinterGetShareNoLock(printer, username, false)) != NULL)
+    weight = share->weight;
+
+  _papplRWUnlock(printer);
+
+  return (weight);
+}
+
+
 //
 // 'papplPrinterGetGeoLocation()' - Get the current geo-location as a "geo:"
 //                                  URI.
@@ -280,7 +388,7 @@ int					// O - Number of printed impressions/sides
 papplPrinterGetImpressionsCompleted(
     pappl_printer_t *printer)		// I - Printer
 {
-  return (printer ? printer->impcompleted : 0);
+  return (printer ? _papplAtomicGet(&printer->impcompleted) : 0);
 }
 
 
@@ -397,6 +505,44 @@ papplPrinterGetLocation(
 }
 
 
+//
+// 'papplPrinterGetLookAhead()' - Get the look-ahead processing limits.
+//
+// This function returns the number of pending jobs that are processed ahead of
+// time and, optionally, the maximum amount of disk space used for the
+// processed output, as configured by the @link papplPrinterSetLookAhead@
+// function.
+//
+
+int					// O - Number of look-ahead jobs, `0` if disabled
+papplPrinterGetLookAhead(
+    pappl_printer_t *printer,		// I - Printer
+    size_t          *max_size)		// O - Maximum disk space in bytes or `NULL` for don't care
+{
+  int	num_jobs;			// Number of look-ahead jobs
+
+
+  if (!printer)
+  {
+    if (max_size)
+      *max_size = 0;
+
+    return (0);
+  }
+
+  _papplRWLockRead(printer);
+
+  num_jobs = printer->lookahead_jobs;
+
+  if (max_size)
+    *max_size = printer->lookahead_size;
+
+  _papplRWUnlock(printer);
+
+  return (num_jobs);
+}
+
+
 //
 // 'papplPrinterGetMaxActiveJobs()' - Get the maximum number of active (queued)
 //                                    jobs allowed by the printer.
@@ -447,6 +593,23 @@ papplPrinterGetMaxPreservedJobs(
 }
 
 
+//
+// 'papplPrinterGetMaxResidentJobs()' - Get the maximum number of completed
+//                                      jobs kept in memory by the printer.
+//
+// This function returns the maximum number of completed jobs whose attributes
+// are kept in memory as configured by the
+// @link papplPrinterSetMaxResidentJobs@ function.
+//
+
+size_t					// O - Maximum number of resident jobs, `0` for unlimited
+papplPrinterGetMaxResidentJobs(
+    pappl_printer_t *printer)		// I - Printer
+{
+  return (printer ? printer->max_resident_jobs : 0);
+}
+
+
 //
 // 'papplPrinterGetName()' - Get the printer name.
 //
@@ -546,6 +709,30 @@ papplPrinterGetNumberOfJobs(
 }
 
 
+//
+// 'papplPrinterGetNumberOfPoolMembers()' - Get the number of member printers in a printer pool.
+//
+
+size_t					// O - Number of member printers
+papplPrinterGetNumberOfPoolMembers(
+    pappl_printer_t *printer)		// I - Pool printer
+{
+  size_t	ret = 0;		// Return value
+
+
+  // Range check input...
+  if (printer)
+  {
+    _papplRWLockRead(printer);
+    ret = cupsArrayGetCount(printer->pool_members);
+    _papplRWUnlock(printer);
+  }
+
+  // Return the count...
+  return (ret);
+}
+
+
 //
 // 'papplPrinterGetOrganization()' - Get the organization name.
 //
@@ -665,6 +852,22 @@ papplPrinterGetPrintGroup(
 }
 
 
+//
+// 'papplPrinterGetPriorityAging()' - Get the job priority aging interval.
+//
+// This function returns the number of seconds a pending job must wait before
+// its priority is raised by one level, as configured by the
+// @link papplPrinterSetPriorityAging@ function.
+//
+
+int					// O - Aging interval in seconds, `0` if disabled
+papplPrinterGetPriorityAging(
+    pappl_printer_t *printer)		// I - Printer
+{
+  return (printer ? printer->priority_aging : 0);
+}
+
+
 //
 // 'papplPrinterGetReasons()' - Get the current "printer-state-reasons" bit values.
 //
@@ -1091,7 +1294,7 @@ papplPrinterHoldNewJobs(
   _papplRWUnlock(printer);
 
   if (ret)
-    _papplSystemConfigChanged(printer->system);
+    _papplSystemObjectChanged(printer->system, &printer->state_changes);
 
   return (ret);
 }
@@ -1494,6 +1697,43 @@ papplPrinterRemoveInfraProxy(
 }
 
 
+//
+// 'papplPrinterRemovePoolMember()' - Remove a member printer from a printer pool.
+//
+// This function removes a member printer from a printer pool.  Any pool job
+// that is currently printing on the member printer is allowed to complete.
+//
+
+void
+papplPrinterRemovePoolMember(
+    pappl_printer_t *printer,		// I - Pool printer
+    pappl_printer_t *member)		// I - Member printer
+{
+  bool	removed;			// Was the member removed?
+
+
+  // Range check input...
+  if (!printer || !member)
+    return;
+
+  // Remove the member...
+  _papplRWLockWrite(printer);
+  _papplRWLockWrite(member);
+
+  if ((removed = member->pool == printer) == true)
+  {
+    cupsArrayRemove(printer->pool_members, member);
+    member->pool = NULL;
+  }
+
+  _papplRWUnlock(member);
+  _papplRWUnlock(printer);
+
+  if (removed)
+    _papplSystemObjectChanged(printer->system, &printer->state_changes);
+}
+
+
 //
 // 'papplPrinterResume()' - Resume (start) a printer.
 //
@@ -1517,6 +1757,9 @@ papplPrinterResume(
   _papplPrinterCheckJobsNoLock(printer);
 
   _papplRWUnlock(printer);
+
+  // Let the pool (if any) use this printer...
+  _papplPrinterCheckPoolJobs(printer);
 }
 
 
@@ -1541,7 +1784,7 @@ papplPrinterSetContact(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 }
 
 
@@ -1575,7 +1818,72 @@ papplPrinterSetDNSSDName(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
+}
+
+
+//
+// 'papplPrinterSetFairShare()' - Enable or disable weighted fair-share
+//                                scheduling.
+//
+// This function controls how pending jobs are scheduled.  By default, jobs are
+// processed in order of their "job-priority" value and then in the order they
+// were submitted.  When fair-share scheduling is enabled, the printer instead
+// alternates between the users ("job-originating-user-name" values) with
+// pending jobs, in proportion to the weights set with the
+// @link papplPrinterSetFairShareWeight@ function, so that a user submitting
+// many jobs cannot prevent other users from printing.  Each user's own jobs
+// are still processed in priority order.
+//
+
+void
+papplPrinterSetFairShare(
+    pappl_printer_t *printer,		// I - Printer
+    bool            enable)		// I - `true` to enable, `false` to disable
+{
+  if (!printer)
+    return;
+
+  _papplRWLockWrite(printer);
+
+  if (printer->fair_share != enable)
+  {
+    printer->fair_share = enable;
+
+    _papplPrinterRebuildQueueNoLock(printer);
+  }
+
+  _papplRWUnlock(printer);
+}
+
+
+//
+// 'papplPrinterSetFairShareWeight()' - Set the fair-share weight for a user.
+//
+// This function sets the relative share of the printer given to the named
+// user when fair-share scheduling is enabled.  A user with a weight of `2`
+// gets twice as many jobs processed as a user with the default weight of `1`
+// when both have pending jobs.
+//
+
+void
+papplPrinterSetFairShareWeight(
+    pappl_printer_t *printer,		// I - Printer
+    const char      *username,		// I - Username
+    int             weight)		// I - Weight (`1` to `100`)
+{
+  _pappl_share_t	*share;		// Fair-share user
+
+
+  if (!printer || !username || weight < 1 || weight > 100)
+    return;
+
+  _papplRWLockWrite(printer);
+
+  if ((share = _papplPrinterGetShareNoLock(printer, username, true)) != NULL)
+    share->weight = weight;
+
+  _papplRWUnlock(printer);
 }
 
 
@@ -1611,7 +1919,7 @@ papplPrinterSetGeoLocation(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 }
 
 
@@ -1631,14 +1939,10 @@ papplPrinterSetImpressionsCompleted(
   if (!printer || add <= 0)
     return;
 
-  _papplRWLockWrite(printer);
-
-  printer->impcompleted += add;
-  printer->state_time   = time(NULL);
+  _papplAtomicAdd(&printer->impcompleted, add);
+  _papplAtomicSet(&printer->state_time, time(NULL));
 
-  _papplRWUnlock(printer);
-
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 }
 
 
@@ -1701,7 +2005,45 @@ papplPrinterSetLocation(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
+}
+
+
+//
+// 'papplPrinterSetLookAhead()' - Set the look-ahead processing limits.
+//
+// This function enables look-ahead processing of pending jobs.  While a job is
+// printing, up to "num_jobs" of the following pending jobs are inspected and
+// converted into device-ready output files in the spool directory so that
+// they can be sent to the printer as soon as the current job completes.  The
+// "max_size" argument limits the total disk space used by this output, with
+// `0` meaning no limit.
+//
+// Look-ahead output is discarded when the job is held or canceled, and jobs
+// whose output would exceed the disk limit are processed normally.
+//
+// > Note: Look-ahead processing runs the driver's raster callbacks with a
+// > file-based device, so it should only be enabled for drivers that do not
+// > read status from the device while producing output.
+//
+
+void
+papplPrinterSetLookAhead(
+    pappl_printer_t *printer,		// I - Printer
+    int             num_jobs,		// I - Number of pending jobs to process, `0` to disable
+    size_t          max_size)		// I - Maximum disk space in bytes, `0` for unlimited
+{
+  if (!printer || num_jobs < 0)
+    return;
+
+  _papplRWLockWrite(printer);
+
+  printer->lookahead_jobs = num_jobs;
+  printer->lookahead_size = max_size;
+
+  _papplPrinterCheckLookAheadNoLock(printer);
+
+  _papplRWUnlock(printer);
 }
 
 
@@ -1731,7 +2073,7 @@ papplPrinterSetMaxActiveJobs(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 }
 
 
@@ -1756,9 +2098,11 @@ papplPrinterSetMaxCompletedJobs(
   printer->max_completed_jobs = max_completed_jobs;
   printer->config_time        = time(NULL);
 
+  _papplPrinterNeedCleanNoLock(printer);
+
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 }
 
 
@@ -1783,9 +2127,42 @@ papplPrinterSetMaxPreservedJobs(
   printer->max_preserved_jobs = max_preserved_jobs;
   printer->config_time        = time(NULL);
 
+  _papplPrinterNeedCleanNoLock(printer);
+
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
+}
+
+
+//
+// 'papplPrinterSetMaxResidentJobs()' - Set the maximum number of completed
+//                                      jobs kept in memory for the printer.
+//
+// This function sets the maximum number of aborted, canceled, or completed jobs
+// whose attributes are kept in memory.  The attributes of older jobs in the
+// job history are saved to the spool directory and loaded again as needed,
+// leaving only the job ID, name, user, state, times, and counters in memory.
+//
+
+void
+papplPrinterSetMaxResidentJobs(
+    pappl_printer_t *printer,		// I - Printer
+    size_t          max_resident_jobs)	// I - Maximum number of resident jobs, `0` for unlimited
+{
+  if (!printer)
+    return;
+
+  _papplRWLockWrite(printer);
+
+  printer->max_resident_jobs = max_resident_jobs;
+  printer->config_time       = time(NULL);
+
+  _papplPrinterNeedCleanNoLock(printer);
+
+  _papplRWUnlock(printer);
+
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 }
 
 
@@ -1814,7 +2191,7 @@ papplPrinterSetNextJobID(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 }
 
 
@@ -1841,7 +2218,7 @@ papplPrinterSetOrganization(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 }
 
 
@@ -1868,7 +2245,7 @@ papplPrinterSetOrganizationalUnit(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 }
 
 
@@ -1914,7 +2291,37 @@ papplPrinterSetPrintGroup(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
+}
+
+
+//
+// 'papplPrinterSetPriorityAging()' - Set the job priority aging interval.
+//
+// This function sets the number of seconds a pending job must wait before its
+// "job-priority" value is raised by one level for scheduling purposes, which
+// ensures that low priority jobs are eventually processed on a busy printer.
+// A value of `0` disables priority aging.
+//
+
+void
+papplPrinterSetPriorityAging(
+    pappl_printer_t *printer,		// I - Printer
+    int             seconds)		// I - Aging interval in seconds, `0` to disable
+{
+  if (!printer || seconds < 0)
+    return;
+
+  _papplRWLockWrite(printer);
+
+  if (printer->priority_aging != seconds)
+  {
+    printer->priority_aging = seconds;
+
+    _papplPrinterRebuildQueueNoLock(printer);
+  }
+
+  _papplRWUnlock(printer);
 }
 
 
@@ -1975,7 +2382,7 @@ papplPrinterSetProxy(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 
   // If the system is running, start the proxy...
   if (printer->system->is_running && printer->proxy_common_name)
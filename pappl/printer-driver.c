@@ -307,7 +307,7 @@ papplPrinterSetDriverDefaults(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 
   return (true);
 }
@@ -358,7 +358,7 @@ papplPrinterSetReadyMedia(
 
   _papplRWUnlock(printer);
 
-  _papplSystemConfigChanged(printer->system);
+  _papplSystemObjectChanged(printer->system, &printer->state_changes);
 
   return (true);
 }
@@ -73,6 +73,41 @@ _papplPrinterCopyAttributesNoLock(
     ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "copies-default", data->copies_default);
   }
 
+  if (printer->pool_members && (!ra || cupsArrayFind(ra, "member-names") || cupsArrayFind(ra, "member-uris")))
+  {
+    // member-names and member-uris for the printers in a pool...
+    size_t		count;		// Number of members
+    pappl_printer_t	*member;	// Current member
+    ipp_attribute_t	*names = NULL,	// "member-names" attribute
+			*uris = NULL;	// "member-uris" attribute
+    char		uri[1024];	// URI value
+    const char		*ippscheme = (httpAddrIsLocalhost(httpGetAddress(client->http)) || !papplSystemGetTLSOnly(client->system)) ? "ipp" : "ipps";
+					// URI scheme for members
+
+    for (i = 0, count = cupsArrayGetCount(printer->pool_members); i < count; i ++)
+    {
+      member = (pappl_printer_t *)cupsArrayGetElement(printer->pool_members, i);
+
+      if (!ra || cupsArrayFind(ra, "member-names"))
+      {
+        if (names)
+          ippSetString(client->response, &names, ippGetCount(names), member->name);
+        else
+          names = ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_NAME, "member-names", NULL, member->name);
+      }
+
+      if (!ra || cupsArrayFind(ra, "member-uris"))
+      {
+        httpAssembleURI(HTTP_URI_CODING_ALL, uri, sizeof(uri), ippscheme, NULL, client->host_field, client->host_port, member->resource);
+
+        if (uris)
+          ippSetString(client->response, &uris, ippGetCount(uris), uri);
+        else
+          uris = ippAddString(client->response, IPP_TAG_PRINTER, IPP_TAG_URI, "member-uris", NULL, uri);
+      }
+    }
+  }
+
   if (!ra || cupsArrayFind(ra, "copies-supported"))
   {
     // Filter copies-supported value based on the document format...
@@ -436,7 +471,7 @@ _papplPrinterCopyAttributesNoLock(
   }
 
   if (!ra || cupsArrayFind(ra, "printer-impressions-completed"))
-    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-impressions-completed", printer->impcompleted);
+    ippAddInteger(client->response, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "printer-impressions-completed", _papplAtomicGet(&printer->impcompleted));
 
   if (!ra || cupsArrayFind(ra, "printer-input-tray"))
   {
@@ -40,6 +40,15 @@ struct _pappl_odevice_s			// Output Device data
   char			*pending_message;	// Pending Identify-Printer message, if any
 };
 
+typedef struct _pappl_share_s		// Fair-share user data
+{
+  char			*username;		// "job-originating-user-name" value
+  int			weight;			// Relative share of the printer
+  double		pass;			// Pass (virtual time) value
+  _pappl_heap_t		*jobs;			// Heap of pending jobs
+  size_t		index;			// Position in share heap, if any
+} _pappl_share_t;
+
 struct _pappl_printer_s			// Printer data
 {
   cups_rwlock_t		rwlock;			// Reader/writer lock
@@ -68,6 +77,9 @@ struct _pappl_printer_s			// Printer data
   bool			device_in_use;		// Is the device in use?
   cups_rwlock_t		output_rwlock;		// Reader/writer lock for output devices
   cups_array_t		*output_devices;	// Output devices for infrastructure printer
+  pappl_printer_t	*pool;			// Pool this printer belongs to, if any
+  cups_array_t		*pool_members;		// Member printers for a pool, if any
+  size_t		pool_processing;	// Number of pool jobs being processed
   char			*driver_name;		// Driver name
   pappl_pr_driver_data_t driver_data;		// Driver data
   ipp_t			*driver_attrs;		// Driver attributes
@@ -75,6 +87,10 @@ struct _pappl_printer_s			// Printer data
   ipp_t			*attrs;			// Other (static) printer attributes
   time_t		start_time;		// Startup time
   time_t		config_time;		// "printer-config-change-time" value
+  size_t		state_changes;		// Change number of last saved state change
+  int			*removed_jobs;		// Jobs removed since last save
+  size_t		num_removed_jobs,	// Number of removed jobs
+			alloc_removed_jobs;	// Allocated removed jobs
   time_t		status_time;		// Last time status was updated
   char			*print_group;		// PAM printing group, if any
   gid_t			print_gid;		// PAM printing group ID
@@ -85,12 +101,26 @@ struct _pappl_printer_s			// Printer data
   bool			hold_new_jobs;		// Hold new jobs
   size_t		max_active_jobs,	// Maximum number of active jobs to accept
 			max_completed_jobs,	// Maximum number of completed jobs to retain in history
-			max_preserved_jobs;	// Maximum number of completed jobs to preserve in history
+			max_preserved_jobs,	// Maximum number of completed jobs to preserve in history
+			max_resident_jobs;	// Maximum number of completed jobs with attributes in memory
   cups_array_t		*active_jobs,		// Array of active jobs
 			*all_jobs,		// Array of all jobs
 			*completed_jobs;	// Array of completed jobs
   int			next_job_id,		// Next "job-id" value
-			impcompleted;		// "printer-impressions-completed" value
+			impcompleted;		// "printer-impressions-completed" value (atomic)
+  _pappl_heap_t		*pending_jobs;		// Heap of pending jobs (no fair-share)
+  int			priority_aging;		// Seconds to raise job priority by one level, `0` for none
+  bool			fair_share;		// Use weighted fair-share scheduling?
+  cups_array_t		*shares;		// Fair-share users
+  _pappl_heap_t		*share_heap;		// Heap of fair-share users with pending jobs
+  double		share_pass;		// Current fair-share pass value
+  int			lookahead_jobs;		// Number of pending jobs to process ahead of time
+  size_t		lookahead_size;		// Maximum disk space for look-ahead output
+  pappl_job_t		*lookahead_job;		// Job being processed ahead of time, if any
+  _pappl_heap_t		*timer_jobs;		// Heap of jobs with hold/retain timers
+  time_t		clean_time,		// Next time to prune completed jobs, if any
+			timer_time;		// Time of next printer timer, if any
+  size_t		timer_index;		// Position in system timer heap, if any
   cups_array_t		*links;			// Web navigation links
 
   cups_dnssd_service_t	*dns_sd_services;	// DNS-SD services
@@ -167,6 +197,8 @@ extern pappl_media_tracking_t _papplMediaTrackingValue(const char *s);
 extern bool		_papplPrinterAddRawListeners(pappl_printer_t *printer) _PAPPL_PRIVATE;
 
 extern void		_papplPrinterCheckJobsNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterCheckLookAheadNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterCheckPoolJobs(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		_papplPrinterCleanJobsNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern http_t		*_papplPrinterConnectProxyNoLock(pappl_printer_t *printer, char *resource, size_t ressize) _PAPPL_PRIVATE;
 extern void		_papplPrinterCopyAttributesNoLock(pappl_printer_t *printer, pappl_client_t *client, cups_array_t *ra, const char *format) _PAPPL_PRIVATE;
@@ -175,24 +207,37 @@ extern void		_papplPrinterCopyXRINoLock(pappl_printer_t *printer, ipp_t *ipp, pa
 
 extern void		_papplPrinterDelete(pappl_printer_t *printer) _PAPPL_PRIVATE;
 
+extern pappl_job_t	*_papplPrinterDequeueJobNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+
 extern pappl_job_t	*_papplPrinterFindJobNoLock(pappl_printer_t *printer, int job_id) _PAPPL_PRIVATE;
 
+extern size_t		_papplPrinterGetNextJobsNoLock(pappl_printer_t *printer, size_t max_jobs, pappl_job_t **jobs) _PAPPL_PRIVATE;
+extern _pappl_share_t	*_papplPrinterGetShareNoLock(pappl_printer_t *printer, const char *username, bool create) _PAPPL_PRIVATE;
+
 extern void		_papplPrinterInitDriverData(pappl_pr_driver_data_t *d) _PAPPL_PRIVATE;
 extern bool		_papplPrinterIsAuthorized(pappl_client_t *client) _PAPPL_PRIVATE;
 
+extern void		_papplPrinterNeedCleanNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+
 extern void		_papplPrinterProcessIPP(pappl_client_t *client) _PAPPL_PRIVATE;
+extern void		_papplPrinterQueueJobNoLock(pappl_printer_t *printer, pappl_job_t *job) _PAPPL_PRIVATE;
 
 extern const char	*_papplPrinterReasonString(pappl_preason_t value) _PAPPL_PRIVATE;
 extern pappl_preason_t	_papplPrinterReasonValue(const char *value) _PAPPL_PRIVATE;
+extern void		_papplPrinterRebuildQueueNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern bool		_papplPrinterRegisterDNSSDNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern bool		_papplPrinterReservePoolMemberNoLock(pappl_printer_t *printer, pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		*_papplPrinterRunProxy(pappl_printer_t *printer) _PAPPL_PRIVATE;
 extern void		*_papplPrinterRunRaw(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterRunTimersNoLock(pappl_printer_t *printer, time_t curtime) _PAPPL_PRIVATE;
 extern void		*_papplPrinterRunUSB(pappl_printer_t *printer) _PAPPL_PRIVATE;
 
 extern bool		_papplPrinterSetAttributes(pappl_client_t *client, pappl_printer_t *printer) _PAPPL_PRIVATE;
 
 extern void		_papplPrinterUnregisterDNSSDNoLock(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterUnqueueJobNoLock(pappl_printer_t *printer, pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		_papplPrinterUpdateInfra(pappl_printer_t *printer) _PAPPL_PRIVATE;
+extern void		_papplPrinterUpdateJobTimerNoLock(pappl_printer_t *printer, pappl_job_t *job) _PAPPL_PRIVATE;
 extern void		_papplPrinterUpdateProxy(pappl_printer_t *printer, http_t *http, const char *resource) _PAPPL_PRIVATE;
 extern void		_papplPrinterUpdateProxyDocument(pappl_printer_t *printer, pappl_job_t *job, int doc_number) _PAPPL_PRIVATE;
 extern void		_papplPrinterUpdateProxyJobNoLock(pappl_printer_t *printer, pappl_job_t *job) _PAPPL_PRIVATE;
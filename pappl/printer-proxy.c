@@ -252,7 +252,7 @@ _papplPrinterUpdateProxyDocument(
   ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "document-number", doc_number);
   ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "output-device-uuid", /*language*/NULL, printer->proxy_device_uuid);
 
-  ippAddInteger(request, IPP_TAG_DOCUMENT, IPP_TAG_INTEGER, "impressions-completed", doc->impcompleted);
+  ippAddInteger(request, IPP_TAG_DOCUMENT, IPP_TAG_INTEGER, "impressions-completed", _papplAtomicGet(&doc->impcompleted));
   ippAddInteger(request, IPP_TAG_DOCUMENT, IPP_TAG_ENUM, "output-device-document-state", (int)doc->state);
   _papplJobCopyStateReasonsNoLock(job, request, IPP_TAG_DOCUMENT, "output-device-document-state-reasons", (ipp_jstate_t)doc->state, doc->state_reasons);
 
@@ -296,7 +296,7 @@ _papplPrinterUpdateProxyJobNoLock(
   ippAddInteger(request, IPP_TAG_OPERATION, IPP_TAG_INTEGER, "job-id", pjob->parent_job_id);
   ippAddString(request, IPP_TAG_OPERATION, IPP_TAG_URI, "output-device-uuid", /*language*/NULL, printer->proxy_device_uuid);
 
-  ippAddInteger(request, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", job->impcompleted);
+  ippAddInteger(request, IPP_TAG_JOB, IPP_TAG_INTEGER, "job-impressions-completed", _papplAtomicGet(&job->impcompleted));
   ippAddInteger(request, IPP_TAG_JOB, IPP_TAG_ENUM, "output-device-job-state", (int)job->state);
   if (job->message)
     ippAddString(request, IPP_TAG_JOB, IPP_TAG_TEXT, "output-device-job-state-message", /*language*/NULL, job->message);
@@ -844,6 +844,8 @@ update_active_jobs(
   if (ippGetGroupTag(job_ids) == IPP_TAG_OPERATION && ippGetGroupTag(job_states) == IPP_TAG_OPERATION && ippGetCount(job_ids) == ippGetCount(job_states))
   {
     // Got a list of jobs with different states...
+    _papplRWLockWrite(printer);
+
     for (i = 0, count = ippGetCount(job_ids); i < count; i ++)
       check_jobs |= update_proxy_job_no_lock(printer, ippGetInteger(job_ids, i), (ipp_jstate_t)ippGetInteger(job_states, i));
 
@@ -121,8 +121,8 @@ _papplPrinterRunRaw(
           struct pollfd	sockp;		// poll() data for client socket
           pappl_job_t	*job;		// New print job
           ssize_t	bytes;		// Bytes read from socket
-          char		buffer[8192];	// Copy buffer
-          char		filename[1024];	// Job filename
+          char		buffer[256];	// Address string
+          _pappl_spool_t	spool;		// Spool file
 
           // Accept the connection...
           sockaddrlen = sizeof(sockaddr);
@@ -141,15 +141,14 @@ _papplPrinterRunRaw(
           }
 
           // Read the print data from the socket...
-	  if ((job->fd = papplJobOpenFile(job, 0, filename, sizeof(filename), printer->system->directory, /*ext*/NULL, printer->driver_data.format, "w")) < 0)
+	  if (!_papplJobSpoolOpen(&spool, job, 0, printer->driver_data.format, /*length*/0))
 	  {
 	    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to create print file: %s", strerror(errno));
+            close(sock);
 
 	    goto abort_job;
 	  }
 
-	  papplLogJob(job, PAPPL_LOGLEVEL_DEBUG, "Created job file '%s'.", filename);
-
           activity     = time(NULL);
           sockp.fd     = sock;
           sockp.events = POLLIN | POLLERR;
@@ -174,10 +173,15 @@ _papplPrinterRunRaw(
             {
 	      activity = time(NULL);
 
-              if ((bytes = recv(sock, buffer, sizeof(buffer), 0)) > 0)
-                write(job->fd, buffer, (size_t)bytes);
-              else
+              if ((bytes = _papplJobSpoolRecv(&spool, sock, _PAPPL_SPOOL_BUFSIZE)) < 0)
+              {
+		papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to spool print data: %s", strerror(errno));
+                break;
+              }
+              else if (bytes == 0)
+              {
                 break;
+              }
             }
             else if (sockp.revents & POLLERR)
             {
@@ -191,17 +195,21 @@ _papplPrinterRunRaw(
           }
 
           close(sock);
-	  close(job->fd);
-	  job->fd = -1;
 
           if (bytes < 0)
           {
             // Error while reading
+            _papplJobSpoolAbort(&spool);
 	    goto abort_job;
 	  }
+          else if (!_papplJobSpoolClose(&spool))
+          {
+	    papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to write print file: %s", strerror(errno));
+	    goto abort_job;
+          }
 
 	  // Submit the job file...
-          _papplJobSubmitFile(job, filename, printer->driver_data.format ? printer->driver_data.format : "application/octet-stream", /*attrs*/NULL, /*last_document*/true);
+          _papplJobSubmitFile(job, spool.filename, printer->driver_data.format ? printer->driver_data.format : "application/octet-stream", /*attrs*/NULL, /*last_document*/true);
 	  continue;
 
 	  // Abort the job...
@@ -215,7 +223,7 @@ _papplPrinterRunRaw(
 	  cupsArrayRemove(printer->active_jobs, job);
 	  cupsArrayAdd(printer->completed_jobs, job);
 
-	  _papplSystemNeedClean(printer->system);
+	  _papplPrinterNeedCleanNoLock(printer);
 
 	  _papplRWUnlock(printer);
         }
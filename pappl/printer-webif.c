@@ -1237,26 +1237,27 @@ _papplPrinterWebJobs(
 	  bool		failed = false;	// Failed?
 	  pappl_job_t	*new_job;	// New job
 
+	  _papplJobLoadAttrs(job);
+
 	  if ((new_job = _papplJobCreate(printer, /*job-id*/0, username, job->name, job->attrs)) != NULL)
 	  {
-	    // Copy the job file...
+	    // Copy the job file, decompressing it as needed...
 	    int		i;		// Looping var
-	    int		oldfd,		// Old job file
-			newfd;		// New job file
+	    cups_file_t	*oldfp;		// Old job file
+	    int		newfd;		// New job file
 	    char	filename[1024],	// Job filename
 			buffer[8192];	// Copy buffer
 	    ssize_t	bytes;		// Bytes read...
 
             for (i = 0; i < job->num_documents && !failed; i ++)
             {
-	      if ((oldfd = open(job->documents[i].filename, O_RDONLY | O_BINARY)) >= 0)
+	      if ((oldfp = cupsFileOpen(job->documents[i].filename, "r")) != NULL)
 	      {
 		if ((newfd = papplJobOpenFile(new_job, i + 1, filename, sizeof(filename), printer->system->directory, /*ext*/NULL, job->documents[i].format, "w")) >= 0)
 		{
-		  while ((bytes = read(oldfd, buffer, sizeof(buffer))) > 0)
+		  while ((bytes = cupsFileRead(oldfp, buffer, sizeof(buffer))) > 0)
 		    write(newfd, buffer, (size_t)bytes);
 
-		  close(oldfd);
 		  close(newfd);
 
 		  // Submit the job for processing...
@@ -1268,7 +1269,7 @@ _papplPrinterWebJobs(
 		  failed = true;
 		}
 
-		close(oldfd);
+		cupsFileClose(oldfp);
 	      }
 	    }
 	  }
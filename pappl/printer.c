@@ -56,17 +56,22 @@ papplPrinterCancelAllJobs(
       job->state     = IPP_JSTATE_CANCELED;
       job->completed = time(NULL);
 
+      _papplRWLockWrite(job);
+      _papplJobDiscardPreRIPNoLock(job);
+      _papplRWUnlock(job);
+
       _papplJobRemoveFiles(job);
 
+      _papplPrinterUnqueueJobNoLock(printer, job);
+      _papplPrinterUpdateJobTimerNoLock(printer, job);
       cupsArrayRemove(printer->active_jobs, job);
       cupsArrayAdd(printer->completed_jobs, job);
     }
   }
 
-  _papplRWUnlock(printer);
+  _papplPrinterNeedCleanNoLock(printer);
 
-  if (!printer->system->clean_time)
-    printer->system->clean_time = time(NULL) + 60;
+  _papplRWUnlock(printer);
 }
 
 
@@ -162,13 +167,25 @@ _papplPrinterDelete(
   _pappl_resource_t	*r;		// Current resource
   char			prefix[1024];	// Prefix for printer resources
   size_t		prefixlen;	// Length of prefix
+  pappl_printer_t	*member;	// Pool member printer
 
 
-  // Let USB/raw printing threads know to exit
+  // Remove the printer from its pool, if any...
+  if (printer->pool)
+    papplPrinterRemovePoolMember(printer->pool, printer);
+
+  // Let USB/raw printing and look-ahead threads know to exit
   _papplRWLockWrite(printer);
   printer->is_deleted = true;
 
-  while (printer->raw_active || printer->usb_active)
+  if (printer->lookahead_job)
+  {
+    _papplRWLockWrite(printer->lookahead_job);
+    _papplJobDiscardPreRIPNoLock(printer->lookahead_job);
+    _papplRWUnlock(printer->lookahead_job);
+  }
+
+  while (printer->raw_active || printer->usb_active || printer->lookahead_job)
   {
     // Wait for threads to finish
     _papplRWUnlock(printer);
@@ -212,12 +229,19 @@ _papplPrinterDelete(
   if (printer->driver_data.delete_cb)
     (printer->driver_data.delete_cb)(printer, &printer->driver_data);
 
-  // Delete jobs...
+  // Delete the scheduling queues, timers, and jobs...
+  _papplSystemUpdateJobTimer(printer->system, printer, 0);
+  _papplHeapDelete(printer->timer_jobs);
+  _papplHeapDelete(printer->pending_jobs);
+  _papplHeapDelete(printer->share_heap);
+  cupsArrayDelete(printer->shares);
+
   cupsArrayDelete(printer->active_jobs);
   cupsArrayDelete(printer->completed_jobs);
   cupsArrayDelete(printer->all_jobs);
 
   // Free memory...
+  free(printer->removed_jobs);
   free(printer->name);
   free(printer->dns_sd_name);
   free(printer->location);
@@ -232,6 +256,15 @@ _papplPrinterDelete(
   free(printer->usb_storage);
 
   cupsArrayDelete(printer->output_devices);
+
+  for (member = (pappl_printer_t *)cupsArrayGetFirst(printer->pool_members); member; member = (pappl_printer_t *)cupsArrayGetNext(printer->pool_members))
+  {
+    _papplRWLockWrite(member);
+    member->pool = NULL;
+    _papplRWUnlock(member);
+  }
+
+  cupsArrayDelete(printer->pool_members);
   cupsRWDestroy(&printer->output_rwlock);
 
   ippDelete(printer->driver_attrs);
@@ -914,7 +947,7 @@ create_printer(
   ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "job-priority-default", 50);
 
   // job-priority-supported
-  ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "job-priority-supported", 1);
+  ippAddInteger(printer->attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, "job-priority-supported", 100);
 
   // job-sheets-default
   ippAddString(printer->attrs, IPP_TAG_PRINTER, IPP_CONST_TAG(IPP_TAG_NAME), "job-sheets-default", NULL, "none");
@@ -250,10 +250,14 @@ typedef bool (*pappl_pr_rendjob_cb_t)(pappl_job_t *job, pappl_pr_options_t *opti
 					// End a raster job callback
 typedef bool (*pappl_pr_rendpage_cb_t)(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
 					// End a raster page callback
+typedef bool (*pappl_pr_rskiplines_cb_t)(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, unsigned count);
+					// Skip blank raster lines callback
 typedef bool (*pappl_pr_rstartjob_cb_t)(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device);
 					// Start a raster job callback
 typedef bool (*pappl_pr_rstartpage_cb_t)(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
 					// Start a raster page callback
+typedef bool (*pappl_pr_rwriteband_cb_t)(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, unsigned count, const unsigned char *lines);
+					// Write a band of raster graphics callback
 typedef bool (*pappl_pr_rwriteline_cb_t)(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, const unsigned char *line);
 					// Write a line of raster graphics callback
 typedef bool (*pappl_pr_status_cb_t)(pappl_printer_t *printer);
@@ -326,8 +330,10 @@ struct pappl_pr_driver_data_s		// Printer driver data
   pappl_pr_printfile_cb_t	printfile_cb;	// Print (raw) file callback
   pappl_pr_rendjob_cb_t		rendjob_cb;	// End raster job callback
   pappl_pr_rendpage_cb_t	rendpage_cb;	// End raster page callback
+  pappl_pr_rskiplines_cb_t	rskiplines_cb;	// Skip blank raster lines callback, if any
   pappl_pr_rstartjob_cb_t	rstartjob_cb;	// Start raster job callback
   pappl_pr_rstartpage_cb_t	rstartpage_cb;	// Start raster page callback
+  pappl_pr_rwriteband_cb_t	rwriteband_cb;	// Write raster band callback, if any
   pappl_pr_rwriteline_cb_t	rwriteline_cb;	// Write raster line callback
   pappl_pr_status_cb_t		status_cb;	// Status callback
   pappl_pr_testpage_cb_t	testpage_cb;	// Test page callback
@@ -418,6 +424,7 @@ struct pappl_pr_driver_data_s		// Printer driver data
 extern void		papplPrinterAddInfraDevice(pappl_printer_t *printer, const char *device_uuid) _PAPPL_PUBLIC;
 extern bool		papplPrinterAddInfraProxy(pappl_printer_t *printer, const char *uri) _PAPPL_PUBLIC;
 extern void		papplPrinterAddLink(pappl_printer_t *printer, const char *label, const char *path_or_url, pappl_loptions_t options) _PAPPL_PUBLIC;
+extern bool		papplPrinterAddPoolMember(pappl_printer_t *printer, pappl_printer_t *member) _PAPPL_PUBLIC;
 
 extern void		papplPrinterCancelAllJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern void		papplPrinterCloseDevice(pappl_printer_t *printer) _PAPPL_PUBLIC;
@@ -438,25 +445,31 @@ extern char		*papplPrinterGetDNSSDName(pappl_printer_t *printer, char *buffer, s
 extern ipp_t		*papplPrinterGetDriverAttributes(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern pappl_pr_driver_data_t *papplPrinterGetDriverData(pappl_printer_t *printer, pappl_pr_driver_data_t *data) _PAPPL_PUBLIC;
 extern const char	*papplPrinterGetDriverName(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern bool		papplPrinterGetFairShare(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern int		papplPrinterGetFairShareWeight(pappl_printer_t *printer, const char *username) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetGeoLocation(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern int		papplPrinterGetID(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetImpressionsCompleted(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern ipp_t		*papplPrinterGetInfraAttributes(pappl_printer_t *printer, const char *device_uuid) _PAPPL_PUBLIC;
 extern char		**papplPrinterGetInfraDevices(pappl_printer_t *printer, size_t *num_devices) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetLocation(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern int		papplPrinterGetLookAhead(pappl_printer_t *printer, size_t *max_size) _PAPPL_PUBLIC;
 extern size_t		papplPrinterGetMaxActiveJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern size_t		papplPrinterGetMaxCompletedJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern size_t		papplPrinterGetMaxPreservedJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern size_t		papplPrinterGetMaxResidentJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern const char	*papplPrinterGetName(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern int		papplPrinterGetNextJobID(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern size_t		papplPrinterGetNumberOfActiveJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern size_t		papplPrinterGetNumberOfCompletedJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern size_t		papplPrinterGetNumberOfInfraDevices(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern size_t		papplPrinterGetNumberOfJobs(pappl_printer_t *printer) _PAPPL_PUBLIC;
+extern size_t		papplPrinterGetNumberOfPoolMembers(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetOrganization(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetOrganizationalUnit(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetPath(pappl_printer_t *printer, const char *subpath, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetPrintGroup(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern int		papplPrinterGetPriorityAging(pappl_printer_t *printer) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetProxyClientID(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetProxyCommonName(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplPrinterGetProxyDeviceUUID(pappl_printer_t *printer, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
@@ -493,23 +506,29 @@ extern bool		papplPrinterReleaseHeldNewJobs(pappl_printer_t *printer, const char
 extern void		papplPrinterRemoveInfraDevice(pappl_printer_t *printer, const char *device_uuid) _PAPPL_PUBLIC;
 extern void		papplPrinterRemoveInfraProxy(pappl_printer_t *printer, const char *printer_uri) _PAPPL_PUBLIC;
 extern void		papplPrinterRemoveLink(pappl_printer_t *printer, const char *label) _PAPPL_PUBLIC;
+extern void		papplPrinterRemovePoolMember(pappl_printer_t *printer, pappl_printer_t *member) _PAPPL_PUBLIC;
 extern void		papplPrinterResume(pappl_printer_t *printer) _PAPPL_PUBLIC;
 
 extern void		papplPrinterSetContact(pappl_printer_t *printer, pappl_contact_t *contact) _PAPPL_PUBLIC;
 extern void		papplPrinterSetDNSSDName(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern bool		papplPrinterSetDriverData(pappl_printer_t *printer, pappl_pr_driver_data_t *data, ipp_t *attrs) _PAPPL_PUBLIC;
 extern bool		papplPrinterSetDriverDefaults(pappl_printer_t *printer, pappl_pr_driver_data_t *data, size_t num_vendor, cups_option_t *vendor) _PAPPL_PUBLIC;
+extern void		papplPrinterSetFairShare(pappl_printer_t *printer, bool enable) _PAPPL_PUBLIC;
+extern void		papplPrinterSetFairShareWeight(pappl_printer_t *printer, const char *username, int weight) _PAPPL_PUBLIC;
 extern void		papplPrinterSetGeoLocation(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern void		papplPrinterSetInfraAttributes(pappl_printer_t *printer, const char *device_uuid, ipp_t *device_attrs) _PAPPL_PUBLIC;
 extern void		papplPrinterSetImpressionsCompleted(pappl_printer_t *printer, int add) _PAPPL_PUBLIC;
 extern void		papplPrinterSetLocation(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
+extern void		papplPrinterSetLookAhead(pappl_printer_t *printer, int num_jobs, size_t max_size) _PAPPL_PUBLIC;
 extern void		papplPrinterSetMaxActiveJobs(pappl_printer_t *printer, size_t max_active_jobs) _PAPPL_PUBLIC;
 extern void		papplPrinterSetMaxCompletedJobs(pappl_printer_t *printer, size_t max_completed_jobs) _PAPPL_PUBLIC;
 extern void		papplPrinterSetMaxPreservedJobs(pappl_printer_t *printer, size_t max_preserved_jobs) _PAPPL_PUBLIC;
+extern void		papplPrinterSetMaxResidentJobs(pappl_printer_t *printer, size_t max_resident_jobs) _PAPPL_PUBLIC;
 extern void		papplPrinterSetNextJobID(pappl_printer_t *printer, int next_job_id) _PAPPL_PUBLIC;
 extern void		papplPrinterSetOrganization(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern void		papplPrinterSetOrganizationalUnit(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
 extern void		papplPrinterSetPrintGroup(pappl_printer_t *printer, const char *value) _PAPPL_PUBLIC;
+extern void		papplPrinterSetPriorityAging(pappl_printer_t *printer, int seconds) _PAPPL_PUBLIC;
 extern void		papplPrinterSetProxy(pappl_printer_t *printer, const char *client_id, const char *common_name, const char *device_uuid, const char *provider_uri, const char *token_url, const char *infra_uri, const char *infra_uuid) _PAPPL_PUBLIC;
 extern bool		papplPrinterSetReadyMedia(pappl_printer_t *printer, size_t num_ready, pappl_media_col_t *ready) _PAPPL_PUBLIC;
 extern void		papplPrinterSetReasons(pappl_printer_t *printer, pappl_preason_t add, pappl_preason_t remove) _PAPPL_PUBLIC;
@@ -0,0 +1,60 @@
+//
+// Private raster header file for the Printer Application Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#ifndef _PAPPL_RASTER_PRIVATE_H_
+#  define _PAPPL_RASTER_PRIVATE_H_
+#  include "base-private.h"
+#  include "raster.h"
+
+
+//
+// Types...
+//
+
+typedef enum _pappl_simd_e		// SIMD instruction sets
+{
+  _PAPPL_SIMD_NONE,				// Portable C code
+  _PAPPL_SIMD_SSE2,				// x86 SSE2
+  _PAPPL_SIMD_AVX2				// x86 AVX2
+} _pappl_simd_t;
+
+typedef struct _pappl_rbands_s _pappl_rbands_t;
+					// Band renderer
+
+typedef bool (*_pappl_rrender_cb_t)(void *cbdata, unsigned worker, unsigned y, unsigned count, unsigned char *lines);
+					// Band render callback
+
+typedef struct _pappl_rscale_s _pappl_rscale_t;
+					// Image scaler
+
+typedef const unsigned char *(*_pappl_rscale_cb_t)(void *cbdata, unsigned y);
+					// Image scaler row callback
+
+typedef bool (*_pappl_rwrite_cb_t)(void *cbdata, unsigned y, unsigned count, const unsigned char *lines);
+					// Band write callback
+
+
+//
+// Functions...
+//
+
+extern _pappl_rbands_t	*_papplRasterBandsCreate(unsigned num_threads, unsigned band_lines, size_t bytes_per_line, _pappl_rrender_cb_t render_cb, _pappl_rwrite_cb_t write_cb, void *cbdata) _PAPPL_PRIVATE;
+extern void		_papplRasterBandsDelete(_pappl_rbands_t *bands) _PAPPL_PRIVATE;
+extern bool		_papplRasterBandsRender(_pappl_rbands_t *bands, unsigned y, unsigned count) _PAPPL_PRIVATE;
+extern void		_papplRasterDitherLine(unsigned char *dst, const unsigned char *src, unsigned x, unsigned count, const unsigned char *dither, bool black) _PAPPL_PRIVATE;
+extern _pappl_simd_t	_papplRasterGetSIMD(void) _PAPPL_PRIVATE;
+extern bool		_papplRasterIsBlank(const unsigned char *line, size_t bytes, unsigned char white) _PAPPL_PRIVATE;
+extern void		_papplRasterRotate(unsigned char *dst, const unsigned char *pixels, unsigned width, unsigned height, unsigned depth, ipp_orient_t orientation, unsigned y, unsigned count) _PAPPL_PRIVATE;
+extern _pappl_rscale_t	*_papplRasterScaleCreate(unsigned depth, unsigned in_width, unsigned in_height, unsigned out_width, unsigned out_height, unsigned out_x, unsigned out_count, bool smoothing, _pappl_rscale_cb_t cb, void *cbdata) _PAPPL_PRIVATE;
+extern void		_papplRasterScaleDelete(_pappl_rscale_t *scale) _PAPPL_PRIVATE;
+extern const unsigned char *_papplRasterScaleGetLine(_pappl_rscale_t *scale, unsigned y) _PAPPL_PRIVATE;
+extern _pappl_simd_t	_papplRasterSetSIMD(_pappl_simd_t simd) _PAPPL_PRIVATE;
+
+
+#endif // !_PAPPL_RASTER_PRIVATE_H_
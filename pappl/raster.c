@@ -0,0 +1,2006 @@
+//
+// Raster line and image scaling functions for the Printer Application
+// Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "raster-private.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  define _PAPPL_HAVE_SSE2 1
+#  include <emmintrin.h>
+#  if defined(__GNUC__)
+#    define _PAPPL_HAVE_AVX2 1
+#    include <immintrin.h>
+#  endif // __GNUC__
+#endif // __SSE2__ || _M_X64 || _M_IX86_FP >= 2
+
+
+//
+// Local constants...
+//
+
+#define _PAPPL_MAX_RTHREADS	16	// Maximum number of band rendering threads
+#define _PAPPL_MAX_RUN		128	// Maximum run length for PackBits and PWG
+#define _PAPPL_MAX_REPEAT	256	// Maximum line repeat count for PWG
+
+
+//
+// Local types...
+//
+
+typedef enum _pappl_rfilter_e		// Image scaling filters
+{
+  _PAPPL_RFILTER_NEAREST,			// Nearest-neighbor sampling
+  _PAPPL_RFILTER_BILINEAR,			// Bilinear interpolation
+  _PAPPL_RFILTER_BOX				// Box filter (averaging)
+} _pappl_rfilter_t;
+
+struct _pappl_rscale_s			// Image scaler
+{
+  unsigned		depth,			// Bytes per pixel
+			in_width,		// Source width in columns
+			in_height,		// Source height in lines
+			out_width,		// Scaled width in columns
+			out_height,		// Scaled height in lines
+			count;			// Number of output columns
+  _pappl_rfilter_t	xfilter,		// Horizontal filter
+			yfilter;		// Vertical filter
+  _pappl_rscale_cb_t	cb;			// Row callback
+  void			*cbdata;		// Row callback data
+  unsigned		*xoffsets;		// Source offset for each output column
+  unsigned short	*xweights;		// Weight or number of taps for each output column
+  unsigned char		*rows[2],		// Horizontally scaled source rows
+			*line;			// Output line
+  unsigned		rows_y[2];		// Source row numbers
+  unsigned short	*accum;			// Box filter accumulator
+};
+
+struct _pappl_rbands_s			// Band renderer
+{
+  cups_mutex_t		mutex;			// Mutex for state
+  cups_cond_t		cond;			// Condition for state changes
+  unsigned		y,			// First line
+			count,			// Number of lines
+			band_lines,		// Number of lines per band
+			num_bands,		// Number of bands
+			num_slots,		// Number of band buffers
+			next_band,		// Next band to render
+			write_band,		// Next band to write
+			next_worker,		// Next worker number
+			num_busy,		// Number of workers rendering a band
+			num_workers;		// Number of worker threads
+  cups_thread_t		workers[_PAPPL_MAX_RTHREADS];
+						// Worker threads
+  size_t		band_size;		// Bytes per band buffer
+  unsigned char		*buffer;		// Band buffers
+  bool			*rendered;		// Which band buffers are rendered
+  bool			abort,			// Stop rendering?
+			shutdown;		// Stop the worker threads?
+  _pappl_rrender_cb_t	render_cb;		// Render callback
+  _pappl_rwrite_cb_t	write_cb;		// Write callback
+  void			*cbdata;		// Callback data
+};
+
+
+//
+// Local globals...
+//
+
+static const unsigned char raster_bitrev[256] =
+{					// Bit-reversed byte values
+  0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0, 0x10, 0x90, 0x50, 0xd0,
+  0x30, 0xb0, 0x70, 0xf0, 0x08, 0x88, 0x48, 0xc8, 0x28, 0xa8, 0x68, 0xe8,
+  0x18, 0x98, 0x58, 0xd8, 0x38, 0xb8, 0x78, 0xf8, 0x04, 0x84, 0x44, 0xc4,
+  0x24, 0xa4, 0x64, 0xe4, 0x14, 0x94, 0x54, 0xd4, 0x34, 0xb4, 0x74, 0xf4,
+  0x0c, 0x8c, 0x4c, 0xcc, 0x2c, 0xac, 0x6c, 0xec, 0x1c, 0x9c, 0x5c, 0xdc,
+  0x3c, 0xbc, 0x7c, 0xfc, 0x02, 0x82, 0x42, 0xc2, 0x22, 0xa2, 0x62, 0xe2,
+  0x12, 0x92, 0x52, 0xd2, 0x32, 0xb2, 0x72, 0xf2, 0x0a, 0x8a, 0x4a, 0xca,
+  0x2a, 0xaa, 0x6a, 0xea, 0x1a, 0x9a, 0x5a, 0xda, 0x3a, 0xba, 0x7a, 0xfa,
+  0x06, 0x86, 0x46, 0xc6, 0x26, 0xa6, 0x66, 0xe6, 0x16, 0x96, 0x56, 0xd6,
+  0x36, 0xb6, 0x76, 0xf6, 0x0e, 0x8e, 0x4e, 0xce, 0x2e, 0xae, 0x6e, 0xee,
+  0x1e, 0x9e, 0x5e, 0xde, 0x3e, 0xbe, 0x7e, 0xfe, 0x01, 0x81, 0x41, 0xc1,
+  0x21, 0xa1, 0x61, 0xe1, 0x11, 0x91, 0x51, 0xd1, 0x31, 0xb1, 0x71, 0xf1,
+  0x09, 0x89, 0x49, 0xc9, 0x29, 0xa9, 0x69, 0xe9, 0x19, 0x99, 0x59, 0xd9,
+  0x39, 0xb9, 0x79, 0xf9, 0x05, 0x85, 0x45, 0xc5, 0x25, 0xa5, 0x65, 0xe5,
+  0x15, 0x95, 0x55, 0xd5, 0x35, 0xb5, 0x75, 0xf5, 0x0d, 0x8d, 0x4d, 0xcd,
+  0x2d, 0xad, 0x6d, 0xed, 0x1d, 0x9d, 0x5d, 0xdd, 0x3d, 0xbd, 0x7d, 0xfd,
+  0x03, 0x83, 0x43, 0xc3, 0x23, 0xa3, 0x63, 0xe3, 0x13, 0x93, 0x53, 0xd3,
+  0x33, 0xb3, 0x73, 0xf3, 0x0b, 0x8b, 0x4b, 0xcb, 0x2b, 0xab, 0x6b, 0xeb,
+  0x1b, 0x9b, 0x5b, 0xdb, 0x3b, 0xbb, 0x7b, 0xfb, 0x07, 0x87, 0x47, 0xc7,
+  0x27, 0xa7, 0x67, 0xe7, 0x17, 0x97, 0x57, 0xd7, 0x37, 0xb7, 0x77, 0xf7,
+  0x0f, 0x8f, 0x4f, 0xcf, 0x2f, 0xaf, 0x6f, 0xef, 0x1f, 0x9f, 0x5f, 0xdf,
+  0x3f, 0xbf, 0x7f, 0xff
+};
+static int		raster_simd = -1;
+					// SIMD instruction set to use
+
+
+//
+// Local functions...
+//
+
+#ifdef _PAPPL_HAVE_AVX2
+static size_t	blank_avx2(const unsigned char *line, size_t bytes, unsigned char white) __attribute__((target("avx2")));
+#endif // _PAPPL_HAVE_AVX2
+#ifdef _PAPPL_HAVE_SSE2
+static size_t	blank_sse2(const unsigned char *line, size_t bytes, unsigned char white);
+#endif // _PAPPL_HAVE_SSE2
+static size_t	compress_find(const unsigned char *src, size_t count, size_t stride, bool equal);
+#ifdef _PAPPL_HAVE_AVX2
+static size_t	compress_find_avx2(const unsigned char *src, size_t count, size_t stride, bool equal) __attribute__((target("avx2")));
+#endif // _PAPPL_HAVE_AVX2
+#ifdef _PAPPL_HAVE_SSE2
+static size_t	compress_find_sse2(const unsigned char *src, size_t count, size_t stride, bool equal);
+#endif // _PAPPL_HAVE_SSE2
+#ifdef _PAPPL_HAVE_AVX2
+static unsigned	dither_avx2(unsigned char *dst, const unsigned char *src, unsigned x, unsigned count, const unsigned char *dither, bool black) __attribute__((target("avx2")));
+#endif // _PAPPL_HAVE_AVX2
+static void	dither_bits(unsigned char *dst, const unsigned char *src, unsigned x, unsigned count, const unsigned char *dither, bool black);
+static void	dither_bytes(unsigned char *dst, const unsigned char *src, unsigned x, unsigned count, const unsigned char *dither, bool black);
+#ifdef _PAPPL_HAVE_SSE2
+static unsigned	dither_sse2(unsigned char *dst, const unsigned char *src, unsigned x, unsigned count, const unsigned char *dither, bool black);
+#endif // _PAPPL_HAVE_SSE2
+static _pappl_simd_t get_simd(void);
+static void	*render_thread(_pappl_rbands_t *bands);
+static void	scale_accum(unsigned short *accum, const unsigned char *src, size_t count, bool first);
+#ifdef _PAPPL_HAVE_AVX2
+static size_t	scale_accum_avx2(unsigned short *accum, const unsigned char *src, size_t count, bool first) __attribute__((target("avx2")));
+#endif // _PAPPL_HAVE_AVX2
+#ifdef _PAPPL_HAVE_SSE2
+static size_t	scale_accum_sse2(unsigned short *accum, const unsigned char *src, size_t count, bool first);
+#endif // _PAPPL_HAVE_SSE2
+static void	scale_average(unsigned char *dst, const unsigned short *accum, size_t count, unsigned taps);
+#ifdef _PAPPL_HAVE_AVX2
+static size_t	scale_average_avx2(unsigned char *dst, const unsigned short *accum, size_t count, unsigned taps) __attribute__((target("avx2")));
+#endif // _PAPPL_HAVE_AVX2
+#ifdef _PAPPL_HAVE_SSE2
+static size_t	scale_average_sse2(unsigned char *dst, const unsigned short *accum, size_t count, unsigned taps);
+#endif // _PAPPL_HAVE_SSE2
+static void	scale_blend(unsigned char *dst, const unsigned char *a, const unsigned char *b, size_t count, unsigned weight);
+#ifdef _PAPPL_HAVE_AVX2
+static size_t	scale_blend_avx2(unsigned char *dst, const unsigned char *a, const unsigned char *b, size_t count, unsigned weight) __attribute__((target("avx2")));
+#endif // _PAPPL_HAVE_AVX2
+#ifdef _PAPPL_HAVE_SSE2
+static size_t	scale_blend_sse2(unsigned char *dst, const unsigned char *a, const unsigned char *b, size_t count, unsigned weight);
+#endif // _PAPPL_HAVE_SSE2
+static unsigned char *scale_get_row(_pappl_rscale_t *scale, unsigned y, unsigned keep);
+static void	scale_map(_pappl_rfilter_t filter, unsigned in_size, unsigned out_size, unsigned pos, unsigned *first, unsigned *weight);
+static void	scale_row(_pappl_rscale_t *scale, unsigned char *dst, const unsigned char *src);
+
+
+//
+// '_papplRasterBandsCreate()' - Create a band renderer.
+//
+// This function creates a band renderer that renders lines in bands of up to
+// "band_lines" lines.  The render callback is called from up to "num_threads"
+// worker threads with the worker number (`0` to `num_threads - 1`), so that
+// per-worker state can be kept by the caller, while the write callback is
+// always called from the thread calling '_papplRasterBandsRender()' with the
+// rendered bands in order.
+//
+// The worker threads are started here and wait for work, so a band renderer
+// can be used for any number of '_papplRasterBandsRender()' calls, for
+// example once per copy of a page.  When "num_threads" is `1` or the worker
+// threads cannot be created, the bands are rendered by the calling thread.
+//
+
+_pappl_rbands_t *			// O - Band renderer or `NULL` on error
+_papplRasterBandsCreate(
+    unsigned            num_threads,	// I - Number of worker threads
+    unsigned            band_lines,	// I - Number of lines per band
+    size_t              bytes_per_line,	// I - Bytes per line
+    _pappl_rrender_cb_t render_cb,	// I - Render callback
+    _pappl_rwrite_cb_t  write_cb,	// I - Write callback
+    void                *cbdata)	// I - Callback data
+{
+  _pappl_rbands_t	*bands;		// Band renderer
+  unsigned		i;		// Looping var
+
+
+  if (band_lines == 0 || bytes_per_line == 0 || !render_cb || !write_cb)
+    return (NULL);
+
+  if (num_threads > _PAPPL_MAX_RTHREADS)
+    num_threads = _PAPPL_MAX_RTHREADS;
+
+  if ((bands = calloc(1, sizeof(_pappl_rbands_t))) == NULL)
+    return (NULL);
+
+  bands->band_lines = band_lines;
+  bands->num_slots  = num_threads > 1 ? 2 * num_threads : 1;
+  bands->band_size  = band_lines * bytes_per_line;
+  bands->render_cb  = render_cb;
+  bands->write_cb   = write_cb;
+  bands->cbdata     = cbdata;
+
+  if ((bands->buffer = malloc(bands->num_slots * bands->band_size)) == NULL || (bands->rendered = calloc(bands->num_slots, sizeof(bool))) == NULL)
+  {
+    free(bands->buffer);
+    free(bands);
+    return (NULL);
+  }
+
+  cupsMutexInit(&bands->mutex);
+  cupsCondInit(&bands->cond);
+
+  if (bands->num_slots > 1)
+  {
+    // Start the worker threads...
+    for (i = 0; i < num_threads; i ++)
+    {
+      if ((bands->workers[bands->num_workers] = cupsThreadCreate((cups_thread_func_t)render_thread, bands)) != CUPS_THREAD_INVALID)
+        bands->num_workers ++;
+    }
+  }
+
+  return (bands);
+}
+
+
+//
+// '_papplRasterBandsDelete()' - Stop the worker threads and free a band
+//                               renderer.
+//
+
+void
+_papplRasterBandsDelete(
+    _pappl_rbands_t *bands)		// I - Band renderer
+{
+  unsigned	i;			// Looping var
+
+
+  if (!bands)
+    return;
+
+  cupsMutexLock(&bands->mutex);
+  bands->shutdown = true;
+  cupsCondBroadcast(&bands->cond);
+  cupsMutexUnlock(&bands->mutex);
+
+  for (i = 0; i < bands->num_workers; i ++)
+    cupsThreadWait(bands->workers[i]);
+
+  cupsCondDestroy(&bands->cond);
+  cupsMutexDestroy(&bands->mutex);
+
+  free(bands->buffer);
+  free(bands->rendered);
+  free(bands);
+}
+
+
+//
+// '_papplRasterBandsRender()' - Render lines in bands.
+//
+// This function renders "count" lines starting at line "y" and returns once
+// all of the bands have been written and the worker threads are idle.
+// Rendering stops when either callback returns `false`.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplRasterBandsRender(
+    _pappl_rbands_t *bands,		// I - Band renderer
+    unsigned        y,			// I - First line
+    unsigned        count)		// I - Number of lines
+{
+  bool			ret = true;	// Return value
+  unsigned		i,		// Looping var
+			band,		// Current band
+			band_y,		// First line in band
+			band_count,	// Number of lines in band
+			num_bands;	// Number of bands
+  unsigned char		*lines;		// Lines in band
+
+
+  if (!bands)
+    return (false);
+
+  if (count == 0)
+    return (true);
+
+  num_bands = (count + bands->band_lines - 1) / bands->band_lines;
+
+  if (bands->num_workers == 0)
+  {
+    // Render and write each band from this thread...
+    for (band = 0, band_y = y; band < num_bands && ret; band ++, band_y += band_count)
+    {
+      if ((band_count = count - (band_y - y)) > bands->band_lines)
+        band_count = bands->band_lines;
+
+      ret = (bands->render_cb)(bands->cbdata, 0, band_y, band_count, bands->buffer) && (bands->write_cb)(bands->cbdata, band_y, band_count, bands->buffer);
+    }
+
+    return (ret);
+  }
+
+  // Hand the bands to the worker threads...
+  cupsMutexLock(&bands->mutex);
+
+  bands->y          = y;
+  bands->count      = count;
+  bands->num_bands  = num_bands;
+  bands->next_band  = 0;
+  bands->write_band = 0;
+  bands->abort      = false;
+
+  memset(bands->rendered, 0, bands->num_slots * sizeof(bool));
+
+  cupsCondBroadcast(&bands->cond);
+  cupsMutexUnlock(&bands->mutex);
+
+  // Write bands in order as the workers finish them...
+  for (band = 0, band_y = y; band < num_bands && ret; band ++, band_y += band_count)
+  {
+    i = band % bands->num_slots;
+
+    cupsMutexLock(&bands->mutex);
+    while (!bands->rendered[i] && !bands->abort)
+      cupsCondWait(&bands->cond, &bands->mutex, 0.0);
+    ret = !bands->abort;
+    cupsMutexUnlock(&bands->mutex);
+
+    if (!ret)
+      break;
+
+    if ((band_count = count - (band_y - y)) > bands->band_lines)
+      band_count = bands->band_lines;
+
+    lines = bands->buffer + i * bands->band_size;
+    ret   = (bands->write_cb)(bands->cbdata, band_y, band_count, lines);
+
+    cupsMutexLock(&bands->mutex);
+    bands->rendered[i] = false;
+    bands->write_band ++;
+    if (!ret)
+      bands->abort = true;
+    cupsCondBroadcast(&bands->cond);
+    cupsMutexUnlock(&bands->mutex);
+  }
+
+  // Wait for the workers to finish any bands they are rendering so that the
+  // callback data can be changed or freed...
+  cupsMutexLock(&bands->mutex);
+
+  bands->num_bands = bands->next_band;
+
+  while (bands->num_busy > 0)
+    cupsCondWait(&bands->cond, &bands->mutex, 0.0);
+
+  cupsMutexUnlock(&bands->mutex);
+
+  return (ret);
+}
+
+
+//
+// 'papplRasterCompressPackBits()' - Compress a line using PackBits.
+//
+// This function compresses "srclen" bytes from "src" using the PackBits
+// algorithm used by TIFF and PCL compression mode 2 and stores the result in
+// "dst".  Runs of repeated bytes are stored as a count byte from 255 to 129
+// (2 to 128 bytes) followed by the byte value, while other bytes are stored
+// as a count byte from 0 to 127 (1 to 128 bytes) followed by the bytes.
+//
+// The output buffer must be at least "srclen + (srclen + 127) / 128" bytes
+// to hold the compressed data in all cases.  `0` is returned if the
+// compressed data does not fit in the output buffer.
+//
+// SSE2 or AVX2 instructions are used to find runs when the CPU supports them.
+//
+
+size_t					// O - Number of compressed bytes or `0` on error
+papplRasterCompressPackBits(
+    unsigned char       *dst,		// I - Output buffer
+    size_t              dstsize,	// I - Size of output buffer
+    const unsigned char *src,		// I - Input bytes
+    size_t              srclen)		// I - Number of input bytes
+{
+  unsigned char		*dstptr,	// Pointer into output buffer
+			*dstend;	// End of output buffer
+  const unsigned char	*srcend;	// End of input bytes
+  size_t		count,		// Number of bytes in run
+			maxcount,	// Maximum number of bytes in run
+			i,		// Looping var
+			ilimit;		// Limit for run search
+
+
+  if (!dst || !src || srclen == 0)
+    return (0);
+
+  for (dstptr = dst, dstend = dst + dstsize, srcend = src + srclen; src < srcend; src += count)
+  {
+    if ((maxcount = (size_t)(srcend - src)) > _PAPPL_MAX_RUN)
+      maxcount = _PAPPL_MAX_RUN;
+
+    if (maxcount > 1 && src[0] == src[1])
+    {
+      // Repeated bytes...
+      count = 1 + compress_find(src, maxcount - 1, 1, false);
+
+      if ((dstend - dstptr) < 2)
+        return (0);
+
+      *dstptr++ = (unsigned char)(257 - count);
+      *dstptr++ = *src;
+    }
+    else
+    {
+      // Literal bytes up to the next run of 3 or more bytes...
+      if ((ilimit = (size_t)(srcend - src)) > 2)
+        ilimit -= 2;
+      else
+        ilimit = 0;
+
+      if (ilimit > maxcount)
+        ilimit = maxcount;
+
+      for (i = 1; i < ilimit; i ++)
+      {
+        i += compress_find(src + i, ilimit - i, 1, true);
+
+        if (i < ilimit && src[i + 1] == src[i + 2])
+          break;
+      }
+
+      count = i < ilimit ? i : maxcount;
+
+      if ((size_t)(dstend - dstptr) < (count + 1))
+        return (0);
+
+      *dstptr++ = (unsigned char)(count - 1);
+      memcpy(dstptr, src, count);
+      dstptr += count;
+    }
+  }
+
+  return ((size_t)(dstptr - dst));
+}
+
+
+//
+// 'papplRasterCompressPWG()' - Compress a band of lines using PWG raster compression.
+//
+// This function compresses "count" lines of "bytes_per_line" bytes each from
+// "lines" using the PWG/Apple raster compression and stores the result in
+// "dst".  Each group of identical lines is stored as a line repeat count byte
+// (1 to 256 lines) followed by the compressed pixels of the line.  Runs of
+// repeated pixels are stored as a count byte from 0 to 127 (1 to 128 pixels)
+// followed by the pixel value, while other pixels are stored as a count byte
+// from 255 to 129 (2 to 128 pixels) followed by the pixels.
+//
+// The "bytes_per_pixel" argument specifies the size of a pixel in bytes and
+// is `1` for raster data with 8 or fewer bits per pixel.
+//
+// The output buffer must be at least "count * (2 * bytes_per_line + 1)" bytes
+// to hold the compressed data in all cases.  `0` is returned if the
+// compressed data does not fit in the output buffer.
+//
+// SSE2 or AVX2 instructions are used to find runs when the CPU supports them.
+//
+
+size_t					// O - Number of compressed bytes or `0` on error
+papplRasterCompressPWG(
+    unsigned char       *dst,		// I - Output buffer
+    size_t              dstsize,	// I - Size of output buffer
+    const unsigned char *lines,		// I - Lines
+    unsigned            count,		// I - Number of lines
+    size_t              bytes_per_line,	// I - Bytes per line
+    unsigned            bytes_per_pixel)// I - Bytes per pixel
+{
+  unsigned char		*dstptr,	// Pointer into output buffer
+			*dstend;	// End of output buffer
+  const unsigned char	*line,		// Current line
+			*pixel;		// Current pixel
+  unsigned		y,		// Current line
+			repeat;		// Number of identical lines
+  size_t		bpp = bytes_per_pixel,
+					// Bytes per pixel
+			width,		// Pixels per line
+			x,		// Current column
+			n,		// Number of pixels in run
+			maxn,		// Maximum number of pixels in run
+			i,		// Current byte in run search
+			ilimit;		// Limit for run search
+
+
+  if (!dst || !lines || count == 0 || bytes_per_line == 0 || bpp == 0 || (bytes_per_line % bpp) != 0)
+    return (0);
+
+  width  = bytes_per_line / bpp;
+  dstptr = dst;
+  dstend = dst + dstsize;
+
+  for (y = 0; y < count; y += repeat)
+  {
+    // Count identical lines...
+    line = lines + y * bytes_per_line;
+
+    for (repeat = 1; repeat < _PAPPL_MAX_REPEAT && (y + repeat) < count && !memcmp(line, line + repeat * bytes_per_line, bytes_per_line); repeat ++);
+
+    if (dstptr >= dstend)
+      return (0);
+
+    *dstptr++ = (unsigned char)(repeat - 1);
+
+    // Compress the pixels in the line...
+    for (x = 0; x < width; x += n)
+    {
+      pixel = line + x * bpp;
+
+      if ((maxn = width - x) > _PAPPL_MAX_RUN)
+        maxn = _PAPPL_MAX_RUN;
+
+      if (maxn > 1 && !memcmp(pixel, pixel + bpp, bpp))
+      {
+        // Repeated pixels...
+        n = 1 + compress_find(pixel, (maxn - 1) * bpp, bpp, false) / bpp;
+
+        if ((size_t)(dstend - dstptr) < (bpp + 1))
+          return (0);
+
+        *dstptr++ = (unsigned char)(n - 1);
+        memcpy(dstptr, pixel, bpp);
+        dstptr += bpp;
+      }
+      else
+      {
+        // Literal pixels up to the next pair of identical pixels...
+        if ((ilimit = width - x - 1) > maxn)
+          ilimit = maxn;
+
+        ilimit *= bpp;
+
+        for (i = bpp; i < ilimit; i = (i / bpp + 1) * bpp)
+        {
+          i += compress_find(pixel + i, ilimit - i, bpp, true);
+
+          if (i < ilimit && !memcmp(pixel + i - i % bpp, pixel + i - i % bpp + bpp, bpp))
+            break;
+        }
+
+        n = i < ilimit ? i / bpp : maxn;
+
+        if ((size_t)(dstend - dstptr) < (n * bpp + 1))
+          return (0);
+
+        *dstptr++ = (unsigned char)(n == 1 ? 0 : 257 - n);
+        memcpy(dstptr, pixel, n * bpp);
+        dstptr += n * bpp;
+      }
+    }
+  }
+
+  return ((size_t)(dstptr - dst));
+}
+
+
+//
+// '_papplRasterDitherLine()' - Dither a line of 8-bit pixels to 1-bit.
+//
+// This function thresholds "count" 8-bit pixels from "src" against a 16-entry
+// row of the dither matrix and stores the packed bits starting at column "x"
+// in "dst".  Black ("black" = `true`) pixels produce a set bit when the pixel
+// value is greater than the dither value, while grayscale pixels produce a set
+// bit when the pixel value is less than or equal to the dither value.  Bits
+// in the first byte before column "x" and in the last byte after the last
+// pixel are cleared.
+//
+// SSE2 or AVX2 instructions are used when the CPU supports them.
+//
+
+void
+_papplRasterDitherLine(
+    unsigned char       *dst,		// I - Output line
+    const unsigned char *src,		// I - Pixels starting at column "x"
+    unsigned            x,		// I - First column
+    unsigned            count,		// I - Number of pixels
+    const unsigned char *dither,	// I - Dither row (16 entries)
+    bool                black)		// I - `true` for black pixels, `false` for grayscale
+{
+  unsigned	n;			// Number of pixels
+
+
+  if (count == 0)
+    return;
+
+  // Dither leading pixels up to a byte boundary...
+  if (x & 7)
+  {
+    if ((n = 8 - (x & 7)) > count)
+      n = count;
+
+    dither_bits(dst, src, x, n, dither, black);
+
+    if ((count -= n) == 0)
+      return;
+
+    src += n;
+    x   += n;
+  }
+
+  // Dither whole bytes...
+  if ((n = count & ~7U) > 0)
+  {
+    unsigned	done;			// Number of pixels dithered
+
+    switch (raster_simd < 0 ? get_simd() : (_pappl_simd_t)raster_simd)
+    {
+#ifdef _PAPPL_HAVE_AVX2
+      case _PAPPL_SIMD_AVX2 :
+          done = dither_avx2(dst + x / 8, src, x, n, dither, black);
+          break;
+#endif // _PAPPL_HAVE_AVX2
+
+#ifdef _PAPPL_HAVE_SSE2
+      case _PAPPL_SIMD_SSE2 :
+          done = dither_sse2(dst + x / 8, src, x, n, dither, black);
+          break;
+#endif // _PAPPL_HAVE_SSE2
+
+      default :
+          done = 0;
+          break;
+    }
+
+    if (done < n)
+      dither_bytes(dst + (x + done) / 8, src + done, x + done, n - done, dither, black);
+
+    src   += n;
+    x     += n;
+    count -= n;
+  }
+
+  // Dither trailing pixels...
+  if (count > 0)
+    dither_bits(dst, src, x, count, dither, black);
+}
+
+
+//
+// '_papplRasterGetSIMD()' - Get the SIMD instruction set used for raster data.
+//
+
+_pappl_simd_t				// O - SIMD instruction set
+_papplRasterGetSIMD(void)
+{
+  return (raster_simd < 0 ? get_simd() : (_pappl_simd_t)raster_simd);
+}
+
+
+//
+// '_papplRasterIsBlank()' - Determine whether raster data is blank.
+//
+// This function returns `true` when all "bytes" bytes starting at "line" are
+// equal to "white".  Multiple lines can be checked at once by passing the
+// total number of bytes in the lines.
+//
+// SSE2 or AVX2 instructions are used when the CPU supports them.
+//
+
+bool					// O - `true` if blank, `false` otherwise
+_papplRasterIsBlank(
+    const unsigned char *line,		// I - Raster data
+    size_t              bytes,		// I - Number of bytes
+    unsigned char       white)		// I - White value
+{
+  size_t	i;			// Current byte
+
+
+  switch (bytes < 16 ? _PAPPL_SIMD_NONE : raster_simd < 0 ? get_simd() : (_pappl_simd_t)raster_simd)
+  {
+#ifdef _PAPPL_HAVE_AVX2
+    case _PAPPL_SIMD_AVX2 :
+        i = blank_avx2(line, bytes, white);
+        break;
+#endif // _PAPPL_HAVE_AVX2
+
+#ifdef _PAPPL_HAVE_SSE2
+    case _PAPPL_SIMD_SSE2 :
+        i = blank_sse2(line, bytes, white);
+        break;
+#endif // _PAPPL_HAVE_SSE2
+
+    default :
+        i = 0;
+        break;
+  }
+
+  for (; i < bytes; i ++)
+  {
+    if (line[i] != white)
+      return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// '_papplRasterRotate()' - Copy a band of lines from a rotated image.
+//
+// This function copies "count" lines starting at line "y" of the "width" by
+// "height" image rotated for the specified orientation.  Lines of the rotated
+// image are "height" pixels wide for the landscape orientations and "width"
+// pixels wide otherwise.
+//
+// Each source line is read sequentially and its pixels stored in the same
+// column of each line in the band, so that the source image is read in memory
+// order and the destination stays in the CPU cache for small bands.
+//
+
+void
+_papplRasterRotate(
+    unsigned char       *dst,		// I - Output lines
+    const unsigned char *pixels,	// I - Image pixels
+    unsigned            width,		// I - Image width in columns
+    unsigned            height,		// I - Image height in lines
+    unsigned            depth,		// I - Bytes per pixel
+    ipp_orient_t        orientation,	// I - Orientation
+    unsigned            y,		// I - First line in rotated image
+    unsigned            count)		// I - Number of lines
+{
+  unsigned		i,		// Looping var
+			j,		// Looping var
+			col;		// Column in rotated image
+  size_t		rowsize = (size_t)width * depth,
+					// Bytes per source line
+			dstsize = (size_t)height * depth;
+					// Bytes per rotated line (landscape)
+  const unsigned char	*src;		// Pointer into source line
+  unsigned char		*dstptr;	// Pointer into output
+
+
+  switch (orientation)
+  {
+    default :
+    case IPP_ORIENT_PORTRAIT :
+        memcpy(dst, pixels + y * rowsize, count * rowsize);
+        break;
+
+    case IPP_ORIENT_REVERSE_PORTRAIT :
+        // Lines are the source lines in reverse order with reversed pixels...
+        for (i = 0; i < count; i ++)
+        {
+          src = pixels + (height - y - i) * rowsize - depth;
+
+          for (j = width; j > 0; j --, src -= depth, dst += depth)
+            memcpy(dst, src, depth);
+        }
+        break;
+
+    case IPP_ORIENT_LANDSCAPE : // 90 counter-clockwise
+        // Line N is column "width - 1 - N", source line M is column M...
+        for (col = 0; col < height; col ++)
+        {
+          src    = pixels + col * rowsize + (width - y - 1) * depth;
+          dstptr = dst + col * depth;
+
+          if (depth == 1)
+          {
+            for (i = count; i > 0; i --, src --, dstptr += dstsize)
+              *dstptr = *src;
+          }
+          else
+          {
+            for (i = count; i > 0; i --, src -= depth, dstptr += dstsize)
+              memcpy(dstptr, src, depth);
+          }
+        }
+        break;
+
+    case IPP_ORIENT_REVERSE_LANDSCAPE : // 90 clockwise
+        // Line N is column N, source line M is column "height - 1 - M"...
+        for (col = 0; col < height; col ++)
+        {
+          src    = pixels + col * rowsize + y * depth;
+          dstptr = dst + (height - 1 - col) * depth;
+
+          if (depth == 1)
+          {
+            for (i = count; i > 0; i --, src ++, dstptr += dstsize)
+              *dstptr = *src;
+          }
+          else
+          {
+            for (i = count; i > 0; i --, src += depth, dstptr += dstsize)
+              memcpy(dstptr, src, depth);
+          }
+        }
+        break;
+  }
+}
+
+
+//
+// '_papplRasterScaleCreate()' - Create an image scaler.
+//
+// This function creates an image scaler for a "in_width" by "in_height" image
+// with "depth" (`1` or `3`) bytes per pixel that is scaled to "out_width" by
+// "out_height" pixels.  Only the "out_count" columns starting at column
+// "out_x" of the scaled image are produced.
+//
+// The source offsets and weights for each output column are computed once.
+// When "smoothing" is `true`, bilinear interpolation is used when enlarging
+// the image and a box filter is used when reducing the image.  Otherwise
+// nearest-neighbor sampling is used.
+//
+// The row callback "cb" is called to get each source row.  Rows are requested
+// in increasing order when the output lines are requested in increasing order,
+// and each row is only requested once.
+//
+
+_pappl_rscale_t *			// O - Image scaler or `NULL` on error
+_papplRasterScaleCreate(
+    unsigned           depth,		// I - Bytes per pixel
+    unsigned           in_width,	// I - Source width in columns
+    unsigned           in_height,	// I - Source height in lines
+    unsigned           out_width,	// I - Scaled width in columns
+    unsigned           out_height,	// I - Scaled height in lines
+    unsigned           out_x,		// I - First output column
+    unsigned           out_count,	// I - Number of output columns
+    bool               smoothing,	// I - `true` to smooth, `false` for nearest-neighbor
+    _pappl_rscale_cb_t cb,		// I - Row callback
+    void               *cbdata)		// I - Row callback data
+{
+  _pappl_rscale_t	*scale;		// Image scaler
+  unsigned		i,		// Looping var
+			first,		// First source column
+			weight;		// Weight or number of taps
+  size_t		bytes;		// Bytes per output line
+
+
+  // Range check input...
+  if (depth < 1 || in_width < 1 || in_height < 1 || out_width < 1 || out_height < 1 || out_count < 1 || out_x >= out_width || out_count > (out_width - out_x) || !cb)
+    return (NULL);
+
+  // Allocate memory...
+  bytes = (size_t)out_count * depth;
+
+  if ((scale = (_pappl_rscale_t *)calloc(1, sizeof(_pappl_rscale_t))) == NULL)
+    return (NULL);
+
+  scale->depth      = depth;
+  scale->in_width   = in_width;
+  scale->in_height  = in_height;
+  scale->out_width  = out_width;
+  scale->out_height = out_height;
+  scale->count      = out_count;
+  scale->cb         = cb;
+  scale->cbdata     = cbdata;
+  scale->rows_y[0]  = UINT_MAX;
+  scale->rows_y[1]  = UINT_MAX;
+
+  if (!smoothing)
+    scale->xfilter = _PAPPL_RFILTER_NEAREST;
+  else if (out_width < in_width)
+    scale->xfilter = _PAPPL_RFILTER_BOX;
+  else if (in_width > 1)
+    scale->xfilter = _PAPPL_RFILTER_BILINEAR;
+  else
+    scale->xfilter = _PAPPL_RFILTER_NEAREST;
+
+  if (!smoothing)
+    scale->yfilter = _PAPPL_RFILTER_NEAREST;
+  else if (out_height < in_height)
+    scale->yfilter = _PAPPL_RFILTER_BOX;
+  else if (in_height > 1)
+    scale->yfilter = _PAPPL_RFILTER_BILINEAR;
+  else
+    scale->yfilter = _PAPPL_RFILTER_NEAREST;
+
+  if ((scale->xoffsets = (unsigned *)calloc(out_count, sizeof(unsigned))) == NULL || (scale->xweights = (unsigned short *)calloc(out_count, sizeof(unsigned short))) == NULL || (scale->rows[0] = (unsigned char *)malloc(bytes)) == NULL || (scale->rows[1] = (unsigned char *)malloc(bytes)) == NULL || (scale->line = (unsigned char *)malloc(bytes)) == NULL || (scale->yfilter == _PAPPL_RFILTER_BOX && (scale->accum = (unsigned short *)calloc(bytes, sizeof(unsigned short))) == NULL))
+  {
+    _papplRasterScaleDelete(scale);
+    return (NULL);
+  }
+
+  // Compute the source offset and weight for each output column...
+  for (i = 0; i < out_count; i ++)
+  {
+    scale_map(scale->xfilter, in_width, out_width, out_x + i, &first, &weight);
+
+    scale->xoffsets[i] = first * depth;
+    scale->xweights[i] = (unsigned short)weight;
+  }
+
+  return (scale);
+}
+
+
+//
+// '_papplRasterScaleDelete()' - Delete an image scaler.
+//
+
+void
+_papplRasterScaleDelete(
+    _pappl_rscale_t *scale)		// I - Image scaler
+{
+  if (scale)
+  {
+    free(scale->xoffsets);
+    free(scale->xweights);
+    free(scale->rows[0]);
+    free(scale->rows[1]);
+    free(scale->line);
+    free(scale->accum);
+    free(scale);
+  }
+}
+
+
+//
+// '_papplRasterScaleGetLine()' - Get a line of the scaled image.
+//
+// This function returns the output columns of line "y" of the scaled image.
+// The returned pointer is valid until the next call.  Vertical interpolation
+// and box filtering use SSE2 or AVX2 instructions when supported by the CPU.
+//
+
+const unsigned char *			// O - Scaled pixels or `NULL` on error
+_papplRasterScaleGetLine(
+    _pappl_rscale_t *scale,		// I - Image scaler
+    unsigned        y)			// I - Line number
+{
+  unsigned		first,		// First source row
+			weight,		// Weight or number of taps
+			i;		// Looping var
+  size_t		bytes;		// Bytes per output line
+  const unsigned char	*a,		// First row
+			*b;		// Second row
+
+
+  if (!scale || y >= scale->out_height)
+    return (NULL);
+
+  bytes = (size_t)scale->count * scale->depth;
+
+  scale_map(scale->yfilter, scale->in_height, scale->out_height, y, &first, &weight);
+
+  switch (scale->yfilter)
+  {
+    default :
+    case _PAPPL_RFILTER_NEAREST :
+        return (scale_get_row(scale, first, UINT_MAX));
+
+    case _PAPPL_RFILTER_BILINEAR :
+        if ((a = scale_get_row(scale, first, first + 1)) == NULL)
+          return (NULL);
+
+        if (weight == 0)
+          return (a);
+
+        if ((b = scale_get_row(scale, first + 1, first)) == NULL)
+          return (NULL);
+
+        if (weight == 256)
+          return (b);
+
+        scale_blend(scale->line, a, b, bytes, weight);
+        return (scale->line);
+
+    case _PAPPL_RFILTER_BOX :
+        if (weight == 1)
+          return (scale_get_row(scale, first, UINT_MAX));
+
+        for (i = 0; i < weight; i ++)
+        {
+          if ((a = scale_get_row(scale, first + i, UINT_MAX)) == NULL)
+            return (NULL);
+
+          scale_accum(scale->accum, a, bytes, i == 0);
+        }
+
+        scale_average(scale->line, scale->accum, bytes, weight);
+        return (scale->line);
+  }
+}
+
+
+//
+// '_papplRasterSetSIMD()' - Limit the SIMD instruction set used for raster data.
+//
+// This function is used by the unit tests and benchmarks to compare the
+// portable C code with the SIMD code.  The instruction set is limited to
+// what the current CPU supports.
+//
+
+_pappl_simd_t				// O - SIMD instruction set that will be used
+_papplRasterSetSIMD(_pappl_simd_t simd)	// I - Maximum SIMD instruction set
+{
+  _pappl_simd_t	supported = get_simd();	// Supported instruction set
+
+
+  if (simd > supported)
+    simd = supported;
+
+  raster_simd = (int)simd;
+
+  return (simd);
+}
+
+
+#ifdef _PAPPL_HAVE_AVX2
+//
+// 'blank_avx2()' - Check for white bytes 128 bytes at a time using AVX2.
+//
+// The returned offset is at or before the first non-white byte.
+//
+
+static size_t				// O - Number of white bytes checked
+blank_avx2(
+    const unsigned char *line,		// I - Raster data
+    size_t              bytes,		// I - Number of bytes
+    unsigned char       white)		// I - White value
+{
+  size_t	i;			// Current byte
+  __m256i	w = _mm256_set1_epi8((char)white),
+					// White bytes
+		diff;			// Differing bits
+
+
+  // Compare 4 vectors at a time to amortize the test for non-white bytes...
+  for (i = 0; (i + 128) <= bytes; i += 128)
+  {
+    diff = _mm256_or_si256(_mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(line + i)), w), _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(line + i + 32)), w)), _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(line + i + 64)), w), _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(line + i + 96)), w)));
+
+    if (!_mm256_testz_si256(diff, diff))
+      return (i);
+  }
+
+  for (; (i + 32) <= bytes; i += 32)
+  {
+    diff = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(line + i)), w);
+
+    if (!_mm256_testz_si256(diff, diff))
+      break;
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_AVX2
+
+
+#ifdef _PAPPL_HAVE_SSE2
+//
+// 'blank_sse2()' - Check for white bytes 64 bytes at a time using SSE2.
+//
+// The returned offset is at or before the first non-white byte.
+//
+
+static size_t				// O - Number of white bytes checked
+blank_sse2(
+    const unsigned char *line,		// I - Raster data
+    size_t              bytes,		// I - Number of bytes
+    unsigned char       white)		// I - White value
+{
+  size_t	i;			// Current byte
+  __m128i	w = _mm_set1_epi8((char)white),
+					// White bytes
+		same;			// Matching bytes
+
+
+  // Compare 4 vectors at a time to amortize the test for non-white bytes...
+  for (i = 0; (i + 64) <= bytes; i += 64)
+  {
+    same = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(line + i)), w), _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(line + i + 16)), w)), _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(line + i + 32)), w), _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(line + i + 48)), w)));
+
+    if (_mm_movemask_epi8(same) != 0xffff)
+      return (i);
+  }
+
+  for (; (i + 16) <= bytes; i += 16)
+  {
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(line + i)), w)) != 0xffff)
+      break;
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_SSE2
+
+
+//
+// 'compress_find()' - Find the first byte that matches (or differs from) the
+//                     byte "stride" bytes later.
+//
+// The bytes from "src" through "src + count + stride - 1" must be readable.
+//
+
+static size_t				// O - Offset of byte or "count" if none
+compress_find(
+    const unsigned char *src,		// I - Bytes
+    size_t              count,		// I - Number of bytes to check
+    size_t              stride,		// I - Distance to compared byte
+    bool                equal)		// I - `true` to find a match, `false` to find a difference
+{
+  size_t	i;			// Current offset
+
+
+  // Short runs are checked one byte at a time...
+  switch (count < 16 ? _PAPPL_SIMD_NONE : raster_simd < 0 ? get_simd() : (_pappl_simd_t)raster_simd)
+  {
+#ifdef _PAPPL_HAVE_AVX2
+    case _PAPPL_SIMD_AVX2 :
+        i = compress_find_avx2(src, count, stride, equal);
+        break;
+#endif // _PAPPL_HAVE_AVX2
+
+#ifdef _PAPPL_HAVE_SSE2
+    case _PAPPL_SIMD_SSE2 :
+        i = compress_find_sse2(src, count, stride, equal);
+        break;
+#endif // _PAPPL_HAVE_SSE2
+
+    default :
+        i = 0;
+        break;
+  }
+
+  for (; i < count; i ++)
+  {
+    if ((src[i] == src[i + stride]) == equal)
+      break;
+  }
+
+  return (i);
+}
+
+
+#ifdef _PAPPL_HAVE_AVX2
+//
+// 'compress_find_avx2()' - Find a matching or differing byte 32 bytes at a time
+//                          using AVX2.
+//
+// The returned offset is at or before the first matching or differing byte.
+//
+
+static size_t				// O - Offset of byte or number of bytes checked
+compress_find_avx2(
+    const unsigned char *src,		// I - Bytes
+    size_t              count,		// I - Number of bytes to check
+    size_t              stride,		// I - Distance to compared byte
+    bool                equal)		// I - `true` to find a match, `false` to find a difference
+{
+  size_t	i;			// Current offset
+  unsigned	invert = equal ? 0 : 0xffffffff;
+					// Bits to invert
+
+
+  for (i = 0; (i + 32) <= count; i += 32)
+  {
+    if (((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(src + i)), _mm256_loadu_si256((const __m256i *)(src + i + stride))))) ^ invert)
+      break;
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_AVX2
+
+
+#ifdef _PAPPL_HAVE_SSE2
+//
+// 'compress_find_sse2()' - Find a matching or differing byte 16 bytes at a time
+//                          using SSE2.
+//
+// The returned offset is at or before the first matching or differing byte.
+//
+
+static size_t				// O - Offset of byte or number of bytes checked
+compress_find_sse2(
+    const unsigned char *src,		// I - Bytes
+    size_t              count,		// I - Number of bytes to check
+    size_t              stride,		// I - Distance to compared byte
+    bool                equal)		// I - `true` to find a match, `false` to find a difference
+{
+  size_t	i;			// Current offset
+  unsigned	invert = equal ? 0 : 0xffff;
+					// Bits to invert
+
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    if (((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(src + i)), _mm_loadu_si128((const __m128i *)(src + i + stride))))) ^ invert)
+      break;
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_SSE2
+
+
+#ifdef _PAPPL_HAVE_AVX2
+//
+// 'dither_avx2()' - Dither 32 pixels at a time using AVX2.
+//
+
+static unsigned				// O - Number of pixels dithered
+dither_avx2(
+    unsigned char       *dst,		// I - Output bytes
+    const unsigned char *src,		// I - Pixels
+    unsigned            x,		// I - First column (multiple of 8)
+    unsigned            count,		// I - Number of pixels
+    const unsigned char *dither,	// I - Dither row
+    bool                black)		// I - Black pixels?
+{
+  unsigned	i;			// Looping var
+  unsigned char	pattern[48];		// Repeated dither row
+  __m256i	d,			// Dither values
+		s;			// Pixel values
+  uint32_t	mask,			// Bit mask
+		invert = black ? 0xffffffff : 0;
+					// Bits to invert
+
+
+  memcpy(pattern, dither, 16);
+  memcpy(pattern + 16, dither, 16);
+  memcpy(pattern + 32, dither, 16);
+
+  d = _mm256_loadu_si256((const __m256i *)(pattern + (x & 15)));
+
+  for (i = 0; (i + 32) <= count; i += 32, src += 32, dst += 4)
+  {
+    // Pixels less than or equal to the dither value have max(s,d) == d...
+    s    = _mm256_loadu_si256((const __m256i *)src);
+    mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_max_epu8(s, d), d)) ^ invert;
+
+    dst[0] = raster_bitrev[mask & 255];
+    dst[1] = raster_bitrev[(mask >> 8) & 255];
+    dst[2] = raster_bitrev[(mask >> 16) & 255];
+    dst[3] = raster_bitrev[mask >> 24];
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_AVX2
+
+
+//
+// 'dither_bits()' - Dither pixels one bit at a time.
+//
+
+static void
+dither_bits(
+    unsigned char       *dst,		// I - Output line
+    const unsigned char *src,		// I - Pixels
+    unsigned            x,		// I - First column
+    unsigned            count,		// I - Number of pixels
+    const unsigned char *dither,	// I - Dither row
+    bool                black)		// I - Black pixels?
+{
+  unsigned char	*dstptr = dst + x / 8,	// Pointer into line
+		byte = 0,		// Current byte
+		bit = 128 >> (x & 7);	// Current bit
+
+
+  for (; count > 0; count --, src ++, x ++)
+  {
+    if (black ? *src > dither[x & 15] : *src <= dither[x & 15])
+      byte |= bit;
+
+    if (bit == 1)
+    {
+      *dstptr++ = byte;
+      byte      = 0;
+      bit       = 128;
+    }
+    else
+      bit /= 2;
+  }
+
+  if (bit < 128)
+    *dstptr = byte;
+}
+
+
+//
+// 'dither_bytes()' - Dither pixels one byte at a time.
+//
+
+static void
+dither_bytes(
+    unsigned char       *dst,		// I - Output bytes
+    const unsigned char *src,		// I - Pixels
+    unsigned            x,		// I - First column (multiple of 8)
+    unsigned            count,		// I - Number of pixels (multiple of 8)
+    const unsigned char *dither,	// I - Dither row
+    bool                black)		// I - Black pixels?
+{
+  unsigned		i;		// Looping var
+  unsigned		byte;		// Current byte
+  const unsigned char	*d;		// Dither values for byte
+  unsigned		invert = black ? 255 : 0;
+					// Bits to invert
+
+
+  for (; count > 0; count -= 8, src += 8, x += 8)
+  {
+    for (i = 0, byte = 0, d = dither + (x & 15); i < 8; i ++)
+      byte = (byte << 1) | (src[i] <= d[i]);
+
+    *dst++ = (unsigned char)(byte ^ invert);
+  }
+}
+
+
+#ifdef _PAPPL_HAVE_SSE2
+//
+// 'dither_sse2()' - Dither 16 pixels at a time using SSE2.
+//
+
+static unsigned				// O - Number of pixels dithered
+dither_sse2(
+    unsigned char       *dst,		// I - Output bytes
+    const unsigned char *src,		// I - Pixels
+    unsigned            x,		// I - First column (multiple of 8)
+    unsigned            count,		// I - Number of pixels
+    const unsigned char *dither,	// I - Dither row
+    bool                black)		// I - Black pixels?
+{
+  unsigned	i;			// Looping var
+  unsigned char	pattern[32];		// Repeated dither row
+  __m128i	d,			// Dither values
+		s;			// Pixel values
+  unsigned	mask,			// Bit mask
+		invert = black ? 0xffff : 0;
+					// Bits to invert
+
+
+  memcpy(pattern, dither, 16);
+  memcpy(pattern + 16, dither, 16);
+
+  d = _mm_loadu_si128((const __m128i *)(pattern + (x & 15)));
+
+  for (i = 0; (i + 16) <= count; i += 16, src += 16, dst += 2)
+  {
+    // Pixels less than or equal to the dither value have max(s,d) == d...
+    s    = _mm_loadu_si128((const __m128i *)src);
+    mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(s, d), d)) ^ invert;
+
+    dst[0] = raster_bitrev[mask & 255];
+    dst[1] = raster_bitrev[mask >> 8];
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_SSE2
+
+
+//
+// 'get_simd()' - Get the best SIMD instruction set supported by the CPU.
+//
+
+static _pappl_simd_t			// O - SIMD instruction set
+get_simd(void)
+{
+  _pappl_simd_t	simd = _PAPPL_SIMD_NONE;// SIMD instruction set
+
+
+#ifdef _PAPPL_HAVE_SSE2
+  simd = _PAPPL_SIMD_SSE2;
+#endif // _PAPPL_HAVE_SSE2
+
+#ifdef _PAPPL_HAVE_AVX2
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+    simd = _PAPPL_SIMD_AVX2;
+#endif // _PAPPL_HAVE_AVX2
+
+  // Save the result; all threads compute the same value...
+  if (raster_simd < 0)
+    raster_simd = (int)simd;
+
+  return (simd);
+}
+
+
+//
+// 'render_thread()' - Render bands for '_papplRasterBandsRender()'.
+//
+
+static void *				// O - Thread exit status (unused)
+render_thread(_pappl_rbands_t *bands)	// I - Band renderer
+{
+  unsigned	worker,			// Worker number
+		band,			// Current band
+		band_y,			// First line in band
+		band_count,		// Number of lines in band
+		slot;			// Band buffer
+  bool		ret;			// Did the band render?
+
+
+  cupsMutexLock(&bands->mutex);
+
+  worker = bands->next_worker ++;
+
+  while (!bands->shutdown)
+  {
+    // Wait for a band to render and a free band buffer...
+    if (bands->abort || bands->next_band >= bands->num_bands || bands->next_band >= (bands->write_band + bands->num_slots))
+    {
+      cupsCondWait(&bands->cond, &bands->mutex, 0.0);
+      continue;
+    }
+
+    band = bands->next_band ++;
+    slot = band % bands->num_slots;
+
+    bands->num_busy ++;
+
+    cupsMutexUnlock(&bands->mutex);
+
+    // Render the band...
+    band_y = band * bands->band_lines;
+
+    if ((band_count = bands->count - band_y) > bands->band_lines)
+      band_count = bands->band_lines;
+
+    ret = (bands->render_cb)(bands->cbdata, worker, bands->y + band_y, band_count, bands->buffer + slot * bands->band_size);
+
+    cupsMutexLock(&bands->mutex);
+
+    if (ret)
+      bands->rendered[slot] = true;
+    else
+      bands->abort = true;
+
+    bands->num_busy --;
+
+    cupsCondBroadcast(&bands->cond);
+  }
+
+  cupsMutexUnlock(&bands->mutex);
+
+  return (NULL);
+}
+
+
+//
+// 'scale_accum()' - Add a row of pixels to the box filter accumulator.
+//
+
+static void
+scale_accum(
+    unsigned short      *accum,		// I - Accumulator
+    const unsigned char *src,		// I - Pixels
+    size_t              count,		// I - Number of bytes
+    bool                first)		// I - `true` for the first row
+{
+  size_t	done;			// Number of bytes processed
+
+
+  switch (raster_simd < 0 ? get_simd() : (_pappl_simd_t)raster_simd)
+  {
+#ifdef _PAPPL_HAVE_AVX2
+    case _PAPPL_SIMD_AVX2 :
+        done = scale_accum_avx2(accum, src, count, first);
+        break;
+#endif // _PAPPL_HAVE_AVX2
+
+#ifdef _PAPPL_HAVE_SSE2
+    case _PAPPL_SIMD_SSE2 :
+        done = scale_accum_sse2(accum, src, count, first);
+        break;
+#endif // _PAPPL_HAVE_SSE2
+
+    default :
+        done = 0;
+        break;
+  }
+
+  if (first)
+  {
+    for (; done < count; done ++)
+      accum[done] = src[done];
+  }
+  else
+  {
+    for (; done < count; done ++)
+      accum[done] += src[done];
+  }
+}
+
+
+#ifdef _PAPPL_HAVE_AVX2
+//
+// 'scale_accum_avx2()' - Add 32 pixels at a time using AVX2.
+//
+
+static size_t				// O - Number of bytes processed
+scale_accum_avx2(
+    unsigned short      *accum,		// I - Accumulator
+    const unsigned char *src,		// I - Pixels
+    size_t              count,		// I - Number of bytes
+    bool                first)		// I - `true` for the first row
+{
+  size_t	i;			// Looping var
+  __m256i	s,			// Pixels
+		lo,			// Low pixels (16-bit)
+		hi;			// High pixels (16-bit)
+
+
+  for (i = 0; (i + 32) <= count; i += 32)
+  {
+    s  = _mm256_permute4x64_epi64(_mm256_loadu_si256((const __m256i *)(src + i)), 0xd8);
+    lo = _mm256_unpacklo_epi8(s, _mm256_setzero_si256());
+    hi = _mm256_unpackhi_epi8(s, _mm256_setzero_si256());
+
+    if (!first)
+    {
+      lo = _mm256_add_epi16(lo, _mm256_loadu_si256((const __m256i *)(accum + i)));
+      hi = _mm256_add_epi16(hi, _mm256_loadu_si256((const __m256i *)(accum + i + 16)));
+    }
+
+    _mm256_storeu_si256((__m256i *)(accum + i), lo);
+    _mm256_storeu_si256((__m256i *)(accum + i + 16), hi);
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_AVX2
+
+
+#ifdef _PAPPL_HAVE_SSE2
+//
+// 'scale_accum_sse2()' - Add 16 pixels at a time using SSE2.
+//
+
+static size_t				// O - Number of bytes processed
+scale_accum_sse2(
+    unsigned short      *accum,		// I - Accumulator
+    const unsigned char *src,		// I - Pixels
+    size_t              count,		// I - Number of bytes
+    bool                first)		// I - `true` for the first row
+{
+  size_t	i;			// Looping var
+  __m128i	s,			// Pixels
+		lo,			// Low pixels (16-bit)
+		hi;			// High pixels (16-bit)
+
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    s  = _mm_loadu_si128((const __m128i *)(src + i));
+    lo = _mm_unpacklo_epi8(s, _mm_setzero_si128());
+    hi = _mm_unpackhi_epi8(s, _mm_setzero_si128());
+
+    if (!first)
+    {
+      lo = _mm_add_epi16(lo, _mm_loadu_si128((const __m128i *)(accum + i)));
+      hi = _mm_add_epi16(hi, _mm_loadu_si128((const __m128i *)(accum + i + 8)));
+    }
+
+    _mm_storeu_si128((__m128i *)(accum + i), lo);
+    _mm_storeu_si128((__m128i *)(accum + i + 8), hi);
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_SSE2
+
+
+//
+// 'scale_average()' - Divide the box filter accumulator by the number of taps.
+//
+// The division uses a 16-bit fixed-point reciprocal so that the C and SIMD
+// code produce identical results.
+//
+
+static void
+scale_average(
+    unsigned char        *dst,		// I - Output pixels
+    const unsigned short *accum,	// I - Accumulator
+    size_t               count,		// I - Number of bytes
+    unsigned             taps)		// I - Number of taps (2 to 256)
+{
+  size_t	done;			// Number of bytes processed
+  unsigned	recip = (65536 + taps / 2) / taps,
+					// Reciprocal of taps
+		round = taps / 2;	// Rounding
+
+
+  switch (raster_simd < 0 ? get_simd() : (_pappl_simd_t)raster_simd)
+  {
+#ifdef _PAPPL_HAVE_AVX2
+    case _PAPPL_SIMD_AVX2 :
+        done = scale_average_avx2(dst, accum, count, taps);
+        break;
+#endif // _PAPPL_HAVE_AVX2
+
+#ifdef _PAPPL_HAVE_SSE2
+    case _PAPPL_SIMD_SSE2 :
+        done = scale_average_sse2(dst, accum, count, taps);
+        break;
+#endif // _PAPPL_HAVE_SSE2
+
+    default :
+        done = 0;
+        break;
+  }
+
+  for (; done < count; done ++)
+    dst[done] = (unsigned char)(((accum[done] + round) * recip) >> 16);
+}
+
+
+#ifdef _PAPPL_HAVE_AVX2
+//
+// 'scale_average_avx2()' - Divide 32 accumulated values at a time using AVX2.
+//
+
+static size_t				// O - Number of bytes processed
+scale_average_avx2(
+    unsigned char        *dst,		// I - Output pixels
+    const unsigned short *accum,	// I - Accumulator
+    size_t               count,		// I - Number of bytes
+    unsigned             taps)		// I - Number of taps (2 to 256)
+{
+  size_t	i;			// Looping var
+  __m256i	recip = _mm256_set1_epi16((short)((65536 + taps / 2) / taps)),
+					// Reciprocal of taps
+		round = _mm256_set1_epi16((short)(taps / 2)),
+					// Rounding
+		lo,			// Low values
+		hi;			// High values
+
+
+  for (i = 0; (i + 32) <= count; i += 32)
+  {
+    lo = _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i *)(accum + i)), round), recip);
+    hi = _mm256_mulhi_epu16(_mm256_add_epi16(_mm256_loadu_si256((const __m256i *)(accum + i + 16)), round), recip);
+
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8));
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_AVX2
+
+
+#ifdef _PAPPL_HAVE_SSE2
+//
+// 'scale_average_sse2()' - Divide 16 accumulated values at a time using SSE2.
+//
+
+static size_t				// O - Number of bytes processed
+scale_average_sse2(
+    unsigned char        *dst,		// I - Output pixels
+    const unsigned short *accum,	// I - Accumulator
+    size_t               count,		// I - Number of bytes
+    unsigned             taps)		// I - Number of taps (2 to 256)
+{
+  size_t	i;			// Looping var
+  __m128i	recip = _mm_set1_epi16((short)((65536 + taps / 2) / taps)),
+					// Reciprocal of taps
+		round = _mm_set1_epi16((short)(taps / 2)),
+					// Rounding
+		lo,			// Low values
+		hi;			// High values
+
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    lo = _mm_mulhi_epu16(_mm_add_epi16(_mm_loadu_si128((const __m128i *)(accum + i)), round), recip);
+    hi = _mm_mulhi_epu16(_mm_add_epi16(_mm_loadu_si128((const __m128i *)(accum + i + 8)), round), recip);
+
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(lo, hi));
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_SSE2
+
+
+//
+// 'scale_blend()' - Interpolate between two rows of pixels.
+//
+// The weight of the second row is a fixed-point value from `0` to `256`.
+//
+
+static void
+scale_blend(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *a,		// I - First row
+    const unsigned char *b,		// I - Second row
+    size_t              count,		// I - Number of bytes
+    unsigned            weight)		// I - Weight of second row (0 to 256)
+{
+  size_t	done;			// Number of bytes processed
+  unsigned	aweight = 256 - weight;	// Weight of first row
+
+
+  switch (raster_simd < 0 ? get_simd() : (_pappl_simd_t)raster_simd)
+  {
+#ifdef _PAPPL_HAVE_AVX2
+    case _PAPPL_SIMD_AVX2 :
+        done = scale_blend_avx2(dst, a, b, count, weight);
+        break;
+#endif // _PAPPL_HAVE_AVX2
+
+#ifdef _PAPPL_HAVE_SSE2
+    case _PAPPL_SIMD_SSE2 :
+        done = scale_blend_sse2(dst, a, b, count, weight);
+        break;
+#endif // _PAPPL_HAVE_SSE2
+
+    default :
+        done = 0;
+        break;
+  }
+
+  for (; done < count; done ++)
+    dst[done] = (unsigned char)((a[done] * aweight + b[done] * weight + 128) >> 8);
+}
+
+
+#ifdef _PAPPL_HAVE_AVX2
+//
+// 'scale_blend_avx2()' - Interpolate 32 pixels at a time using AVX2.
+//
+
+static size_t				// O - Number of bytes processed
+scale_blend_avx2(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *a,		// I - First row
+    const unsigned char *b,		// I - Second row
+    size_t              count,		// I - Number of bytes
+    unsigned            weight)		// I - Weight of second row (0 to 256)
+{
+  size_t	i;			// Looping var
+  __m256i	aweight = _mm256_set1_epi16((short)(256 - weight)),
+					// Weight of first row
+		bweight = _mm256_set1_epi16((short)weight),
+					// Weight of second row
+		round = _mm256_set1_epi16(128),
+					// Rounding
+		zero = _mm256_setzero_si256(),
+					// Zero
+		av,			// First row pixels
+		bv,			// Second row pixels
+		lo,			// Low values
+		hi;			// High values
+
+
+  for (i = 0; (i + 32) <= count; i += 32)
+  {
+    av = _mm256_loadu_si256((const __m256i *)(a + i));
+    bv = _mm256_loadu_si256((const __m256i *)(b + i));
+
+    lo = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(av, zero), aweight), _mm256_mullo_epi16(_mm256_unpacklo_epi8(bv, zero), bweight)), round);
+    hi = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(av, zero), aweight), _mm256_mullo_epi16(_mm256_unpackhi_epi8(bv, zero), bweight)), round);
+
+    // The unpack and pack instructions work within each 128-bit lane, so the
+    // byte order is preserved...
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_packus_epi16(_mm256_srli_epi16(lo, 8), _mm256_srli_epi16(hi, 8)));
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_AVX2
+
+
+#ifdef _PAPPL_HAVE_SSE2
+//
+// 'scale_blend_sse2()' - Interpolate 16 pixels at a time using SSE2.
+//
+
+static size_t				// O - Number of bytes processed
+scale_blend_sse2(
+    unsigned char       *dst,		// I - Output pixels
+    const unsigned char *a,		// I - First row
+    const unsigned char *b,		// I - Second row
+    size_t              count,		// I - Number of bytes
+    unsigned            weight)		// I - Weight of second row (0 to 256)
+{
+  size_t	i;			// Looping var
+  __m128i	aweight = _mm_set1_epi16((short)(256 - weight)),
+					// Weight of first row
+		bweight = _mm_set1_epi16((short)weight),
+					// Weight of second row
+		round = _mm_set1_epi16(128),
+					// Rounding
+		zero = _mm_setzero_si128(),
+					// Zero
+		av,			// First row pixels
+		bv,			// Second row pixels
+		lo,			// Low values
+		hi;			// High values
+
+
+  for (i = 0; (i + 16) <= count; i += 16)
+  {
+    av = _mm_loadu_si128((const __m128i *)(a + i));
+    bv = _mm_loadu_si128((const __m128i *)(b + i));
+
+    lo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(av, zero), aweight), _mm_mullo_epi16(_mm_unpacklo_epi8(bv, zero), bweight)), round);
+    hi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(av, zero), aweight), _mm_mullo_epi16(_mm_unpackhi_epi8(bv, zero), bweight)), round);
+
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+  }
+
+  return (i);
+}
+#endif // _PAPPL_HAVE_SSE2
+
+
+//
+// 'scale_get_row()' - Get a horizontally scaled source row.
+//
+// The two most recently scaled rows are cached.  The "keep" row is not
+// replaced when a new row is scaled.
+//
+
+static unsigned char *			// O - Scaled row or `NULL` on error
+scale_get_row(_pappl_rscale_t *scale,	// I - Image scaler
+              unsigned        y,	// I - Source row
+              unsigned        keep)	// I - Source row to keep in the cache
+{
+  int			slot;		// Cache slot
+  const unsigned char	*src;		// Source row
+
+
+  if (y >= scale->in_height)
+    y = scale->in_height - 1;
+
+  if (scale->rows_y[0] == y)
+    return (scale->rows[0]);
+  else if (scale->rows_y[1] == y)
+    return (scale->rows[1]);
+
+  slot = scale->rows_y[0] == keep ? 1 : 0;
+
+  if ((src = (scale->cb)(scale->cbdata, y)) == NULL)
+    return (NULL);
+
+  scale_row(scale, scale->rows[slot], src);
+  scale->rows_y[slot] = y;
+
+  return (scale->rows[slot]);
+}
+
+
+//
+// 'scale_map()' - Map an output column or line to the source image.
+//
+// For nearest-neighbor sampling, "first" is the source pixel.  For bilinear
+// interpolation, "first" is the first of two source pixels and "weight" is the
+// weight of the second pixel from `0` to `256`.  For box filtering, "first" is
+// the first source pixel and "weight" is the number of source pixels from `1`
+// to `256`.
+//
+
+static void
+scale_map(_pappl_rfilter_t filter,	// I - Scaling filter
+          unsigned         in_size,	// I - Source size
+          unsigned         out_size,	// I - Scaled size
+          unsigned         pos,		// I - Output position
+          unsigned         *first,	// O - First source pixel
+          unsigned         *weight)	// O - Weight or number of source pixels
+{
+  uint64_t	center;			// Center in source (8-bit fraction)
+  unsigned	last;			// Last source pixel
+
+
+  switch (filter)
+  {
+    default :
+    case _PAPPL_RFILTER_NEAREST :
+        *first  = (unsigned)(((2 * (uint64_t)pos + 1) * in_size) / (2 * (uint64_t)out_size));
+        *weight = 0;
+        break;
+
+    case _PAPPL_RFILTER_BILINEAR :
+        // Pixel centers are at N + 0.5...
+        center = ((2 * (uint64_t)pos + 1) * in_size * 256) / (2 * (uint64_t)out_size);
+        center = center > 128 ? center - 128 : 0;
+
+        *first  = (unsigned)(center >> 8);
+        *weight = (unsigned)(center & 255);
+
+        if (*first >= (in_size - 1))
+        {
+          *first  = in_size - 2;
+          *weight = 256;
+        }
+        break;
+
+    case _PAPPL_RFILTER_BOX :
+        *first = (unsigned)(((uint64_t)pos * in_size) / out_size);
+        last   = (unsigned)((((uint64_t)pos + 1) * in_size) / out_size);
+
+        if (last <= *first)
+          *weight = 1;
+        else if ((last - *first) > 256)
+          *weight = 256;
+        else
+          *weight = last - *first;
+        break;
+  }
+
+  if (*first >= in_size)
+    *first = in_size - 1;
+}
+
+
+//
+// 'scale_row()' - Scale a source row horizontally.
+//
+
+static void
+scale_row(_pappl_rscale_t     *scale,	// I - Image scaler
+          unsigned char       *dst,	// I - Output pixels
+          const unsigned char *src)	// I - Source row
+{
+  unsigned		i,		// Looping var
+			j,		// Looping var
+			count = scale->count,
+					// Number of output columns
+			depth = scale->depth;
+					// Bytes per pixel
+  const unsigned	*xoffsets = scale->xoffsets;
+					// Source offsets
+  const unsigned short	*xweights = scale->xweights;
+					// Weights or number of taps
+
+
+  switch (scale->xfilter)
+  {
+    default :
+    case _PAPPL_RFILTER_NEAREST :
+        if (depth == 1)
+        {
+          for (i = 0; i < count; i ++)
+            *dst++ = src[xoffsets[i]];
+        }
+        else
+        {
+          for (i = 0; i < count; i ++, dst += depth)
+            memcpy(dst, src + xoffsets[i], depth);
+        }
+        break;
+
+    case _PAPPL_RFILTER_BILINEAR :
+        for (i = 0; i < count; i ++)
+        {
+          const unsigned char	*a = src + xoffsets[i],
+					// First pixel
+				*b = a + depth;
+					// Second pixel
+          unsigned		bweight = xweights[i],
+					// Weight of second pixel
+				aweight = 256 - bweight;
+					// Weight of first pixel
+
+          for (j = 0; j < depth; j ++)
+            *dst++ = (unsigned char)((a[j] * aweight + b[j] * bweight + 128) >> 8);
+        }
+        break;
+
+    case _PAPPL_RFILTER_BOX :
+        for (i = 0; i < count; i ++)
+        {
+          const unsigned char	*a = src + xoffsets[i];
+					// First pixel
+          unsigned		taps = xweights[i],
+					// Number of pixels
+				recip = (65536 + taps / 2) / taps,
+					// Reciprocal of taps
+				k,	// Looping var
+				sum;	// Sum of pixels
+
+          for (j = 0; j < depth; j ++)
+          {
+            for (k = 0, sum = taps / 2; k < taps; k ++)
+              sum += a[k * depth + j];
+
+            *dst++ = (unsigned char)((sum * recip) >> 16);
+          }
+        }
+        break;
+  }
+}
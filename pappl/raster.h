@@ -0,0 +1,29 @@
+//
+// Raster header file for the Printer Application Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#ifndef _PAPPL_RASTER_H_
+#  define _PAPPL_RASTER_H_
+#  include "base.h"
+#  ifdef __cplusplus
+extern "C" {
+#  endif // __cplusplus
+
+
+//
+// Functions...
+//
+
+extern size_t		papplRasterCompressPackBits(unsigned char *dst, size_t dstsize, const unsigned char *src, size_t srclen) _PAPPL_PUBLIC;
+extern size_t		papplRasterCompressPWG(unsigned char *dst, size_t dstsize, const unsigned char *lines, unsigned count, size_t bytes_per_line, unsigned bytes_per_pixel) _PAPPL_PUBLIC;
+
+
+#  ifdef __cplusplus
+}
+#  endif // __cplusplus
+#endif // !_PAPPL_RASTER_H_
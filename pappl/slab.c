@@ -0,0 +1,328 @@
+//
+// Slab allocator and string pool functions for the Printer Application
+// Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+
+#include "pappl-private.h"
+
+
+//
+// Constants...
+//
+
+#define _PAPPL_SLAB_ALIGN	16	// Alignment of objects
+#define _PAPPL_SLAB_CHUNK	65536	// Target size of each chunk of objects
+#define _PAPPL_SLAB_MIN		16	// Minimum number of objects per chunk
+
+
+//
+// Types...
+//
+
+typedef struct _pappl_slabobj_s		// Free object
+{
+  struct _pappl_slabobj_s *next;		// Next free object
+} _pappl_slabobj_t;
+
+typedef struct _pappl_slabinfo_s	// Slab allocator
+{
+  cups_mutex_t		mutex;			// Mutex for allocator
+  size_t		size;			// Size of objects
+  _pappl_slabobj_t	*free_objs;		// Free objects
+  size_t		num_used,		// Number of objects in use
+			num_allocs;		// Number of chunks allocated
+} _pappl_slabinfo_t;
+
+typedef struct _pappl_str_s		// Pooled string
+{
+  size_t		refcount;		// Reference count
+  char			str[1];			// String
+} _pappl_str_t;
+
+
+//
+// Local globals...
+//
+
+static _pappl_slabinfo_t slabs[_PAPPL_SLAB_MAX] =
+{					// Slab allocators
+  { CUPS_MUTEX_INITIALIZER, sizeof(pappl_client_t), NULL, 0, 0 },
+  { CUPS_MUTEX_INITIALIZER, sizeof(_pappl_doc_t), NULL, 0, 0 },
+  { CUPS_MUTEX_INITIALIZER, sizeof(pappl_job_t), NULL, 0, 0 },
+  { CUPS_MUTEX_INITIALIZER, sizeof(pappl_subscription_t), NULL, 0, 0 }
+};
+static cups_mutex_t	str_mutex = CUPS_MUTEX_INITIALIZER;
+					// Mutex for string pool
+static cups_array_t	*str_pool = NULL;
+					// String pool
+static size_t		str_allocs = 0;	// Number of strings allocated
+
+
+//
+// Local functions...
+//
+
+static int	compare_strings(const char *a, const char *b, void *data);
+
+
+//
+// '_papplSlabAlloc()' - Allocate a cleared object.
+//
+// Objects are allocated in chunks and are reused once freed with the
+// @link _papplSlabFree@ function.  The memory used by the chunks is not
+// returned to the operating system.
+//
+
+void *					// O - Object or `NULL` on error
+_papplSlabAlloc(_pappl_slab_t type)	// I - Type of object
+{
+  _pappl_slabinfo_t	*slab;		// Slab allocator
+  _pappl_slabobj_t	*obj;		// Object
+  size_t		size;		// Aligned size of object
+
+
+  if (type < _PAPPL_SLAB_CLIENT || type >= _PAPPL_SLAB_MAX)
+    return (NULL);
+
+  slab = slabs + type;
+  size = (slab->size + _PAPPL_SLAB_ALIGN - 1) & ~(size_t)(_PAPPL_SLAB_ALIGN - 1);
+
+  cupsMutexLock(&slab->mutex);
+
+  if (!slab->free_objs)
+  {
+    // Allocate a new chunk of objects and add them to the free list...
+    char	*chunk;			// Chunk of objects
+    size_t	i,			// Looping var
+		count = _PAPPL_SLAB_CHUNK / size;
+					// Number of objects in chunk
+
+    if (count < _PAPPL_SLAB_MIN)
+      count = _PAPPL_SLAB_MIN;
+
+    if ((chunk = malloc(count * size)) == NULL)
+    {
+      cupsMutexUnlock(&slab->mutex);
+      return (NULL);
+    }
+
+    for (i = count; i > 0; i --)
+    {
+      obj             = (_pappl_slabobj_t *)(chunk + (i - 1) * size);
+      obj->next       = slab->free_objs;
+      slab->free_objs = obj;
+    }
+
+    slab->num_allocs ++;
+  }
+
+  obj             = slab->free_objs;
+  slab->free_objs = obj->next;
+  slab->num_used ++;
+
+  cupsMutexUnlock(&slab->mutex);
+
+  memset(obj, 0, slab->size);
+
+  return (obj);
+}
+
+
+//
+// '_papplSlabFree()' - Free an object.
+//
+
+void
+_papplSlabFree(_pappl_slab_t type,	// I - Type of object
+               void          *obj)	// I - Object
+{
+  _pappl_slabinfo_t	*slab;		// Slab allocator
+
+
+  if (!obj || type < _PAPPL_SLAB_CLIENT || type >= _PAPPL_SLAB_MAX)
+    return;
+
+  slab = slabs + type;
+
+  cupsMutexLock(&slab->mutex);
+
+  ((_pappl_slabobj_t *)obj)->next = slab->free_objs;
+  slab->free_objs                 = (_pappl_slabobj_t *)obj;
+  slab->num_used --;
+
+  cupsMutexUnlock(&slab->mutex);
+}
+
+
+//
+// '_papplSlabGetStats()' - Get the number of objects in use and chunks allocated.
+//
+
+size_t					// O - Number of objects in use
+_papplSlabGetStats(
+    _pappl_slab_t type,			// I - Type of object
+    size_t        *num_allocs)		// O - Number of chunks allocated
+{
+  size_t	num_used;		// Number of objects in use
+
+
+  if (type < _PAPPL_SLAB_CLIENT || type >= _PAPPL_SLAB_MAX)
+  {
+    if (num_allocs)
+      *num_allocs = 0;
+
+    return (0);
+  }
+
+  cupsMutexLock(&slabs[type].mutex);
+
+  num_used = slabs[type].num_used;
+
+  if (num_allocs)
+    *num_allocs = slabs[type].num_allocs;
+
+  cupsMutexUnlock(&slabs[type].mutex);
+
+  return (num_used);
+}
+
+
+//
+// '_papplStrAlloc()' - Allocate a pooled string.
+//
+// This function returns a reference-counted copy of the string that is shared
+// with other users of the same string.  Pooled strings must not be modified
+// and are released with the @link _papplStrFree@ function.
+//
+
+const char *				// O - Pooled string or `NULL` on error
+_papplStrAlloc(const char *s)		// I - String
+{
+  char		*str;			// Pooled string
+  _pappl_str_t	*item;			// String pool item
+  size_t	len;			// Length of string
+
+
+  if (!s)
+    return (NULL);
+
+  cupsMutexLock(&str_mutex);
+
+  if (!str_pool && (str_pool = cupsArrayNew((cups_array_cb_t)compare_strings, /*cbdata*/NULL, /*hash_cb*/NULL, /*hashsize*/0, /*copy_cb*/NULL, /*free_cb*/NULL)) == NULL)
+  {
+    cupsMutexUnlock(&str_mutex);
+    return (NULL);
+  }
+
+  if ((str = (char *)cupsArrayFind(str_pool, (void *)s)) != NULL)
+  {
+    // Use the existing string...
+    item = (_pappl_str_t *)(str - offsetof(_pappl_str_t, str));
+    item->refcount ++;
+  }
+  else
+  {
+    // Add a new string...
+    len = strlen(s);
+
+    if ((item = (_pappl_str_t *)malloc(sizeof(_pappl_str_t) + len)) != NULL)
+    {
+      item->refcount = 1;
+      str            = item->str;
+
+      memcpy(str, s, len + 1);
+
+      if (cupsArrayAdd(str_pool, str))
+      {
+        str_allocs ++;
+      }
+      else
+      {
+        free(item);
+        str = NULL;
+      }
+    }
+  }
+
+  cupsMutexUnlock(&str_mutex);
+
+  return (str);
+}
+
+
+//
+// '_papplStrFree()' - Free a pooled string.
+//
+// Strings that were not allocated with the @link _papplStrAlloc@ function are
+// ignored.
+//
+
+void
+_papplStrFree(const char *s)		// I - Pooled string
+{
+  char		*str;			// Pooled string
+  _pappl_str_t	*item;			// String pool item
+
+
+  if (!s)
+    return;
+
+  cupsMutexLock(&str_mutex);
+
+  if ((str = (char *)cupsArrayFind(str_pool, (void *)s)) != NULL && str == s)
+  {
+    item = (_pappl_str_t *)(str - offsetof(_pappl_str_t, str));
+
+    if (-- item->refcount == 0)
+    {
+      // Last reference, remove the string from the pool...
+      cupsArrayRemove(str_pool, str);
+      free(item);
+    }
+  }
+
+  cupsMutexUnlock(&str_mutex);
+}
+
+
+//
+// '_papplStrGetStats()' - Get the number of pooled strings.
+//
+
+size_t					// O - Number of strings in the pool
+_papplStrGetStats(size_t *num_allocs)	// O - Number of strings allocated
+{
+  size_t	num_strings;		// Number of strings in the pool
+
+
+  cupsMutexLock(&str_mutex);
+
+  num_strings = cupsArrayGetCount(str_pool);
+
+  if (num_allocs)
+    *num_allocs = str_allocs;
+
+  cupsMutexUnlock(&str_mutex);
+
+  return (num_strings);
+}
+
+
+//
+// 'compare_strings()' - Compare two pooled strings.
+//
+
+static int				// O - Result of comparison
+compare_strings(const char *a,		// I - First string
+                const char *b,		// I - Second string
+                void       *data)	// I - Callback data (unused)
+{
+  (void)data;
+
+  return (strcmp(a, b));
+}
@@ -97,7 +97,7 @@ papplSubscriptionCreate(
   if (!system || !events)
     return (NULL);
 
-  if ((sub = (pappl_subscription_t *)calloc(1, sizeof(pappl_subscription_t))) == NULL)
+  if ((sub = (pappl_subscription_t *)_papplSlabAlloc(_PAPPL_SLAB_SUBSCRIPTION)) == NULL)
     return (NULL);
 
   cupsRWInit(&sub->rwlock);
@@ -106,8 +106,8 @@ papplSubscriptionCreate(
   sub->job             = job;
   sub->subscription_id = sub_id;
   sub->mask            = events;
-  sub->username        = strdup(username);
-  sub->language        = strdup(language ? language : "en");
+  sub->username        = _papplStrAlloc(username);
+  sub->language        = _papplStrAlloc(language ? language : "en");
   sub->interval        = interval;
   sub->lease           = lease;
 
@@ -160,14 +160,14 @@ _papplSubscriptionDelete(
   _papplRWLockWrite(sub);
 
   ippDelete(sub->attrs);
-  free(sub->username);
-  free(sub->language);
+  _papplStrFree(sub->username);
+  _papplStrFree(sub->language);
   cupsArrayDelete(sub->events);
 
   _papplRWUnlock(sub);
   cupsRWDestroy(&sub->rwlock);
 
-  free(sub);
+  _papplSlabFree(_PAPPL_SLAB_SUBSCRIPTION, sub);
 }
 
 
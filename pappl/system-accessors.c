@@ -1025,6 +1025,31 @@ papplSystemGetMaxClients(
 }
 
 
+//
+// 'papplSystemGetMaxImageMemory()' - Get the memory budget for decoding images.
+//
+// This function gets the maximum amount of memory used to decode a JPEG or PNG
+// image, as set by the @link papplSystemSetMaxImageMemory@ function.
+//
+
+size_t					// O - Maximum image memory in bytes
+papplSystemGetMaxImageMemory(
+    pappl_system_t *system)		// I - System
+{
+  size_t	ret = 0;		// Return value
+
+
+  if (system)
+  {
+    _papplRWLockRead(system);
+    ret = system->max_image_memory;
+    _papplRWUnlock(system);
+  }
+
+  return (ret);
+}
+
+
 //
 // 'papplSystemGetMaxImageSize()' - Get the maximum supported size for images.
 //
@@ -1069,6 +1094,31 @@ papplSystemGetMaxImageSize(
 }
 
 
+//
+// 'papplSystemGetMaxImageThreads()' - Get the number of threads for rendering images.
+//
+// This function gets the maximum number of threads used to scale and dither
+// an image, as set by the @link papplSystemSetMaxImageThreads@ function.
+//
+
+size_t					// O - Maximum number of threads
+papplSystemGetMaxImageThreads(
+    pappl_system_t *system)		// I - System
+{
+  size_t	ret = 0;		// Return value
+
+
+  if (system)
+  {
+    _papplRWLockRead(system);
+    ret = system->max_image_threads;
+    _papplRWUnlock(system);
+  }
+
+  return (ret);
+}
+
+
 //
 // 'papplSystemGetMaxLogSize()' - Get the maximum log file size.
 //
@@ -1125,6 +1175,77 @@ papplSystemGetMaxSubscriptions(
 }
 
 
+//
+// 'papplSystemGetMemorySpool()' - Get the memory spool limits.
+//
+// This function gets the maximum size of a document and the maximum size of
+// all documents that are spooled in memory, as set by the
+// @link papplSystemSetMemorySpool@ function.  A maximum size of `0` means the
+// memory spool is disabled.
+//
+
+size_t					// O - Maximum document size in bytes or `0` if disabled
+papplSystemGetMemorySpool(
+    pappl_system_t *system,		// I - System
+    size_t         *max_total)		// O - Maximum size of all documents in bytes or `NULL` for don't care
+{
+  size_t	ret = 0;		// Return value
+
+
+  if (system)
+  {
+    cupsMutexLock(&system->config_mutex);
+    if (system->spool_memdir)
+    {
+      ret = system->spool_memmax;
+      if (max_total)
+        *max_total = system->spool_memtotal;
+    }
+    else if (max_total)
+    {
+      *max_total = 0;
+    }
+    cupsMutexUnlock(&system->config_mutex);
+  }
+  else if (max_total)
+  {
+    *max_total = 0;
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetMetrics()' - Get the system metrics.
+//
+// This function returns a copy of the system metrics data, which includes the
+// number and duration (in milliseconds) of state saves since the system was
+// created.  This information is normally used for performance measurement and
+// tuning of the save delays set with the @link papplSystemSetSaveDelay@
+// function.
+//
+
+pappl_sysmetrics_t *			// O - Metrics data
+papplSystemGetMetrics(
+    pappl_system_t     *system,		// I - System
+    pappl_sysmetrics_t *metrics)	// I - Buffer for metrics data
+{
+  if (system && metrics)
+  {
+    cupsMutexLock(&system->config_mutex);
+    memcpy(metrics, &system->metrics, sizeof(pappl_sysmetrics_t));
+    cupsMutexUnlock(&system->config_mutex);
+  }
+  else if (metrics)
+  {
+    memset(metrics, 0, sizeof(pappl_sysmetrics_t));
+  }
+
+  return (metrics);
+}
+
+
 //
 // 'papplSystemGetName()' - Get the system name.
 //
@@ -1329,6 +1450,39 @@ papplSystemGetPassword(
 }
 
 
+//
+// 'papplSystemGetSaveDelay()' - Get the system state save delays.
+//
+// This function gets the minimum and maximum delays in seconds before changes
+// to the system state are saved, as set by the @link papplSystemSetSaveDelay@
+// function.
+//
+
+int					// O - Minimum delay in seconds
+papplSystemGetSaveDelay(
+    pappl_system_t *system,		// I - System
+    int            *max_delay)		// O - Maximum delay in seconds or `NULL` for don't care
+{
+  int	ret = 0;			// Return value
+
+
+  if (system)
+  {
+    cupsMutexLock(&system->config_mutex);
+    ret = system->save_min_delay;
+    if (max_delay)
+      *max_delay = system->save_max_delay;
+    cupsMutexUnlock(&system->config_mutex);
+  }
+  else if (max_delay)
+  {
+    *max_delay = 0;
+  }
+
+  return (ret);
+}
+
+
 //
 // 'papplSystemGetServerHeader()' - Get the Server: header for HTTP responses.
 //
@@ -1385,7 +1539,33 @@ papplSystemGetSessionKey(
 
 
 //
-// 'papplSystemGetTLSOnly()' - Get the TLS-only state of the system.
+// 'papplSystemGetSpoolSync()' - Get the spool file synchronization policy.
+//
+// This function returns the policy used to flush document files in the spool
+// directory to disk, as set by the @link papplSystemSetSpoolSync@ function.
+//
+
+pappl_spool_sync_t			// O - Synchronization policy
+papplSystemGetSpoolSync(
+    pappl_system_t *system)		// I - System
+{
+  pappl_spool_sync_t	ret = PAPPL_SPOOL_SYNC_NONE;
+					// Return value
+
+
+  if (system)
+  {
+    cupsMutexLock(&system->config_mutex);
+    ret = system->spool_sync;
+    cupsMutexUnlock(&system->config_mutex);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'papplSystemGetTLSOnly() - Get the TLS-only state of the system.
 //
 // This function returns whether the system will only accept encrypted
 // connections.
@@ -1687,21 +1867,6 @@ papplSystemMatchDriver(
 }
 
 
-//
-// '_papplSystemNeedClean()' - Mark the system needing cleaning.
-//
-
-void
-_papplSystemNeedClean(
-    pappl_system_t *system)		// I - System
-{
-  _papplRWLockWrite(system);
-  if (!system->clean_time)
-    system->clean_time = time(NULL) + 60;
-  _papplRWUnlock(system);
-}
-
-
 //
 // 'papplSystemRemoveTimerCallback()' - Remove a timer callback.
 //
@@ -2260,6 +2425,37 @@ papplSystemSetMaxClients(
 }
 
 
+//
+// 'papplSystemSetMaxImageMemory()' - Set the memory budget for decoding images.
+//
+// This function sets the maximum amount of memory used to decode a JPEG or PNG
+// image, which is separate from the maximum image size set by the
+// @link papplSystemSetMaxImageSize@ function.  Images printed in portrait
+// orientation that are larger than the budget are decoded a row or band of
+// rows at a time.  The default budget is 16MiB.
+//
+
+void
+papplSystemSetMaxImageMemory(
+    pappl_system_t *system,		// I - System
+    size_t         max_memory)		// I - Maximum image memory in bytes or `0` for default
+{
+  if (!system)
+    return;
+
+  if (max_memory == 0)
+    max_memory = 16 * 1024 * 1024;
+
+  _papplRWLockWrite(system);
+
+  system->max_image_memory = max_memory;
+
+  _papplSystemConfigChanged(system);
+
+  _papplRWUnlock(system);
+}
+
+
 //
 // 'papplSystemSetMaxImageSize()' - Set the maximum allowed JPEG/PNG image sizes.
 //
@@ -2321,6 +2517,57 @@ papplSystemSetMaxImageSize(
 }
 
 
+//
+// 'papplSystemSetMaxImageThreads()' - Set the number of threads for rendering images.
+//
+// This function sets the maximum number of threads used to scale and dither
+// an image printed with the @link papplJobFilterImage@ function.  Each page is
+// rendered in bands by worker threads, and the bands are passed to the
+// printer driver in order from the job's thread.  The default is the number of
+// CPUs, up to 16.  Use a value of `1` to render images in the job's thread.
+//
+
+void
+papplSystemSetMaxImageThreads(
+    pappl_system_t *system,		// I - System
+    size_t         max_threads)		// I - Maximum number of threads or `0` for default
+{
+  if (!system)
+    return;
+
+  if (max_threads == 0)
+  {
+    // By default, use one thread per CPU...
+#if _WIN32
+    SYSTEM_INFO	sysinfo;		// System information
+
+    GetSystemInfo(&sysinfo);
+    max_threads = (size_t)sysinfo.dwNumberOfProcessors;
+
+#else
+    long	ncpus;			// Number of CPUs
+
+    if ((ncpus = sysconf(_SC_NPROCESSORS_ONLN)) > 0)
+      max_threads = (size_t)ncpus;
+#endif // _WIN32
+  }
+
+  // Limit to between 1 and 16 threads...
+  if (max_threads < 1)
+    max_threads = 1;
+  else if (max_threads > 16)
+    max_threads = 16;
+
+  _papplRWLockWrite(system);
+
+  system->max_image_threads = max_threads;
+
+  _papplSystemConfigChanged(system);
+
+  _papplRWUnlock(system);
+}
+
+
 //
 // 'papplSystemSetMaxLogSize()' - Set the maximum log file size in bytes.
 //
@@ -2377,6 +2624,92 @@ papplSystemSetMaxSubscriptions(
 }
 
 
+//
+// 'papplSystemSetMemorySpool()' - Set the memory spool limits.
+//
+// This function enables spooling of small documents in a memory-backed (tmpfs)
+// directory, which avoids writing them to the spool directory on disk.  The
+// "directory" argument specifies the memory-backed directory to use, or `NULL`
+// for the default ("/dev/shm" on Linux).  The "max_size" argument specifies
+// the largest document in bytes that is spooled in memory, and the "max_total"
+// argument specifies the maximum size in bytes of all documents spooled in
+// memory.  Larger documents and documents received while the memory spool is
+// full are written to the spool directory.  A "max_size" value of `0`
+// disables the memory spool, which is the default.
+//
+// Documents for printers that preserve jobs (see
+// @link papplPrinterSetMaxPreservedJobs@) are always written to the spool
+// directory.  Documents of retained jobs and pending jobs at shutdown are
+// moved to the spool directory.
+//
+// > Note: The memory spool can only be set prior to calling
+// > @link papplSystemRun@.
+//
+
+bool					// O - `true` on success, `false` on error
+papplSystemSetMemorySpool(
+    pappl_system_t *system,		// I - System
+    const char     *directory,		// I - Memory-backed directory or `NULL` for default
+    size_t         max_size,		// I - Maximum document size in bytes or `0` to disable
+    size_t         max_total)		// I - Maximum size of all documents in bytes
+{
+  char		memdir[1024];		// Memory spool directory
+  struct stat	dirinfo;		// Directory information
+
+
+  if (!system || system->is_running)
+    return (false);
+
+  if (max_size > 0)
+  {
+    if (!directory)
+    {
+#ifdef __linux
+      directory = "/dev/shm";
+#else
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "No default memory spool directory.");
+      return (false);
+#endif // __linux
+    }
+
+    if (stat(directory, &dirinfo))
+    {
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to use memory spool directory '%s': %s", directory, strerror(errno));
+      return (false);
+    }
+    else if (!S_ISDIR(dirinfo.st_mode))
+    {
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Memory spool directory '%s' is not a directory.", directory);
+      return (false);
+    }
+
+    snprintf(memdir, sizeof(memdir), "%s/pappl%d.m", directory, (int)getpid());
+    if (mkdir(memdir, 0700) && errno != EEXIST)
+    {
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create memory spool directory '%s': %s", memdir, strerror(errno));
+      return (false);
+    }
+  }
+
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->spool_memdir)
+  {
+    // Remove the old directory if it is empty...
+    rmdir(system->spool_memdir);
+    free(system->spool_memdir);
+  }
+
+  system->spool_memdir   = max_size > 0 ? strdup(memdir) : NULL;
+  system->spool_memmax   = max_size;
+  system->spool_memtotal = max_total;
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  return (max_size == 0 || system->spool_memdir != NULL);
+}
+
+
 //
 // 'papplSystemSetMIMECallback()' - Set the MIME typing callback for the system.
 //
@@ -2737,7 +3070,63 @@ papplSystemSetSaveCallback(
 
 
 //
-// 'papplSystemSetUUID()' - Set the system UUID.
+// 'papplSystemSetSaveDelay()' - Set the system state save delays.
+//
+// This function sets the delays used to coalesce changes to the system state
+// before the save callback is called from a background thread.  The
+// "min_delay" argument specifies how long to wait in seconds for more changes
+// and the "max_delay" argument specifies the longest time in seconds a change
+// can remain unsaved while changes keep arriving.  A "min_delay" value of `0`
+// saves changes as soon as possible.  The default delays are 1 and 10 seconds.
+//
+// Any unsaved changes are always saved when the system is shutdown.
+//
+
+void
+papplSystemSetSaveDelay(
+    pappl_system_t *system,		// I - System
+    int            min_delay,		// I - Minimum delay in seconds
+    int            max_delay)		// I - Maximum delay in seconds
+{
+  if (system && min_delay >= 0 && max_delay >= min_delay)
+  {
+    cupsMutexLock(&system->config_mutex);
+    system->save_min_delay = min_delay;
+    system->save_max_delay = max_delay;
+    cupsCondBroadcast(&system->save_cond);
+    cupsMutexUnlock(&system->config_mutex);
+  }
+}
+
+
+//
+// 'papplSystemSetSpoolSync()' - Set the spool file synchronization policy.
+//
+// This function sets the policy used to flush document files in the spool
+// directory to disk.  `PAPPL_SPOOL_SYNC_NONE` (the default) leaves this to the
+// operating system, `PAPPL_SPOOL_SYNC_CLOSE` flushes each document file and the
+// spool directory when the document has been received, and
+// `PAPPL_SPOOL_SYNC_WRITE` also flushes the document file after every write,
+// which is the safest and slowest policy.  Documents in the memory spool are
+// never flushed.
+//
+
+void
+papplSystemSetSpoolSync(
+    pappl_system_t     *system,		// I - System
+    pappl_spool_sync_t sync)		// I - Synchronization policy
+{
+  if (system && sync >= PAPPL_SPOOL_SYNC_NONE && sync <= PAPPL_SPOOL_SYNC_WRITE)
+  {
+    cupsMutexLock(&system->config_mutex);
+    system->spool_sync = sync;
+    cupsMutexUnlock(&system->config_mutex);
+  }
+}
+
+
+//
+// 'papplSystemSetUUID() - Set the system UUID.
 //
 // This function sets the system UUID value, overriding the default (generated)
 // value.  It is typically used when restoring the state of a previous
@@ -429,7 +429,7 @@ ipp_delete_printer(
   }
 
   _papplRWLockWrite(client->printer);
-  if (!client->printer->processing_job)
+  if (!client->printer->processing_job && !client->printer->pool_processing)
   {
     // Not busy, delete immediately...
     _papplRWUnlock(client->printer);
@@ -1325,7 +1325,7 @@ ipp_set_system_attributes(
     }
   }
 
-  system->config_changes ++;
+  _papplSystemConfigChanged(system);
 
   _papplRWUnlock(system);
 
@@ -10,17 +10,72 @@
 #include "pappl-private.h"
 
 
+//
+// Local constants...
+//
+
+#define _PAPPL_JOURNAL_MIN	65536	// Minimum journal size before compacting
+
+#define _PAPPL_STATE_MAGIC	"PAPPLBIN"
+					// Binary state file header magic
+#define _PAPPL_STATE_END	"PAPPLEND"
+					// Binary state file trailer magic
+#define _PAPPL_STATE_HEADER	16	// Size of binary state file header
+#define _PAPPL_STATE_TRAILER	32	// Size of binary state file trailer
+#define _PAPPL_STATE_VERSION	1	// Binary state file version
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_bin_s		// Binary state buffer
+{
+  ipp_uchar_t	*start,			// Start of buffer
+		*ptr,			// Current position in buffer
+		*end;			// End of buffer
+  bool		error;			// Did an error occur?
+} _pappl_bin_t;
+
+typedef struct _pappl_pool_member_s	// Pool member from a state file
+{
+  int		pool_id,		// Pool printer ID
+		member_id;		// Member printer ID
+} _pappl_pool_member_t;
+
+
 //
 // Local functions...
 //
 
 static size_t	add_time(const char *name, time_t value, size_t num_options, cups_option_t **options);
+static void	bin_add(_pappl_bin_t *bin, const void *data, size_t datalen);
+static void	bin_add_int(_pappl_bin_t *bin, long long value, size_t bytes);
+static void	bin_add_ipp(_pappl_bin_t *bin, ipp_t *ipp);
+static void	bin_add_string(_pappl_bin_t *bin, const char *s);
+static const ipp_uchar_t *bin_get_data(_pappl_bin_t *bin, size_t *datalen);
+static long long bin_get_int(_pappl_bin_t *bin, size_t bytes);
+static const char *bin_get_string(_pappl_bin_t *bin);
+static ssize_t	bin_write_cb(_pappl_bin_t *bin, ipp_uchar_t *data, size_t bytes);
+static bool	load_binary(pappl_system_t *system, cups_file_t *fp, const char *filename);
+static void	load_binary_job(pappl_system_t *system, _pappl_bin_t *bin, pappl_printer_t **printer);
+static bool	load_state(pappl_system_t *system, cups_file_t *fp, const char *filename, off_t end, bool journal);
 static void	parse_contact(char *value, pappl_contact_t *contact);
 static void	parse_media_col(char *value, pappl_media_col_t *media);
 static char	*read_line(cups_file_t *fp, char *line, size_t linesize, char **value, int *linenum);
-static void	write_contact(cups_file_t *fp, pappl_contact_t *contact);
-static void	write_media_col(cups_file_t *fp, const char *name, pappl_media_col_t *media);
-static void	write_options(cups_file_t *fp, const char *name, size_t num_options, cups_option_t *options);
+static void	remove_job(pappl_printer_t *printer, pappl_job_t *job, bool keep_files);
+static void	reset_printer(pappl_printer_t *printer);
+static bool	save_journal(pappl_system_t *system, const char *filename, size_t changes);
+static bool	save_snapshot(pappl_system_t *system, const char *filename);
+static void	sync_directory(pappl_system_t *system, const char *filename);
+static bool	sync_file(pappl_system_t *system, cups_file_t *fp, const char *filename);
+static bool	write_binary_job(cups_file_t *fp, _pappl_bin_t *bin, pappl_system_t *system, pappl_job_t *job);
+static bool	write_contact(cups_file_t *fp, pappl_contact_t *contact);
+static bool	write_job(cups_file_t *fp, pappl_system_t *system, pappl_job_t *job);
+static bool	write_media_col(cups_file_t *fp, const char *name, pappl_media_col_t *media);
+static bool	write_options(cups_file_t *fp, const char *name, size_t num_options, cups_option_t *options);
+static bool	write_printer(cups_file_t *fp, pappl_system_t *system, pappl_printer_t *printer);
+static bool	write_system(cups_file_t *fp, pappl_system_t *system);
 
 
 //
@@ -29,6 +84,12 @@ static void	write_options(cups_file_t *fp, const char *name, size_t num_options,
 // This function loads the previous system state from a file created by the
 // @link papplSystemSaveState@ function.  The system state contains all of the
 // system object values, the list of printers, and the jobs for each printer.
+// Any changes that were saved to the journal file ("filename.journal") are
+// then applied.
+//
+// Both text and binary (`PAPPL_SOPTIONS_BINARY_STATE`) state files are
+// supported.  Binary state files are memory-mapped and the document attributes
+// of each job are only loaded when they are needed.
 //
 // When loading a printer definition, if the printer cannot be created (e.g.,
 // because the driver name is no longer valid) then that printer and all of its
@@ -45,12 +106,13 @@ papplSystemLoadState(
     pappl_system_t *system,		// I - System
     const char     *filename)		// I - File to load
 {
-  size_t		i;		// Looping var
-  cups_file_t		*fp;		// Output file
-  int			linenum;	// Line number
-  char			line[32768],	// Line from file
-			*ptr,		// Pointer into line/value
-			*value;		// Value from line
+  bool			ret;		// Return value
+  cups_file_t		*fp;		// State file
+  char			jfilename[1024],// Journal filename
+			line[32768],	// Line from journal
+			magic[8];	// Binary state file magic
+  off_t			end = 0;	// End of last complete save in journal
+  struct stat		fileinfo;	// File information
 
 
   // Range check input...
@@ -76,233 +138,967 @@ papplSystemLoadState(
   // Read lines from the state file...
   papplLog(system, PAPPL_LOGLEVEL_INFO, "Loading system state from '%s'.", filename);
 
-  linenum = 0;
-  while (read_line(fp, line, sizeof(line), &value, &linenum))
+  if (cupsFileRead(fp, magic, sizeof(magic)) == (ssize_t)sizeof(magic) && !memcmp(magic, _PAPPL_STATE_MAGIC, sizeof(magic)))
   {
-    if (!strcasecmp(line, "DNSSDName"))
-      papplSystemSetDNSSDName(system, value);
-    else if (!strcasecmp(line, "Location"))
-      papplSystemSetLocation(system, value);
-    else if (!strcasecmp(line, "GeoLocation"))
-      papplSystemSetGeoLocation(system, value);
-    else if (!strcasecmp(line, "Organization"))
-      papplSystemSetOrganization(system, value);
-    else if (!strcasecmp(line, "OrganizationalUnit"))
-      papplSystemSetOrganizationalUnit(system, value);
-    else if (!strcasecmp(line, "Contact"))
-    {
-      pappl_contact_t	contact;		// "system-contact" value
+    ret = load_binary(system, fp, filename);
+  }
+  else
+  {
+    cupsFileRewind(fp);
+    ret = load_state(system, fp, filename, /*end*/-1, /*journal*/false);
+  }
 
-      parse_contact(value, &contact);
-      papplSystemSetContact(system, &contact);
-    }
-    else if (!strcasecmp(line, "AdminGroup"))
-      papplSystemSetAdminGroup(system, value);
-    else if (!strcasecmp(line, "DefaultPrintGroup"))
-      papplSystemSetDefaultPrintGroup(system, value);
-    else if (!strcasecmp(line, "Password"))
-      papplSystemSetPassword(system, value);
-    else if (!strcasecmp(line, "DefaultPrinterID") && value)
-      papplSystemSetDefaultPrinterID(system, (int)strtol(value, NULL, 10));
-    else if (!strcasecmp(line, "MaxImageSize") && value)
-    {
-      long	max_size;		// Maximum (uncompressed) size
-      int	max_width,		// Maximum width in columns
-		max_height;		// Maximum height in lines
+  cupsFileClose(fp);
 
-      if (sscanf(value, "%ld%d%d", &max_size, &max_width, &max_height) == 3)
-        papplSystemSetMaxImageSize(system, (size_t)max_size, max_width, max_height);
-    }
-    else if (!strcasecmp(line, "NextPrinterID") && value)
-      papplSystemSetNextPrinterID(system, (int)strtol(value, NULL, 10));
-    else if (!strcasecmp(line, "UUID") && value)
+  if (!ret)
+    return (false);
+
+  // Replay any changes that were saved to the journal.  Only complete saves
+  // (ending with a "Commit" line) are used...
+  snprintf(jfilename, sizeof(jfilename), "%s.journal", filename);
+
+  if ((fp = cupsFileOpen(jfilename, "r")) != NULL)
+  {
+    while (cupsFileGets(fp, line, sizeof(line)))
     {
-      if ((system->uuid = strdup(value)) == NULL)
-      {
-        papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for system UUID.");
-        return (false);
-      }
+      if (!strcmp(line, "Commit"))
+        end = cupsFileTell(fp);
     }
-    else if (!strcasecmp(line, "<Printer") && value)
+
+    if (end > 0)
     {
-      // Read a printer...
-      size_t		num_options;	// Number of options
-      cups_option_t	*options = NULL;// Options
-      const char	*printer_id,	// Printer ID
-			*printer_name,	// Printer name
-			*printer_state,	// Printer state
-			*device_id,	// Device ID
-			*device_uri,	// Device URI
-			*driver_name;	// Driver name
-      pappl_printer_t	*printer;	// Current printer
+      papplLog(system, PAPPL_LOGLEVEL_INFO, "Loading system state changes from '%s'.", jfilename);
 
+      cupsFileRewind(fp);
+      load_state(system, fp, jfilename, end, /*journal*/true);
+    }
 
-      if ((num_options = cupsParseOptions(value, /*end*/NULL, 0, &options)) == 0 || (printer_id = cupsGetOption("id", num_options, options)) == NULL || strtol(printer_id, NULL, 10) <= 0 || (printer_name = cupsGetOption("name", num_options, options)) == NULL || (device_id = cupsGetOption("did", num_options, options)) == NULL || (device_uri = cupsGetOption("uri", num_options, options)) == NULL || (driver_name = cupsGetOption("driver", num_options, options)) == NULL)
-      {
-        papplLog(system, PAPPL_LOGLEVEL_ERROR, "Bad printer definition on line %d of \"%s\".", linenum, filename);
-        break;
-      }
+    cupsFileClose(fp);
+  }
 
-      if ((printer = papplPrinterCreate(system, (int)strtol(printer_id, NULL, 10), printer_name, driver_name, device_id, device_uri)) == NULL)
-      {
-	if (errno == EEXIST)
-	  papplLog(system, PAPPL_LOGLEVEL_ERROR, "Printer '%s' already exists, dropping duplicate printer and job history in state file.", printer_name);
-	else if (errno == EIO)
-	  papplLog(system, PAPPL_LOGLEVEL_ERROR, "Dropping printer '%s' and its job history because the driver ('%s') is no longer supported.", printer_name, driver_name);
-	else
-	  papplLog(system, PAPPL_LOGLEVEL_ERROR, "Dropping printer '%s' and its job history because an error occurred: %s", printer_name, strerror(errno));
-      }
+  // Append future changes to the journal unless it has an incomplete save at
+  // the end, in which case the next save writes a new state file...
+  if (!stat(filename, &fileinfo))
+    system->snapshot_size = (size_t)fileinfo.st_size;
 
-      if ((system->options & PAPPL_SOPTIONS_MULTI_QUEUE) && (printer_state = cupsGetOption("state", num_options, options)) != NULL && (ipp_pstate_t)atoi(printer_state) == IPP_PSTATE_STOPPED)
-        papplPrinterPause(printer);
+  if (stat(jfilename, &fileinfo))
+    system->journal_size = 0;
+  else
+    system->journal_size = (size_t)fileinfo.st_size;
 
-      while (read_line(fp, line, sizeof(line), &value, &linenum))
-      {
-        if (!strcasecmp(line, "</Printer>"))
-          break;
-	else if (!printer)
-	  continue;
-	else if (!strcasecmp(line, "DNSSDName"))
-	  papplPrinterSetDNSSDName(printer, value);
-	else if (!strcasecmp(line, "Location"))
-	  papplPrinterSetLocation(printer, value);
-	else if (!strcasecmp(line, "GeoLocation"))
-	  papplPrinterSetGeoLocation(printer, value);
-	else if (!strcasecmp(line, "Organization"))
-	  papplPrinterSetOrganization(printer, value);
-	else if (!strcasecmp(line, "OrganizationalUnit"))
-	  papplPrinterSetOrganizationalUnit(printer, value);
-	else if (!strcasecmp(line, "Contact"))
-	{
-	  pappl_contact_t	contact;// "printer-contact" value
+  free(system->journal_filename);
 
-	  parse_contact(value, &contact);
-	  papplPrinterSetContact(printer, &contact);
-	}
-	else if (!strcasecmp(line, "HoldNewJobs"))
-	  printer->hold_new_jobs = true;
-	else if (!strcasecmp(line, "PrintGroup"))
-	  papplPrinterSetPrintGroup(printer, value);
-	else if (!strcasecmp(line, "MaxActiveJobs") && value)
-	  papplPrinterSetMaxActiveJobs(printer, (size_t)strtol(value, NULL, 10));
-	else if (!strcasecmp(line, "MaxCompletedJobs") && value)
-	  papplPrinterSetMaxCompletedJobs(printer, (size_t)strtol(value, NULL, 10));
-	else if (!strcasecmp(line, "NextJobId") && value)
-	  papplPrinterSetNextJobID(printer, (int)strtol(value, NULL, 10));
-	else if (!strcasecmp(line, "ImpressionsCompleted") && value)
-	  papplPrinterSetImpressionsCompleted(printer, (int)strtol(value, NULL, 10));
-	else if (!strcasecmp(line, "copies-default") && value)
-	  printer->driver_data.copies_default = atoi(value);
-	else if (!strcasecmp(line, "finishings-default") && value)
-	{
-	  char	*start;			// Start of value
+  if (system->journal_size == (size_t)end)
+    system->journal_filename = strdup(filename);
+  else
+    system->journal_filename = NULL;
 
-	  printer->driver_data.finishings_default = PAPPL_FINISHINGS_NONE;
+  return (true);
+}
 
-          for (ptr = value; ptr && *ptr;)
-          {
-            start = ptr;
-            if ((ptr = strchr(start, ',')) != NULL)
-              *ptr++ = '\0';
 
-            printer->driver_data.finishings_default |= _papplFinishingsValue(start);
-          }
-	}
-	else if (!strcasecmp(line, "identify-actions-default") && value)
-	  printer->driver_data.identify_default = _papplIdentifyActionsValue(value);
-	else if (!strcasecmp(line, "label-mode-configured") && value)
-	  printer->driver_data.mode_configured = _papplLabelModeValue(value);
-	else if (!strcasecmp(line, "label-tear-offset-configured") && value)
-	  printer->driver_data.tear_offset_configured = (int)strtol(value, NULL, 10);
-	else if (!strcasecmp(line, "media-col-default") && value)
-	  parse_media_col(value, &printer->driver_data.media_default);
-	else if (!strncasecmp(line, "media-col-ready", 15) && value)
-	{
-	  long val;			// Source index
+//
+// 'papplSystemSaveState()' - Save the current system state.
+//
+// This function saves the current system state to a file.  It is typically
+// used with the @link papplSystemSetSaveCallback@ function to periodically
+// save the state:
+//
+// ```
+// |papplSystemSetSaveCallback(system, (pappl_save_cb_t)papplSystemSaveState,
+// |    (void *)filename);
+// ```
+//
+// While the system is running, only the printers and jobs that have changed
+// since the last save are appended to a journal file ("filename.journal").
+// The journal is replaced by a new state file when it gets too large and when
+// the system is shut down.  The state file is saved in binary format when the
+// `PAPPL_SOPTIONS_BINARY_STATE` system option is set.
+//
 
-	  if ((val = strtol(line + 15, NULL, 10)) >= 0 && val < PAPPL_MAX_SOURCE)
-	    parse_media_col(value, printer->driver_data.media_ready + val);
-	}
-	else if (!strcasecmp(line, "orientation-requested-default") && value)
-	  printer->driver_data.orient_default = (ipp_orient_t)ippEnumValue("orientation-requested", value);
-	else if (!strcasecmp(line, "output-bin-default") && value)
-	{
-	  for (i = 0; i < printer->driver_data.num_bin; i ++)
-	  {
-	    if (!strcmp(value, printer->driver_data.bin[i]))
-	    {
-	      printer->driver_data.bin_default = i;
-	      break;
-	    }
-	  }
-	}
-	else if (!strcasecmp(line, "print-color-mode-default") && value)
-	  printer->driver_data.color_default = _papplColorModeValue(value);
-	else if (!strcasecmp(line, "print-content-optimize-default") && value)
-	  printer->driver_data.content_default = _papplContentValue(value);
-	else if (!strcasecmp(line, "print-darkness-default") && value)
-	  printer->driver_data.darkness_default = (int)strtol(value, NULL, 10);
-	else if (!strcasecmp(line, "print-quality-default") && value)
-	  printer->driver_data.quality_default = (ipp_quality_t)ippEnumValue("print-quality", value);
-	else if (!strcasecmp(line, "print-scaling-default") && value)
-	  printer->driver_data.scaling_default = _papplScalingValue(value);
-	else if (!strcasecmp(line, "print-speed-default") && value)
-	  printer->driver_data.speed_default = (int)strtol(value, NULL, 10);
-	else if (!strcasecmp(line, "printer-darkness-configured") && value)
-	  printer->driver_data.darkness_configured = (int)strtol(value, NULL, 10);
-	else if (!strcasecmp(line, "printer-resolution-default") && value)
-	  sscanf(value, "%dx%ddpi", &printer->driver_data.x_default, &printer->driver_data.y_default);
-	else if (!strcasecmp(line, "sides-default") && value)
-	  printer->driver_data.sides_default = _papplSidesValue(value);
-        else if ((ptr = strstr(line, "-default")) != NULL)
-        {
-          char	defname[128],		// xxx-default name
-	      	supname[128];		// xxx-supported name
-	  ipp_attribute_t *attr;	// Attribute
+bool					// O - `true` on success, `false` on failure
+papplSystemSaveState(
+    pappl_system_t *system,		// I - System
+    const char     *filename)		// I - File to save
+{
+  bool		ret,			// Return value
+		snapshot;		// Write a full state file?
+  size_t	changes,		// Current change number
+		last_changes;		// Change number of last save
 
-          *ptr = '\0';
 
-          snprintf(defname, sizeof(defname), "%s-default", line);
-          snprintf(supname, sizeof(supname), "%s-supported", line);
+  if (!system || !filename)
+    return (false);
 
-          if (!value)
-            value = ptr;
+  // Changes to system values, new or deleted printers, the first save, and a
+  // journal that has grown larger than the state file all need a full state
+  // file.  Everything else just appends the changed printers and jobs to the
+  // journal...
+  cupsMutexLock(&system->config_mutex);
 
-	  ippDeleteAttribute(printer->driver_attrs, ippFindAttribute(printer->driver_attrs, defname, IPP_TAG_ZERO));
+  changes      = system->config_changes;
+  last_changes = system->journal_changes;
+  snapshot     = !system->is_running || !system->journal_filename || strcmp(system->journal_filename, filename) || system->state_changes > last_changes || (system->journal_size >= _PAPPL_JOURNAL_MIN && system->journal_size >= system->snapshot_size);
 
-          if ((attr = ippFindAttribute(printer->driver_attrs, supname, IPP_TAG_ZERO)) != NULL)
-          {
-            switch (ippGetValueTag(attr))
-            {
-              case IPP_TAG_BOOLEAN :
-                  ippAddBoolean(printer->driver_attrs, IPP_TAG_PRINTER, defname, !strcmp(value, "true"));
-                  break;
+  cupsMutexUnlock(&system->config_mutex);
 
-              case IPP_TAG_INTEGER :
-              case IPP_TAG_RANGE :
-                  ippAddInteger(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, defname, (int)strtol(value, NULL, 10));
-                  break;
+  if (snapshot)
+    ret = save_snapshot(system, filename);
+  else
+    ret = save_journal(system, filename, last_changes);
 
-              case IPP_TAG_KEYWORD :
-		  ippAddString(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, defname, NULL, value);
-                  break;
+  cupsMutexLock(&system->config_mutex);
 
-              default :
-                  break;
-            }
-	  }
-          else
-          {
-            ippAddString(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_TEXT, defname, NULL, value);
-          }
-        }
-	else if (!strcasecmp(line, "Job") && value)
-	{
-	  // Read printer job
-	  pappl_job_t	*job;		// Current Job
-	  struct stat	jobbuf;		// Job file buffer
-	  const char	*job_name,	// Job name
-			*job_id,	// Job ID
+  if (ret)
+  {
+    system->journal_changes = changes;
+  }
+  else
+  {
+    // Write a full state file next time...
+    free(system->journal_filename);
+    system->journal_filename = NULL;
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  return (ret);
+}
+
+
+//
+// 'add_time()' - Add a time_t value as an option.
+//
+
+static size_t			// O  - New number of options
+add_time(const char    *name,		// I  - Name
+	 time_t        value,		// I  - Value
+	 size_t    num_options,	// I  - Number of options
+	 cups_option_t **options)	// IO - Options
+{
+  char	buffer[100];			// Value string buffer
+
+
+  // Format the number as a long integer...
+  snprintf(buffer, sizeof(buffer), "%ld", (long)value);
+
+  // Add the option with the string...
+  return (cupsAddOption(name, buffer, num_options, options));
+}
+
+
+//
+// 'bin_add()' - Add data to a binary state buffer.
+//
+
+static void
+bin_add(_pappl_bin_t *bin,		// I - Buffer
+        const void   *data,		// I - Data
+        size_t       datalen)		// I - Length of data
+{
+  if (bin->error)
+    return;
+
+  if ((size_t)(bin->end - bin->ptr) < datalen)
+  {
+    // Grow the buffer...
+    size_t	used = (size_t)(bin->ptr - bin->start),
+					// Bytes used
+		alloc = 2 * (size_t)(bin->end - bin->start);
+					// New size
+    ipp_uchar_t	*start;			// New buffer
+
+    if (alloc < (used + datalen))
+      alloc = used + datalen + 4096;
+
+    if ((start = realloc(bin->start, alloc)) == NULL)
+    {
+      bin->error = true;
+      return;
+    }
+
+    bin->start = start;
+    bin->ptr   = start + used;
+    bin->end   = start + alloc;
+  }
+
+  memcpy(bin->ptr, data, datalen);
+  bin->ptr += datalen;
+}
+
+
+//
+// 'bin_add_int()' - Add a little-endian integer to a binary state buffer.
+//
+
+static void
+bin_add_int(_pappl_bin_t *bin,		// I - Buffer
+            long long    value,		// I - Value
+            size_t       bytes)		// I - Size of integer (4 or 8)
+{
+  unsigned long long	uvalue = (unsigned long long)value;
+					// Unsigned value
+  ipp_uchar_t		buffer[8];	// Integer buffer
+  size_t		i;		// Looping var
+
+
+  for (i = 0; i < bytes; i ++, uvalue >>= 8)
+    buffer[i] = (ipp_uchar_t)(uvalue & 255);
+
+  bin_add(bin, buffer, bytes);
+}
+
+
+//
+// 'bin_add_ipp()' - Add an encoded IPP message to a binary state buffer.
+//
+
+static void
+bin_add_ipp(_pappl_bin_t *bin,		// I - Buffer
+            ipp_t        *ipp)		// I - IPP message or `NULL` for none
+{
+  size_t	offset,			// Offset of length
+		length;			// Length of message
+  ipp_uchar_t	*ptr;			// Current position in buffer
+
+
+  offset = (size_t)(bin->ptr - bin->start);
+
+  bin_add_int(bin, 0, 4);
+
+  if (!ipp || bin->error)
+    return;
+
+  ippSetState(ipp, IPP_STATE_IDLE);
+  if (ippWriteIO(bin, (ipp_io_cb_t)bin_write_cb, /*blocking*/true, /*parent*/NULL, ipp) != IPP_STATE_DATA)
+    bin->error = true;
+
+  if (bin->error || (length = (size_t)(bin->ptr - bin->start) - offset - 4) > 0x7fffffff)
+  {
+    bin->error = true;
+    return;
+  }
+
+  // Update the length...
+  ptr      = bin->ptr;
+  bin->ptr = bin->start + offset;
+  bin_add_int(bin, (long long)length, 4);
+  bin->ptr = ptr;
+}
+
+
+//
+// 'bin_add_string()' - Add a nul-terminated string to a binary state buffer.
+//
+
+static void
+bin_add_string(_pappl_bin_t *bin,	// I - Buffer
+               const char   *s)		// I - String or `NULL` for none
+{
+  size_t	length;			// Length of string including nul
+
+
+  if (!s)
+    s = "";
+
+  length = strlen(s) + 1;
+
+  bin_add_int(bin, (long long)length, 4);
+  bin_add(bin, s, length);
+}
+
+
+//
+// 'bin_get_data()' - Get length-prefixed data from a binary state buffer.
+//
+
+static const ipp_uchar_t *		// O - Data or `NULL` for none
+bin_get_data(_pappl_bin_t *bin,		// I - Buffer
+             size_t       *datalen)	// O - Length of data
+{
+  const ipp_uchar_t	*data;		// Data
+
+
+  *datalen = (size_t)bin_get_int(bin, 4);
+
+  if (bin->error || *datalen > (size_t)(bin->end - bin->ptr))
+  {
+    bin->error = true;
+    *datalen   = 0;
+    return (NULL);
+  }
+  else if (*datalen == 0)
+  {
+    return (NULL);
+  }
+
+  data     = bin->ptr;
+  bin->ptr += *datalen;
+
+  return (data);
+}
+
+
+//
+// 'bin_get_int()' - Get a little-endian integer from a binary state buffer.
+//
+
+static long long			// O - Value
+bin_get_int(_pappl_bin_t *bin,		// I - Buffer
+            size_t       bytes)		// I - Size of integer (4 or 8)
+{
+  unsigned long long	uvalue = 0;	// Unsigned value
+  size_t		i;		// Looping var
+
+
+  if (bin->error || (size_t)(bin->end - bin->ptr) < bytes)
+  {
+    bin->error = true;
+    return (0);
+  }
+
+  for (i = bytes; i > 0; i --)
+    uvalue = (uvalue << 8) | bin->ptr[i - 1];
+
+  bin->ptr += bytes;
+
+  return ((long long)uvalue);
+}
+
+
+//
+// 'bin_get_string()' - Get a nul-terminated string from a binary state buffer.
+//
+
+static const char *			// O - String
+bin_get_string(_pappl_bin_t *bin)	// I - Buffer
+{
+  const ipp_uchar_t	*data;		// String data
+  size_t		datalen;	// Length of string data
+
+
+  if ((data = bin_get_data(bin, &datalen)) == NULL || data[datalen - 1])
+  {
+    bin->error = true;
+    return ("");
+  }
+
+  return ((const char *)data);
+}
+
+
+//
+// 'bin_write_cb()' - Write IPP message data to a binary state buffer.
+//
+
+static ssize_t				// O - Number of bytes written or `-1` on error
+bin_write_cb(_pappl_bin_t *bin,		// I - Buffer
+             ipp_uchar_t  *data,	// I - Data
+             size_t       bytes)	// I - Number of bytes
+{
+  bin_add(bin, data, bytes);
+
+  return (bin->error ? -1 : (ssize_t)bytes);
+}
+
+
+//
+// 'load_binary()' - Load a binary state file.
+//
+// Binary state files start with a 16 byte header ("PAPPLBIN" followed by the
+// version number and a reserved 32-bit value), followed by the system and
+// printer values in text form, the job records, and a 32 byte trailer (the
+// lengths of the text section, number of jobs, length of the job records, and
+// "PAPPLEND").  All integers are stored in little-endian byte order.
+//
+// Each job record starts with its length so that fields can be added to the
+// end of a record without changing the version number.
+//
+
+static bool				// O - `true` on success, `false` on failure
+load_binary(pappl_system_t *system,	// I - System
+            cups_file_t    *fp,		// I - State file
+            const char     *filename)	// I - Filename
+{
+  int			fd;		// File descriptor
+  struct stat		fileinfo;	// File information
+  ipp_uchar_t		*data;		// State file data
+  size_t		datalen;	// Length of state file data
+  _pappl_bin_t		bin;		// Binary state buffer
+  long long		i,		// Looping var
+			version,	// File version
+			text_length,	// Length of text section
+			num_jobs,	// Number of job records
+			jobs_length;	// Length of job records
+  pappl_printer_t	*printer = NULL;// Current printer
+
+
+  if (system->snapshot_data)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Binary system state has already been loaded.");
+    return (false);
+  }
+
+  // Map the state file into memory...
+  if ((fd = open(filename, O_RDONLY | O_BINARY)) < 0)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to open system state file '%s': %s", filename, strerror(errno));
+    return (false);
+  }
+
+  if (fstat(fd, &fileinfo) || fileinfo.st_size < (_PAPPL_STATE_HEADER + _PAPPL_STATE_TRAILER))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Bad binary system state file '%s'.", filename);
+    close(fd);
+    return (false);
+  }
+
+  datalen = (size_t)fileinfo.st_size;
+
+#if _WIN32
+  // No mmap on Windows, read the whole file...
+  if ((data = malloc(datalen)) != NULL)
+  {
+    size_t	total;			// Total bytes read
+    ssize_t	bytes;			// Bytes read
+
+    for (total = 0; total < datalen; total += (size_t)bytes)
+    {
+      if ((bytes = read(fd, data + total, (unsigned)(datalen - total))) <= 0)
+      {
+        free(data);
+        data = NULL;
+        break;
+      }
+    }
+  }
+#else
+  if ((data = mmap(NULL, datalen, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED)
+    data = NULL;
+#endif // _WIN32
+
+  close(fd);
+
+  if (!data)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to load system state file '%s': %s", filename, strerror(errno));
+    return (false);
+  }
+
+  // The mapping is kept until the system is deleted since jobs reference the
+  // document attributes and formats in it...
+  system->snapshot_data    = data;
+  system->snapshot_datalen = datalen;
+
+  // Validate the header and trailer...
+  bin.start = data;
+  bin.ptr   = data + 8;
+  bin.end   = data + datalen;
+  bin.error = false;
+
+  version = bin_get_int(&bin, 4);
+
+  bin.ptr = data + datalen - _PAPPL_STATE_TRAILER;
+
+  text_length = bin_get_int(&bin, 8);
+  num_jobs    = bin_get_int(&bin, 8);
+  jobs_length = bin_get_int(&bin, 8);
+
+  if (version != _PAPPL_STATE_VERSION || memcmp(bin.ptr, _PAPPL_STATE_END, 8) || text_length < 0 || jobs_length < 0 || (size_t)text_length > datalen || (size_t)jobs_length > datalen || (_PAPPL_STATE_HEADER + (size_t)text_length + (size_t)jobs_length + _PAPPL_STATE_TRAILER) != datalen)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unsupported or damaged binary system state file '%s'.", filename);
+    return (false);
+  }
+
+  // Load the system and printer values...
+  if (cupsFileSeek(fp, _PAPPL_STATE_HEADER) != _PAPPL_STATE_HEADER || !load_state(system, fp, filename, _PAPPL_STATE_HEADER + (off_t)text_length, /*journal*/false))
+    return (false);
+
+  // Then the jobs...
+  bin.start = data + _PAPPL_STATE_HEADER + text_length;
+  bin.ptr   = bin.start;
+  bin.end   = bin.start + jobs_length;
+
+  for (i = 0; i < num_jobs && !bin.error; i ++)
+    load_binary_job(system, &bin, &printer);
+
+  if (bin.error)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Bad job record %lld in binary system state file '%s'.", i, filename);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'load_binary_job()' - Load a job record from a binary state file.
+//
+
+static void
+load_binary_job(
+    pappl_system_t  *system,		// I  - System
+    _pappl_bin_t    *bin,		// I  - Binary state buffer
+    pappl_printer_t **printer)		// IO - Current printer
+{
+  ipp_uchar_t		*end;		// End of buffer
+  size_t		reclen;		// Length of record
+  int			printer_id,	// Printer ID
+			job_id,		// Job ID
+			priority,	// Job priority
+			impressions,	// Number of impressions
+			impcompleted,	// Number of completed impressions
+			num_documents,	// Number of documents
+			doc_number;	// Current document number
+  ipp_jstate_t		state;		// Job state
+  pappl_jreason_t	state_reasons;	// Job state reasons
+  time_t		created,	// Creation time
+			processing,	// Processing time
+			completed;	// Completion time
+  const char		*name,		// Job name
+			*username;	// Job username
+  pappl_job_t		*job;		// Job
+  _pappl_doc_t		*doc;		// Current document
+  const ipp_uchar_t	*job_attrs;	// Encoded job attributes
+  size_t		job_attrslen;	// Length of encoded job attributes
+  struct stat		fileinfo;	// Document file information
+
+
+  // Limit reads to the current record...
+  reclen = (size_t)bin_get_int(bin, 4);
+
+  if (bin->error || reclen > (size_t)(bin->end - bin->ptr))
+  {
+    bin->error = true;
+    return;
+  }
+
+  end      = bin->end;
+  bin->end = bin->ptr + reclen;
+
+  printer_id    = (int)bin_get_int(bin, 4);
+  job_id        = (int)bin_get_int(bin, 4);
+  state         = (ipp_jstate_t)bin_get_int(bin, 4);
+  state_reasons = (pappl_jreason_t)bin_get_int(bin, 4);
+  priority      = (int)bin_get_int(bin, 4);
+  impressions   = (int)bin_get_int(bin, 4);
+  impcompleted  = (int)bin_get_int(bin, 4);
+  created       = (time_t)bin_get_int(bin, 8);
+  processing    = (time_t)bin_get_int(bin, 8);
+  completed     = (time_t)bin_get_int(bin, 8);
+  name          = bin_get_string(bin);
+  username      = bin_get_string(bin);
+  num_documents = (int)bin_get_int(bin, 4);
+
+  if (bin->error || job_id <= 0 || num_documents < 0 || num_documents > _PAPPL_MAX_DOCUMENTS)
+  {
+    bin->error = true;
+    goto done;
+  }
+
+  // Find the printer, skipping jobs for printers that were dropped...
+  if (!*printer || (*printer)->printer_id != printer_id)
+    *printer = papplSystemFindPrinter(system, /*resource*/NULL, printer_id, /*device_uri*/NULL);
+
+  if (!*printer)
+    goto done;
+
+  if ((job = _papplJobCreate(*printer, job_id, username, name, NULL)) == NULL)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Error creating job %s for printer %s", name, (*printer)->name);
+    goto done;
+  }
+
+  // Load the documents, leaving the document attributes in the state file
+  // until they are needed...
+  for (doc_number = 1; doc_number <= num_documents && !bin->error; doc_number ++)
+  {
+    const char	*doc_filename,		// Document filename
+		*doc_format;		// Document format
+
+    if ((doc = _papplJobAddDocumentNoLock(job)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for document %d.", doc_number);
+      break;
+    }
+
+    doc_filename  = bin_get_string(bin);
+    doc_format    = bin_get_string(bin);
+    doc->state         = (ipp_dstate_t)bin_get_int(bin, 4);
+    doc->state_reasons = (pappl_jreason_t)bin_get_int(bin, 4);
+    doc->created       = (time_t)bin_get_int(bin, 8);
+    doc->processing    = (time_t)bin_get_int(bin, 8);
+    doc->completed     = (time_t)bin_get_int(bin, 8);
+    doc->k_octets      = (off_t)bin_get_int(bin, 8);
+    doc->attrs_data    = bin_get_data(bin, &doc->attrs_datalen);
+
+    if (bin->error || !*doc_filename)
+      break;
+
+    if ((doc->filename = strdup(doc_filename)) == NULL)
+    {
+      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for document %d.", doc_number);
+      break;
+    }
+
+    _papplJobRetainSharedFile(job, doc->filename);
+
+    doc->format   = *doc_format ? _papplStrAlloc(doc_format) : NULL;
+    job->k_octets += doc->k_octets;
+
+    job->num_documents ++;
+  }
+
+  job_attrs = bin_get_data(bin, &job_attrslen);
+
+  job->state         = state;
+  job->state_reasons = state_reasons;
+  job->priority      = priority;
+  job->impressions   = impressions;
+  job->impcompleted  = impcompleted;
+  job->created       = created;
+  job->processing    = processing;
+  job->completed     = completed;
+
+  if (job->num_documents == 0 && job->state < IPP_JSTATE_CANCELED)
+    job->state = IPP_JSTATE_ABORTED;
+
+  if (job->state < IPP_JSTATE_STOPPED)
+  {
+    // Active jobs need their attributes...
+    if (job_attrs)
+      _papplIPPReadBuffer(job->attrs, job_attrs, job_attrslen);
+
+    if (!job->documents[0].filename || stat(job->documents[0].filename, &fileinfo))
+    {
+      // If file removed, then set job state to aborted...
+      job->state = IPP_JSTATE_ABORTED;
+      cupsArrayAdd((*printer)->completed_jobs, job);
+    }
+    else
+    {
+      // Add the job to printer active jobs array and scheduling queue...
+      cupsArrayAdd((*printer)->active_jobs, job);
+      _papplPrinterQueueJobNoLock(*printer, job);
+    }
+  }
+  else
+  {
+    // Add job to printer completed jobs...
+    cupsArrayAdd((*printer)->completed_jobs, job);
+  }
+
+  done:
+
+  // Skip any remaining fields in the record...
+  bin->ptr = bin->end;
+  bin->end = end;
+}
+
+
+//
+// 'load_state()' - Load system state from a state file or journal.
+//
+// When loading from a journal, printer and job records update any existing
+// printers and jobs and only lines before the "end" offset are used.
+//
+
+static bool				// O - `true` on success, `false` on failure
+load_state(pappl_system_t *system,	// I - System
+           cups_file_t    *fp,		// I - File
+           const char     *filename,	// I - Filename
+           off_t          end,		// I - End offset or `-1` for end of file
+           bool           journal)	// I - Loading a journal?
+{
+  size_t		i;		// Looping var
+  int			linenum;	// Line number
+  _pappl_pool_member_t	*pool_members = NULL;
+					// Pool members to add
+  size_t		num_pool_members = 0,
+					// Number of pool members
+			alloc_pool_members = 0;
+					// Allocated pool members
+  char			line[32768],	// Line from file
+			*ptr,		// Pointer into line/value
+			*value;		// Value from line
+
+
+  linenum = 0;
+  while ((end < 0 || cupsFileTell(fp) < end) && read_line(fp, line, sizeof(line), &value, &linenum))
+  {
+    if (!strcasecmp(line, "Commit"))
+      continue;
+    else if (!strcasecmp(line, "DNSSDName"))
+      papplSystemSetDNSSDName(system, value);
+    else if (!strcasecmp(line, "Location"))
+      papplSystemSetLocation(system, value);
+    else if (!strcasecmp(line, "GeoLocation"))
+      papplSystemSetGeoLocation(system, value);
+    else if (!strcasecmp(line, "Organization"))
+      papplSystemSetOrganization(system, value);
+    else if (!strcasecmp(line, "OrganizationalUnit"))
+      papplSystemSetOrganizationalUnit(system, value);
+    else if (!strcasecmp(line, "Contact"))
+    {
+      pappl_contact_t	contact;		// "system-contact" value
+
+      parse_contact(value, &contact);
+      papplSystemSetContact(system, &contact);
+    }
+    else if (!strcasecmp(line, "AdminGroup"))
+      papplSystemSetAdminGroup(system, value);
+    else if (!strcasecmp(line, "DefaultPrintGroup"))
+      papplSystemSetDefaultPrintGroup(system, value);
+    else if (!strcasecmp(line, "Password"))
+      papplSystemSetPassword(system, value);
+    else if (!strcasecmp(line, "DefaultPrinterID") && value)
+      papplSystemSetDefaultPrinterID(system, (int)strtol(value, NULL, 10));
+    else if (!strcasecmp(line, "MaxImageMemory") && value)
+      papplSystemSetMaxImageMemory(system, (size_t)strtol(value, NULL, 10));
+    else if (!strcasecmp(line, "MaxImageSize") && value)
+    {
+      long	max_size;		// Maximum (uncompressed) size
+      int	max_width,		// Maximum width in columns
+		max_height;		// Maximum height in lines
+
+      if (sscanf(value, "%ld%d%d", &max_size, &max_width, &max_height) == 3)
+        papplSystemSetMaxImageSize(system, (size_t)max_size, max_width, max_height);
+    }
+    else if (!strcasecmp(line, "MaxImageThreads") && value)
+      papplSystemSetMaxImageThreads(system, (size_t)strtol(value, NULL, 10));
+    else if (!strcasecmp(line, "NextPrinterID") && value)
+      papplSystemSetNextPrinterID(system, (int)strtol(value, NULL, 10));
+    else if (!strcasecmp(line, "UUID") && value)
+    {
+      if ((system->uuid = strdup(value)) == NULL)
+      {
+        papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for system UUID.");
+        free(pool_members);
+        return (false);
+      }
+    }
+    else if (!strcasecmp(line, "<Printer") && value)
+    {
+      // Read a printer...
+      size_t		num_options;	// Number of options
+      cups_option_t	*options = NULL;// Options
+      const char	*printer_id,	// Printer ID
+			*printer_name,	// Printer name
+			*printer_state,	// Printer state
+			*device_id,	// Device ID
+			*device_uri,	// Device URI
+			*driver_name;	// Driver name
+      pappl_printer_t	*printer;	// Current printer
+
+
+      if ((num_options = cupsParseOptions(value, /*end*/NULL, 0, &options)) == 0 || (printer_id = cupsGetOption("id", num_options, options)) == NULL || strtol(printer_id, NULL, 10) <= 0 || (printer_name = cupsGetOption("name", num_options, options)) == NULL || (device_id = cupsGetOption("did", num_options, options)) == NULL || (device_uri = cupsGetOption("uri", num_options, options)) == NULL || (driver_name = cupsGetOption("driver", num_options, options)) == NULL)
+      {
+        papplLog(system, PAPPL_LOGLEVEL_ERROR, "Bad printer definition on line %d of \"%s\".", linenum, filename);
+        break;
+      }
+
+      if (journal && (printer = papplSystemFindPrinter(system, /*resource*/NULL, (int)strtol(printer_id, NULL, 10), /*device_uri*/NULL)) != NULL)
+      {
+        // Update an existing printer, replacing any pool members from an
+        // earlier record...
+        reset_printer(printer);
+
+        for (i = num_pool_members; i > 0; i --)
+        {
+          if (pool_members[i - 1].pool_id == printer->printer_id)
+            pool_members[i - 1] = pool_members[-- num_pool_members];
+        }
+      }
+      else if ((printer = papplPrinterCreate(system, (int)strtol(printer_id, NULL, 10), printer_name, driver_name, device_id, device_uri)) == NULL)
+      {
+	if (errno == EEXIST)
+	  papplLog(system, PAPPL_LOGLEVEL_ERROR, "Printer '%s' already exists, dropping duplicate printer and job history in state file.", printer_name);
+	else if (errno == EIO)
+	  papplLog(system, PAPPL_LOGLEVEL_ERROR, "Dropping printer '%s' and its job history because the driver ('%s') is no longer supported.", printer_name, driver_name);
+	else
+	  papplLog(system, PAPPL_LOGLEVEL_ERROR, "Dropping printer '%s' and its job history because an error occurred: %s", printer_name, strerror(errno));
+      }
+
+      if ((system->options & PAPPL_SOPTIONS_MULTI_QUEUE) && (printer_state = cupsGetOption("state", num_options, options)) != NULL)
+      {
+        if ((ipp_pstate_t)atoi(printer_state) == IPP_PSTATE_STOPPED)
+          papplPrinterPause(printer);
+        else if (printer && printer->state == IPP_PSTATE_STOPPED)
+          printer->state = IPP_PSTATE_IDLE;
+      }
+
+      while (read_line(fp, line, sizeof(line), &value, &linenum))
+      {
+        if (!strcasecmp(line, "</Printer>"))
+          break;
+	else if (!printer)
+	  continue;
+	else if (!strcasecmp(line, "DNSSDName"))
+	  papplPrinterSetDNSSDName(printer, value);
+	else if (!strcasecmp(line, "Location"))
+	  papplPrinterSetLocation(printer, value);
+	else if (!strcasecmp(line, "GeoLocation"))
+	  papplPrinterSetGeoLocation(printer, value);
+	else if (!strcasecmp(line, "Organization"))
+	  papplPrinterSetOrganization(printer, value);
+	else if (!strcasecmp(line, "OrganizationalUnit"))
+	  papplPrinterSetOrganizationalUnit(printer, value);
+	else if (!strcasecmp(line, "Contact"))
+	{
+	  pappl_contact_t	contact;// "printer-contact" value
+
+	  parse_contact(value, &contact);
+	  papplPrinterSetContact(printer, &contact);
+	}
+	else if (!strcasecmp(line, "HoldNewJobs"))
+	  printer->hold_new_jobs = true;
+	else if (!strcasecmp(line, "PrintGroup"))
+	  papplPrinterSetPrintGroup(printer, value);
+	else if (!strcasecmp(line, "MaxActiveJobs") && value)
+	  papplPrinterSetMaxActiveJobs(printer, (size_t)strtol(value, NULL, 10));
+	else if (!strcasecmp(line, "MaxCompletedJobs") && value)
+	  papplPrinterSetMaxCompletedJobs(printer, (size_t)strtol(value, NULL, 10));
+	else if (!strcasecmp(line, "MaxResidentJobs") && value)
+	  papplPrinterSetMaxResidentJobs(printer, (size_t)strtol(value, NULL, 10));
+	else if (!strcasecmp(line, "NextJobId") && value)
+	  papplPrinterSetNextJobID(printer, (int)strtol(value, NULL, 10));
+	else if (!strcasecmp(line, "ImpressionsCompleted") && value)
+	  papplPrinterSetImpressionsCompleted(printer, (int)strtol(value, NULL, 10));
+	else if (!strcasecmp(line, "PoolMember") && value)
+	{
+	  // Members are added once all of the printers are loaded...
+	  if (num_pool_members >= alloc_pool_members)
+	  {
+	    _pappl_pool_member_t *temp;	// New pool members
+
+	    if ((temp = realloc(pool_members, (alloc_pool_members + 16) * sizeof(_pappl_pool_member_t))) == NULL)
+	    {
+	      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for pool member on line %d of \"%s\".", linenum, filename);
+	      continue;
+	    }
+
+	    pool_members       = temp;
+	    alloc_pool_members += 16;
+	  }
+
+	  pool_members[num_pool_members].pool_id   = printer->printer_id;
+	  pool_members[num_pool_members].member_id = (int)strtol(value, NULL, 10);
+	  num_pool_members ++;
+	}
+	else if (!strcasecmp(line, "copies-default") && value)
+	  printer->driver_data.copies_default = atoi(value);
+	else if (!strcasecmp(line, "finishings-default") && value)
+	{
+	  char	*start;			// Start of value
+
+	  printer->driver_data.finishings_default = PAPPL_FINISHINGS_NONE;
+
+          for (ptr = value; ptr && *ptr;)
+          {
+            start = ptr;
+            if ((ptr = strchr(start, ',')) != NULL)
+              *ptr++ = '\0';
+
+            printer->driver_data.finishings_default |= _papplFinishingsValue(start);
+          }
+	}
+	else if (!strcasecmp(line, "identify-actions-default") && value)
+	  printer->driver_data.identify_default = _papplIdentifyActionsValue(value);
+	else if (!strcasecmp(line, "label-mode-configured") && value)
+	  printer->driver_data.mode_configured = _papplLabelModeValue(value);
+	else if (!strcasecmp(line, "label-tear-offset-configured") && value)
+	  printer->driver_data.tear_offset_configured = (int)strtol(value, NULL, 10);
+	else if (!strcasecmp(line, "media-col-default") && value)
+	  parse_media_col(value, &printer->driver_data.media_default);
+	else if (!strncasecmp(line, "media-col-ready", 15) && value)
+	{
+	  long val;			// Source index
+
+	  if ((val = strtol(line + 15, NULL, 10)) >= 0 && val < PAPPL_MAX_SOURCE)
+	    parse_media_col(value, printer->driver_data.media_ready + val);
+	}
+	else if (!strcasecmp(line, "orientation-requested-default") && value)
+	  printer->driver_data.orient_default = (ipp_orient_t)ippEnumValue("orientation-requested", value);
+	else if (!strcasecmp(line, "output-bin-default") && value)
+	{
+	  for (i = 0; i < printer->driver_data.num_bin; i ++)
+	  {
+	    if (!strcmp(value, printer->driver_data.bin[i]))
+	    {
+	      printer->driver_data.bin_default = i;
+	      break;
+	    }
+	  }
+	}
+	else if (!strcasecmp(line, "print-color-mode-default") && value)
+	  printer->driver_data.color_default = _papplColorModeValue(value);
+	else if (!strcasecmp(line, "print-content-optimize-default") && value)
+	  printer->driver_data.content_default = _papplContentValue(value);
+	else if (!strcasecmp(line, "print-darkness-default") && value)
+	  printer->driver_data.darkness_default = (int)strtol(value, NULL, 10);
+	else if (!strcasecmp(line, "print-quality-default") && value)
+	  printer->driver_data.quality_default = (ipp_quality_t)ippEnumValue("print-quality", value);
+	else if (!strcasecmp(line, "print-scaling-default") && value)
+	  printer->driver_data.scaling_default = _papplScalingValue(value);
+	else if (!strcasecmp(line, "print-speed-default") && value)
+	  printer->driver_data.speed_default = (int)strtol(value, NULL, 10);
+	else if (!strcasecmp(line, "printer-darkness-configured") && value)
+	  printer->driver_data.darkness_configured = (int)strtol(value, NULL, 10);
+	else if (!strcasecmp(line, "printer-resolution-default") && value)
+	  sscanf(value, "%dx%ddpi", &printer->driver_data.x_default, &printer->driver_data.y_default);
+	else if (!strcasecmp(line, "sides-default") && value)
+	  printer->driver_data.sides_default = _papplSidesValue(value);
+        else if ((ptr = strstr(line, "-default")) != NULL)
+        {
+          char	defname[128],		// xxx-default name
+	      	supname[128];		// xxx-supported name
+	  ipp_attribute_t *attr;	// Attribute
+
+          *ptr = '\0';
+
+          snprintf(defname, sizeof(defname), "%s-default", line);
+          snprintf(supname, sizeof(supname), "%s-supported", line);
+
+          if (!value)
+            value = ptr;
+
+	  ippDeleteAttribute(printer->driver_attrs, ippFindAttribute(printer->driver_attrs, defname, IPP_TAG_ZERO));
+
+          if ((attr = ippFindAttribute(printer->driver_attrs, supname, IPP_TAG_ZERO)) != NULL)
+          {
+            switch (ippGetValueTag(attr))
+            {
+              case IPP_TAG_BOOLEAN :
+                  ippAddBoolean(printer->driver_attrs, IPP_TAG_PRINTER, defname, !strcmp(value, "true"));
+                  break;
+
+              case IPP_TAG_INTEGER :
+              case IPP_TAG_RANGE :
+                  ippAddInteger(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_INTEGER, defname, (int)strtol(value, NULL, 10));
+                  break;
+
+              case IPP_TAG_KEYWORD :
+		  ippAddString(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_KEYWORD, defname, NULL, value);
+                  break;
+
+              default :
+                  break;
+            }
+	  }
+          else
+          {
+            ippAddString(printer->driver_attrs, IPP_TAG_PRINTER, IPP_TAG_TEXT, defname, NULL, value);
+          }
+        }
+	else if (!strcasecmp(line, "Job") && value)
+	{
+	  // Read printer job
+	  pappl_job_t	*job;		// Current Job
+	  ipp_attribute_t *attr;	// Job attribute
+	  struct stat	jobbuf;		// Job file buffer
+	  const char	*job_name,	// Job name
+			*job_id,	// Job ID
 			*job_username,	// Job username
 			*job_value;	// Job option value
 	  int		doc_number;	// Current document number
@@ -310,213 +1106,572 @@ papplSystemLoadState(
 	  int		doc_attr_fd;	// Attribute file descriptor
 	  char		doc_attr_filename[256],
 					// Attribute filename
-			name[128];	// Option name
+			name[128];	// Option name
+
+	  num_options = cupsParseOptions(value, /*end*/NULL, 0, &options);
+
+	  if ((job_id = cupsGetOption("id", num_options, options)) == NULL || strtol(job_id, NULL, 10) <= 0 || (job_name = cupsGetOption("name", num_options, options)) == NULL || (job_username = cupsGetOption("username", num_options, options)) == NULL)
+	  {
+	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Bad Job definition on line %d of \"%s\".", linenum, filename);
+	    break;
+	  }
+
+	  if (journal && (job = _papplPrinterFindJobNoLock(printer, (int)strtol(job_id, NULL, 10))) != NULL)
+	  {
+	    // Replace the existing job...
+	    remove_job(printer, job, /*keep_files*/true);
+	  }
+
+	  if ((job = _papplJobCreate(printer, (int)strtol(job_id, NULL, 10), job_username, job_name, NULL)) == NULL)
+	  {
+	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Error creating job %s for printer %s", job_name, printer->name);
+	    break;
+	  }
+
+          for (doc_number = 1; doc_number <= _PAPPL_MAX_DOCUMENTS; doc_number ++)
+          {
+            if (doc_number > 1)
+              snprintf(name, sizeof(name), "filename%d", doc_number);
+	    else
+	      cupsCopyString(name, "filename", sizeof(name));
+
+	    if ((job_value = cupsGetOption(name, num_options, options)) == NULL)
+	      break;
+
+            if (stat(job_value, &jobbuf))
+            {
+              papplLogJob(job, PAPPL_LOGLEVEL_WARN, "Document %d file \"%s\" not accessible: %s", doc_number, job_value, strerror(errno));
+              break;
+            }
+
+	    if ((doc = _papplJobAddDocumentNoLock(job)) == NULL)
+	    {
+	      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for document %d.", doc_number);
+	      break;
+	    }
+
+	    doc->filename = strdup(job_value);
+	    doc->k_octets = jobbuf.st_size;
+	    job->k_octets += jobbuf.st_size;
+
+            if (!doc->filename)
+	    {
+	      free(doc->filename);
+	      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for document %d.", doc_number);
+	      break;
+	    }
+
+            _papplJobRetainSharedFile(job, doc->filename);
+
+	    if ((doc_attr_fd = papplJobOpenFile(job, doc_number, doc_attr_filename, sizeof(doc_attr_filename), system->directory, "ipp", /*format*/NULL, "r")) >= 0)
+	    {
+	      doc->attrs = ippNew();
+	      ippReadFile(doc_attr_fd, doc->attrs);
+	      close(doc_attr_fd);
+
+	      // Copy the format since the attributes can be saved to the spool
+	      // directory and freed...
+	      doc->format = _papplStrAlloc(ippGetString(ippFindAttribute(doc->attrs, "document-format", IPP_TAG_MIMETYPE), 0, NULL));
+	    }
+
+	    snprintf(name, sizeof(name), "state%d", doc_number);
+	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
+	      doc->state = (ipp_dstate_t)strtol(job_value, NULL, 10);
+	    else
+	      doc->state = IPP_DSTATE_PENDING;
+
+	    snprintf(name, sizeof(name), "state_reasons%d", doc_number);
+	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
+	      doc->state_reasons = (pappl_jreason_t)strtol(job_value, NULL, 10);
+
+	    snprintf(name, sizeof(name), "created%d", doc_number);
+	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
+	      doc->created = strtol(job_value, NULL, 10);
+	    snprintf(name, sizeof(name), "processing%d", doc_number);
+	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
+	      doc->processing = strtol(job_value, NULL, 10);
+	    snprintf(name, sizeof(name), "completed%d", doc_number);
+	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
+	      doc->completed = strtol(job_value, NULL, 10);
+
+	    job->num_documents ++;
+          }
+
+	  if ((job_value = cupsGetOption("state", num_options, options)) != NULL)
+	    job->state = (ipp_jstate_t)strtol(job_value, NULL, 10);
+	  if (job->num_documents == 0 && job->state < IPP_JSTATE_CANCELED)
+	    job->state = IPP_JSTATE_ABORTED;
+
+	  if ((job_value = cupsGetOption("state_reasons", num_options, options)) != NULL)
+	    job->state_reasons = (pappl_jreason_t)strtol(job_value, NULL, 10);
+	  if ((job_value = cupsGetOption("created", num_options, options)) != NULL)
+	    job->created = strtol(job_value, NULL, 10);
+	  if ((job_value = cupsGetOption("processing", num_options, options)) != NULL)
+	    job->processing = strtol(job_value, NULL, 10);
+	  if ((job_value = cupsGetOption("completed", num_options, options)) != NULL)
+	    job->completed = strtol(job_value, NULL, 10);
+	  if ((job_value = cupsGetOption("impressions", num_options, options)) != NULL)
+	    job->impressions = (int)strtol(job_value, NULL, 10);
+	  if ((job_value = cupsGetOption("imcompleted", num_options, options)) != NULL)
+	    job->impcompleted = (int)strtol(job_value, NULL, 10);
+
+	  // Add the job to printer completed jobs array...
+	  if (job->state < IPP_JSTATE_STOPPED)
+	  {
+	    // Load the file attributes from the spool directory...
+	    int		job_attr_fd;	// Attribute file descriptor
+	    char	job_attr_filename[256];
+					// Attribute filename
+
+	    if ((job_attr_fd = papplJobOpenFile(job, 0, job_attr_filename, sizeof(job_attr_filename), system->directory, "ipp", /*format*/NULL, "r")) < 0)
+	    {
+	      if (errno != ENOENT)
+		papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to open file for job attributes: '%s'.", job_attr_filename);
+	      continue;
+	    }
+
+	    ippReadFile(job_attr_fd, job->attrs);
+	    close(job_attr_fd);
+
+	    if ((attr = ippFindAttribute(job->attrs, "job-priority", IPP_TAG_INTEGER)) != NULL)
+	      job->priority = ippGetInteger(attr, 0);
+
+	    if (!job->documents[0].filename || stat(job->documents[0].filename, &jobbuf))
+	    {
+	      // If file removed, then set job state to aborted...
+	      job->state = IPP_JSTATE_ABORTED;
+	    }
+	    else
+	    {
+	      // Add the job to printer active jobs array and scheduling queue...
+	      cupsArrayAdd(printer->active_jobs, job);
+	      _papplPrinterQueueJobNoLock(printer, job);
+	    }
+	  }
+	  else
+	  {
+	    // Add job to printer completed jobs...
+	    cupsArrayAdd(printer->completed_jobs, job);
+	  }
+	}
+	else if (!strcasecmp(line, "RemoveJob") && value)
+	{
+	  // Remove a job from the job history...
+	  pappl_job_t	*job;		// Job
+
+	  if ((job = _papplPrinterFindJobNoLock(printer, (int)strtol(value, NULL, 10))) != NULL)
+	    remove_job(printer, job, /*keep_files*/false);
+	}
+	else
+	{
+	  papplLog(system, PAPPL_LOGLEVEL_WARN, "Unknown printer directive '%s' on line %d of \"%s\".", line, linenum, filename);
+	}
+      }
+
+      // Loaded all printer attributes, call the status callback (if any) to
+      // update the current printer state...
+      if (printer && printer->driver_data.status_cb)
+        (printer->driver_data.status_cb)(printer);
+    }
+    else
+    {
+      papplLog(system, PAPPL_LOGLEVEL_WARN, "Unknown directive '%s' on line %d of \"%s\".", line, linenum, filename);
+    }
+  }
+
+  // Add pool members now that all of the printers are loaded...
+  for (i = 0; i < num_pool_members; i ++)
+  {
+    pappl_printer_t	*pool,		// Pool printer
+			*member;	// Member printer
+
+    pool   = papplSystemFindPrinter(system, /*resource*/NULL, pool_members[i].pool_id, /*device_uri*/NULL);
+    member = papplSystemFindPrinter(system, /*resource*/NULL, pool_members[i].member_id, /*device_uri*/NULL);
+
+    if (!pool || !member || !papplPrinterAddPoolMember(pool, member))
+      papplLog(system, PAPPL_LOGLEVEL_WARN, "Unable to add printer %d to pool printer %d in \"%s\".", pool_members[i].member_id, pool_members[i].pool_id, filename);
+  }
+
+  free(pool_members);
+
+  return (true);
+}
+
+
+//
+// 'parse_contact()' - Parse a contact value.
+//
+
+static void
+parse_contact(char            *value,	// I - Value
+              pappl_contact_t *contact)	// O - Contact
+{
+  size_t	i,			// Looping var
+		num_options;		// Number of options
+  cups_option_t	*options = NULL,	// Options
+		*option;		// Current option
+
+
+  memset(contact, 0, sizeof(pappl_contact_t));
+  num_options = cupsParseOptions(value, /*end*/NULL, 0, &options);
+
+  for (i = num_options, option = options; i > 0; i --, option ++)
+  {
+    if (!strcasecmp(option->name, "name"))
+      cupsCopyString(contact->name, option->value, sizeof(contact->name));
+    else if (!strcasecmp(option->name, "email"))
+      cupsCopyString(contact->email, option->value, sizeof(contact->email));
+    else if (!strcasecmp(option->name, "telephone"))
+      cupsCopyString(contact->telephone, option->value, sizeof(contact->telephone));
+  }
+
+  cupsFreeOptions(num_options, options);
+}
+
+
+//
+// 'parse_media_col()' - Parse a media-col value.
+//
+
+static void
+parse_media_col(
+    char              *value,		// I - Value
+    pappl_media_col_t *media)		// O - Media collection
+{
+  size_t	i,			// Looping var
+		num_options;		// Number of options
+  cups_option_t	*options = NULL,	// Options
+		*option;		// Current option
+
+
+  memset(media, 0, sizeof(pappl_media_col_t));
+  num_options = cupsParseOptions(value, /*end*/NULL, 0, &options);
+
+  for (i = num_options, option = options; i > 0; i --, option ++)
+  {
+    if (!strcasecmp(option->name, "bottom"))
+      media->bottom_margin = (int)strtol(option->value, NULL, 10);
+    else if (!strcasecmp(option->name, "left"))
+      media->left_margin = (int)strtol(option->value, NULL, 10);
+    else if (!strcasecmp(option->name, "left-offset"))
+      media->left_offset = (int)strtol(option->value, NULL, 10);
+    else if (!strcasecmp(option->name, "right"))
+      media->right_margin = (int)strtol(option->value, NULL, 10);
+    else if (!strcasecmp(option->name, "name"))
+      cupsCopyString(media->size_name, option->value, sizeof(media->size_name));
+    else if (!strcasecmp(option->name, "width"))
+      media->size_width = (int)strtol(option->value, NULL, 10);
+    else if (!strcasecmp(option->name, "length"))
+      media->size_length = (int)strtol(option->value, NULL, 10);
+    else if (!strcasecmp(option->name, "source"))
+      cupsCopyString(media->source, option->value, sizeof(media->source));
+    else if (!strcasecmp(option->name, "top"))
+      media->top_margin = (int)strtol(option->value, NULL, 10);
+    else if (!strcasecmp(option->name, "offset") || !strcasecmp(option->name, "top-offset"))
+      media->top_offset = (int)strtol(option->value, NULL, 10);
+    else if (!strcasecmp(option->name, "tracking"))
+      media->tracking = _papplMediaTrackingValue(option->value);
+    else if (!strcasecmp(option->name, "type"))
+      cupsCopyString(media->type, option->value, sizeof(media->type));
+  }
+
+  cupsFreeOptions(num_options, options);
+}
+
+
+//
+// 'read_line()' - Read a line from the state file.
+//
+// This function is like `cupsFileGetConf`, except that it doesn't support
+// comments since the state files are not meant to be edited or maintained by
+// humans.
+//
+
+static char *				// O  - Line or `NULL` on EOF
+read_line(cups_file_t *fp,		// I  - File
+          char        *line,		// I  - Line buffer
+          size_t      linesize,		// I  - Size of line buffer
+          char        **value,		// O  - Value portion of line
+          int         *linenum)		// IO - Current line number
+{
+  char	*ptr;				// Pointer into line
+
+
+  // Try reading a line from the file...
+  *value = NULL;
+
+  if (!cupsFileGets(fp, line, linesize))
+    return (NULL);
+
+  // Got it, bump the line number...
+  (*linenum) ++;
+
+  // If we have "something value" then split at the whitespace...
+  if ((ptr = strchr(line, ' ')) != NULL)
+  {
+    *ptr++ = '\0';
+    *value = ptr;
+  }
+
+  // Strip the trailing ">" for "<something value(s)>"
+  if (line[0] == '<' && *value && (ptr = *value + strlen(*value) - 1) >= *value && *ptr == '>')
+    *ptr = '\0';
 
-	  num_options = cupsParseOptions(value, /*end*/NULL, 0, &options);
+  return (line);
+}
 
-	  if ((job_id = cupsGetOption("id", num_options, options)) == NULL || strtol(job_id, NULL, 10) <= 0 || (job_name = cupsGetOption("name", num_options, options)) == NULL || (job_username = cupsGetOption("username", num_options, options)) == NULL)
-	  {
-	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Bad Job definition on line %d of \"%s\".", linenum, filename);
-	    break;
-	  }
 
-	  if ((job = _papplJobCreate(printer, (int)strtol(job_id, NULL, 10), job_username, job_name, NULL)) == NULL)
-	  {
-	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Error creating job %s for printer %s", job_name, printer->name);
-	    break;
-	  }
+//
+// 'remove_job()' - Remove a job loaded from a state file.
+//
 
-          for (doc_number = 1, doc = job->documents; doc_number <= _PAPPL_MAX_DOCUMENTS; doc_number ++, doc ++)
-          {
-            if (doc_number > 1)
-              snprintf(name, sizeof(name), "filename%d", doc_number);
-	    else
-	      cupsCopyString(name, "filename", sizeof(name));
+static void
+remove_job(pappl_printer_t *printer,	// I - Printer
+           pappl_job_t     *job,	// I - Job
+           bool            keep_files)	// I - Keep document files for a replacement job?
+{
+  // Jobs that are not completed keep their document files when deleted...
+  if (keep_files)
+    job->state = IPP_JSTATE_PENDING;
+
+  _papplPrinterUnqueueJobNoLock(printer, job);
+  _papplHeapRemove(printer->timer_jobs, job);
+  cupsArrayRemove(printer->active_jobs, job);
+  cupsArrayRemove(printer->completed_jobs, job);
+  cupsArrayRemove(printer->all_jobs, job);
+}
 
-	    if ((job_value = cupsGetOption(name, num_options, options)) == NULL)
-	      break;
 
-            if (stat(job_value, &jobbuf))
-            {
-              papplLogJob(job, PAPPL_LOGLEVEL_WARN, "Document %d file \"%s\" not accessible: %s", doc_number, job_value, strerror(errno));
-              break;
-            }
+//
+// 'reset_printer()' - Reset the saved printer values before loading a journal
+//                     record.
+//
+// Values that are not written when empty or zero need to be cleared so that
+// the journal record replaces them.
+//
 
-	    doc->filename = strdup(job_value);
-	    doc->k_octets = jobbuf.st_size;
-	    job->k_octets += jobbuf.st_size;
+static void
+reset_printer(pappl_printer_t *printer)	// I - Printer
+{
+  size_t	i;			// Looping var
+  pappl_printer_t *member;		// Pool member
+
+
+  free(printer->location);
+  free(printer->geo_location);
+  free(printer->organization);
+  free(printer->org_unit);
+
+  printer->location          = NULL;
+  printer->geo_location      = NULL;
+  printer->organization      = NULL;
+  printer->org_unit          = NULL;
+  printer->hold_new_jobs     = false;
+  printer->max_resident_jobs = 0;
+
+  printer->driver_data.copies_default         = 1;
+  printer->driver_data.finishings_default     = PAPPL_FINISHINGS_NONE;
+  printer->driver_data.identify_default       = PAPPL_IDENTIFY_ACTIONS_NONE;
+  printer->driver_data.mode_configured        = (pappl_label_mode_t)0;
+  printer->driver_data.tear_offset_configured = 0;
+  printer->driver_data.orient_default         = (ipp_orient_t)0;
+  printer->driver_data.bin_default            = 0;
+  printer->driver_data.color_default          = (pappl_color_mode_t)0;
+  printer->driver_data.content_default        = (pappl_content_t)0;
+  printer->driver_data.darkness_default       = 0;
+  printer->driver_data.quality_default        = (ipp_quality_t)0;
+  printer->driver_data.scaling_default        = (pappl_scaling_t)0;
+  printer->driver_data.sides_default          = (pappl_sides_t)0;
+
+  for (i = 0; i < (size_t)printer->driver_data.num_source && i < PAPPL_MAX_SOURCE; i ++)
+    printer->driver_data.media_ready[i].size_name[0] = '\0';
+
+  while ((member = (pappl_printer_t *)cupsArrayGetFirst(printer->pool_members)) != NULL)
+    papplPrinterRemovePoolMember(printer, member);
+}
 
-            if (!doc->filename)
-	    {
-	      free(doc->filename);
-	      papplLogJob(job, PAPPL_LOGLEVEL_ERROR, "Unable to allocate memory for document %d.", doc_number);
-	      break;
-	    }
 
-	    if ((doc_attr_fd = papplJobOpenFile(job, doc_number, doc_attr_filename, sizeof(doc_attr_filename), system->directory, "ipp", /*format*/NULL, "r")) >= 0)
-	    {
-	      doc->attrs = ippNew();
-	      ippReadFile(doc_attr_fd, doc->attrs);
-	      close(doc_attr_fd);
+//
+// 'save_journal()' - Append changed printers and jobs to the state journal.
+//
 
-	      doc->format = ippGetString(ippFindAttribute(doc->attrs, "document-format", IPP_TAG_MIMETYPE), 0, NULL);
-	    }
+static bool				// O - `true` on success, `false` on failure
+save_journal(pappl_system_t *system,	// I - System
+             const char     *filename,	// I - State file
+             size_t         changes)	// I - Change number of last save
+{
+  bool			ret = true;	// Return value
+  size_t		i, j,		// Looping vars
+			count,		// Number of printers
+			jcount;		// Number of jobs
+  char			jfilename[1024];// Journal filename
+  cups_file_t		*fp;		// Journal file
+  pappl_printer_t	*printer;	// Current printer
+  pappl_job_t		*job;		// Current job
+  size_t		printer_changes;// Printer's change number
+  int			*removed_jobs;	// Removed jobs
+  size_t		num_removed_jobs;// Number of removed jobs
+  bool			in_printer;	// Have we written the printer record?
+  struct stat		fileinfo;	// Journal file information
 
-	    snprintf(name, sizeof(name), "state%d", doc_number);
-	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
-	      doc->state = (ipp_dstate_t)strtol(job_value, NULL, 10);
-	    else
-	      doc->state = IPP_DSTATE_PENDING;
 
-	    snprintf(name, sizeof(name), "state_reasons%d", doc_number);
-	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
-	      doc->state_reasons = (pappl_jreason_t)strtol(job_value, NULL, 10);
+  snprintf(jfilename, sizeof(jfilename), "%s.journal", filename);
 
-	    snprintf(name, sizeof(name), "created%d", doc_number);
-	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
-	      doc->created = strtol(job_value, NULL, 10);
-	    snprintf(name, sizeof(name), "processing%d", doc_number);
-	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
-	      doc->processing = strtol(job_value, NULL, 10);
-	    snprintf(name, sizeof(name), "completed%d", doc_number);
-	    if ((job_value = cupsGetOption(name, num_options, options)) != NULL)
-	      doc->completed = strtol(job_value, NULL, 10);
+  if ((fp = cupsFileOpen(jfilename, "a")) == NULL)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to open system state journal '%s': %s", jfilename, cupsGetErrorString());
+    return (false);
+  }
 
-	    job->num_documents ++;
-          }
+  papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Saving system state changes to '%s'.", jfilename);
 
-	  if ((job_value = cupsGetOption("state", num_options, options)) != NULL)
-	    job->state = (ipp_jstate_t)strtol(job_value, NULL, 10);
-	  if (job->num_documents == 0 && job->state < IPP_JSTATE_CANCELED)
-	    job->state = IPP_JSTATE_ABORTED;
+  _papplRWLockRead(system);
+  cupsRWLockRead(&system->printers_rwlock);
 
-	  if ((job_value = cupsGetOption("state_reasons", num_options, options)) != NULL)
-	    job->state_reasons = (pappl_jreason_t)strtol(job_value, NULL, 10);
-	  if ((job_value = cupsGetOption("created", num_options, options)) != NULL)
-	    job->created = strtol(job_value, NULL, 10);
-	  if ((job_value = cupsGetOption("processing", num_options, options)) != NULL)
-	    job->processing = strtol(job_value, NULL, 10);
-	  if ((job_value = cupsGetOption("completed", num_options, options)) != NULL)
-	    job->completed = strtol(job_value, NULL, 10);
-	  if ((job_value = cupsGetOption("impressions", num_options, options)) != NULL)
-	    job->impressions = (int)strtol(job_value, NULL, 10);
-	  if ((job_value = cupsGetOption("imcompleted", num_options, options)) != NULL)
-	    job->impcompleted = (int)strtol(job_value, NULL, 10);
+  for (i = 0, count = cupsArrayGetCount(system->printers); i < count; i ++)
+  {
+    printer = (pappl_printer_t *)cupsArrayGetElement(system->printers, i);
 
-	  // Add the job to printer completed jobs array...
-	  if (job->state < IPP_JSTATE_STOPPED)
-	  {
-	    // Load the file attributes from the spool directory...
-	    int		job_attr_fd;	// Attribute file descriptor
-	    char	job_attr_filename[256];
-					// Attribute filename
+    // Grab the list of removed jobs...
+    cupsMutexLock(&system->config_mutex);
 
-	    if ((job_attr_fd = papplJobOpenFile(job, 0, job_attr_filename, sizeof(job_attr_filename), system->directory, "ipp", /*format*/NULL, "r")) < 0)
-	    {
-	      if (errno != ENOENT)
-		papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to open file for job attributes: '%s'.", job_attr_filename);
-	      continue;
-	    }
+    printer_changes  = printer->state_changes;
+    removed_jobs     = printer->removed_jobs;
+    num_removed_jobs = printer->num_removed_jobs;
 
-	    ippReadFile(job_attr_fd, job->attrs);
-	    close(job_attr_fd);
+    printer->removed_jobs       = NULL;
+    printer->num_removed_jobs   = 0;
+    printer->alloc_removed_jobs = 0;
 
-	    if (!job->documents[0].filename || stat(job->documents[0].filename, &jobbuf))
-	    {
-	      // If file removed, then set job state to aborted...
-	      job->state = IPP_JSTATE_ABORTED;
-	    }
-	    else
-	    {
-	      // Add the job to printer active jobs array...
-	      cupsArrayAdd(printer->active_jobs, job);
-	    }
-	  }
-	  else
-	  {
-	    // Add job to printer completed jobs...
-	    cupsArrayAdd(printer->completed_jobs, job);
-	  }
-	}
-	else
+    cupsMutexUnlock(&system->config_mutex);
+
+    _papplRWLockRead(printer);
+
+    if (!printer->is_deleted)
+    {
+      // Write the printer values if anything changed, followed by any changed
+      // or removed jobs...
+      in_printer = printer_changes > changes || num_removed_jobs > 0;
+
+      if (in_printer)
+        ret &= write_printer(fp, system, printer);
+
+      // Note: Cannot use cupsArrayGetFirst/Last since other threads might be
+      // enumerating the all_jobs array.
+      for (j = 0, jcount = cupsArrayGetCount(printer->all_jobs); j < jcount; j ++)
+      {
+	job = (pappl_job_t *)cupsArrayGetElement(printer->all_jobs, j);
+
+	if (job->state_changes <= changes)
+	  continue;
+
+	if (!in_printer)
 	{
-	  papplLog(system, PAPPL_LOGLEVEL_WARN, "Unknown printer directive '%s' on line %d of \"%s\".", line, linenum, filename);
+	  ret &= write_printer(fp, system, printer);
+	  in_printer = true;
 	}
+
+	ret &= write_job(fp, system, job);
       }
 
-      // Loaded all printer attributes, call the status callback (if any) to
-      // update the current printer state...
-      if (printer && printer->driver_data.status_cb)
-        (printer->driver_data.status_cb)(printer);
-    }
-    else
-    {
-      papplLog(system, PAPPL_LOGLEVEL_WARN, "Unknown directive '%s' on line %d of \"%s\".", line, linenum, filename);
+      for (j = 0; j < num_removed_jobs; j ++)
+	ret &= _papplFilePrintf(fp, "RemoveJob %d\n", removed_jobs[j]);
+
+      if (in_printer)
+	ret &= _papplFilePuts(fp, "</Printer>\n");
     }
+
+    _papplRWUnlock(printer);
+
+    free(removed_jobs);
   }
 
-  cupsFileClose(fp);
+  cupsRWUnlock(&system->printers_rwlock);
+  _papplRWUnlock(system);
+
+  // Mark the end of this save so that incomplete saves are ignored...  A save
+  // with any write errors is not committed so the next save writes a full
+  // state file.
+  if (ret)
+    ret &= _papplFilePuts(fp, "Commit\n");
+  if (ret)
+    ret &= sync_file(system, fp, jfilename);
+  if (!_papplFileClose(fp))
+    ret = false;
+
+  if (!ret)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to write system state journal '%s'.", jfilename);
+    return (false);
+  }
+
+  if (!stat(jfilename, &fileinfo))
+  {
+    cupsMutexLock(&system->config_mutex);
+    system->journal_size = (size_t)fileinfo.st_size;
+    cupsMutexUnlock(&system->config_mutex);
+  }
 
   return (true);
 }
 
 
 //
-// 'papplSystemSaveState()' - Save the current system state.
-//
-// This function saves the current system state to a file.  It is typically
-// used with the @link papplSystemSetSaveCallback@ function to periodically
-// save the state:
+// 'save_snapshot()' - Save the complete system state and remove the journal.
 //
-// ```
-// |papplSystemSetSaveCallback(system, (pappl_save_cb_t)papplSystemSaveState,
-// |    (void *)filename);
-// ```
+// The state file is written to a temporary file that then replaces the old
+// state file, so a binary state file that is currently mapped into memory is
+// never modified.
 //
 
-bool					// O - `true` on success, `false` on failure
-papplSystemSaveState(
-    pappl_system_t *system,		// I - System
-    const char     *filename)		// I - File to save
+static bool				// O - `true` on success, `false` on failure
+save_snapshot(pappl_system_t *system,	// I - System
+              const char     *filename)	// I - State file
 {
   size_t		i, j,		// Looping vars
-			count;		// Number of printers
+			count,		// Number of printers
+			jcount;		// Number of jobs
+  bool			binary,		// Write a binary state file?
+			ret = true;	// Return value
+  char			jfilename[1024],// Journal filename
+			tfilename[1024];// Temporary filename
   cups_file_t		*fp;		// Output file
   pappl_printer_t	*printer;	// Current printer
-  pappl_job_t		*job;		// Current Job
+  pappl_job_t		*job;		// Current job
+  _pappl_bin_t		bin;		// Binary record buffer
+  off_t			text_length = 0,// Length of text section
+			jobs_length;	// Length of job records
+  size_t		num_jobs = 0;	// Number of job records
+  struct stat		fileinfo;	// State file information
+
 
+  binary = (system->options & PAPPL_SOPTIONS_BINARY_STATE) != 0;
 
-  if ((fp = cupsFileOpen(filename, "wp600")) == NULL)
+  snprintf(tfilename, sizeof(tfilename), "%s.N", filename);
+
+  if ((fp = cupsFileOpen(tfilename, "wp600")) == NULL)
   {
-    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create system state file '%s': %s", filename, cupsGetErrorString());
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create system state file '%s': %s", tfilename, cupsGetErrorString());
     return (false);
   }
 
-  papplLog(system, PAPPL_LOGLEVEL_INFO, "Saving system state to '%s'.", filename);
+  papplLog(system, PAPPL_LOGLEVEL_INFO, "Saving %s system state to '%s'.", binary ? "binary" : "text", filename);
+
+  memset(&bin, 0, sizeof(bin));
+
+  if (binary)
+  {
+    // Binary state files start with a header followed by the system and
+    // printer values in text form...
+    bin_add(&bin, _PAPPL_STATE_MAGIC, 8);
+    bin_add_int(&bin, _PAPPL_STATE_VERSION, 4);
+    bin_add_int(&bin, 0, 4);
+    ret &= _papplFileWrite(fp, (char *)bin.start, (size_t)(bin.ptr - bin.start));
+  }
 
   _papplRWLockRead(system);
 
-  if (system->dns_sd_name)
-    cupsFilePutConf(fp, "DNSSDName", system->dns_sd_name);
-  if (system->location)
-    cupsFilePutConf(fp, "Location", system->location);
-  if (system->geo_location)
-    cupsFilePutConf(fp, "Geolocation", system->geo_location);
-  if (system->organization)
-    cupsFilePutConf(fp, "Organization", system->organization);
-  if (system->org_unit)
-    cupsFilePutConf(fp, "OrganizationalUnit", system->org_unit);
-  write_contact(fp, &system->contact);
-  if (system->admin_group)
-    cupsFilePutConf(fp, "AdminGroup", system->admin_group);
-  if (system->default_print_group)
-    cupsFilePutConf(fp, "DefaultPrintGroup", system->default_print_group);
-  if (system->password_hash[0])
-    cupsFilePutConf(fp, "Password", system->password_hash);
-  cupsFilePrintf(fp, "DefaultPrinterID %d\n", system->default_printer_id);
-  cupsFilePrintf(fp, "MaxImageSize %ld %d %d\n", (long)system->max_image_size, system->max_image_width, system->max_image_height);
-  cupsFilePrintf(fp, "NextPrinterID %d\n", system->next_printer_id);
-  cupsFilePutConf(fp, "UUID", system->uuid);
+  ret &= write_system(fp, system);
 
   // Loop through the printers.
   //
@@ -526,407 +1681,289 @@ papplSystemSaveState(
 
   for (i = 0, count = cupsArrayGetCount(system->printers); i < count; i ++)
   {
-    size_t		jcount;		// Number of jobs
-    size_t		num_options = 0;// Number of options
-    cups_option_t	*options = NULL;// Options
-
     printer = (pappl_printer_t *)cupsArrayGetElement(system->printers, i);
 
     _papplRWLockRead(printer);
 
+    // Removed jobs are not in the state file...
+    cupsMutexLock(&system->config_mutex);
+    free(printer->removed_jobs);
+    printer->removed_jobs       = NULL;
+    printer->num_removed_jobs   = 0;
+    printer->alloc_removed_jobs = 0;
+    cupsMutexUnlock(&system->config_mutex);
+
     if (printer->is_deleted)
     {
       _papplRWUnlock(printer);
       continue;
     }
 
-    num_options = cupsAddIntegerOption("id", printer->printer_id, num_options, &options);
-    num_options = cupsAddOption("name", printer->name, num_options, &options);
-    num_options = cupsAddOption("did", printer->device_id ? printer->device_id : "", num_options, &options);
-    num_options = cupsAddOption("uri", printer->device_uri, num_options, &options);
-    num_options = cupsAddOption("driver", printer->driver_name, num_options, &options);
-
-    if (system->options & PAPPL_SOPTIONS_MULTI_QUEUE)
-      num_options = cupsAddIntegerOption("state", (int)printer->state, num_options, &options);
-
-    write_options(fp, "<Printer", num_options, options);
-    cupsFreeOptions(num_options, options);
-
-    if (printer->dns_sd_name)
-      cupsFilePutConf(fp, "DNSSDName", printer->dns_sd_name);
-    if (printer->location)
-      cupsFilePutConf(fp, "Location", printer->location);
-    if (printer->geo_location)
-      cupsFilePutConf(fp, "Geolocation", printer->geo_location);
-    if (printer->organization)
-      cupsFilePutConf(fp, "Organization", printer->organization);
-    if (printer->org_unit)
-      cupsFilePutConf(fp, "OrganizationalUnit", printer->org_unit);
-    write_contact(fp, &printer->contact);
-    if (printer->hold_new_jobs)
-      cupsFilePuts(fp, "HoldNewJobs\n");
-    if (printer->print_group)
-      cupsFilePutConf(fp, "PrintGroup", printer->print_group);
-    cupsFilePrintf(fp, "MaxActiveJobs %u\n", (unsigned)printer->max_active_jobs);
-    cupsFilePrintf(fp, "MaxCompletedJobs %u\n", (unsigned)printer->max_completed_jobs);
-    cupsFilePrintf(fp, "NextJobId %d\n", printer->next_job_id);
-    cupsFilePrintf(fp, "ImpressionsCompleted %d\n", printer->impcompleted);
-
-    if (printer->driver_data.copies_default > 1)
-      cupsFilePrintf(fp, "copies-default %d\n", printer->driver_data.copies_default);
-
-    if (printer->driver_data.finishings_default)
-    {
-      pappl_finishings_t fin;		// Current finishings value
-      const char	*prefix = "finishings-default ";
-					// Prefix for value
-
-      for (fin = PAPPL_FINISHINGS_PUNCH; fin <= PAPPL_FINISHINGS_STAPLE_DUAL_TOP; fin *= 2)
-      {
-        if (printer->driver_data.finishings_default & fin)
-        {
-          cupsFilePrintf(fp, "%s%s", prefix, _papplFinishingsString(fin));
-          prefix = ",";
-        }
-      }
-      cupsFilePuts(fp, "\n");
-    }
-
-    if (printer->driver_data.identify_default)
-      cupsFilePutConf(fp, "identify-actions-default", _papplIdentifyActionsString(printer->driver_data.identify_default));
+    ret &= write_printer(fp, system, printer);
 
-    if (printer->driver_data.mode_configured)
-      cupsFilePutConf(fp, "label-mode-configured", _papplLabelModeString(printer->driver_data.mode_configured));
-    if (printer->driver_data.tear_offset_configured)
-      cupsFilePrintf(fp, "label-tear-offset-configured %d\n", printer->driver_data.tear_offset_configured);
-
-    write_media_col(fp, "media-col-default", &printer->driver_data.media_default);
-    for (j = 0; j < (size_t)printer->driver_data.num_source; j ++)
+    // Note: Cannot use cupsArrayGetFirst/Last since other threads might be
+    // enumerating the all_jobs array.
+    if (!binary)
     {
-      if (printer->driver_data.media_ready[j].size_name[0])
-      {
-        char	name[128];		// Attribute name
-
-        snprintf(name, sizeof(name), "media-col-ready%u", (unsigned)j);
-        write_media_col(fp, name, printer->driver_data.media_ready + j);
-      }
+      for (j = 0, jcount = cupsArrayGetCount(printer->all_jobs); j < jcount; j ++)
+	ret &= write_job(fp, system, (pappl_job_t *)cupsArrayGetElement(printer->all_jobs, j));
     }
-    if (printer->driver_data.handling_default)
-      cupsFilePutConf(fp, "multiple-document-handling-default", _papplHandlingString(printer->driver_data.handling_default));
-
-    if (printer->driver_data.orient_default)
-      cupsFilePutConf(fp, "orientation-requested-default", ippEnumString("orientation-requested", (int)printer->driver_data.orient_default));
-    if (printer->driver_data.bin_default && printer->driver_data.num_bin > 0)
-      cupsFilePutConf(fp, "output-bin-default", printer->driver_data.bin[printer->driver_data.bin_default]);
-
-    if (printer->driver_data.color_default)
-      cupsFilePutConf(fp, "print-color-mode-default", _papplColorModeString(printer->driver_data.color_default));
-    if (printer->driver_data.content_default)
-      cupsFilePutConf(fp, "print-content-optimize-default", _papplContentString(printer->driver_data.content_default));
-    if (printer->driver_data.darkness_default)
-      cupsFilePrintf(fp, "print-darkness-default %d\n", printer->driver_data.darkness_default);
-    if (printer->driver_data.quality_default)
-      cupsFilePutConf(fp, "print-quality-default", ippEnumString("print-quality", (int)printer->driver_data.quality_default));
-    if (printer->driver_data.scaling_default)
-      cupsFilePutConf(fp, "print-scaling-default", _papplScalingString(printer->driver_data.scaling_default));
-    if (printer->driver_data.speed_supported[1] > 0)
-      cupsFilePrintf(fp, "print-speed-default %d\n", printer->driver_data.speed_default);
-    if (printer->driver_data.darkness_supported > 0)
-      cupsFilePrintf(fp, "printer-darkness-configured %d\n", printer->driver_data.darkness_configured);
-    if (printer->driver_data.x_default)
-      cupsFilePrintf(fp, "printer-resolution-default %dx%ddpi\n", printer->driver_data.x_default, printer->driver_data.y_default);
-
-    if (printer->driver_data.sides_default)
-      cupsFilePutConf(fp, "sides-default", _papplSidesString(printer->driver_data.sides_default));
-    for (j = 0; j < (size_t)printer->driver_data.num_vendor; j ++)
-    {
-      char	defname[128],		// xxx-default name
-	      	defvalue[1024];		// xxx-default value
 
-      snprintf(defname, sizeof(defname), "%s-default", printer->driver_data.vendor[j]);
-      ippAttributeString(ippFindAttribute(printer->driver_attrs, defname, IPP_TAG_ZERO), defvalue, sizeof(defvalue));
+    ret &= _papplFilePuts(fp, "</Printer>\n");
 
-      cupsFilePutConf(fp, defname, defvalue);
-    }
+    _papplRWUnlock(printer);
+  }
 
-    // Note: Cannot use cupsArrayGetFirst/Last since other threads might be
-    // enumerating the all_jobs array.
+  if (binary)
+  {
+    // Then write the job records and trailer...
+    text_length = cupsFileTell(fp) - _PAPPL_STATE_HEADER;
 
-    for (j = 0, jcount = cupsArrayGetCount(printer->all_jobs); j < jcount; j ++)
+    for (i = 0; i < count && ret; i ++)
     {
-      int		doc_number;	// Document number
-      _pappl_doc_t	*doc;		// Document
+      printer = (pappl_printer_t *)cupsArrayGetElement(system->printers, i);
 
-      job = (pappl_job_t *)cupsArrayGetElement(printer->all_jobs, j);
+      _papplRWLockRead(printer);
 
-      _papplRWLockRead(job);
-
-      // Add basic job attributes...
-      num_options = 0;
-      num_options = cupsAddIntegerOption("id", job->job_id, num_options, &options);
-      num_options = cupsAddOption("name", job->name, num_options, &options);
-      num_options = cupsAddOption("username", job->username, num_options, &options);
-      for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+      if (!printer->is_deleted)
       {
-        char	name[32];		// Option name
-
-        if (doc->attrs)
-        {
-	  int	doc_attr_fd;		// Attribute file descriptor
-	  char	doc_attr_filename[1024];// Attribute filename
-
-	  // Save job attributes to file in spool directory...
-	  if ((doc_attr_fd = papplJobOpenFile(job, doc_number, doc_attr_filename, sizeof(doc_attr_filename), system->directory, "ipp", /*format*/NULL, "w")) < 0)
-	  {
-	    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create '%s' for document attributes: %s", doc_attr_filename, strerror(errno));
-	    _papplRWUnlock(job);
-	    continue;
-	  }
-
-	  ippWriteFile(doc_attr_fd, doc->attrs);
-	  close(doc_attr_fd);
-	}
-
-	if (doc->filename)
+	for (j = 0, jcount = cupsArrayGetCount(printer->all_jobs); j < jcount && ret; j ++)
 	{
-          if (doc_number > 1)
-          {
-            snprintf(name, sizeof(name), "filename%d", doc_number);
-	    num_options = cupsAddOption(name, doc->filename, num_options, &options);
-	  }
-	  else
-	  {
-	    num_options = cupsAddOption("filename", doc->filename, num_options, &options);
-          }
-	}
-
-	snprintf(name, sizeof(name), "state%d", doc_number);
-	num_options = cupsAddIntegerOption(name, doc->state, num_options, &options);
-
-	snprintf(name, sizeof(name), "state_reasons%d", doc_number);
-	num_options = cupsAddIntegerOption(name, doc->state_reasons, num_options, &options);
-
-	snprintf(name, sizeof(name), "created%d", doc_number);
-	num_options = add_time(name, doc->created, num_options, &options);
+	  job = (pappl_job_t *)cupsArrayGetElement(printer->all_jobs, j);
 
-        if (doc->processing)
-        {
-	  snprintf(name, sizeof(name), "processing%d", doc_number);
-	  num_options = add_time(name, doc->processing, num_options, &options);
-	}
-
-        if (doc->completed)
-        {
-	  snprintf(name, sizeof(name), "completed%d", doc_number);
-	  num_options = add_time(name, doc->completed, num_options, &options);
+	  if ((ret = write_binary_job(fp, &bin, system, job)) == true)
+	    num_jobs ++;
 	}
       }
 
-      if (job->is_canceled)
-        num_options = cupsAddIntegerOption("state", (int)IPP_JSTATE_CANCELED, num_options, &options);
-      else if (job->state)
-        num_options = cupsAddIntegerOption("state", (int)job->state, num_options, &options);
-      if (job->state_reasons)
-        num_options = cupsAddIntegerOption("state_reasons", (int)job->state_reasons, num_options, &options);
-      if (job->created)
-        num_options = add_time("created", job->created, num_options, &options);
-      if (job->processing)
-        num_options = add_time("processing", job->processing, num_options, &options);
-      if (job->completed)
-        num_options = add_time("completed", job->completed, num_options, &options);
-      else if (job->is_canceled)
-        num_options = add_time("completed", time(NULL), num_options, &options);
-      if (job->impressions)
-        num_options = cupsAddIntegerOption("impressions", job->impressions, num_options, &options);
-      if (job->impcompleted)
-        num_options = cupsAddIntegerOption("imcompleted", job->impcompleted, num_options, &options);
-
-      if (job->attrs)
-      {
-	int	attr_fd;		// Attribute file descriptor
-	char	job_attr_filename[1024];// Attribute filename
+      _papplRWUnlock(printer);
+    }
 
-        // Save job attributes to file in spool directory...
-        if (job->state < IPP_JSTATE_STOPPED)
-        {
-          if ((attr_fd = papplJobOpenFile(job, 0, job_attr_filename, sizeof(job_attr_filename), system->directory, "ipp", /*format*/NULL, "w")) < 0)
-          {
-            papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create '%s' for job attributes: %s", job_attr_filename, strerror(errno));
-            _papplRWUnlock(job);
-            continue;
-          }
+    jobs_length = cupsFileTell(fp) - _PAPPL_STATE_HEADER - text_length;
 
-          ippWriteFile(attr_fd, job->attrs);
-          close(attr_fd);
-        }
-        else
-        {
-          // If job completed or aborted, remove job-attributes file...
-          papplJobOpenFile(job, /*doc_number*/0, job_attr_filename, sizeof(job_attr_filename), system->directory, "ipp", /*format*/NULL, /*mode*/"x");
-        }
-      }
+    bin.ptr = bin.start;
+    bin_add_int(&bin, (long long)text_length, 8);
+    bin_add_int(&bin, (long long)num_jobs, 8);
+    bin_add_int(&bin, (long long)jobs_length, 8);
+    bin_add(&bin, _PAPPL_STATE_END, 8);
+
+    if (bin.error)
+      ret = false;
+    else
+      ret &= _papplFileWrite(fp, (char *)bin.start, (size_t)(bin.ptr - bin.start));
 
-      write_options(fp, "Job", num_options, options);
-      cupsFreeOptions(num_options, options);
+    free(bin.start);
+  }
+
+  cupsRWUnlock(&system->printers_rwlock);
+  _papplRWUnlock(system);
 
-      _papplRWUnlock(job);
-    }
+  if (ret && !sync_file(system, fp, tfilename))
+    ret = false;
 
-    cupsFilePuts(fp, "</Printer>\n");
+  if (!_papplFileClose(fp))
+    ret = false;
 
-    _papplRWUnlock(printer);
+  if (!ret)
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to write system state file '%s'.", tfilename);
+    unlink(tfilename);
+    return (false);
   }
 
-  cupsRWUnlock(&system->printers_rwlock);
-  _papplRWUnlock(system);
+  // Replace the old state file...
+#if _WIN32
+  // Windows doesn't allow renaming over an existing file...
+  unlink(filename);
+#endif // _WIN32
 
-  cupsFileClose(fp);
+  if (rename(tfilename, filename))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to rename '%s' to '%s': %s", tfilename, filename, strerror(errno));
+    unlink(tfilename);
+    return (false);
+  }
 
-  return (true);
-}
+  // The state file replaces the journal...
+  snprintf(jfilename, sizeof(jfilename), "%s.journal", filename);
+  unlink(jfilename);
 
+  sync_directory(system, filename);
 
-//
-// 'add_time()' - Add a time_t value as an option.
-//
+  cupsMutexLock(&system->config_mutex);
 
-static size_t			// O  - New number of options
-add_time(const char    *name,		// I  - Name
-	 time_t        value,		// I  - Value
-	 size_t    num_options,	// I  - Number of options
-	 cups_option_t **options)	// IO - Options
-{
-  char	buffer[100];			// Value string buffer
+  if (!stat(filename, &fileinfo))
+    system->snapshot_size = (size_t)fileinfo.st_size;
 
+  system->journal_size = 0;
 
-  // Format the number as a long integer...
-  snprintf(buffer, sizeof(buffer), "%ld", (long)value);
+  if (!system->journal_filename || strcmp(system->journal_filename, filename))
+  {
+    free(system->journal_filename);
+    system->journal_filename = strdup(filename);
+  }
 
-  // Add the option with the string...
-  return (cupsAddOption(name, buffer, num_options, options));
+  cupsMutexUnlock(&system->config_mutex);
+
+  return (true);
 }
 
 
 //
-// 'parse_contact()' - Parse a contact value.
+// 'sync_directory()' - Flush the directory containing a state file to disk as
+//                      needed.
+//
+// This makes sure that the renamed state file is found after a power loss.
 //
 
 static void
-parse_contact(char            *value,	// I - Value
-              pappl_contact_t *contact)	// O - Contact
+sync_directory(pappl_system_t *system,	// I - System
+               const char     *filename)// I - State file
 {
-  size_t	i,			// Looping var
-		num_options;		// Number of options
-  cups_option_t	*options = NULL,	// Options
-		*option;		// Current option
+#if _WIN32
+  (void)system;
+  (void)filename;
 
+#else
+  char		dirname[1024],		// Directory name
+		*ptr;			// Pointer into directory name
+  int		fd;			// Directory file descriptor
 
-  memset(contact, 0, sizeof(pappl_contact_t));
-  num_options = cupsParseOptions(value, /*end*/NULL, 0, &options);
 
-  for (i = num_options, option = options; i > 0; i --, option ++)
+  if (!(system->options & PAPPL_SOPTIONS_SYNC_STATE))
+    return;
+
+  cupsCopyString(dirname, filename, sizeof(dirname));
+  if ((ptr = strrchr(dirname, '/')) != NULL)
   {
-    if (!strcasecmp(option->name, "name"))
-      cupsCopyString(contact->name, option->value, sizeof(contact->name));
-    else if (!strcasecmp(option->name, "email"))
-      cupsCopyString(contact->email, option->value, sizeof(contact->email));
-    else if (!strcasecmp(option->name, "telephone"))
-      cupsCopyString(contact->telephone, option->value, sizeof(contact->telephone));
+    if (ptr == dirname)
+      ptr ++;
+    *ptr = '\0';
+  }
+  else
+  {
+    cupsCopyString(dirname, ".", sizeof(dirname));
   }
 
-  cupsFreeOptions(num_options, options);
+  if ((fd = open(dirname, O_RDONLY | O_CLOEXEC)) >= 0)
+  {
+    if (fsync(fd))
+      papplLog(system, PAPPL_LOGLEVEL_WARN, "Unable to flush directory '%s': %s", dirname, strerror(errno));
+
+    close(fd);
+  }
+#endif // _WIN32
 }
 
 
 //
-// 'parse_media_col()' - Parse a media-col value.
+// 'sync_file()' - Flush a state file to disk as needed.
 //
 
-static void
-parse_media_col(
-    char              *value,		// I - Value
-    pappl_media_col_t *media)		// O - Media collection
+static bool				// O - `true` on success, `false` on failure
+sync_file(pappl_system_t *system,	// I - System
+          cups_file_t    *fp,		// I - File
+          const char     *filename)	// I - Filename
 {
-  size_t	i,			// Looping var
-		num_options;		// Number of options
-  cups_option_t	*options = NULL,	// Options
-		*option;		// Current option
-
+  if (!(system->options & PAPPL_SOPTIONS_SYNC_STATE))
+    return (true);
 
-  memset(media, 0, sizeof(pappl_media_col_t));
-  num_options = cupsParseOptions(value, /*end*/NULL, 0, &options);
+  cupsFileFlush(fp);
 
-  for (i = num_options, option = options; i > 0; i --, option ++)
+  if (fsync(cupsFileNumber(fp)))
   {
-    if (!strcasecmp(option->name, "bottom"))
-      media->bottom_margin = (int)strtol(option->value, NULL, 10);
-    else if (!strcasecmp(option->name, "left"))
-      media->left_margin = (int)strtol(option->value, NULL, 10);
-    else if (!strcasecmp(option->name, "left-offset"))
-      media->left_offset = (int)strtol(option->value, NULL, 10);
-    else if (!strcasecmp(option->name, "right"))
-      media->right_margin = (int)strtol(option->value, NULL, 10);
-    else if (!strcasecmp(option->name, "name"))
-      cupsCopyString(media->size_name, option->value, sizeof(media->size_name));
-    else if (!strcasecmp(option->name, "width"))
-      media->size_width = (int)strtol(option->value, NULL, 10);
-    else if (!strcasecmp(option->name, "length"))
-      media->size_length = (int)strtol(option->value, NULL, 10);
-    else if (!strcasecmp(option->name, "source"))
-      cupsCopyString(media->source, option->value, sizeof(media->source));
-    else if (!strcasecmp(option->name, "top"))
-      media->top_margin = (int)strtol(option->value, NULL, 10);
-    else if (!strcasecmp(option->name, "offset") || !strcasecmp(option->name, "top-offset"))
-      media->top_offset = (int)strtol(option->value, NULL, 10);
-    else if (!strcasecmp(option->name, "tracking"))
-      media->tracking = _papplMediaTrackingValue(option->value);
-    else if (!strcasecmp(option->name, "type"))
-      cupsCopyString(media->type, option->value, sizeof(media->type));
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to flush '%s': %s", filename, strerror(errno));
+    return (false);
   }
 
-  cupsFreeOptions(num_options, options);
+  return (true);
 }
 
 
 //
-// 'read_line()' - Read a line from the state file.
-//
-// This function is like `cupsFileGetConf`, except that it doesn't support
-// comments since the state files are not meant to be edited or maintained by
-// humans.
+// 'write_binary_job()' - Write a job record to a binary state file.
 //
 
-static char *				// O  - Line or `NULL` on EOF
-read_line(cups_file_t *fp,		// I  - File
-          char        *line,		// I  - Line buffer
-          size_t      linesize,		// I  - Size of line buffer
-          char        **value,		// O  - Value portion of line
-          int         *linenum)		// IO - Current line number
+static bool				// O - `true` on success, `false` on failure
+write_binary_job(cups_file_t    *fp,	// I - File
+                 _pappl_bin_t   *bin,	// I - Record buffer
+                 pappl_system_t *system,// I - System
+                 pappl_job_t    *job)	// I - Job
 {
-  char	*ptr;				// Pointer into line
-
+  int		doc_number;		// Document number
+  _pappl_doc_t	*doc;			// Document
+  ipp_uchar_t	*ptr;			// End of record
+
+
+  _papplRWLockRead(job);
+
+  bin->ptr = bin->start;
+
+  bin_add_int(bin, 0, 4);
+  bin_add_int(bin, job->printer->printer_id, 4);
+  bin_add_int(bin, job->job_id, 4);
+  bin_add_int(bin, job->is_canceled ? IPP_JSTATE_CANCELED : job->state, 4);
+  bin_add_int(bin, job->state_reasons, 4);
+  bin_add_int(bin, job->priority, 4);
+  bin_add_int(bin, job->impressions, 4);
+  bin_add_int(bin, _papplAtomicGet(&job->impcompleted), 4);
+  bin_add_int(bin, job->created, 8);
+  bin_add_int(bin, job->processing, 8);
+  bin_add_int(bin, job->completed ? job->completed : job->is_canceled ? time(NULL) : 0, 8);
+  bin_add_string(bin, job->name);
+  bin_add_string(bin, job->username);
+  bin_add_int(bin, job->num_documents, 4);
+
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    bin_add_string(bin, doc->filename);
+    bin_add_string(bin, doc->format);
+    bin_add_int(bin, doc->state, 4);
+    bin_add_int(bin, doc->state_reasons, 4);
+    bin_add_int(bin, doc->created, 8);
+    bin_add_int(bin, doc->processing, 8);
+    bin_add_int(bin, doc->completed, 8);
+    bin_add_int(bin, (long long)_papplAtomicGet(&doc->k_octets), 8);
+
+    if (doc->attrs_data)
+    {
+      // Copy attributes that have not been loaded from the old state file...
+      bin_add_int(bin, (long long)doc->attrs_datalen, 4);
+      bin_add(bin, doc->attrs_data, doc->attrs_datalen);
+    }
+    else if (!doc->attrs && job->is_evicted)
+    {
+      // Copy attributes that were saved to the spool directory...
+      ipp_t	*attrs = _papplJobReadAttrsNoLock(job, doc_number);
+					// Document attributes
 
-  // Try reading a line from the file...
-  *value = NULL;
+      bin_add_ipp(bin, attrs);
+      ippDelete(attrs);
+    }
+    else
+    {
+      bin_add_ipp(bin, doc->attrs);
+    }
+  }
 
-  if (!cupsFileGets(fp, line, linesize))
-    return (NULL);
+  // Only active jobs need their job attributes...
+  bin_add_ipp(bin, job->state < IPP_JSTATE_STOPPED ? job->attrs : NULL);
 
-  // Got it, bump the line number...
-  (*linenum) ++;
+  _papplRWUnlock(job);
 
-  // If we have "something value" then split at the whitespace...
-  if ((ptr = strchr(line, ' ')) != NULL)
+  if (bin->error || (size_t)(bin->ptr - bin->start) > 0x7fffffff)
   {
-    *ptr++ = '\0';
-    *value = ptr;
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to save job %d to the system state.", job->job_id);
+    return (false);
   }
 
-  // Strip the trailing ">" for "<something value(s)>"
-  if (line[0] == '<' && *value && (ptr = *value + strlen(*value) - 1) >= *value && *ptr == '>')
-    *ptr = '\0';
+  // Update the record length and write it...
+  ptr      = bin->ptr;
+  bin->ptr = bin->start;
+  bin_add_int(bin, (long long)(ptr - bin->start - 4), 4);
+  bin->ptr = ptr;
 
-  return (line);
+  return (_papplFileWrite(fp, (char *)bin->start, (size_t)(bin->ptr - bin->start)));
 }
 
 
@@ -934,10 +1971,11 @@ read_line(cups_file_t *fp,		// I  - File
 // 'write_contact()' - Write an "xxx-contact" value.
 //
 
-static void
+static bool				// O - `true` on success, `false` on failure
 write_contact(cups_file_t     *fp,	// I - File
               pappl_contact_t *contact)	// I - Contact
 {
+  bool		ret = true;		// Return value
   size_t	num_options = 0;	// Number of options
   cups_option_t	*options = NULL;	// Options
 
@@ -949,8 +1987,166 @@ write_contact(cups_file_t     *fp,	// I - File
   if (contact->telephone[0])
     num_options = cupsAddOption("telephone", contact->telephone, num_options, &options);
 
-  write_options(fp, "Contact", num_options, options);
+  ret &= write_options(fp, "Contact", num_options, options);
+  cupsFreeOptions(num_options, options);
+
+  return (ret);
+}
+
+
+//
+// 'write_job()' - Write a job record.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_job(cups_file_t    *fp,		// I - File
+          pappl_system_t *system,	// I - System
+          pappl_job_t    *job)		// I - Job
+{
+  bool		ret = true;		// Return value
+  int		doc_number,		// Document number
+		impcompleted;		// Impressions completed
+  _pappl_doc_t	*doc;			// Document
+  size_t	num_options;		// Number of options
+  cups_option_t	*options = NULL;	// Options
+
+
+  _papplRWLockRead(job);
+
+  // Add basic job attributes...
+  num_options = 0;
+  num_options = cupsAddIntegerOption("id", job->job_id, num_options, &options);
+  num_options = cupsAddOption("name", job->name, num_options, &options);
+  num_options = cupsAddOption("username", job->username, num_options, &options);
+  for (doc_number = 1, doc = job->documents; doc_number <= job->num_documents; doc_number ++, doc ++)
+  {
+    char	name[32];		// Option name
+
+    if (doc->attrs || doc->attrs_data)
+    {
+      int	doc_attr_fd;		// Attribute file descriptor
+      char	doc_attr_filename[1024];// Attribute filename
+
+      // Save job attributes to file in spool directory...
+      if ((doc_attr_fd = papplJobOpenFile(job, doc_number, doc_attr_filename, sizeof(doc_attr_filename), system->directory, "ipp", /*format*/NULL, "w")) < 0)
+      {
+	papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create '%s' for document attributes: %s", doc_attr_filename, strerror(errno));
+	_papplRWUnlock(job);
+	cupsFreeOptions(num_options, options);
+	return (false);
+      }
+
+      if (doc->attrs_data)
+      {
+        // Attributes from a binary state file are already encoded...
+        if (write(doc_attr_fd, doc->attrs_data, doc->attrs_datalen) != (ssize_t)doc->attrs_datalen)
+        {
+	  papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to write '%s': %s", doc_attr_filename, strerror(errno));
+	  ret = false;
+	}
+      }
+      else if (ippWriteFile(doc_attr_fd, doc->attrs) != IPP_STATE_DATA)
+      {
+	papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to write '%s': %s", doc_attr_filename, strerror(errno));
+	ret = false;
+      }
+
+      if (close(doc_attr_fd))
+        ret = false;
+    }
+
+    if (doc->filename)
+    {
+      if (doc_number > 1)
+      {
+        snprintf(name, sizeof(name), "filename%d", doc_number);
+	num_options = cupsAddOption(name, doc->filename, num_options, &options);
+      }
+      else
+      {
+	num_options = cupsAddOption("filename", doc->filename, num_options, &options);
+      }
+    }
+
+    snprintf(name, sizeof(name), "state%d", doc_number);
+    num_options = cupsAddIntegerOption(name, doc->state, num_options, &options);
+
+    snprintf(name, sizeof(name), "state_reasons%d", doc_number);
+    num_options = cupsAddIntegerOption(name, doc->state_reasons, num_options, &options);
+
+    snprintf(name, sizeof(name), "created%d", doc_number);
+    num_options = add_time(name, doc->created, num_options, &options);
+
+    if (doc->processing)
+    {
+      snprintf(name, sizeof(name), "processing%d", doc_number);
+      num_options = add_time(name, doc->processing, num_options, &options);
+    }
+
+    if (doc->completed)
+    {
+      snprintf(name, sizeof(name), "completed%d", doc_number);
+      num_options = add_time(name, doc->completed, num_options, &options);
+    }
+  }
+
+  if (job->is_canceled)
+    num_options = cupsAddIntegerOption("state", (int)IPP_JSTATE_CANCELED, num_options, &options);
+  else if (job->state)
+    num_options = cupsAddIntegerOption("state", (int)job->state, num_options, &options);
+  if (job->state_reasons)
+    num_options = cupsAddIntegerOption("state_reasons", (int)job->state_reasons, num_options, &options);
+  if (job->created)
+    num_options = add_time("created", job->created, num_options, &options);
+  if (job->processing)
+    num_options = add_time("processing", job->processing, num_options, &options);
+  if (job->completed)
+    num_options = add_time("completed", job->completed, num_options, &options);
+  else if (job->is_canceled)
+    num_options = add_time("completed", time(NULL), num_options, &options);
+  if (job->impressions)
+    num_options = cupsAddIntegerOption("impressions", job->impressions, num_options, &options);
+  if ((impcompleted = _papplAtomicGet(&job->impcompleted)) != 0)
+    num_options = cupsAddIntegerOption("imcompleted", impcompleted, num_options, &options);
+
+  if (job->attrs)
+  {
+    int	attr_fd;		// Attribute file descriptor
+    char	job_attr_filename[1024];// Attribute filename
+
+    // Save job attributes to file in spool directory...
+    if (job->state < IPP_JSTATE_STOPPED)
+    {
+      if ((attr_fd = papplJobOpenFile(job, 0, job_attr_filename, sizeof(job_attr_filename), system->directory, "ipp", /*format*/NULL, "w")) < 0)
+      {
+        papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create '%s' for job attributes: %s", job_attr_filename, strerror(errno));
+        _papplRWUnlock(job);
+        cupsFreeOptions(num_options, options);
+        return (false);
+      }
+
+      if (ippWriteFile(attr_fd, job->attrs) != IPP_STATE_DATA)
+      {
+        papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to write '%s': %s", job_attr_filename, strerror(errno));
+        ret = false;
+      }
+
+      if (close(attr_fd))
+        ret = false;
+    }
+    else
+    {
+      // If job completed or aborted, remove job-attributes file...
+      papplJobOpenFile(job, /*doc_number*/0, job_attr_filename, sizeof(job_attr_filename), system->directory, "ipp", /*format*/NULL, /*mode*/"x");
+    }
+  }
+
+  ret &= write_options(fp, "Job", num_options, options);
   cupsFreeOptions(num_options, options);
+
+  _papplRWUnlock(job);
+
+  return (ret);
 }
 
 
@@ -958,12 +2154,13 @@ write_contact(cups_file_t     *fp,	// I - File
 // 'write_media_col()' - Write a media-col value...
 //
 
-static void
+static bool				// O - `true` on success, `false` on failure
 write_media_col(
     cups_file_t       *fp,		// I - File
     const char        *name,		// I - Attribute name
     pappl_media_col_t *media)		// I - Media value
 {
+  bool		ret = true;		// Return value
   size_t	num_options = 0;	// Number of options
   cups_option_t	*options = NULL;	// Options
 
@@ -993,8 +2190,10 @@ write_media_col(
   if (media->type[0])
     num_options = cupsAddOption("type", media->type, num_options, &options);
 
-  write_options(fp, name, num_options, options);
+  ret &= write_options(fp, name, num_options, options);
   cupsFreeOptions(num_options, options);
+
+  return (ret);
 }
 
 
@@ -1002,44 +2201,218 @@ write_media_col(
 // 'write_options()' - Write a CUPS options array value...
 //
 
-static void
+static bool				// O - `true` on success, `false` on failure
 write_options(cups_file_t   *fp,	// I - File
               const char    *name,	// I - Attribute name
               size_t    num_options,// I - Number of options
               cups_option_t *options)	// I - Options
 {
+  bool		ret = true;		// Return value
   const char	*start,			// Start of current subset
                 *ptr;			// Pointer into value
 
 
-  cupsFilePuts(fp, name);
+  ret &= _papplFilePuts(fp, name);
   while (num_options > 0)
   {
-    cupsFilePrintf(fp, " %s=\"", options->name);
+    ret &= _papplFilePrintf(fp, " %s=\"", options->name);
 
     for (start = options->value, ptr = start; *ptr; ptr ++)
     {
       if (*ptr == '\\' || *ptr == '\"')
       {
         if (ptr > start)
-          cupsFileWrite(fp, start, (size_t)(ptr - start));
+          ret &= _papplFileWrite(fp, start, (size_t)(ptr - start));
 
-	cupsFilePutChar(fp, '\\');
+	ret &= _papplFilePutChar(fp, '\\');
 	start = ptr;
       }
     }
 
     if (ptr > start)
-      cupsFileWrite(fp, start, (size_t)(ptr - start));
+      ret &= _papplFileWrite(fp, start, (size_t)(ptr - start));
 
-    cupsFilePutChar(fp, '\"');
+    ret &= _papplFilePutChar(fp, '\"');
 
     num_options --;
     options ++;
   }
 
   if (*name == '<')
-    cupsFilePuts(fp, ">\n");
+    ret &= _papplFilePuts(fp, ">\n");
   else
-    cupsFilePutChar(fp, '\n');
+    ret &= _papplFilePutChar(fp, '\n');
+
+  return (ret);
+}
+
+
+//
+// 'write_printer()' - Write the start of a printer record and its values.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_printer(cups_file_t     *fp,	// I - File
+              pappl_system_t  *system,	// I - System
+              pappl_printer_t *printer)	// I - Printer
+{
+  bool		ret = true;		// Return value
+  size_t	j;			// Looping var
+  size_t	num_options = 0;	// Number of options
+  cups_option_t	*options = NULL;	// Options
+
+
+  num_options = cupsAddIntegerOption("id", printer->printer_id, num_options, &options);
+  num_options = cupsAddOption("name", printer->name, num_options, &options);
+  num_options = cupsAddOption("did", printer->device_id ? printer->device_id : "", num_options, &options);
+  num_options = cupsAddOption("uri", printer->device_uri, num_options, &options);
+  num_options = cupsAddOption("driver", printer->driver_name, num_options, &options);
+
+  if (system->options & PAPPL_SOPTIONS_MULTI_QUEUE)
+    num_options = cupsAddIntegerOption("state", (int)printer->state, num_options, &options);
+
+  ret &= write_options(fp, "<Printer", num_options, options);
+  cupsFreeOptions(num_options, options);
+
+  if (printer->dns_sd_name)
+    ret &= _papplFilePutConf(fp, "DNSSDName", printer->dns_sd_name);
+  if (printer->location)
+    ret &= _papplFilePutConf(fp, "Location", printer->location);
+  if (printer->geo_location)
+    ret &= _papplFilePutConf(fp, "Geolocation", printer->geo_location);
+  if (printer->organization)
+    ret &= _papplFilePutConf(fp, "Organization", printer->organization);
+  if (printer->org_unit)
+    ret &= _papplFilePutConf(fp, "OrganizationalUnit", printer->org_unit);
+  ret &= write_contact(fp, &printer->contact);
+  if (printer->hold_new_jobs)
+    ret &= _papplFilePuts(fp, "HoldNewJobs\n");
+  if (printer->print_group)
+    ret &= _papplFilePutConf(fp, "PrintGroup", printer->print_group);
+  ret &= _papplFilePrintf(fp, "MaxActiveJobs %u\n", (unsigned)printer->max_active_jobs);
+  ret &= _papplFilePrintf(fp, "MaxCompletedJobs %u\n", (unsigned)printer->max_completed_jobs);
+  if (printer->max_resident_jobs)
+    ret &= _papplFilePrintf(fp, "MaxResidentJobs %u\n", (unsigned)printer->max_resident_jobs);
+  ret &= _papplFilePrintf(fp, "NextJobId %d\n", printer->next_job_id);
+  ret &= _papplFilePrintf(fp, "ImpressionsCompleted %d\n", _papplAtomicGet(&printer->impcompleted));
+  for (j = 0; j < cupsArrayGetCount(printer->pool_members); j ++)
+    ret &= _papplFilePrintf(fp, "PoolMember %d\n", ((pappl_printer_t *)cupsArrayGetElement(printer->pool_members, j))->printer_id);
+
+  if (printer->driver_data.copies_default > 1)
+    ret &= _papplFilePrintf(fp, "copies-default %d\n", printer->driver_data.copies_default);
+
+  if (printer->driver_data.finishings_default)
+  {
+    pappl_finishings_t fin;		// Current finishings value
+    const char	*prefix = "finishings-default ";
+					// Prefix for value
+
+    for (fin = PAPPL_FINISHINGS_PUNCH; fin <= PAPPL_FINISHINGS_STAPLE_DUAL_TOP; fin *= 2)
+    {
+      if (printer->driver_data.finishings_default & fin)
+      {
+        ret &= _papplFilePrintf(fp, "%s%s", prefix, _papplFinishingsString(fin));
+        prefix = ",";
+      }
+    }
+    ret &= _papplFilePuts(fp, "\n");
+  }
+
+  if (printer->driver_data.identify_default)
+    ret &= _papplFilePutConf(fp, "identify-actions-default", _papplIdentifyActionsString(printer->driver_data.identify_default));
+
+  if (printer->driver_data.mode_configured)
+    ret &= _papplFilePutConf(fp, "label-mode-configured", _papplLabelModeString(printer->driver_data.mode_configured));
+  if (printer->driver_data.tear_offset_configured)
+    ret &= _papplFilePrintf(fp, "label-tear-offset-configured %d\n", printer->driver_data.tear_offset_configured);
+
+  ret &= write_media_col(fp, "media-col-default", &printer->driver_data.media_default);
+  for (j = 0; j < (size_t)printer->driver_data.num_source; j ++)
+  {
+    if (printer->driver_data.media_ready[j].size_name[0])
+    {
+      char	name[128];		// Attribute name
+
+      snprintf(name, sizeof(name), "media-col-ready%u", (unsigned)j);
+      ret &= write_media_col(fp, name, printer->driver_data.media_ready + j);
+    }
+  }
+  if (printer->driver_data.handling_default)
+    ret &= _papplFilePutConf(fp, "multiple-document-handling-default", _papplHandlingString(printer->driver_data.handling_default));
+
+  if (printer->driver_data.orient_default)
+    ret &= _papplFilePutConf(fp, "orientation-requested-default", ippEnumString("orientation-requested", (int)printer->driver_data.orient_default));
+  if (printer->driver_data.bin_default && printer->driver_data.num_bin > 0)
+    ret &= _papplFilePutConf(fp, "output-bin-default", printer->driver_data.bin[printer->driver_data.bin_default]);
+
+  if (printer->driver_data.color_default)
+    ret &= _papplFilePutConf(fp, "print-color-mode-default", _papplColorModeString(printer->driver_data.color_default));
+  if (printer->driver_data.content_default)
+    ret &= _papplFilePutConf(fp, "print-content-optimize-default", _papplContentString(printer->driver_data.content_default));
+  if (printer->driver_data.darkness_default)
+    ret &= _papplFilePrintf(fp, "print-darkness-default %d\n", printer->driver_data.darkness_default);
+  if (printer->driver_data.quality_default)
+    ret &= _papplFilePutConf(fp, "print-quality-default", ippEnumString("print-quality", (int)printer->driver_data.quality_default));
+  if (printer->driver_data.scaling_default)
+    ret &= _papplFilePutConf(fp, "print-scaling-default", _papplScalingString(printer->driver_data.scaling_default));
+  if (printer->driver_data.speed_supported[1] > 0)
+    ret &= _papplFilePrintf(fp, "print-speed-default %d\n", printer->driver_data.speed_default);
+  if (printer->driver_data.darkness_supported > 0)
+    ret &= _papplFilePrintf(fp, "printer-darkness-configured %d\n", printer->driver_data.darkness_configured);
+  if (printer->driver_data.x_default)
+    ret &= _papplFilePrintf(fp, "printer-resolution-default %dx%ddpi\n", printer->driver_data.x_default, printer->driver_data.y_default);
+
+  if (printer->driver_data.sides_default)
+    ret &= _papplFilePutConf(fp, "sides-default", _papplSidesString(printer->driver_data.sides_default));
+  for (j = 0; j < (size_t)printer->driver_data.num_vendor; j ++)
+  {
+    char	defname[128],		// xxx-default name
+	      	defvalue[1024];		// xxx-default value
+
+    snprintf(defname, sizeof(defname), "%s-default", printer->driver_data.vendor[j]);
+    ippAttributeString(ippFindAttribute(printer->driver_attrs, defname, IPP_TAG_ZERO), defvalue, sizeof(defvalue));
+
+    ret &= _papplFilePutConf(fp, defname, defvalue);
+  }
+
+  return (ret);
+}
+
+
+//
+// 'write_system()' - Write the system values.
+//
+
+static bool				// O - `true` on success, `false` on failure
+write_system(cups_file_t    *fp,	// I - File
+             pappl_system_t *system)	// I - System
+{
+  bool		ret = true;		// Return value
+
+
+  if (system->dns_sd_name)
+    ret &= _papplFilePutConf(fp, "DNSSDName", system->dns_sd_name);
+  if (system->location)
+    ret &= _papplFilePutConf(fp, "Location", system->location);
+  if (system->geo_location)
+    ret &= _papplFilePutConf(fp, "Geolocation", system->geo_location);
+  if (system->organization)
+    ret &= _papplFilePutConf(fp, "Organization", system->organization);
+  if (system->org_unit)
+    ret &= _papplFilePutConf(fp, "OrganizationalUnit", system->org_unit);
+  ret &= write_contact(fp, &system->contact);
+  if (system->admin_group)
+    ret &= _papplFilePutConf(fp, "AdminGroup", system->admin_group);
+  if (system->default_print_group)
+    ret &= _papplFilePutConf(fp, "DefaultPrintGroup", system->default_print_group);
+  if (system->password_hash[0])
+    ret &= _papplFilePutConf(fp, "Password", system->password_hash);
+  ret &= _papplFilePrintf(fp, "DefaultPrinterID %d\n", system->default_printer_id);
+  ret &= _papplFilePrintf(fp, "MaxImageMemory %ld\n", (long)system->max_image_memory);
+  ret &= _papplFilePrintf(fp, "MaxImageSize %ld %d %d\n", (long)system->max_image_size, system->max_image_width, system->max_image_height);
+  ret &= _papplFilePrintf(fp, "MaxImageThreads %ld\n", (long)system->max_image_threads);
+  ret &= _papplFilePrintf(fp, "NextPrinterID %d\n", system->next_printer_id);
+  ret &= _papplFilePutConf(fp, "UUID", system->uuid);
+
+  return (ret);
 }
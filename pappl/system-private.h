@@ -18,6 +18,8 @@
 //
 
 #  define _PAPPL_MAX_LISTENERS	32	// Maximum number of listener sockets
+#  define _PAPPL_SAVE_MIN_DELAY	1	// Default minimum delay before saving state
+#  define _PAPPL_SAVE_MAX_DELAY	10	// Default maximum delay before saving state
 
 
 //
@@ -39,6 +41,12 @@ typedef struct _pappl_mime_inspector_s	// MIME inspectors
   void			*cbdata;		// Callback data
 } _pappl_mime_inspector_t;
 
+typedef struct _pappl_spool_work_s	// Background spool work item
+{
+  int			printer_id,		// Printer ID
+			job_id;			// Job ID
+} _pappl_spool_work_t;
+
 typedef struct _pappl_infrap_s		// Cloud/INFRA Provider
 {
   char			*name,			// Provider name
@@ -65,11 +73,23 @@ struct _pappl_system_s			// System data
   bool			is_running;		// Is the system running?
   time_t		start_time,		// Startup time
 			config_time,		// Time of last config change
-			clean_time,		// Next clean time
 			shutdown_time;		// Shutdown requested?
   cups_mutex_t		config_mutex;		// Mutex for configuration changes
   size_t		config_changes,		// Number of configuration changes
-			save_changes;		// Number of saved changes
+			save_changes,		// Number of saved changes
+			state_changes;		// Change number of last system config change
+  cups_cond_t		save_cond;		// Condition for unsaved changes
+  cups_thread_t		save_thread;		// Background save thread
+  bool			save_running;		// Is the background save thread running?
+  int			save_min_delay,		// Minimum delay before saving changes
+			save_max_delay;		// Maximum delay before saving changes
+  pappl_sysmetrics_t	metrics;		// System metrics
+  char			*journal_filename;	// State file for journal, if any
+  size_t		journal_changes,	// Change number of last save
+			journal_size,		// Size of journal file
+			snapshot_size;		// Size of state file
+  void			*snapshot_data;		// Binary state file data, if any
+  size_t		snapshot_datalen;	// Length of binary state file data
   char			*uuid,			// "system-uuid" value
 			*name,			// "system-name" value
 			*dns_sd_name,		// "system-dns-sd-name" value
@@ -88,6 +108,19 @@ struct _pappl_system_s			// System data
   char			*footer_html;		// Footer HTML for web interface
   char			*server_header;		// Server: header value
   char			*directory;		// Spool directory
+  char			*spool_memdir;		// Memory spool directory, if any
+  size_t		spool_memmax,		// Maximum size of a memory-spooled document
+			spool_memtotal,		// Maximum size of all memory-spooled documents
+			spool_memused;		// Size of all memory-spooled documents
+  pappl_spool_sync_t	spool_sync;		// Spool file synchronization policy
+  cups_array_t		*spool_files,		// Shared document files by filename
+			*spool_hashes;		// Shared document files by hash
+  cups_array_t		*spool_queue,		// Background spool work queue
+			*spool_reap_files,	// Files to remove in the background
+			*spool_reap_jobs;	// Jobs to free in the background
+  cups_cond_t		spool_cond;		// Condition for spool work
+  cups_thread_t		spool_thread;		// Background spool thread
+  bool			spool_running;		// Is the background spool thread running?
   cups_mutex_t		log_mutex;		// Log mutex
   char			*log_file;		// Log filename, if any
   int			log_fd;			// Log file descriptor, if any
@@ -163,8 +196,14 @@ struct _pappl_system_s			// System data
   cups_mutex_t		subscription_mutex;	// Subscription mutex
 
   cups_array_t		*timers;		// Timers array
-
-  size_t		max_image_size;		// Maximum image file size (uncompressed)
+  cups_mutex_t		job_timer_mutex;	// Mutex for job timers
+  _pappl_heap_t		*job_timers;		// Heap of printers with job timers
+  time_t		wake_time;		// Next wakeup time for run loop
+  int			wake_pipe[2];		// Pipe for waking the run loop
+
+  size_t		max_image_memory,	// Maximum memory for decoding an image
+			max_image_size,		// Maximum image file size (uncompressed)
+			max_image_threads;	// Maximum threads for rendering an image
   int			max_image_width,	// Maximum image file width
 			max_image_height;	// Maximum image file height
 
@@ -203,7 +242,9 @@ extern void		_papplSystemAddPrinterIcons(pappl_system_t *system, pappl_printer_t
 extern bool		_papplSystemAddSubscription(pappl_system_t *system, pappl_subscription_t *sub, int sub_id) _PAPPL_PRIVATE;
 
 extern void		_papplSystemCleanSubscriptions(pappl_system_t *system, bool clean_all) _PAPPL_PRIVATE;
+extern bool		_papplSystemCompressJob(pappl_system_t *system, int printer_id, int job_id) _PAPPL_PRIVATE;
 extern void		_papplSystemConfigChanged(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemObjectChanged(pappl_system_t *system, size_t *state_changes) _PAPPL_PRIVATE;
 
 extern void		_papplSystemExportVersions(pappl_system_t *system, ipp_t *ipp, ipp_tag_t group_tag, cups_array_t *ra);
 
@@ -216,16 +257,18 @@ extern bool		_papplSystemIsShutdownNoLock(pappl_system_t *system) _PAPPL_PRIVATE
 
 extern char		*_papplSystemMakeUUID(pappl_system_t *system, const char *printer_name, int job_id, char *buffer, size_t bufsize) _PAPPL_PRIVATE;
 
-extern void		_papplSystemNeedClean(pappl_system_t *system) _PAPPL_PRIVATE;
-
 extern void		_papplSystemProcessIPP(pappl_client_t *client) _PAPPL_PRIVATE;
 
 extern bool		_papplSystemRegisterDNSSDNoLock(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemRunJobTimers(pappl_system_t *system, time_t curtime) _PAPPL_PRIVATE;
+extern void		*_papplSystemRunSpool(pappl_system_t *system) _PAPPL_PRIVATE;
 
 extern void		_papplSystemSetHostNameNoLock(pappl_system_t *system, const char *value) _PAPPL_PRIVATE;
+extern time_t		_papplSystemSetWakeTime(pappl_system_t *system, time_t next) _PAPPL_PRIVATE;
 extern void		_papplSystemStopAllExtCommands(pappl_system_t *system) _PAPPL_PRIVATE;
 
 extern void		_papplSystemUnregisterDNSSDNoLock(pappl_system_t *system) _PAPPL_PRIVATE;
+extern void		_papplSystemUpdateJobTimer(pappl_system_t *system, pappl_printer_t *printer, time_t timer_time) _PAPPL_PRIVATE;
 
 extern void		_papplSystemWebAddPrinter(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
 extern void		_papplSystemWebConfig(pappl_client_t *client, pappl_system_t *system) _PAPPL_PRIVATE;
@@ -27,6 +27,8 @@ static bool	restart_logging = false;// Restart logging?
 
 static void	log_dns_sd_error(pappl_system_t *system, const char *message);
 static void	make_attributes(pappl_system_t *system);
+static void	save_state(pappl_system_t *system);
+static void	*save_state_thread(pappl_system_t *system);
 static void	sighup_handler(int sig);
 static void	sigterm_handler(int sig);
 
@@ -82,15 +84,7 @@ void
 _papplSystemConfigChanged(
     pappl_system_t *system)		// I - System
 {
-  cupsMutexLock(&system->config_mutex);
-
-  if (system->is_running)
-  {
-    system->config_time = time(NULL);
-    system->config_changes ++;
-  }
-
-  cupsMutexUnlock(&system->config_mutex);
+  _papplSystemObjectChanged(system, &system->state_changes);
 }
 
 
@@ -103,6 +97,7 @@ _papplSystemConfigChanged(
 // The "options" argument specifies which options are enabled for the server:
 //
 // - `PAPPL_SOPTIONS_NONE`: No options.
+// - `PAPPL_SOPTIONS_BINARY_STATE`: Save the system state in binary format.
 // - `PAPPL_SOPTIONS_DNSSD_HOST`: When resolving DNS-SD service name collisions,
 //   use the DNS-SD hostname instead of a serial number or UUID.
 // - `PAPPL_SOPTIONS_WEB_LOG`: Include the log file web page.
@@ -110,6 +105,7 @@ _papplSystemConfigChanged(
 // - `PAPPL_SOPTIONS_WEB_NETWORK`: Include the network settings web page.
 // - `PAPPL_SOPTIONS_RAW_SOCKET`: Accept jobs via raw sockets starting on port
 //   9100 (all but Windows).
+// - `PAPPL_SOPTIONS_SYNC_STATE`: Flush the system state to disk when saving.
 // - `PAPPL_SOPTIONS_WEB_REMOTE`: Allow remote queue management.
 // - `PAPPL_SOPTIONS_WEB_SECURITY`: Include the security settings web page.
 // - `PAPPL_SOPTIONS_WEB_INTERFACE`: Include the standard printer and job monitoring
@@ -177,10 +173,13 @@ papplSystemCreate(
   cupsMutexInit(&system->session_mutex);
   cupsMutexInit(&system->clients_mutex);
   cupsMutexInit(&system->config_mutex);
+  cupsCondInit(&system->save_cond);
+  cupsCondInit(&system->spool_cond);
   cupsMutexInit(&system->log_mutex);
   cupsMutexInit(&system->subscription_mutex);
   cupsCondInit(&system->subscription_cond);
   cupsMutexInit(&system->ext_mutex);
+  cupsMutexInit(&system->job_timer_mutex);
 
 #if _WIN32
   options &= (pappl_soptions_t)~PAPPL_SOPTIONS_RAW_SOCKET;
@@ -193,9 +192,13 @@ papplSystemCreate(
   system->port              = port;
   system->directory         = spooldir ? strdup(spooldir) : NULL;
   system->log_fd            = -1;
+  system->wake_pipe[0]      = -1;
+  system->wake_pipe[1]      = -1;
   system->log_file          = logfile ? strdup(logfile) : NULL;
   system->log_level         = loglevel;
   system->log_max_size      = 1024 * 1024;
+  system->save_min_delay    = _PAPPL_SAVE_MIN_DELAY;
+  system->save_max_delay    = _PAPPL_SAVE_MAX_DELAY;
   system->next_client       = 1;
   system->next_printer_id   = 1;
   system->subtypes          = subtypes ? strdup(subtypes) : NULL;
@@ -206,6 +209,8 @@ papplSystemCreate(
   system->ext_next_number   = 1;
 
   papplSystemSetMaxClients(system, 0);
+  papplSystemSetMaxImageMemory(system, 0);
+  papplSystemSetMaxImageThreads(system, 0);
   papplSystemSetMaxImageSize(system, 0, 0, 0);
 
   if (!system->name || !system->dns_sd_name || (spooldir && !system->directory) || (logfile && !system->log_file) || (subtypes && !system->subtypes) || (auth_service && !system->auth_service))
@@ -354,6 +359,25 @@ papplSystemDelete(
 
   cupsArrayDelete(system->printers);
 
+  _papplHeapDelete(system->job_timers);
+  cupsMutexDestroy(&system->job_timer_mutex);
+
+  if (system->snapshot_data)
+  {
+    // Free the binary state file data after the jobs that reference it...
+#if _WIN32
+    free(system->snapshot_data);
+#else
+    munmap(system->snapshot_data, system->snapshot_datalen);
+#endif // _WIN32
+  }
+
+  if (system->wake_pipe[0] >= 0)
+  {
+    close(system->wake_pipe[0]);
+    close(system->wake_pipe[1]);
+  }
+
   free(system->uuid);
   free(system->name);
   free(system->dns_sd_name);
@@ -361,6 +385,17 @@ papplSystemDelete(
   free(system->domain_path);
   free(system->server_header);
   free(system->directory);
+  cupsArrayDelete(system->spool_hashes);
+  cupsArrayDelete(system->spool_files);
+  cupsArrayDelete(system->spool_queue);
+  cupsArrayDelete(system->spool_reap_files);
+  cupsArrayDelete(system->spool_reap_jobs);
+  if (system->spool_memdir)
+  {
+    rmdir(system->spool_memdir);
+    free(system->spool_memdir);
+  }
+  free(system->journal_filename);
   free(system->log_file);
   free(system->subtypes);
   free(system->auth_scheme);
@@ -401,6 +436,8 @@ papplSystemDelete(
   cupsRWDestroy(&system->rwlock);
   cupsRWDestroy(&system->printers_rwlock);
   cupsMutexDestroy(&system->session_mutex);
+  cupsCondDestroy(&system->save_cond);
+  cupsCondDestroy(&system->spool_cond);
   cupsMutexDestroy(&system->config_mutex);
   cupsMutexDestroy(&system->log_mutex);
 
@@ -449,6 +486,33 @@ _papplSystemMakeUUID(
 }
 
 
+//
+// '_papplSystemObjectChanged()' - Mark the saved state of an object as changed.
+//
+// The "state_changes" argument points to the system, printer, or job member
+// that records the configuration change number so that the next save can
+// write just the objects that changed.
+//
+
+void
+_papplSystemObjectChanged(
+    pappl_system_t *system,		// I - System
+    size_t         *state_changes)	// I - Object's change number
+{
+  cupsMutexLock(&system->config_mutex);
+
+  if (system->is_running)
+  {
+    system->config_time = time(NULL);
+    *state_changes      = ++ system->config_changes;
+
+    cupsCondBroadcast(&system->save_cond);
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+}
+
+
 //
 // 'papplSystemRun()' - Run the printer application.
 //
@@ -464,6 +528,9 @@ papplSystemRun(pappl_system_t *system)	// I - System
 			count;		// Number of listeners that fired
   int			pcount,		// Poll count
 			ptimeout;	// Poll timeout
+  struct pollfd		pfds[_PAPPL_MAX_LISTENERS + 1];
+					// Listener sockets and wakeup pipe
+  nfds_t		num_pfds;	// Number of poll file descriptors
   pappl_client_t	*client;	// New client
   char			header[256];	// Server: header value
   size_t		dns_sd_host_changes;
@@ -683,6 +750,48 @@ papplSystemRun(pappl_system_t *system)	// I - System
     }
   }
 
+#if !_WIN32
+  // Create a pipe for waking up the run loop when a job timer is added...
+  if (system->wake_pipe[0] < 0 && !papplCreatePipe(system->wake_pipe, false))
+  {
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create wakeup pipe: %s", strerror(errno));
+    system->wake_pipe[0] = system->wake_pipe[1] = -1;
+  }
+#endif // !_WIN32
+
+  // Start the background save thread as needed...
+  if (system->save_cb)
+  {
+    system->save_running = true;
+
+    if ((system->save_thread = cupsThreadCreate((void *(*)(void *))save_state_thread, system)) == CUPS_THREAD_INVALID)
+    {
+      // Unable to create save thread, save when shutting down...
+      papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create save thread: %s", strerror(errno));
+      system->save_running = false;
+    }
+  }
+
+  // Start the background spool thread for removing old jobs and compressing
+  // documents...
+  cupsMutexLock(&system->config_mutex);
+  if (!system->spool_queue)
+    system->spool_queue = cupsArrayNew(/*cb*/NULL, /*cbdata*/NULL, /*hash_cb*/NULL, /*hashsize*/0, /*copy_cb*/NULL, (cups_afree_cb_t)free);
+
+  system->spool_running = system->spool_queue != NULL;
+  cupsMutexUnlock(&system->config_mutex);
+
+  if (system->spool_running && (system->spool_thread = cupsThreadCreate((void *(*)(void *))_papplSystemRunSpool, system)) == CUPS_THREAD_INVALID)
+  {
+    // Unable to create spool thread, remove old jobs immediately and leave
+    // documents uncompressed...
+    papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to create spool thread: %s", strerror(errno));
+
+    cupsMutexLock(&system->config_mutex);
+    system->spool_running = false;
+    cupsMutexUnlock(&system->config_mutex);
+  }
+
   // Loop until we are shutdown or have a hard error...
   papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Entering run loop.");
 
@@ -712,25 +821,50 @@ papplSystemRun(pappl_system_t *system)	// I - System
     if ((timer = (_pappl_timer_t *)cupsArrayGetFirst(system->timers)) != NULL && timer->next < next)
       next = timer->next;
 
-    if (system->clean_time && system->clean_time < next)
-      next = system->clean_time;
-
     if (subtime < next && cupsArrayGetCount(system->subscriptions) > 0)
       next = subtime;
 
     _papplRWUnlock(system);
 
+    next = _papplSystemSetWakeTime(system, next);
+
     if (next <= curtime.tv_sec)
       ptimeout = 0;
     else
       ptimeout = 1000 * (int)(next - curtime.tv_sec) - (int)curtime.tv_usec / 1000;
 
-    if ((pcount = poll(system->listeners, (nfds_t)system->num_listeners, ptimeout)) < 0 && errno != EINTR && errno != EAGAIN)
+    memcpy(pfds, system->listeners, system->num_listeners * sizeof(struct pollfd));
+    num_pfds = (nfds_t)system->num_listeners;
+
+#if !_WIN32
+    if (system->wake_pipe[0] >= 0)
+    {
+      pfds[num_pfds].fd      = system->wake_pipe[0];
+      pfds[num_pfds].events  = POLLIN;
+      pfds[num_pfds].revents = 0;
+      num_pfds ++;
+    }
+#endif // !_WIN32
+
+    if ((pcount = poll(pfds, num_pfds, ptimeout)) < 0 && errno != EINTR && errno != EAGAIN)
     {
       papplLog(system, PAPPL_LOGLEVEL_ERROR, "Unable to accept new connections: %s", strerror(errno));
       break;
     }
 
+#if !_WIN32
+    if (pcount > 0 && num_pfds > system->num_listeners && (pfds[system->num_listeners].revents & POLLIN))
+    {
+      // Woken up for a job timer...
+      char	buffer[256];		// Wakeup bytes
+
+      if (read(system->wake_pipe[0], buffer, sizeof(buffer)) < 0)
+        papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Unable to read wakeup pipe: %s", strerror(errno));
+
+      pcount --;
+    }
+#endif // !_WIN32
+
     if (pcount > 0)
     {
       // Accept client connections as needed...
@@ -738,7 +872,7 @@ papplSystemRun(pappl_system_t *system)	// I - System
 
       for (i = 0; i < (size_t)system->num_listeners; i ++)
       {
-	if (system->listeners[i].revents & POLLIN)
+	if (pfds[i].revents & POLLIN)
 	{
 	  if ((client = _papplClientCreate(system, (int)system->listeners[i].fd)) != NULL)
 	  {
@@ -808,24 +942,6 @@ papplSystemRun(pappl_system_t *system)	// I - System
       system->dns_sd_host_changes  = dns_sd_host_changes;
     }
 
-    _papplRWUnlock(system);
-
-    cupsMutexLock(&system->config_mutex);
-    save_changes = system->config_changes > system->save_changes;
-    cupsMutexUnlock(&system->config_mutex);
-
-    if (save_changes)
-    {
-      system->save_changes = system->config_changes;
-
-      if (system->save_cb)
-      {
-        // Save the configuration...
-	(system->save_cb)(system, system->save_cbdata);
-      }
-    }
-
-    _papplRWLockRead(system);
     if (system->idle_shutdown && (time(NULL) - idletime) >= system->idle_shutdown)
     {
       // Possible idle shutdown...
@@ -871,7 +987,7 @@ papplSystemRun(pappl_system_t *system)	// I - System
       {
 	printer = (pappl_printer_t *)cupsArrayGetElement(system->printers, i);
 
-	if (printer->processing_job)
+	if (printer->processing_job || printer->pool_processing)
 	  break;
       }
       cupsRWUnlock(&system->printers_rwlock);
@@ -901,10 +1017,10 @@ papplSystemRun(pappl_system_t *system)	// I - System
     }
     _papplRWUnlock(system);
 
-    // Clean out old jobs and subscriptions...
-    if (system->clean_time && curtime.tv_sec >= system->clean_time)
-      papplSystemCleanJobs(system);
+    // Run job timers to release held jobs and clean out old jobs...
+    _papplSystemRunJobTimers(system, curtime.tv_sec);
 
+    // Clean out old subscriptions...
     if (curtime.tv_sec >= subtime)
     {
       _papplSystemCleanSubscriptions(system, false);
@@ -930,6 +1046,24 @@ papplSystemRun(pappl_system_t *system)	// I - System
     // Remove advertising via DNS-SD as needed...
     if (printer->dns_sd_name)
       _papplPrinterUnregisterDNSSDNoLock(printer);
+
+    // Move documents in the memory spool to the spool directory...
+    if (system->spool_memdir)
+    {
+      size_t		j;		// Looping var
+      pappl_job_t	*job;		// Current job
+
+      _papplRWLockRead(printer);
+      for (j = 0, jcount = cupsArrayGetCount(printer->active_jobs); j < jcount; j ++)
+      {
+        job = (pappl_job_t *)cupsArrayGetElement(printer->active_jobs, j);
+
+        _papplRWLockWrite(job);
+        _papplJobSpillFilesNoLock(job);
+        _papplRWUnlock(job);
+      }
+      _papplRWUnlock(printer);
+    }
   }
   cupsRWUnlock(&system->printers_rwlock);
 
@@ -937,20 +1071,35 @@ papplSystemRun(pappl_system_t *system)	// I - System
 
   _papplRWUnlock(system);
 
+  // Stop the background save thread and save any remaining changes...
+  if (system->save_running)
+  {
+    cupsMutexLock(&system->config_mutex);
+    system->save_running = false;
+    cupsCondBroadcast(&system->save_cond);
+    cupsMutexUnlock(&system->config_mutex);
+
+    cupsThreadWait(system->save_thread);
+  }
+
+  // Stop the background spool thread...
+  if (system->spool_running)
+  {
+    cupsMutexLock(&system->config_mutex);
+    system->spool_running = false;
+    cupsCondBroadcast(&system->spool_cond);
+    cupsMutexUnlock(&system->config_mutex);
+
+    cupsThreadWait(system->spool_thread);
+  }
+
   cupsMutexLock(&system->config_mutex);
   save_changes = system->config_changes > system->save_changes;
+  system->save_changes = system->config_changes;
   cupsMutexUnlock(&system->config_mutex);
 
   if (save_changes)
-  {
-    system->save_changes = system->config_changes;
-
-    if (system->save_cb)
-    {
-      // Save the configuration...
-      (system->save_cb)(system, system->save_cbdata);
-    }
-  }
+    save_state(system);
 
   if ((system->options & PAPPL_SOPTIONS_USB_PRINTER) && (printer = papplSystemFindPrinter(system, NULL, system->default_printer_id, NULL)) != NULL)
   {
@@ -1132,6 +1281,101 @@ make_attributes(pappl_system_t *system)	// I - System
 }
 
 
+//
+// 'save_state()' - Save the system state using the save callback.
+//
+
+static void
+save_state(pappl_system_t *system)	// I - System
+{
+  struct timeval	starttime,	// Start time
+			endtime;	// End time
+  size_t		msecs;		// Milliseconds spent saving
+
+
+  if (!system->save_cb)
+    return;
+
+  gettimeofday(&starttime, NULL);
+
+  (system->save_cb)(system, system->save_cbdata);
+
+  gettimeofday(&endtime, NULL);
+
+  msecs = (size_t)(1000 * (endtime.tv_sec - starttime.tv_sec) + (endtime.tv_usec - starttime.tv_usec) / 1000);
+
+  cupsMutexLock(&system->config_mutex);
+  system->metrics.save_requests ++;
+  system->metrics.save_msecs += msecs;
+  if (msecs > system->metrics.save_max_msecs)
+    system->metrics.save_max_msecs = msecs;
+  cupsMutexUnlock(&system->config_mutex);
+
+  papplLog(system, PAPPL_LOGLEVEL_DEBUG, "Saved system state in %u milliseconds.", (unsigned)msecs);
+}
+
+
+//
+// 'save_state_thread()' - Save system state changes in the background.
+//
+// Changes are coalesced until no changes have been made for the minimum save
+// delay or the oldest unsaved change reaches the maximum save delay, so that
+// a slow filesystem never blocks the main loop.
+//
+
+static void *				// O - Thread exit status
+save_state_thread(
+    pappl_system_t *system)		// I - System
+{
+  time_t	curtime,		// Current time
+		first_time = 0,		// Time of oldest unsaved change
+		save_time;		// Time to save changes
+
+
+  cupsMutexLock(&system->config_mutex);
+
+  while (system->save_running)
+  {
+    if (system->config_changes <= system->save_changes)
+    {
+      // Wait for changes...
+      first_time = 0;
+      cupsCondWait(&system->save_cond, &system->config_mutex, 0.0);
+      continue;
+    }
+
+    curtime = time(NULL);
+
+    if (!first_time)
+      first_time = curtime;
+
+    // Wait for changes to settle, but not past the maximum delay...
+    save_time = system->config_time + system->save_min_delay;
+
+    if (save_time > (first_time + system->save_max_delay))
+      save_time = first_time + system->save_max_delay;
+
+    if (curtime < save_time)
+    {
+      cupsCondWait(&system->save_cond, &system->config_mutex, (double)(save_time - curtime));
+      continue;
+    }
+
+    // Save the changes...
+    system->save_changes = system->config_changes;
+    first_time           = 0;
+
+    cupsMutexUnlock(&system->config_mutex);
+    save_state(system);
+    cupsMutexLock(&system->config_mutex);
+  }
+
+  cupsMutexUnlock(&system->config_mutex);
+
+  return (NULL);
+}
+
+
 //
 // 'sighup_handler()' - SIGHUP handler
 //
@@ -73,10 +73,26 @@ enum pappl_soptions_e			// System option bits
   PAPPL_SOPTIONS_MULTI_DOCUMENT_JOBS = 0x1000,	// Enable multiple document jobs
   PAPPL_SOPTIONS_INFRA_PROXY = 0x2000,		// Enable shared infrastructure proxy features
   PAPPL_SOPTIONS_INFRA_SERVER = 0x4000,		// Enable shared infrastructure printer/system features
-  PAPPL_SOPTIONS_NO_FILTERS = 0x8000		// Disable default file filters
+  PAPPL_SOPTIONS_NO_FILTERS = 0x8000,		// Disable default file filters
+  PAPPL_SOPTIONS_BINARY_STATE = 0x10000,	// Save system state in binary format
+  PAPPL_SOPTIONS_SYNC_STATE = 0x20000		// Flush system state to disk when saving
 };
 typedef unsigned pappl_soptions_t;	// Bitfield for system options
 
+typedef enum pappl_spool_sync_e		// Spool file synchronization policy
+{
+  PAPPL_SPOOL_SYNC_NONE,			// Let the operating system flush spool files (default)
+  PAPPL_SPOOL_SYNC_CLOSE,			// Flush spool files to disk before accepting documents
+  PAPPL_SPOOL_SYNC_WRITE			// Flush spool files to disk as they are written
+} pappl_spool_sync_t;
+
+typedef struct pappl_sysmetrics_s	// System metrics
+{
+  size_t	save_requests;			// Total number of state saves
+  size_t	save_msecs;			// Total number of milliseconds spent saving state
+  size_t	save_max_msecs;			// Longest state save in milliseconds
+} pappl_sysmetrics_t;
+
 typedef struct pappl_version_s		// Firmware version information
 {
   char			name[64];		// "xxx-firmware-name" value
@@ -204,9 +220,13 @@ extern int		papplSystemGetIdleShutdown(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetLocation(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern pappl_loglevel_t	papplSystemGetLogLevel(pappl_system_t *system) _PAPPL_PUBLIC;
 extern size_t		papplSystemGetMaxClients(pappl_system_t *system) _PAPPL_PUBLIC;
+extern size_t		papplSystemGetMaxImageMemory(pappl_system_t *system) _PAPPL_PUBLIC;
 extern size_t		papplSystemGetMaxImageSize(pappl_system_t *system, int *max_width, int *max_height) _PAPPL_PUBLIC;
+extern size_t		papplSystemGetMaxImageThreads(pappl_system_t *system) _PAPPL_PUBLIC;
 extern size_t		papplSystemGetMaxLogSize(pappl_system_t *system) _PAPPL_PUBLIC;
 extern size_t		papplSystemGetMaxSubscriptions(pappl_system_t *system) _PAPPL_PUBLIC;
+extern size_t		papplSystemGetMemorySpool(pappl_system_t *system, size_t *max_total) _PAPPL_PUBLIC;
+extern pappl_sysmetrics_t *papplSystemGetMetrics(pappl_system_t *system, pappl_sysmetrics_t *metrics) _PAPPL_PUBLIC;
 extern char		*papplSystemGetName(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern int		papplSystemGetNextPrinterID(pappl_system_t *system) _PAPPL_PUBLIC;
 extern size_t		papplSystemGetNumberOfPrinters(pappl_system_t *system) _PAPPL_PUBLIC;
@@ -214,8 +234,10 @@ extern pappl_soptions_t	papplSystemGetOptions(pappl_system_t *system) _PAPPL_PUB
 extern char		*papplSystemGetOrganization(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplSystemGetOrganizationalUnit(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
 extern char		*papplSystemGetPassword(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern int		papplSystemGetSaveDelay(pappl_system_t *system, int *max_delay) _PAPPL_PUBLIC;
 extern const char	*papplSystemGetServerHeader(pappl_system_t *system) _PAPPL_PUBLIC;
 extern char		*papplSystemGetSessionKey(pappl_system_t *system, char *buffer, size_t bufsize) _PAPPL_PUBLIC;
+extern pappl_spool_sync_t papplSystemGetSpoolSync(pappl_system_t *system) _PAPPL_PUBLIC;
 extern bool		papplSystemGetTLSOnly(pappl_system_t *system) _PAPPL_PUBLIC;
 extern const char	*papplSystemGetUUID(pappl_system_t *system) _PAPPL_PUBLIC;
 extern size_t		papplSystemGetVersions(pappl_system_t *system, size_t max_versions, pappl_version_t *versions) _PAPPL_PUBLIC;
@@ -252,9 +274,12 @@ extern void		papplSystemSetIdleShutdown(pappl_system_t *system, int seconds) _PA
 extern void		papplSystemSetLocation(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetLogLevel(pappl_system_t *system, pappl_loglevel_t loglevel) _PAPPL_PUBLIC;
 extern void		papplSystemSetMaxClients(pappl_system_t *system, size_t max_clients) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxImageMemory(pappl_system_t *system, size_t max_memory) _PAPPL_PUBLIC;
 extern void		papplSystemSetMaxImageSize(pappl_system_t *system, size_t max_size, int max_width, int max_height) _PAPPL_PUBLIC;
+extern void		papplSystemSetMaxImageThreads(pappl_system_t *system, size_t max_threads) _PAPPL_PUBLIC;
 extern void		papplSystemSetMaxLogSize(pappl_system_t *system, size_t max_size) _PAPPL_PUBLIC;
 extern void		papplSystemSetMaxSubscriptions(pappl_system_t *system, size_t max_subscriptions) _PAPPL_PUBLIC;
+extern bool		papplSystemSetMemorySpool(pappl_system_t *system, const char *directory, size_t max_size, size_t max_total) _PAPPL_PUBLIC;
 extern void		papplSystemSetMIMECallback(pappl_system_t *system, pappl_mime_cb_t cb, void *data) _PAPPL_PUBLIC;
 extern void		papplSystemSetNetworkCallbacks(pappl_system_t *system, pappl_network_get_cb_t get_cb, pappl_network_set_cb_t set_cb, void *cb_data) _PAPPL_PUBLIC;
 extern void		papplSystemSetNextPrinterID(pappl_system_t *system, int next_printer_id) _PAPPL_PUBLIC;
@@ -265,6 +290,8 @@ extern void		papplSystemSetPassword(pappl_system_t *system, const char *hash) _P
 extern void		papplSystemSetPrinterDrivers(pappl_system_t *system, size_t num_drivers, pappl_pr_driver_t *drivers, pappl_pr_autoadd_cb_t autoadd_cb, pappl_pr_create_cb_t create_cb, pappl_pr_driver_cb_t driver_cb, void *data) _PAPPL_PUBLIC;
 extern void		papplSystemSetRegisterCallbacks(pappl_system_t *system, pappl_pr_register_cb_t reg_cb, pappl_pr_deregister_cb_t dereg_cb, void *data) _PAPPL_PUBLIC;
 extern void		papplSystemSetSaveCallback(pappl_system_t *system, pappl_save_cb_t cb, void *data) _PAPPL_PUBLIC;
+extern void		papplSystemSetSaveDelay(pappl_system_t *system, int min_delay, int max_delay) _PAPPL_PUBLIC;
+extern void		papplSystemSetSpoolSync(pappl_system_t *system, pappl_spool_sync_t sync) _PAPPL_PUBLIC;
 extern void		papplSystemSetUUID(pappl_system_t *system, const char *value) _PAPPL_PUBLIC;
 extern void		papplSystemSetVersions(pappl_system_t *system, size_t num_versions, pappl_version_t *versions) _PAPPL_PUBLIC;
 extern void		papplSystemSetWiFiCallbacks(pappl_system_t *system, pappl_wifi_join_cb_t join_cb, pappl_wifi_list_cb_t list_cb, pappl_wifi_status_cb_t status_cb, void *data) _PAPPL_PUBLIC;
@@ -10,11 +10,23 @@
 #include "base-private.h"
 
 
+//
+// Local types...
+//
+
+typedef struct _pappl_ipp_buffer_s	// IPP message buffer
+{
+  const ipp_uchar_t	*ptr,		// Current position in buffer
+			*end;		// End of buffer
+} _pappl_ipp_buffer_t;
+
+
 //
 // Local functions...
 //
 
 static cups_bool_t filter_cb(_pappl_ipp_filter_t *filter, ipp_t *dst, ipp_attribute_t *attr);
+static ssize_t	read_cb(_pappl_ipp_buffer_t *buffer, ipp_uchar_t *data, size_t bytes);
 
 
 //
@@ -245,6 +257,33 @@ papplGetTempDir(void)
 }
 
 
+//
+// '_papplIPPReadBuffer()' - Read an IPP message from a buffer.
+//
+// The attributes in the buffer are added to the "ipp" message.
+//
+
+bool					// O - `true` on success, `false` on error
+_papplIPPReadBuffer(
+    ipp_t             *ipp,		// I - IPP message
+    const ipp_uchar_t *data,		// I - Encoded IPP message
+    size_t            datalen)		// I - Length of encoded IPP message
+{
+  _pappl_ipp_buffer_t	buffer;		// Message buffer
+
+
+  if (!ipp || !data || datalen == 0)
+    return (false);
+
+  buffer.ptr = data;
+  buffer.end = data + datalen;
+
+  ippSetState(ipp, IPP_STATE_IDLE);
+
+  return (ippReadIO(&buffer, (ipp_io_cb_t)read_cb, /*blocking*/true, /*parent*/NULL, ipp) == IPP_STATE_DATA);
+}
+
+
 //
 // '_papplIsEqual()' - Compare two strings for equality in constant time.
 //
@@ -295,3 +334,22 @@ filter_cb(_pappl_ipp_filter_t *filter,	// I - Filter parameters
   // Otherwise filter attributes by name...
   return (!filter->ra || cupsArrayFind(filter->ra, (void *)name) != NULL);
 }
+
+
+//
+// 'read_cb()' - Read data from an IPP message buffer.
+//
+
+static ssize_t				// O - Number of bytes read
+read_cb(_pappl_ipp_buffer_t *buffer,	// I - Message buffer
+        ipp_uchar_t         *data,	// I - Data buffer
+        size_t              bytes)	// I - Number of bytes to read
+{
+  if (bytes > (size_t)(buffer->end - buffer->ptr))
+    bytes = (size_t)(buffer->end - buffer->ptr);
+
+  memcpy(data, buffer->ptr, bytes);
+  buffer->ptr += bytes;
+
+  return ((ssize_t)bytes);
+}
@@ -79,8 +79,10 @@ static void	pwg_identify(pappl_printer_t *printer, pappl_identify_actions_t acti
 static bool	pwg_print(pappl_job_t *job, int doc_number, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	pwg_rendjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	pwg_rendpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
+static bool	pwg_rskiplines(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, unsigned count);
 static bool	pwg_rstartjob(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device);
 static bool	pwg_rstartpage(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned page);
+static bool	pwg_rwriteband(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, unsigned count, const unsigned char *lines);
 static bool	pwg_rwriteline(pappl_job_t *job, pappl_pr_options_t *options, pappl_device_t *device, unsigned y, const unsigned char *line);
 static bool	pwg_status(pappl_printer_t *printer);
 static const char *pwg_testpage(pappl_printer_t *printer, char *buffer, size_t bufsize);
@@ -183,8 +185,10 @@ pwg_callback(
   driver_data->printfile_cb       = pwg_print;
   driver_data->rendjob_cb         = pwg_rendjob;
   driver_data->rendpage_cb        = pwg_rendpage;
+  driver_data->rskiplines_cb      = pwg_rskiplines;
   driver_data->rstartjob_cb       = pwg_rstartjob;
   driver_data->rstartpage_cb      = pwg_rstartpage;
+  driver_data->rwriteband_cb      = pwg_rwriteband;
   driver_data->rwriteline_cb      = pwg_rwriteline;
   driver_data->status_cb          = pwg_status;
   driver_data->testpage_cb        = pwg_testpage;
@@ -615,6 +619,45 @@ pwg_rendpage(
 }
 
 
+//
+// 'pwg_rskiplines()' - Skip blank raster lines.
+//
+// PWG raster has no way to skip lines, so blank lines are written.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pwg_rskiplines(
+    pappl_job_t        *job,		// I - Job
+    pappl_pr_options_t *options,	// I - Job options
+    pappl_device_t     *device,		// I - Print device (unused)
+    unsigned           y,		// I - First line number
+    unsigned           count)		// I - Number of lines
+{
+  bool			ret = true;	// Return value
+  unsigned char		*line;		// Blank line
+  pwg_job_data_t	*pwg = (pwg_job_data_t *)papplJobGetData(job);
+					// PWG driver data
+
+  (void)device;
+  (void)y;
+
+  if ((line = malloc(options->header.cupsBytesPerLine)) == NULL)
+    return (false);
+
+  if (options->header.cupsBitsPerPixel == 1 || options->header.cupsColorSpace == CUPS_CSPACE_K || options->header.cupsColorSpace == CUPS_CSPACE_CMYK)
+    memset(line, 0x00, options->header.cupsBytesPerLine);
+  else
+    memset(line, 0xff, options->header.cupsBytesPerLine);
+
+  for (; count > 0 && ret; count --)
+    ret = cupsRasterWritePixels(pwg->ras, line, options->header.cupsBytesPerLine) != 0;
+
+  free(line);
+
+  return (ret);
+}
+
+
 //
 // 'pwg_rstartjob()' - Start a job.
 //
@@ -667,28 +710,29 @@ pwg_rstartpage(
 
 
 //
-// 'pwg_rwriteline()' - Write a raster line.
+// 'pwg_rwriteband()' - Write a band of raster lines.
 //
 
 static bool				// O - `true` on success, `false` on failure
-pwg_rwriteline(
+pwg_rwriteband(
     pappl_job_t         *job,		// I - Job
     pappl_pr_options_t  *options,	// I - Job options
     pappl_device_t      *device,	// I - Print device (unused)
-    unsigned            y,		// I - Line number
-    const unsigned char *line)		// I - Line
+    unsigned            y,		// I - First line number
+    unsigned            count,		// I - Number of lines
+    const unsigned char *lines)		// I - Lines
 {
-  const unsigned char	*lineptr,	// Pointer into line
-			*lineend;	// End of line
+  const unsigned char	*lineptr,	// Pointer into lines
+			*lineend;	// End of lines
   pwg_job_data_t	*pwg = (pwg_job_data_t *)papplJobGetData(job);
 					// PWG driver data
 
   (void)device;
   (void)y;
 
-  // Add the colorant usage for this line (for simulation purposes - normally
+  // Add the colorant usage for these lines (for simulation purposes - normally
   // this is tracked by the printer/ink cartridge...)
-  lineend = line + options->header.cupsBytesPerLine;
+  lineend = lines + count * options->header.cupsBytesPerLine;
 
   switch (options->header.cupsColorSpace)
   {
@@ -732,13 +776,13 @@ pwg_rwriteline(
 	    1275, 1530, 1530, 1785, 1530, 1785, 1785, 2040
 	  };
 
-          for (lineptr = line; lineptr < lineend; lineptr ++)
+          for (lineptr = lines; lineptr < lineend; lineptr ++)
 	    pwg->colorants[3] += amounts[*lineptr];
         }
         else
         {
           // 8-bit K
-          for (lineptr = line; lineptr < lineend; lineptr ++)
+          for (lineptr = lines; lineptr < lineend; lineptr ++)
             pwg->colorants[3] += *lineptr;
         }
         break;
@@ -746,7 +790,7 @@ pwg_rwriteline(
     case CUPS_CSPACE_W :
     case CUPS_CSPACE_SW :
 	// 8-bit W (luminance)
-	for (lineptr = line; lineptr < lineend; lineptr ++)
+	for (lineptr = lines; lineptr < lineend; lineptr ++)
 	  pwg->colorants[3] += 255 - *lineptr;
         break;
 
@@ -754,7 +798,7 @@ pwg_rwriteline(
     case CUPS_CSPACE_SRGB :
     case CUPS_CSPACE_ADOBERGB :
         // 24-bit RGB
-	for (lineptr = line; lineptr < lineend; lineptr += 3)
+	for (lineptr = lines; lineptr < lineend; lineptr += 3)
         {
           // Convert RGB to CMYK using simple transform...
           unsigned char cc = 255 - lineptr[0];
@@ -780,7 +824,7 @@ pwg_rwriteline(
 
     case CUPS_CSPACE_CMYK :
         // 32-bit CMYK
-	for (lineptr = line; lineptr < lineend; lineptr += 4)
+	for (lineptr = lines; lineptr < lineend; lineptr += 4)
 	{
 	  pwg->colorants[0] += lineptr[0];
 	  pwg->colorants[1] += lineptr[1];
@@ -793,7 +837,23 @@ pwg_rwriteline(
         break;
   }
 
-  return (cupsRasterWritePixels(pwg->ras, (unsigned char *)line, options->header.cupsBytesPerLine) != 0);
+  return (cupsRasterWritePixels(pwg->ras, (unsigned char *)lines, count * options->header.cupsBytesPerLine) != 0);
+}
+
+
+//
+// 'pwg_rwriteline()' - Write a raster line.
+//
+
+static bool				// O - `true` on success, `false` on failure
+pwg_rwriteline(
+    pappl_job_t         *job,		// I - Job
+    pappl_pr_options_t  *options,	// I - Job options
+    pappl_device_t      *device,	// I - Print device (unused)
+    unsigned            y,		// I - Line number
+    const unsigned char *line)		// I - Line
+{
+  return (pwg_rwriteband(job, options, device, y, 1, line));
 }
 
 
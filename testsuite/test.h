@@ -34,9 +34,11 @@
 #  include <string.h>
 #  if _WIN32
 #    include <io.h>
+#    include <sys/timeb.h>
 #    define isatty(f) _isatty(f)
 #  else
 #    include <unistd.h>
+#    include <sys/time.h>
 #  endif // !_WIN32
 #  ifdef __cplusplus
 extern "C" {
@@ -73,6 +75,10 @@ extern "C" {
 //
 //     Sends a formatted error string to stderr.
 //
+// double testGetTime(void)
+//
+//     Returns the current time in seconds, for timing benchmarks.
+//
 // testHexDump(const unsigned char *buffer, size_t bytes)
 //
 //     Sends a hex dump of the specified buffer to stderr.
@@ -208,6 +214,28 @@ testError(const char *error, ...)	// I - printf-style error string
 }
 
 
+// Get the current time in seconds...
+static inline double
+testGetTime(void)
+{
+#  if _WIN32
+  struct _timeb	curtime;		// Current time
+
+
+  _ftime(&curtime);
+
+  return ((double)curtime.time + 0.001 * curtime.millitm);
+#  else
+  struct timeval	curtime;	// Current time
+
+
+  gettimeofday(&curtime, NULL);
+
+  return ((double)curtime.tv_sec + 0.000001 * curtime.tv_usec);
+#  endif // _WIN32
+}
+
+
 // Show a message to stdout and stderr...
 static inline void
 testMessage(const char *error, ...)	// I - printf-style error string
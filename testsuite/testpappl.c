@@ -920,6 +920,7 @@ main(int  argc,				// I - Number of command-line arguments
 	// Not setting geo-location for label printer to ensure that DNS-SD works without a LOC record...
 	papplPrinterSetLocation(printer, "Test Lab 42");
 	papplPrinterSetOrganization(printer, "Lakeside Robotics");
+	papplPrinterSetLookAhead(printer, 2, 64 * 1024 * 1024);
       }
     }
   }
@@ -1777,7 +1778,8 @@ test_api(pappl_system_t *system)	// I - System
 			set_loglevel;	// Log level for ", set" call
   size_t		get_size,	// Size for "get" call
 			set_size;	// Size for ", set" call
-  pappl_printer_t	*printer;	// Current printer
+  pappl_printer_t	*printer,	// Current printer
+			*pool;		// Pool printer
   pappl_loc_t		*loc;		// Current localization
   _pappl_testprinter_t	pdata;		// Printer test data
   const char		*key = "A printer with that name already exists.",
@@ -2686,6 +2688,53 @@ test_api(pappl_system_t *system)	// I - System
     }
   }
 
+  // papplPrinterAdd/RemovePoolMember
+  _papplTestBegin("api: papplPrinterAddPoolMember");
+  if ((pool = papplPrinterCreate(system, 0, "testpool", "pwg_common-300dpi-black_1-sgray_8", "MFG:PWG;MDL:Office Printer;CMD:PWGRaster;", "file:///dev/null")) == NULL)
+  {
+    _papplTestEndMessage(false, "unable to create pool printer");
+    pass = false;
+  }
+  else
+  {
+    if (papplPrinterAddPoolMember(pool, pool))
+    {
+      _papplTestEndMessage(false, "added pool to itself");
+      pass = false;
+    }
+    else if (!printer || !papplPrinterAddPoolMember(pool, printer))
+    {
+      _papplTestEndMessage(false, "unable to add member");
+      pass = false;
+    }
+    else if (papplPrinterAddPoolMember(printer, pool))
+    {
+      _papplTestEndMessage(false, "added pool to its member");
+      pass = false;
+    }
+    else if ((get_size = papplPrinterGetNumberOfPoolMembers(pool)) != 1)
+    {
+      _papplTestEndMessage(false, "got %u members, expected 1", (unsigned)get_size);
+      pass = false;
+    }
+    else
+    {
+      _papplTestEnd(true);
+
+      _papplTestBegin("api: papplPrinterRemovePoolMember");
+      papplPrinterRemovePoolMember(pool, printer);
+      if ((get_size = papplPrinterGetNumberOfPoolMembers(pool)) != 0)
+      {
+        _papplTestEndMessage(false, "got %u members, expected 0", (unsigned)get_size);
+        pass = false;
+      }
+      else
+        _papplTestEnd(true);
+    }
+
+    papplPrinterDelete(pool);
+  }
+
   // papplSystemIteratePrinters
   _papplTestBegin("api: papplSystemIteratePrinters");
 
@@ -2725,6 +2774,8 @@ test_api_printer(
 			set_contact;	// Contact for ", set" call
   int			get_int,	// Integer for "get" call
 			set_int;	// Integer for ", set" call
+  size_t		get_size,	// Size for "get" call
+			set_size;	// Size for ", set" call
   char			get_str[1024],	// Temporary string for "get" call
 			set_str[1024];	// Temporary string for ", set" call
   const char		*get_ptr;	// Get string pointer
@@ -3101,6 +3152,63 @@ test_api_printer(
   else
     _papplTestEnd(true);
 
+  // papplPrinterGet/SetLookAhead
+  _papplTestBegin("api: papplPrinterGet/SetLookAhead");
+  set_int  = papplPrinterGetLookAhead(printer, &set_size);
+  papplPrinterSetLookAhead(printer, 3, 1048576);
+  if ((get_int = papplPrinterGetLookAhead(printer, &get_size)) != 3 || get_size != 1048576)
+  {
+    _papplTestEndMessage(false, "got %d/%lu, expected 3/1048576", get_int, (unsigned long)get_size);
+    pass = false;
+  }
+  else
+    _papplTestEnd(true);
+
+  papplPrinterSetLookAhead(printer, set_int, set_size);
+
+  // papplPrinterGet/SetPriorityAging
+  _papplTestBegin("api: papplPrinterGet/SetPriorityAging");
+  set_int = papplPrinterGetPriorityAging(printer);
+  papplPrinterSetPriorityAging(printer, 300);
+  if ((get_int = papplPrinterGetPriorityAging(printer)) != 300)
+  {
+    _papplTestEndMessage(false, "got %d, expected 300", get_int);
+    pass = false;
+  }
+  else
+    _papplTestEnd(true);
+
+  papplPrinterSetPriorityAging(printer, set_int);
+
+  // papplPrinterGet/SetFairShare
+  _papplTestBegin("api: papplPrinterGet/SetFairShare");
+  papplPrinterSetFairShare(printer, true);
+  if (!papplPrinterGetFairShare(printer))
+  {
+    _papplTestEndMessage(false, "got false, expected true");
+    pass = false;
+  }
+  else
+    _papplTestEnd(true);
+
+  // papplPrinterGet/SetFairShareWeight
+  _papplTestBegin("api: papplPrinterGet/SetFairShareWeight");
+  papplPrinterSetFairShareWeight(printer, "testuser", 3);
+  if ((get_int = papplPrinterGetFairShareWeight(printer, "testuser")) != 3)
+  {
+    _papplTestEndMessage(false, "got %d, expected 3", get_int);
+    pass = false;
+  }
+  else if ((get_int = papplPrinterGetFairShareWeight(printer, "otheruser")) != 1)
+  {
+    _papplTestEndMessage(false, "got %d for default weight, expected 1", get_int);
+    pass = false;
+  }
+  else
+    _papplTestEnd(true);
+
+  papplPrinterSetFairShare(printer, false);
+
   return (pass);
 }
 
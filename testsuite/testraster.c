@@ -0,0 +1,1700 @@
+//
+// Raster unit tests and benchmarks for the Printer Application Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ./testraster [NUMBER-OF-LINES]
+//
+
+#include <pappl/pappl-private.h>
+#include "test.h"
+#ifdef HAVE_LIBJPEG
+#  include <jpeglib.h>
+#endif // HAVE_LIBJPEG
+#ifdef HAVE_LIBPNG
+#  include <png.h>
+#endif // HAVE_LIBPNG
+
+
+//
+// Constants...
+//
+
+#define LINE_WIDTH	5100		// Width of 8.5" line at 600dpi
+#define NUM_LINES	6600		// Default number of lines for benchmark (11" at 600dpi)
+#define MAX_THREADS	8		// Maximum number of rendering threads
+#define RENDER_BAND	16		// Number of lines in a rendered band
+#define ROTATE_BAND	32		// Number of lines in a rotated band
+
+
+//
+// Local types...
+//
+
+typedef struct _test_image_s		// Test image
+{
+  unsigned char	*pixels;		// Pixels
+  unsigned	width,			// Width in columns
+		height,			// Height in lines
+		depth;			// Bytes per pixel
+  ipp_orient_t	orientation;		// Orientation
+  unsigned char	*band;			// Band of rotated lines
+  unsigned	band_y,			// First line in band
+		band_count,		// Number of lines in band
+		band_max;		// Maximum number of lines in band
+} _test_image_t;
+
+typedef struct _test_render_s		// Test image rendering state
+{
+  _test_image_t	images[MAX_THREADS];	// Image for each worker
+  _pappl_rscale_t *scales[MAX_THREADS];	// Scaler for each worker
+  unsigned char	*grays[MAX_THREADS];	// Grayscale line for each worker
+  const unsigned char *dither;		// Dither matrix
+  unsigned	xsize,			// Scaled width
+		next_y;			// Next line to write
+  size_t	bytes_per_line;		// Bytes per output line
+  bool		in_order;		// Were lines written in order?
+  uint32_t	checksum;		// Checksum of output lines
+} _test_render_t;
+
+
+//
+// Local functions...
+//
+
+static size_t		compress_line(unsigned char *dst, const unsigned char *src, size_t srclen);
+static size_t		decompress_line(unsigned char *dst, size_t dstsize, const unsigned char *src, size_t srclen);
+static bool		decompress_pwg(unsigned char *dst, const unsigned char *src, size_t srclen, unsigned count, size_t bytes_per_line, unsigned bytes_per_pixel);
+static void		dither_line(unsigned char *dst, const unsigned char *src, unsigned x, unsigned count, const unsigned char *dither, bool black);
+static const unsigned char *image_row_cb(_test_image_t *image, unsigned y);
+static bool		load_image(const char *filename, unsigned depth, _test_image_t *image);
+static void		make_line(unsigned char *line, size_t bytes, unsigned seed);
+static const char	*orient_string(ipp_orient_t orientation);
+static bool		render_band_cb(_test_render_t *render, unsigned worker, unsigned y, unsigned count, unsigned char *lines);
+static bool		render_image(_test_image_t *image, unsigned xsize, unsigned ysize, unsigned num_threads, const unsigned char *dither, uint32_t *checksum);
+static void		scale_reference(_test_image_t *image, unsigned xsize, unsigned ysize, unsigned char *line);
+static const char	*simd_string(_pappl_simd_t simd);
+static bool		test_blank(_pappl_simd_t simd);
+static bool		test_compress(_pappl_simd_t simd);
+static bool		test_dither(pappl_dither_t dither, _pappl_simd_t simd);
+static bool		test_render(pappl_dither_t dither);
+static bool		test_rotate(void);
+static bool		test_scale(_pappl_simd_t simd);
+static double		time_blank(size_t num_lines);
+static double		time_compress(size_t num_lines, bool pwg, bool reference, size_t *bytes);
+static double		time_dither(pappl_dither_t dither, size_t num_lines, bool reference);
+static double		time_render(_test_image_t *image, unsigned dpi, unsigned num_threads, const unsigned char *dither);
+static double		time_scale(_test_image_t *image, unsigned dpi, bool reference);
+static bool		write_band_cb(_test_render_t *render, unsigned y, unsigned count, const unsigned char *lines);
+
+
+//
+// 'main()' - Test the raster functions.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  bool			pass = true;	// Pass or fail
+  size_t		num_lines = NUM_LINES;
+					// Number of lines for benchmark
+  int			i,		// Looping var
+			simd;		// SIMD instruction set
+  pappl_dither_t	dither;		// Dither matrix
+  double		ref_time;	// Time for reference code
+  size_t		bytes;		// Number of compressed bytes
+  unsigned		depth,		// Bytes per pixel
+			dpi;		// Output resolution
+  _test_image_t		image;		// Test image
+  double		portrait_time[2];
+					// Time for portrait images
+  const char		*ext;		// Image file extension
+  char			filename[256];	// Image filename
+
+
+  if (argc > 1 && (num_lines = (size_t)strtol(argv[1], NULL, 10)) < 1)
+  {
+    fprintf(stderr, "Usage: %s [NUMBER-OF-LINES]\n", argv[0]);
+    return (1);
+  }
+
+  // Use a scrambled dither matrix for testing...
+  for (i = 0; i < 256; i ++)
+    dither[i / 16][i % 16] = (unsigned char)((i * 167 + 13) & 255);
+
+  // Test each supported instruction set against the reference code...
+  for (simd = _PAPPL_SIMD_NONE; simd <= _PAPPL_SIMD_AVX2; simd ++)
+  {
+    if (_papplRasterSetSIMD((_pappl_simd_t)simd) == (_pappl_simd_t)simd)
+    {
+      pass &= test_blank((_pappl_simd_t)simd);
+      pass &= test_compress((_pappl_simd_t)simd);
+      pass &= test_dither(dither, (_pappl_simd_t)simd);
+      pass &= test_scale((_pappl_simd_t)simd);
+    }
+  }
+
+  pass &= test_rotate();
+  pass &= test_render(dither);
+
+  // Benchmark the dithering code...
+  ref_time = time_dither(dither, num_lines, true);
+
+  testBegin("benchmark: dither reference");
+  testEndMessage(true, "%.3fus/line", 1000000.0 * ref_time / num_lines);
+
+  for (simd = _PAPPL_SIMD_NONE; simd <= _PAPPL_SIMD_AVX2; simd ++)
+  {
+    double	simd_time;		// Time for SIMD code
+
+    if (_papplRasterSetSIMD((_pappl_simd_t)simd) != (_pappl_simd_t)simd)
+      continue;
+
+    simd_time = time_dither(dither, num_lines, false);
+
+    testBegin("benchmark: dither %s", simd_string((_pappl_simd_t)simd));
+    testEndMessage(true, "%.3fus/line, %.1fx", 1000000.0 * simd_time / num_lines, simd_time > 0.0 ? ref_time / simd_time : 0.0);
+  }
+
+  // Benchmark the blank line detection code...
+  for (simd = _PAPPL_SIMD_NONE; simd <= _PAPPL_SIMD_AVX2; simd ++)
+  {
+    double	simd_time;		// Time for SIMD code
+
+    if (_papplRasterSetSIMD((_pappl_simd_t)simd) != (_pappl_simd_t)simd)
+      continue;
+
+    simd_time = time_blank(num_lines);
+
+    testBegin("benchmark: blank %s", simd_string((_pappl_simd_t)simd));
+    testEndMessage(true, "%.3fus/line", 1000000.0 * simd_time / num_lines);
+  }
+
+  // Benchmark the compression code...
+  ref_time = time_compress(num_lines, false, true, &bytes);
+
+  testBegin("benchmark: packbits reference");
+  testEndMessage(true, "%.3fus/line, %.1f%%", 1000000.0 * ref_time / num_lines, 100.0 * bytes / (num_lines * LINE_WIDTH));
+
+  for (simd = _PAPPL_SIMD_NONE; simd <= _PAPPL_SIMD_AVX2; simd ++)
+  {
+    double	simd_time;		// Time for SIMD code
+
+    if (_papplRasterSetSIMD((_pappl_simd_t)simd) != (_pappl_simd_t)simd)
+      continue;
+
+    simd_time = time_compress(num_lines, false, false, &bytes);
+
+    testBegin("benchmark: packbits %s", simd_string((_pappl_simd_t)simd));
+    testEndMessage(true, "%.3fus/line, %.1fx, %.1f%%", 1000000.0 * simd_time / num_lines, simd_time > 0.0 ? ref_time / simd_time : 0.0, 100.0 * bytes / (num_lines * LINE_WIDTH));
+
+    simd_time = time_compress(num_lines, true, false, &bytes);
+
+    testBegin("benchmark: pwg %s", simd_string((_pappl_simd_t)simd));
+    testEndMessage(true, "%.3fus/line, %.1fx, %.1f%%", 1000000.0 * simd_time / num_lines, simd_time > 0.0 ? ref_time / simd_time : 0.0, 100.0 * bytes / (num_lines * LINE_WIDTH));
+  }
+
+  // Benchmark scaling the portrait test images to letter size...
+  for (depth = 1; depth <= 3; depth += 2)
+  {
+    if (!load_image(depth == 1 ? "portrait-gray.png" : "portrait-color.png", depth, &image))
+      continue;
+
+    for (dpi = 300; dpi <= 600; dpi += 300)
+    {
+      ref_time = time_scale(&image, dpi, true);
+
+      testBegin("benchmark: scale %s %udpi reference", depth == 1 ? "gray" : "color", dpi);
+      testEndMessage(true, "%.3fms/page", 1000.0 * ref_time);
+
+      for (simd = _PAPPL_SIMD_NONE; simd <= _PAPPL_SIMD_AVX2; simd ++)
+      {
+        double	simd_time;		// Time for SIMD code
+
+        if (_papplRasterSetSIMD((_pappl_simd_t)simd) != (_pappl_simd_t)simd)
+          continue;
+
+        simd_time = time_scale(&image, dpi, false);
+
+        testBegin("benchmark: scale %s %udpi %s", depth == 1 ? "gray" : "color", dpi, simd_string((_pappl_simd_t)simd));
+        testEndMessage(true, "%.3fms/page, %.1fx", 1000.0 * simd_time, simd_time > 0.0 ? ref_time / simd_time : 0.0);
+
+        portrait_time[dpi / 300 - 1] = simd_time;
+      }
+    }
+
+    // Benchmark rendering the portrait test images with multiple threads...
+    for (dpi = 300; dpi <= 600; dpi += 300)
+    {
+      unsigned	num_threads;		// Number of threads
+      double	one_time = 0.0,		// Time for one thread
+		render_time;		// Time for N threads
+
+      for (num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2)
+      {
+        render_time = time_render(&image, dpi, num_threads, &dither[0][0]);
+
+        if (num_threads == 1)
+          one_time = render_time;
+
+        testBegin("benchmark: render %s %udpi %u thread%s", depth == 1 ? "gray" : "color", dpi, num_threads, num_threads == 1 ? "" : "s");
+        testEndMessage(true, "%.3fms/page, %.2fx", 1000.0 * render_time, render_time > 0.0 ? one_time / render_time : 0.0);
+      }
+    }
+
+    free(image.pixels);
+    free(image.band);
+
+    // Benchmark the landscape test images, reading the rotated image one
+    // column at a time and in bands...
+    for (ext = "png"; ext; ext = strcmp(ext, "png") ? NULL : "jpg")
+    {
+      snprintf(filename, sizeof(filename), "landscape-%s.%s", depth == 1 ? "gray" : "color", ext);
+
+      if (!load_image(filename, depth, &image))
+        continue;
+
+      image.orientation = IPP_ORIENT_LANDSCAPE;
+
+      for (dpi = 300; dpi <= 600; dpi += 300)
+      {
+        for (image.band_max = 1; image.band_max <= ROTATE_BAND; image.band_max *= ROTATE_BAND)
+        {
+          double landscape_time = time_scale(&image, dpi, false);
+					// Time for landscape image
+
+          testBegin("benchmark: scale %s %udpi %s", filename, dpi, image.band_max == 1 ? "columns" : "bands");
+          testEndMessage(true, "%.3fms/page, %.2fx portrait", 1000.0 * landscape_time, portrait_time[dpi / 300 - 1] > 0.0 ? landscape_time / portrait_time[dpi / 300 - 1] : 0.0);
+        }
+      }
+
+      free(image.pixels);
+      free(image.band);
+    }
+  }
+
+  return (pass ? 0 : 1);
+}
+
+
+//
+// 'compress_line()' - Compress a line using PackBits with a per-byte loop.
+//
+
+static size_t				// O - Number of compressed bytes
+compress_line(
+    unsigned char       *dst,		// I - Output buffer
+    const unsigned char *src,		// I - Input bytes
+    size_t              srclen)		// I - Number of input bytes
+{
+  unsigned char	*dstptr = dst;		// Pointer into output buffer
+  size_t	count,			// Number of bytes in run
+		remaining;		// Remaining input bytes
+
+
+  for (remaining = srclen; remaining > 0; src += count, remaining -= count)
+  {
+    if (remaining > 1 && src[0] == src[1])
+    {
+      for (count = 2; count < remaining && count < 128 && src[count] == src[0]; count ++);
+
+      *dstptr++ = (unsigned char)(257 - count);
+      *dstptr++ = src[0];
+    }
+    else
+    {
+      for (count = 1; count < remaining && count < 128; count ++)
+      {
+        if ((count + 2) < remaining && src[count] == src[count + 1] && src[count] == src[count + 2])
+          break;
+      }
+
+      *dstptr++ = (unsigned char)(count - 1);
+      memcpy(dstptr, src, count);
+      dstptr += count;
+    }
+  }
+
+  return ((size_t)(dstptr - dst));
+}
+
+
+//
+// 'decompress_line()' - Decompress a PackBits line.
+//
+
+static size_t				// O - Number of decompressed bytes
+decompress_line(
+    unsigned char       *dst,		// I - Output buffer
+    size_t              dstsize,	// I - Size of output buffer
+    const unsigned char *src,		// I - Compressed bytes
+    size_t              srclen)		// I - Number of compressed bytes
+{
+  unsigned char		*dstptr = dst,	// Pointer into output buffer
+			*dstend = dst + dstsize;
+					// End of output buffer
+  const unsigned char	*srcend = src + srclen;
+					// End of compressed bytes
+  size_t		count;		// Number of bytes
+
+
+  while (src < srcend)
+  {
+    if (*src & 128)
+    {
+      count = 257 - *src++;
+
+      if (src >= srcend || count > (size_t)(dstend - dstptr))
+        return (0);
+
+      memset(dstptr, *src++, count);
+    }
+    else
+    {
+      count = (size_t)*src++ + 1;
+
+      if (count > (size_t)(srcend - src) || count > (size_t)(dstend - dstptr))
+        return (0);
+
+      memcpy(dstptr, src, count);
+      src += count;
+    }
+
+    dstptr += count;
+  }
+
+  return ((size_t)(dstptr - dst));
+}
+
+
+//
+// 'decompress_pwg()' - Decompress a band of PWG raster lines.
+//
+
+static bool				// O - `true` on success, `false` on error
+decompress_pwg(
+    unsigned char       *dst,		// I - Output lines
+    const unsigned char *src,		// I - Compressed bytes
+    size_t              srclen,		// I - Number of compressed bytes
+    unsigned            count,		// I - Number of lines
+    size_t              bytes_per_line,	// I - Bytes per line
+    unsigned            bytes_per_pixel)// I - Bytes per pixel
+{
+  const unsigned char	*srcend = src + srclen;
+					// End of compressed bytes
+  unsigned		y,		// Current line
+			repeat;		// Number of identical lines
+  size_t		x,		// Current byte in line
+			i,		// Looping var
+			n;		// Number of pixels
+
+
+  for (y = 0; y < count; y += repeat)
+  {
+    if (src >= srcend)
+      return (false);
+
+    if ((repeat = (unsigned)*src++ + 1) > (count - y))
+      return (false);
+
+    for (x = 0; x < bytes_per_line; x += n * bytes_per_pixel)
+    {
+      if (src >= srcend || *src == 128)
+        return (false);
+
+      if (*src & 128)
+      {
+        // Literal pixels...
+        n = 257 - *src++;
+
+        if ((n * bytes_per_pixel) > (size_t)(srcend - src) || (n * bytes_per_pixel) > (bytes_per_line - x))
+          return (false);
+
+        memcpy(dst + x, src, n * bytes_per_pixel);
+        src += n * bytes_per_pixel;
+      }
+      else
+      {
+        // Repeated pixels...
+        n = (size_t)*src++ + 1;
+
+        if (bytes_per_pixel > (size_t)(srcend - src) || (n * bytes_per_pixel) > (bytes_per_line - x))
+          return (false);
+
+        for (i = 0; i < n; i ++)
+          memcpy(dst + x + i * bytes_per_pixel, src, bytes_per_pixel);
+
+        src += bytes_per_pixel;
+      }
+    }
+
+    for (i = 1, dst += bytes_per_line; i < repeat; i ++, dst += bytes_per_line)
+      memcpy(dst, dst - bytes_per_line, bytes_per_line);
+  }
+
+  return (src == srcend);
+}
+
+
+//
+// 'dither_line()' - Dither a line using the original per-pixel loop.
+//
+
+static void
+dither_line(
+    unsigned char       *dst,		// I - Output line
+    const unsigned char *src,		// I - Pixels
+    unsigned            x,		// I - First column
+    unsigned            count,		// I - Number of pixels
+    const unsigned char *dither,	// I - Dither row
+    bool                black)		// I - Black pixels?
+{
+  unsigned char	*dstptr,		// Pointer into line
+		byte,			// Byte in line
+		bit;			// Current bit
+  unsigned	xend = x + count;	// End column
+
+
+  for (dstptr = dst + x / 8, bit = 128 >> (x & 7), byte = 0; x < xend; x ++, src ++)
+  {
+    if (black ? *src > dither[x & 15] : *src <= dither[x & 15])
+      byte |= bit;
+
+    if (bit == 1)
+    {
+      *dstptr++ = byte;
+      byte      = 0;
+      bit       = 128;
+    }
+    else
+      bit /= 2;
+  }
+
+  if (bit < 128)
+    *dstptr = byte;
+}
+
+
+//
+// 'image_row_cb()' - Return a row from a test image.
+//
+
+static const unsigned char *		// O - Row pixels
+image_row_cb(_test_image_t *image,	// I - Test image
+             unsigned      y)		// I - Row number
+{
+  unsigned	lines;			// Number of rotated lines
+
+
+  if (image->orientation == IPP_ORIENT_PORTRAIT)
+    return (image->pixels + (size_t)y * image->width * image->depth);
+
+  if (image->orientation == IPP_ORIENT_LANDSCAPE || image->orientation == IPP_ORIENT_REVERSE_LANDSCAPE)
+    lines = image->width;
+  else
+    lines = image->height;
+
+  if (y < image->band_y || y >= (image->band_y + image->band_count))
+  {
+    // Copy the next band of rotated lines...
+    image->band_y     = y;
+    image->band_count = image->band_max;
+
+    if (image->band_count > (lines - y))
+      image->band_count = lines - y;
+
+    _papplRasterRotate(image->band, image->pixels, image->width, image->height, image->depth, image->orientation, y, image->band_count);
+  }
+
+  return (image->band + (size_t)(y - image->band_y) * (image->width * image->height / lines) * image->depth);
+}
+
+
+//
+// 'load_image()' - Load a JPEG or PNG test image or generate a synthetic one.
+//
+
+static bool				// O - `true` on success, `false` on error
+load_image(const char    *filename,	// I - JPEG or PNG filename
+           unsigned      depth,		// I - Bytes per pixel (`1` or `3`)
+           _test_image_t *image)	// O - Test image
+{
+  unsigned	x, y;			// Looping vars
+  unsigned char	*pixptr;		// Pointer into pixels
+  char		path[1024];		// Path to image
+  const char	*ext;			// Extension
+#ifdef HAVE_LIBJPEG
+  FILE		*fp;			// JPEG file
+  struct jpeg_decompress_struct dinfo;	// Decompressor info
+  struct jpeg_error_mgr	jerr;		// Error handler info
+  JSAMPROW	row;			// Sample row pointer
+#endif // HAVE_LIBJPEG
+#ifdef HAVE_LIBPNG
+  png_image	png;			// PNG image
+#endif // HAVE_LIBPNG
+
+
+  memset(image, 0, sizeof(_test_image_t));
+
+  image->orientation = IPP_ORIENT_PORTRAIT;
+  image->depth       = depth;
+
+  if (access(filename, R_OK))
+    snprintf(path, sizeof(path), "testsuite/%s", filename);
+  else
+    cupsCopyString(path, filename, sizeof(path));
+
+  if ((ext = strrchr(filename, '.')) == NULL)
+    ext = "";
+
+#ifdef HAVE_LIBJPEG
+  if (!strcmp(ext, ".jpg") && (fp = fopen(path, "rb")) != NULL)
+  {
+    dinfo.err = jpeg_std_error(&jerr);
+    jpeg_create_decompress(&dinfo);
+    jpeg_stdio_src(&dinfo, fp);
+    jpeg_read_header(&dinfo, TRUE);
+
+    dinfo.out_color_space = depth == 1 ? JCS_GRAYSCALE : JCS_RGB;
+
+    jpeg_start_decompress(&dinfo);
+
+    image->width  = dinfo.output_width;
+    image->height = dinfo.output_height;
+
+    if ((image->pixels = malloc((size_t)image->width * image->height * depth)) != NULL)
+    {
+      while (dinfo.output_scanline < dinfo.output_height)
+      {
+        row = (JSAMPROW)(image->pixels + (size_t)dinfo.output_scanline * image->width * depth);
+        jpeg_read_scanlines(&dinfo, &row, 1);
+      }
+
+      jpeg_finish_decompress(&dinfo);
+    }
+
+    jpeg_destroy_decompress(&dinfo);
+    fclose(fp);
+
+    if (image->pixels)
+      goto allocate_band;
+  }
+#endif // HAVE_LIBJPEG
+
+#ifdef HAVE_LIBPNG
+  memset(&png, 0, sizeof(png));
+  png.version = PNG_IMAGE_VERSION;
+
+  if (!strcmp(ext, ".png") && png_image_begin_read_from_file(&png, path))
+  {
+    png.format = depth == 1 ? PNG_FORMAT_GRAY : PNG_FORMAT_RGB;
+
+    image->width  = png.width;
+    image->height = png.height;
+    image->depth  = depth;
+
+    if ((image->pixels = malloc(PNG_IMAGE_SIZE(png))) != NULL && png_image_finish_read(&png, NULL, image->pixels, 0, NULL))
+      goto allocate_band;
+
+    free(image->pixels);
+    png_image_free(&png);
+  }
+#endif // HAVE_LIBPNG
+
+  // Generate a synthetic image the same size as the test images...
+  if (!strncmp(filename, "landscape-", 10))
+  {
+    image->width  = 2091;
+    image->height = 1674;
+  }
+  else
+  {
+    image->width  = 1674;
+    image->height = 2091;
+  }
+
+  if ((image->pixels = malloc((size_t)image->width * image->height * depth)) == NULL)
+    return (false);
+
+  for (y = 0, pixptr = image->pixels; y < image->height; y ++)
+  {
+    for (x = 0; x < image->width * depth; x ++)
+      *pixptr++ = (unsigned char)((x * 7 + y * 3 + (x ^ y)) & 255);
+  }
+
+  // Allocate a band for rotating the image...
+  allocate_band:
+
+  image->band_max = ROTATE_BAND;
+
+  if ((image->band = malloc((size_t)ROTATE_BAND * (image->width > image->height ? image->width : image->height) * depth)) == NULL)
+  {
+    free(image->pixels);
+    return (false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'make_line()' - Make a line of white space, solid runs, and noise.
+//
+
+static void
+make_line(unsigned char *line,		// I - Line
+          size_t        bytes,		// I - Bytes per line
+          unsigned      seed)		// I - Seed for line contents
+{
+  size_t	x,			// Current byte
+		count;			// Number of bytes in segment
+  unsigned	state = seed * 2654435761U + 1;
+					// Pseudo-random state
+
+
+  for (x = 0; x < bytes; x += count)
+  {
+    state = state * 1103515245 + 12345;
+
+    if ((count = 1 + (state >> 16) % 300) > (bytes - x))
+      count = bytes - x;
+
+    switch ((state >> 8) & 3)
+    {
+      case 0 :
+      case 1 :
+          // White space
+          memset(line + x, 0, count);
+          break;
+
+      case 2 :
+          // Solid run
+          memset(line + x, (int)(state >> 24), count);
+          break;
+
+      default :
+          // Noise with short runs
+          for (size_t i = 0; i < count; i ++)
+          {
+            state = state * 1103515245 + 12345;
+            line[x + i] = (state & 0x30000) ? (unsigned char)(state >> 24) : line[x + i - (i > 0)];
+          }
+          break;
+    }
+  }
+}
+
+
+//
+// 'orient_string()' - Return the name of an orientation.
+//
+
+static const char *			// O - Name
+orient_string(ipp_orient_t orientation)	// I - Orientation
+{
+  switch (orientation)
+  {
+    case IPP_ORIENT_LANDSCAPE :
+        return ("landscape");
+    case IPP_ORIENT_REVERSE_LANDSCAPE :
+        return ("reverse-landscape");
+    case IPP_ORIENT_REVERSE_PORTRAIT :
+        return ("reverse-portrait");
+    default :
+        return ("portrait");
+  }
+}
+
+
+//
+// 'render_band_cb()' - Scale and dither a band of lines.
+//
+
+static bool				// O - `true` on success, `false` on error
+render_band_cb(_test_render_t *render,	// I - Rendering state
+               unsigned       worker,	// I - Worker number
+               unsigned       y,	// I - First line
+               unsigned       count,	// I - Number of lines
+               unsigned char  *lines)	// I - Lines in band
+{
+  unsigned		x;		// Looping var
+  const unsigned char	*pixptr;	// Pointer into scaled line
+  unsigned		depth = render->images[worker].depth;
+					// Bytes per pixel
+
+
+  for (; count > 0; count --, y ++, lines += render->bytes_per_line)
+  {
+    if ((pixptr = _papplRasterScaleGetLine(render->scales[worker], y)) == NULL)
+      return (false);
+
+    if (depth > 1)
+    {
+      // Use the first component of each pixel...
+      for (x = 0; x < render->xsize; x ++)
+        render->grays[worker][x] = pixptr[x * depth];
+
+      pixptr = render->grays[worker];
+    }
+
+    _papplRasterDitherLine(lines, pixptr, 0, render->xsize, render->dither + 16 * (y & 15), false);
+  }
+
+  return (true);
+}
+
+
+//
+// 'render_image()' - Scale and dither an image using multiple threads.
+//
+
+static bool				// O - `true` on success, `false` on error
+render_image(
+    _test_image_t       *image,		// I - Test image
+    unsigned            xsize,		// I - Scaled width
+    unsigned            ysize,		// I - Scaled height
+    unsigned            num_threads,	// I - Number of threads
+    const unsigned char *dither,	// I - Dither matrix
+    uint32_t            *checksum)	// O - Checksum of output lines
+{
+  bool			ret = true;	// Return value
+  unsigned		i;		// Looping var
+  _test_render_t	render;		// Rendering state
+  _pappl_rbands_t	*bands = NULL;	// Band renderer
+
+
+  memset(&render, 0, sizeof(render));
+
+  render.dither         = dither;
+  render.xsize          = xsize;
+  render.bytes_per_line = (xsize + 7) / 8;
+  render.in_order       = true;
+  render.checksum       = 2166136261U;
+
+  for (i = 0; i < num_threads; i ++)
+  {
+    render.images[i] = *image;
+
+    if ((render.scales[i] = _papplRasterScaleCreate(image->depth, image->width, image->height, xsize, ysize, 0, xsize, true, (_pappl_rscale_cb_t)image_row_cb, render.images + i)) == NULL || (render.grays[i] = malloc(xsize)) == NULL)
+      ret = false;
+  }
+
+  if (ret && (bands = _papplRasterBandsCreate(num_threads, RENDER_BAND, render.bytes_per_line, (_pappl_rrender_cb_t)render_band_cb, (_pappl_rwrite_cb_t)write_band_cb, &render)) == NULL)
+    ret = false;
+
+  // Render the image in two parts to make sure the worker threads are reused...
+  if (ret)
+    ret = _papplRasterBandsRender(bands, 0, ysize / 2) && _papplRasterBandsRender(bands, ysize / 2, ysize - ysize / 2);
+
+  _papplRasterBandsDelete(bands);
+
+  for (i = 0; i < num_threads; i ++)
+  {
+    _papplRasterScaleDelete(render.scales[i]);
+    free(render.grays[i]);
+  }
+
+  *checksum = render.checksum;
+
+  return (ret && render.in_order && render.next_y == ysize);
+}
+
+
+//
+// 'scale_reference()' - Scale an image using the original per-pixel loop.
+//
+
+static void
+scale_reference(_test_image_t *image,	// I - Test image
+                unsigned      xsize,	// I - Scaled width
+                unsigned      ysize,	// I - Scaled height
+                unsigned char *line)	// I - Output line
+{
+  int			x, y,		// Looping vars
+			j,		// Looping var
+			depth = (int)image->depth,
+					// Bytes per pixel
+			xdir = depth,	// X direction
+			ydir = depth * (int)image->width,
+					// Y direction
+			xerr, xmod, xstep,
+					// X error, modulus, and step
+			yerr, ymod, ystep,
+					// Y error, modulus, and step
+			pixel0, pixel1;	// Temporary pixel values
+  const unsigned char	*pixels = image->pixels,
+					// First pixel
+			*pixend = pixels + ydir * (int)image->height,
+					// End of image
+			*pixline,	// Current line
+			*pixptr;	// Current pixel
+  unsigned char		*lineptr;	// Pointer into line
+
+
+  xmod  = (int)(image->width % xsize);
+  xstep = (int)(image->width / xsize) * xdir;
+  ymod  = (int)(image->height % ysize);
+  ystep = (int)(image->height / ysize) * ydir;
+
+  for (y = 0, pixline = pixels, yerr = -ymod / 2; y < (int)ysize; y ++)
+  {
+    for (x = 0, pixptr = pixline, xerr = -xmod / 2, lineptr = line; x < (int)xsize; x ++)
+    {
+      if (yerr >= 0 && xerr >= 0)
+      {
+	const unsigned char *rt = pixptr + xdir, *dn = pixptr + ydir, *dnrt = pixptr + xdir + ydir;
+
+	if (rt >= pixend)
+	  rt = pixptr;
+	if (dn >= pixend)
+	  dn = pixptr;
+	if (dnrt >= pixend)
+	  dnrt = pixptr;
+
+	for (j = 0; j < depth; j ++)
+	{
+	  pixel0     = (((int)xsize - xerr) * pixptr[j] + xerr * rt[j]) / (int)xsize;
+	  pixel1     = (((int)xsize - xerr) * dn[j] + xerr * dnrt[j]) / (int)xsize;
+	  *lineptr++ = (unsigned char)((((int)ysize - yerr) * pixel0 + yerr * pixel1) / (int)ysize);
+	}
+      }
+      else
+      {
+	memcpy(lineptr, pixptr, (size_t)depth);
+	lineptr += depth;
+      }
+
+      pixptr += xstep;
+      xerr += xmod;
+      if (xerr >= (int)xsize)
+      {
+	xerr -= (int)xsize;
+	pixptr += xdir;
+      }
+    }
+
+    pixline += ystep;
+    yerr += ymod;
+    if (yerr >= (int)ysize)
+    {
+      pixline += ydir;
+      yerr -= (int)ysize;
+    }
+  }
+}
+
+
+//
+// 'simd_string()' - Return the name of a SIMD instruction set.
+//
+
+static const char *			// O - Name
+simd_string(_pappl_simd_t simd)		// I - SIMD instruction set
+{
+  switch (simd)
+  {
+    case _PAPPL_SIMD_SSE2 :
+        return ("SSE2");
+    case _PAPPL_SIMD_AVX2 :
+        return ("AVX2");
+    default :
+        return ("C");
+  }
+}
+
+
+//
+// 'test_blank()' - Test blank line detection.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_blank(_pappl_simd_t simd)		// I - SIMD instruction set
+{
+  unsigned	white,			// White value
+		bytes,			// Number of bytes
+		x;			// Non-white byte
+  unsigned char	line[LINE_WIDTH + 1];	// Line
+
+
+  testBegin("_papplRasterIsBlank(%s)", simd_string(simd));
+
+  for (white = 0; white < 256; white += 255)
+  {
+    for (bytes = 0; bytes <= LINE_WIDTH; bytes += bytes < 300 ? 1 : 1201)
+    {
+      // Offset the line by one byte to check unaligned data...
+      memset(line, (int)white, sizeof(line));
+
+      if (!_papplRasterIsBlank(line + 1, bytes, (unsigned char)white))
+      {
+        testEndMessage(false, "%u white bytes (%u) not blank", bytes, white);
+        return (false);
+      }
+
+      for (x = 0; x < bytes; x += x < 300 ? 1 : 997)
+      {
+        line[x + 1] = (unsigned char)(white ^ (1 << (x & 7)));
+
+        if (_papplRasterIsBlank(line + 1, bytes, (unsigned char)white))
+        {
+          testEndMessage(false, "%u bytes (%u) with byte %u set is blank", bytes, white, x);
+          return (false);
+        }
+
+        line[x + 1] = (unsigned char)white;
+      }
+    }
+  }
+
+  testEnd(true);
+
+  return (true);
+}
+
+
+//
+// 'test_compress()' - Test PackBits and PWG raster compression.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_compress(_pappl_simd_t simd)	// I - SIMD instruction set
+{
+  bool		ret = false;		// Return value
+  unsigned	i,			// Looping var
+		bpp,			// Bytes per pixel
+		count;			// Number of lines
+  size_t	srclen,			// Number of input bytes
+		bytes,			// Number of compressed bytes
+		bpl;			// Bytes per line
+  unsigned char	*src = NULL,		// Input lines
+		*dst = NULL,		// Compressed bytes
+		*expected = NULL,	// Expected compressed bytes
+		*actual = NULL;		// Decompressed lines
+  static const unsigned char tn1023[] =	// Example from Apple TN1023
+  {
+    0xaa, 0xaa, 0xaa, 0x80, 0x00, 0x2a, 0xaa, 0xaa, 0xaa, 0xaa, 0x80, 0x00,
+    0x2a, 0x22, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa
+  };
+  static const unsigned char tn1023_packed[] =
+  {					// Compressed example from Apple TN1023
+    0xfe, 0xaa, 0x02, 0x80, 0x00, 0x2a, 0xfd, 0xaa, 0x03, 0x80, 0x00, 0x2a,
+    0x22, 0xf7, 0xaa
+  };
+  static const unsigned char pwg[] =	// PWG raster lines (RGB)
+  {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00,
+    0x11, 0x22, 0x33, 0x44, 0x55, 0x66,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00,
+    0x11, 0x22, 0x33, 0x44, 0x55, 0x66,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+  };
+  static const unsigned char pwg_packed[] =
+  {					// Compressed PWG raster lines
+    0x01, 0x02, 0xff, 0xff, 0xff, 0xfe, 0x00, 0x00, 0x00, 0x11, 0x22, 0x33,
+    0x44, 0x55, 0x66,
+    0x00, 0x05, 0x00, 0x00, 0x00
+  };
+
+
+  testBegin("papplRasterCompressPackBits(%s)", simd_string(simd));
+
+  if ((src = malloc(4 * LINE_WIDTH * 300)) == NULL || (dst = malloc(4 * LINE_WIDTH * 300 * 2 + 300)) == NULL || (expected = malloc(4 * LINE_WIDTH * 2)) == NULL || (actual = malloc(4 * LINE_WIDTH * 300)) == NULL)
+  {
+    testEndMessage(false, "%s", strerror(errno));
+    goto done;
+  }
+
+  // Check the example from Apple TN1023...
+  if ((bytes = papplRasterCompressPackBits(dst, sizeof(tn1023_packed), tn1023, sizeof(tn1023))) != sizeof(tn1023_packed) || memcmp(dst, tn1023_packed, sizeof(tn1023_packed)))
+  {
+    testEndMessage(false, "TN1023 example compressed to %u bytes", (unsigned)bytes);
+    goto done;
+  }
+
+  if (papplRasterCompressPackBits(dst, sizeof(tn1023_packed) - 1, tn1023, sizeof(tn1023)) != 0)
+  {
+    testEndMessage(false, "TN1023 example did not detect short buffer");
+    goto done;
+  }
+
+  // Check lines of every length up to 300 bytes and some full lines against
+  // the per-byte loop...
+  for (srclen = 1; srclen <= LINE_WIDTH; srclen += srclen < 300 ? 1 : 1201)
+  {
+    for (i = 0; i < 4; i ++)
+    {
+      make_line(src, srclen, i * 1000 + (unsigned)srclen);
+
+      if (i == 3)
+        memset(src, 0x42, srclen);
+
+      bytes = papplRasterCompressPackBits(dst, srclen + (srclen + 127) / 128, src, srclen);
+
+      if (bytes == 0 || bytes != compress_line(expected, src, srclen) || memcmp(dst, expected, bytes))
+      {
+        testEndMessage(false, "%u byte line %u differs", (unsigned)srclen, i);
+        goto done;
+      }
+
+      if (decompress_line(actual, srclen, dst, bytes) != srclen || memcmp(actual, src, srclen))
+      {
+        testEndMessage(false, "%u byte line %u does not decompress", (unsigned)srclen, i);
+        goto done;
+      }
+    }
+  }
+
+  testEnd(true);
+
+  testBegin("papplRasterCompressPWG(%s)", simd_string(simd));
+
+  // Check lines with known compressed data...
+  if ((bytes = papplRasterCompressPWG(dst, sizeof(pwg_packed), pwg, 3, sizeof(pwg) / 3, 3)) != sizeof(pwg_packed) || memcmp(dst, pwg_packed, sizeof(pwg_packed)))
+  {
+    testEndMessage(false, "RGB example compressed to %u bytes", (unsigned)bytes);
+    goto done;
+  }
+
+  if (papplRasterCompressPWG(dst, sizeof(pwg_packed) - 1, pwg, 3, sizeof(pwg) / 3, 3) != 0)
+  {
+    testEndMessage(false, "RGB example did not detect short buffer");
+    goto done;
+  }
+
+  // Check bands of lines with repeated lines...
+  for (bpp = 1; bpp <= 8; bpp ++)
+  {
+    for (bpl = bpp; bpl <= (size_t)(4 * LINE_WIDTH); bpl += bpl < (size_t)(bpp * 300) ? bpp : (size_t)(bpp * 1201))
+    {
+      for (count = 1; count <= 300; count += count < 4 ? 1 : 148)
+      {
+        for (i = 0; i < count; i ++)
+        {
+          if ((i % 5) == 0 || count < 4)
+            make_line(src + i * bpl, bpl, i * 7 + bpp + (unsigned)bpl);
+          else
+            memcpy(src + i * bpl, src + (i - 1) * bpl, bpl);
+        }
+
+        bytes = papplRasterCompressPWG(dst, count * (2 * bpl + 1), src, count, bpl, bpp);
+
+        if (bytes == 0 || !decompress_pwg(actual, dst, bytes, count, bpl, bpp) || memcmp(actual, src, count * bpl))
+        {
+          testEndMessage(false, "%u lines of %u bytes with %u bytes per pixel differ", count, (unsigned)bpl, bpp);
+          goto done;
+        }
+      }
+    }
+  }
+
+  // Check a band of identical lines using the maximum repeat count...
+  memset(src, 0, 300 * LINE_WIDTH);
+
+  if ((bytes = papplRasterCompressPWG(dst, 300 * (2 * LINE_WIDTH + 1), src, 300, LINE_WIDTH, 1)) != (2 * (1 + 2 * ((LINE_WIDTH + 127) / 128))))
+  {
+    testEndMessage(false, "300 blank lines compressed to %u bytes", (unsigned)bytes);
+    goto done;
+  }
+
+  testEnd(true);
+
+  ret = true;
+
+  done:
+
+  free(src);
+  free(dst);
+  free(expected);
+  free(actual);
+
+  return (ret);
+}
+
+
+//
+// 'test_dither()' - Test that dithered lines match the original code.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_dither(pappl_dither_t dither,	// I - Dither matrix
+            _pappl_simd_t  simd)	// I - SIMD instruction set
+{
+  unsigned	i,			// Looping var
+		x,			// First column
+		count;			// Number of pixels
+  int		black;			// Black pixels?
+  unsigned char	src[LINE_WIDTH],	// Source pixels
+		expected[LINE_WIDTH / 8 + 2],
+					// Expected output
+		actual[LINE_WIDTH / 8 + 2];
+					// Actual output
+
+
+  testBegin("_papplRasterDitherLine(%s)", simd_string(simd));
+
+  for (i = 0; i < LINE_WIDTH; i ++)
+    src[i] = (unsigned char)(cupsGetRand() & 255);
+
+  for (black = 0; black < 2; black ++)
+  {
+    for (x = 0; x < 16; x ++)
+    {
+      for (count = 0; (x + count) <= LINE_WIDTH; count += count < 80 ? 1 : 997)
+      {
+        memset(expected, 0x55, sizeof(expected));
+        memset(actual, 0x55, sizeof(actual));
+
+        dither_line(expected, src, x, count, dither[(x + count) & 15], black != 0);
+        _papplRasterDitherLine(actual, src, x, count, dither[(x + count) & 15], black != 0);
+
+        if (count > 0 && memcmp(expected, actual, sizeof(expected)))
+        {
+          testEndMessage(false, "%s x=%u, count=%u differs", black ? "black" : "gray", x, count);
+          return (false);
+        }
+      }
+    }
+  }
+
+  testEnd(true);
+
+  return (true);
+}
+
+
+//
+// 'test_render()' - Test that rendering with multiple threads matches one thread.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_render(pappl_dither_t dither)	// I - Dither matrix
+{
+  bool			ret = true;	// Return value
+  unsigned		i,		// Looping var
+			num_threads;	// Number of threads
+  uint32_t		checksum,	// Checksum for N threads
+			one_checksum = 0;
+					// Checksum for one thread
+  _test_image_t		image;		// Test image
+
+
+  memset(&image, 0, sizeof(image));
+
+  image.width       = 333;
+  image.height      = 517;
+  image.depth       = 3;
+  image.orientation = IPP_ORIENT_PORTRAIT;
+
+  if ((image.pixels = malloc((size_t)image.width * image.height * image.depth)) == NULL)
+  {
+    testBegin("_papplRasterBandsRender");
+    testEndMessage(false, "%s", strerror(errno));
+    return (false);
+  }
+
+  for (i = 0; i < (image.width * image.height * image.depth); i ++)
+    image.pixels[i] = (unsigned char)(cupsGetRand() & 255);
+
+  for (num_threads = 1; num_threads <= MAX_THREADS && ret; num_threads ++)
+  {
+    testBegin("_papplRasterBandsRender(%u thread%s)", num_threads, num_threads == 1 ? "" : "s");
+
+    if (!render_image(&image, 1021, 1587, num_threads, &dither[0][0], &checksum))
+    {
+      testEndMessage(false, "lines not rendered in order");
+      ret = false;
+    }
+    else if (num_threads == 1)
+    {
+      one_checksum = checksum;
+      testEnd(true);
+    }
+    else if (checksum != one_checksum)
+    {
+      testEndMessage(false, "got checksum %08x, expected %08x", checksum, one_checksum);
+      ret = false;
+    }
+    else
+    {
+      testEnd(true);
+    }
+  }
+
+  free(image.pixels);
+
+  return (ret);
+}
+
+
+//
+// 'test_rotate()' - Test copying bands of lines from rotated images.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_rotate(void)
+{
+  unsigned		i,		// Looping var
+			o,		// Current orientation
+			x, y,		// Looping vars
+			depth,		// Bytes per pixel
+			lines,		// Number of rotated lines
+			count,		// Number of lines in band
+			sx, sy;		// Source column and line
+  ipp_orient_t		orient;		// Orientation
+  static const ipp_orient_t orients[] =	// Orientations to test
+  {
+    IPP_ORIENT_PORTRAIT,
+    IPP_ORIENT_LANDSCAPE,
+    IPP_ORIENT_REVERSE_LANDSCAPE,
+    IPP_ORIENT_REVERSE_PORTRAIT
+  };
+  unsigned char		pixels[37 * 23 * 3],
+					// Source pixels
+			band[ROTATE_BAND * 37 * 3],
+					// Band of rotated lines
+			*bandptr;	// Pointer into band
+
+
+  for (i = 0; i < sizeof(pixels); i ++)
+    pixels[i] = (unsigned char)(cupsGetRand() & 255);
+
+  for (o = 0; o < (sizeof(orients) / sizeof(orients[0])); o ++)
+  {
+    orient = orients[o];
+
+    testBegin("_papplRasterRotate(%s)", orient_string(orient));
+
+    for (depth = 1; depth <= 3; depth += 2)
+    {
+      lines = (orient == IPP_ORIENT_LANDSCAPE || orient == IPP_ORIENT_REVERSE_LANDSCAPE) ? 37 : 23;
+
+      for (y = 0; y < lines; y += count)
+      {
+        if ((count = (y % 5) + 1) > (lines - y))
+          count = lines - y;
+
+        _papplRasterRotate(band, pixels, 37, 23, depth, orient, y, count);
+
+        for (i = 0, bandptr = band; i < count; i ++)
+        {
+          for (x = 0; x < (37 * 23 / lines); x ++, bandptr += depth)
+          {
+            switch (orient)
+            {
+              default :
+                  sx = x;
+                  sy = y + i;
+                  break;
+              case IPP_ORIENT_LANDSCAPE :
+                  sx = 36 - y - i;
+                  sy = x;
+                  break;
+              case IPP_ORIENT_REVERSE_LANDSCAPE :
+                  sx = y + i;
+                  sy = 22 - x;
+                  break;
+              case IPP_ORIENT_REVERSE_PORTRAIT :
+                  sx = 36 - x;
+                  sy = 22 - y - i;
+                  break;
+            }
+
+            if (memcmp(bandptr, pixels + (sy * 37 + sx) * depth, depth))
+            {
+              testEndMessage(false, "depth=%u, line %u, column %u differs", depth, y + i, x);
+              return (false);
+            }
+          }
+        }
+      }
+    }
+
+    testEnd(true);
+  }
+
+  return (true);
+}
+
+
+//
+// 'test_scale()' - Test that scaled images match the portable C code.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_scale(_pappl_simd_t simd)		// I - SIMD instruction set
+{
+  bool			ret = true;	// Return value
+  unsigned		i,		// Looping var
+			x, y,		// Looping vars
+			depth;		// Bytes per pixel
+  int			smoothing;	// Smooth image?
+  _test_image_t		image;		// Test image
+  _pappl_rscale_t	*scale;		// Image scaler
+  const unsigned char	*line;		// Scaled line
+  unsigned char		*expected = NULL;
+					// Expected output
+  static const unsigned sizes[][6] =	// Test sizes (in w, in h, out w, out h, out x, out count)
+  {
+    { 97, 61, 97, 61, 0, 97 },		// Same size
+    { 97, 61, 1000, 800, 0, 1000 },	// Enlarge
+    { 97, 61, 1000, 800, 333, 400 },	// Enlarge and crop
+    { 1001, 777, 97, 61, 0, 97 },	// Reduce
+    { 1001, 777, 2000, 500, 7, 1900 },	// Enlarge columns and reduce lines
+    { 1, 1, 50, 50, 0, 50 }		// Single pixel
+  };
+
+
+  testBegin("_papplRasterScaleGetLine(%s)", simd_string(simd));
+
+  for (depth = 1; depth <= 3 && ret; depth += 2)
+  {
+    for (smoothing = 0; smoothing < 2 && ret; smoothing ++)
+    {
+      for (i = 0; i < (sizeof(sizes) / sizeof(sizes[0])) && ret; i ++)
+      {
+        size_t	bytes = (size_t)sizes[i][5] * depth;
+					// Bytes per line
+
+        memset(&image, 0, sizeof(image));
+
+        image.width       = sizes[i][0];
+        image.height      = sizes[i][1];
+        image.depth       = depth;
+        image.orientation = IPP_ORIENT_PORTRAIT;
+
+        if ((image.pixels = malloc((size_t)image.width * image.height * depth)) == NULL || (expected = malloc(bytes * sizes[i][3])) == NULL)
+        {
+          testEndMessage(false, "unable to allocate memory");
+          free(image.pixels);
+          return (false);
+        }
+
+        for (x = 0; x < image.width * image.height * depth; x ++)
+          image.pixels[x] = (unsigned char)(cupsGetRand() & 255);
+
+        // Generate the expected output with the portable C code...
+        _papplRasterSetSIMD(_PAPPL_SIMD_NONE);
+
+        if ((scale = _papplRasterScaleCreate(depth, sizes[i][0], sizes[i][1], sizes[i][2], sizes[i][3], sizes[i][4], sizes[i][5], smoothing != 0, (_pappl_rscale_cb_t)image_row_cb, &image)) == NULL)
+        {
+          testEndMessage(false, "unable to create scaler");
+          ret = false;
+        }
+
+        for (y = 0; y < sizes[i][3] && ret; y ++)
+        {
+          if ((line = _papplRasterScaleGetLine(scale, y)) == NULL)
+          {
+            testEndMessage(false, "unable to get line %u", y);
+            ret = false;
+          }
+          else
+          {
+            memcpy(expected + y * bytes, line, bytes);
+          }
+        }
+
+        _papplRasterScaleDelete(scale);
+
+        // Unscaled images should be unchanged...
+        if (ret && sizes[i][0] == sizes[i][2] && sizes[i][1] == sizes[i][3] && memcmp(expected, image.pixels, bytes * sizes[i][3]))
+        {
+          testEndMessage(false, "%ux%ux%u image changed when not scaled", sizes[i][0], sizes[i][1], depth);
+          ret = false;
+        }
+
+        // Then compare against the SIMD code...
+        _papplRasterSetSIMD(simd);
+
+        scale = NULL;
+
+        if (ret && (scale = _papplRasterScaleCreate(depth, sizes[i][0], sizes[i][1], sizes[i][2], sizes[i][3], sizes[i][4], sizes[i][5], smoothing != 0, (_pappl_rscale_cb_t)image_row_cb, &image)) == NULL)
+        {
+          testEndMessage(false, "unable to create scaler");
+          ret = false;
+        }
+
+        for (y = 0; y < sizes[i][3] && ret; y ++)
+        {
+          if ((line = _papplRasterScaleGetLine(scale, y)) == NULL || memcmp(expected + y * bytes, line, bytes))
+          {
+            testEndMessage(false, "%ux%ux%u to %ux%u%s differs at line %u", sizes[i][0], sizes[i][1], depth, sizes[i][2], sizes[i][3], smoothing ? " smoothed" : "", y);
+            ret = false;
+          }
+        }
+
+        _papplRasterScaleDelete(scale);
+
+        free(image.pixels);
+        free(expected);
+      }
+    }
+  }
+
+  if (ret)
+    testEnd(true);
+
+  return (ret);
+}
+
+
+//
+// 'time_blank()' - Time checking for blank lines.
+//
+
+static double				// O - Elapsed time in seconds
+time_blank(size_t num_lines)		// I - Number of lines
+{
+  size_t	y,			// Current line
+		blank = 0;		// Number of blank lines
+  unsigned char	line[LINE_WIDTH];	// Line
+  double	start;			// Start time
+
+
+  memset(line, 0, sizeof(line));
+
+  start = testGetTime();
+
+  for (y = 0; y < num_lines; y ++)
+  {
+    if (_papplRasterIsBlank(line, sizeof(line), 0))
+      blank ++;
+  }
+
+  return (blank == num_lines ? testGetTime() - start : 0.0);
+}
+
+
+//
+// 'time_compress()' - Time compressing lines.
+//
+
+static double				// O - Elapsed time in seconds
+time_compress(size_t num_lines,		// I - Number of lines
+              bool   pwg,		// I - Use PWG raster compression?
+              bool   reference,		// I - Time the per-byte loop?
+              size_t *bytes)		// O - Number of compressed bytes
+{
+  size_t	y;			// Current line
+  unsigned	i,			// Looping var
+		count;			// Number of lines in band
+  unsigned char	*src,			// Band of source lines
+		*dst;			// Compressed lines
+  double	start,			// Start time
+		elapsed;		// Elapsed time
+
+
+  *bytes = 0;
+
+  if ((src = malloc(RENDER_BAND * LINE_WIDTH)) == NULL || (dst = malloc(RENDER_BAND * (2 * LINE_WIDTH + 1))) == NULL)
+  {
+    free(src);
+    return (0.0);
+  }
+
+  // Use a band with groups of 4 identical lines...
+  for (i = 0; i < RENDER_BAND; i ++)
+  {
+    if (i & 3)
+      memcpy(src + i * LINE_WIDTH, src + (i - 1) * LINE_WIDTH, LINE_WIDTH);
+    else
+      make_line(src + i * LINE_WIDTH, LINE_WIDTH, i);
+  }
+
+  start = testGetTime();
+
+  for (y = 0; y < num_lines; y += count)
+  {
+    if ((count = RENDER_BAND) > (num_lines - y))
+      count = (unsigned)(num_lines - y);
+
+    if (pwg)
+    {
+      *bytes += papplRasterCompressPWG(dst, RENDER_BAND * (2 * LINE_WIDTH + 1), src, count, LINE_WIDTH, 1);
+    }
+    else
+    {
+      for (i = 0; i < count; i ++)
+      {
+        if (reference)
+          *bytes += compress_line(dst, src + i * LINE_WIDTH, LINE_WIDTH);
+        else
+          *bytes += papplRasterCompressPackBits(dst, 2 * LINE_WIDTH + 1, src + i * LINE_WIDTH, LINE_WIDTH);
+      }
+    }
+  }
+
+  elapsed = testGetTime() - start;
+
+  free(src);
+  free(dst);
+
+  return (elapsed);
+}
+
+
+//
+// 'time_dither()' - Time dithering a page of lines.
+//
+
+static double				// O - Elapsed time in seconds
+time_dither(pappl_dither_t dither,	// I - Dither matrix
+            size_t         num_lines,	// I - Number of lines
+            bool           reference)	// I - Time the original code?
+{
+  size_t	y;			// Current line
+  unsigned	i;			// Looping var
+  unsigned char	src[LINE_WIDTH],	// Source pixels
+		dst[LINE_WIDTH / 8 + 1];// Output line
+  double	start;			// Start time
+
+
+  for (i = 0; i < LINE_WIDTH; i ++)
+    src[i] = (unsigned char)(i & 255);
+
+  start = testGetTime();
+
+  for (y = 0; y < num_lines; y ++)
+  {
+    if (reference)
+      dither_line(dst, src, 0, LINE_WIDTH, dither[y & 15], false);
+    else
+      _papplRasterDitherLine(dst, src, 0, LINE_WIDTH, dither[y & 15], false);
+  }
+
+  return (testGetTime() - start);
+}
+
+
+//
+// 'time_render()' - Time scaling and dithering an image with multiple threads.
+//
+
+static double				// O - Elapsed time in seconds
+time_render(
+    _test_image_t       *image,		// I - Test image
+    unsigned            dpi,		// I - Output resolution
+    unsigned            num_threads,	// I - Number of threads
+    const unsigned char *dither)	// I - Dither matrix
+{
+  unsigned	xsize,			// Scaled width
+		ysize;			// Scaled height
+  uint32_t	checksum;		// Checksum of output lines
+  double	start;			// Start time
+
+
+  // Fit the image on an 8.5x11" page...
+  xsize = 17 * dpi / 2;
+  ysize = xsize * image->height / image->width;
+
+  if (ysize > (11 * dpi))
+  {
+    ysize = 11 * dpi;
+    xsize = ysize * image->width / image->height;
+  }
+
+  start = testGetTime();
+
+  if (!render_image(image, xsize, ysize, num_threads, dither, &checksum))
+    return (0.0);
+
+  return (testGetTime() - start);
+}
+
+
+//
+// 'time_scale()' - Time scaling an image to fit a letter-size page.
+//
+
+static double				// O - Elapsed time in seconds
+time_scale(_test_image_t *image,	// I - Test image
+           unsigned      dpi,		// I - Output resolution
+           bool          reference)	// I - Time the original code?
+{
+  unsigned		width,		// Rotated width
+			height,		// Rotated height
+			xsize,		// Scaled width
+			ysize,		// Scaled height
+			y;		// Current line
+  unsigned char		*line;		// Output line
+  _pappl_rscale_t	*scale;		// Image scaler
+  double		start;		// Start time
+
+
+  if (image->orientation == IPP_ORIENT_LANDSCAPE || image->orientation == IPP_ORIENT_REVERSE_LANDSCAPE)
+  {
+    width  = image->height;
+    height = image->width;
+  }
+  else
+  {
+    width  = image->width;
+    height = image->height;
+  }
+
+  // Fit the image on an 8.5x11" page...
+  xsize = 17 * dpi / 2;
+  ysize = xsize * height / width;
+
+  if (ysize > (11 * dpi))
+  {
+    ysize = 11 * dpi;
+    xsize = ysize * width / height;
+  }
+
+  if ((line = malloc((size_t)xsize * image->depth)) == NULL)
+    return (0.0);
+
+  start = testGetTime();
+
+  if (reference)
+  {
+    scale_reference(image, xsize, ysize, line);
+  }
+  else if ((scale = _papplRasterScaleCreate(image->depth, width, height, xsize, ysize, 0, xsize, true, (_pappl_rscale_cb_t)image_row_cb, image)) != NULL)
+  {
+    image->band_count = 0;
+
+    for (y = 0; y < ysize; y ++)
+      memcpy(line, _papplRasterScaleGetLine(scale, y), (size_t)xsize * image->depth);
+
+    _papplRasterScaleDelete(scale);
+  }
+
+  free(line);
+
+  return (testGetTime() - start);
+}
+
+
+//
+// 'write_band_cb()' - Check and checksum a band of lines.
+//
+
+static bool				// O - `true` to continue
+write_band_cb(_test_render_t      *render,// I - Rendering state
+              unsigned            y,	// I - First line
+              unsigned            count,// I - Number of lines
+              const unsigned char *lines)// I - Lines in band
+{
+  size_t	i;			// Looping var
+
+
+  if (y != render->next_y)
+    render->in_order = false;
+
+  render->next_y = y + count;
+
+  // Update the FNV-1a hash of the lines...
+  for (i = count * render->bytes_per_line; i > 0; i --, lines ++)
+    render->checksum = (render->checksum ^ *lines) * 16777619U;
+
+  return (true);
+}
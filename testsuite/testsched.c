@@ -0,0 +1,628 @@
+//
+// Job scheduling unit tests and benchmark for the Printer Application
+// Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ./testsched [NUMBER-OF-JOBS]
+//
+// The default number of jobs is small enough for "make test" - use a larger
+// count such as 100000 to benchmark.
+//
+
+#include <pappl/pappl-private.h>
+#include "test.h"
+
+
+//
+// Constants...
+//
+
+#define NUM_JOBS	1000		// Default number of jobs for benchmark
+#define NUM_USERS	100		// Number of users for benchmark
+
+
+//
+// Local globals...
+//
+
+static char	usernames[NUM_USERS][32];
+					// Usernames
+
+
+//
+// Local functions...
+//
+
+static pappl_printer_t	*create_printer(bool fair_share, int priority_aging);
+static pappl_job_t	**create_jobs(size_t num_jobs, size_t num_users, time_t created);
+static void		delete_jobs(pappl_job_t **jobs, size_t num_jobs);
+static void		delete_printer(pappl_printer_t *printer);
+static bool		run_benchmark(size_t num_jobs, bool fair_share);
+static bool		test_aging(void);
+static bool		test_fair_share(void);
+static bool		test_next_jobs(void);
+static bool		test_priority(void);
+static bool		test_timers(size_t num_jobs);
+
+
+//
+// 'main()' - Test the job scheduler.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  bool		pass = true;		// Pass or fail
+  size_t	i,			// Looping var
+		num_jobs = NUM_JOBS;	// Number of jobs for benchmark
+
+
+  if (argc > 1 && (num_jobs = (size_t)strtol(argv[1], NULL, 10)) < 1)
+  {
+    fprintf(stderr, "Usage: %s [NUMBER-OF-JOBS]\n", argv[0]);
+    return (1);
+  }
+
+  for (i = 0; i < NUM_USERS; i ++)
+    snprintf(usernames[i], sizeof(usernames[i]), "user%03u", (unsigned)i);
+
+  pass &= test_priority();
+  pass &= test_aging();
+  pass &= test_fair_share();
+  pass &= test_next_jobs();
+  pass &= test_timers(num_jobs);
+  pass &= run_benchmark(num_jobs, false);
+  pass &= run_benchmark(num_jobs, true);
+
+  return (pass ? 0 : 1);
+}
+
+
+//
+// 'create_jobs()' - Create an array of pending jobs.
+//
+// Jobs are assigned pseudo-random priorities and round-robin usernames.
+//
+
+static pappl_job_t **			// O - Array of jobs
+create_jobs(size_t num_jobs,		// I - Number of jobs
+            size_t num_users,		// I - Number of users
+            time_t created)		// I - Creation time
+{
+  size_t	i;			// Looping var
+  pappl_job_t	**jobs,			// Jobs
+		*job;			// Current job
+  unsigned	seed = 1;		// Pseudo-random seed
+
+
+  if ((jobs = calloc(num_jobs, sizeof(pappl_job_t *))) == NULL)
+  {
+    perror("testsched");
+    exit(1);
+  }
+
+  for (i = 0; i < num_jobs; i ++)
+  {
+    if ((job = calloc(1, sizeof(pappl_job_t))) == NULL)
+    {
+      perror("testsched");
+      exit(1);
+    }
+
+    cupsRWInit(&job->rwlock);
+
+    seed = seed * 1103515245 + 12345;
+
+    job->job_id   = (int)i + 1;
+    job->username = usernames[i % num_users];
+    job->priority = (int)((seed >> 16) % 100) + 1;
+    job->created  = created;
+    job->state    = IPP_JSTATE_PENDING;
+
+    jobs[i] = job;
+  }
+
+  return (jobs);
+}
+
+
+//
+// 'create_printer()' - Create a printer object for scheduling.
+//
+
+static pappl_printer_t *		// O - Printer
+create_printer(bool fair_share,		// I - Use fair-share scheduling?
+               int  priority_aging)	// I - Priority aging interval
+{
+  pappl_printer_t	*printer;	// Printer
+
+
+  if ((printer = calloc(1, sizeof(pappl_printer_t))) == NULL)
+  {
+    perror("testsched");
+    exit(1);
+  }
+
+  printer->active_jobs    = cupsArrayNew(NULL, NULL, NULL, 0, NULL, NULL);
+  printer->fair_share     = fair_share;
+  printer->priority_aging = priority_aging;
+
+  return (printer);
+}
+
+
+//
+// 'delete_jobs()' - Free an array of jobs.
+//
+
+static void
+delete_jobs(pappl_job_t **jobs,		// I - Jobs
+            size_t      num_jobs)	// I - Number of jobs
+{
+  size_t	i;			// Looping var
+
+
+  for (i = 0; i < num_jobs; i ++)
+  {
+    cupsRWDestroy(&jobs[i]->rwlock);
+    free(jobs[i]);
+  }
+
+  free(jobs);
+}
+
+
+//
+// 'delete_printer()' - Delete a printer object.
+//
+
+static void
+delete_printer(
+    pappl_printer_t *printer)		// I - Printer
+{
+  _papplHeapDelete(printer->pending_jobs);
+  _papplHeapDelete(printer->share_heap);
+  _papplHeapDelete(printer->timer_jobs);
+  cupsArrayDelete(printer->shares);
+  cupsArrayDelete(printer->active_jobs);
+  free(printer);
+}
+
+
+//
+// 'run_benchmark()' - Time queuing and selecting jobs.
+//
+// The linear scan of the previous scheduler is measured on a subset of the
+// jobs since it is O(n^2) for the whole queue.
+//
+
+static bool				// O - `true` on success, `false` on failure
+run_benchmark(size_t num_jobs,		// I - Number of jobs
+              bool   fair_share)	// I - Use fair-share scheduling?
+{
+  bool			pass = true;	// Pass or fail
+  size_t		i,		// Looping var
+			count,		// Number of jobs selected
+			num_scan;	// Number of linear scans
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		**jobs,		// Jobs
+			*job,		// Current job
+			*best;		// Best job for linear scan
+  double		start,		// Start time
+			queue_time,	// Time to queue jobs
+			select_time,	// Time to select jobs
+			scan_time;	// Time for linear scans
+
+
+  testBegin("benchmark: %u jobs, %s", (unsigned)num_jobs, fair_share ? "fair-share" : "priority");
+
+  printer = create_printer(fair_share, 0);
+  jobs    = create_jobs(num_jobs, NUM_USERS, time(NULL));
+
+  // Queue all of the jobs...
+  start = testGetTime();
+  for (i = 0; i < num_jobs; i ++)
+    _papplPrinterQueueJobNoLock(printer, jobs[i]);
+  queue_time = testGetTime() - start;
+
+  // Select all of the jobs...
+  start = testGetTime();
+  for (count = 0; (job = _papplPrinterDequeueJobNoLock(printer)) != NULL; count ++)
+    job->state = IPP_JSTATE_COMPLETED;
+  select_time = testGetTime() - start;
+
+  if (count != num_jobs)
+  {
+    testEndMessage(false, "got %u jobs, expected %u", (unsigned)count, (unsigned)num_jobs);
+    pass = false;
+  }
+
+  // Time a linear scan for the highest priority pending job...
+  for (i = 0; i < num_jobs; i ++)
+    jobs[i]->state = IPP_JSTATE_PENDING;
+
+  num_scan = num_jobs < 1000 ? num_jobs : 1000;
+  start    = testGetTime();
+
+  for (count = 0; count < num_scan; count ++)
+  {
+    for (i = 0, best = NULL; i < num_jobs; i ++)
+    {
+      if (jobs[i]->state == IPP_JSTATE_PENDING && (!best || jobs[i]->priority > best->priority))
+        best = jobs[i];
+    }
+
+    if (best)
+      best->state = IPP_JSTATE_COMPLETED;
+  }
+
+  scan_time = testGetTime() - start;
+
+  if (pass)
+    testEndMessage(true, "queue %.3fus/job, select %.3fus/job, linear scan %.3fus/job", 1000000.0 * queue_time / num_jobs, 1000000.0 * select_time / num_jobs, 1000000.0 * scan_time / num_scan);
+
+  delete_printer(printer);
+  delete_jobs(jobs, num_jobs);
+
+  return (pass);
+}
+
+
+//
+// 'test_aging()' - Test priority aging.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_aging(void)
+{
+  bool			pass = true;	// Pass or fail
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		**jobs,		// Jobs
+			*job;		// Current job
+  time_t		curtime = time(NULL);
+					// Current time
+
+
+  testBegin("priority aging");
+
+  printer = create_printer(false, 10);
+  jobs    = create_jobs(2, 1, curtime);
+
+  // Job 1 is priority 20 and has waited 1000 seconds (+100 levels), job 2 is
+  // priority 100 and was just submitted...
+  jobs[0]->priority = 20;
+  jobs[0]->created  = curtime - 1000;
+  jobs[1]->priority = 100;
+
+  cupsArrayAdd(printer->active_jobs, jobs[0]);
+  cupsArrayAdd(printer->active_jobs, jobs[1]);
+
+  _papplPrinterQueueJobNoLock(printer, jobs[1]);
+  _papplPrinterQueueJobNoLock(printer, jobs[0]);
+
+  if ((job = _papplPrinterDequeueJobNoLock(printer)) != jobs[0])
+  {
+    testEndMessage(false, "got job %d first, expected job 1", job ? job->job_id : 0);
+    pass = false;
+  }
+  else
+  {
+    // Disabling aging puts the priority 100 job first...
+    printer->priority_aging = 0;
+
+    _papplPrinterRebuildQueueNoLock(printer);
+
+    if ((job = _papplPrinterDequeueJobNoLock(printer)) != jobs[1])
+    {
+      testEndMessage(false, "got job %d first without aging, expected job 2", job ? job->job_id : 0);
+      pass = false;
+    }
+  }
+
+  if (pass)
+    testEnd(true);
+
+  delete_printer(printer);
+  delete_jobs(jobs, 2);
+
+  return (pass);
+}
+
+
+//
+// 'test_fair_share()' - Test weighted fair-share scheduling.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_fair_share(void)
+{
+  bool			pass = true;	// Pass or fail
+  size_t		i,		// Looping var
+			counts[2];	// Number of jobs for each user
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		**jobs,		// Jobs
+			*job;		// Current job
+  _pappl_share_t	*share;		// Fair-share user
+
+
+  testBegin("weighted fair-share");
+
+  printer = create_printer(true, 0);
+  jobs    = create_jobs(200, 1, time(NULL));
+
+  // user000 submits 180 jobs before user001 submits 20 jobs, all at the same
+  // priority.  user000 gets a weight of 3...
+  for (i = 0; i < 200; i ++)
+  {
+    jobs[i]->priority = 50;
+    jobs[i]->username = usernames[i < 180 ? 0 : 1];
+  }
+
+  if ((share = _papplPrinterGetShareNoLock(printer, usernames[0], true)) == NULL)
+  {
+    testEndMessage(false, "unable to create fair-share user");
+    pass = false;
+    goto done;
+  }
+
+  share->weight = 3;
+
+  for (i = 0; i < 200; i ++)
+    _papplPrinterQueueJobNoLock(printer, jobs[i]);
+
+  // The first 40 jobs should be split 3:1...
+  for (i = 0, counts[0] = 0, counts[1] = 0; i < 40; i ++)
+  {
+    if ((job = _papplPrinterDequeueJobNoLock(printer)) == NULL)
+      break;
+
+    counts[job->username == usernames[0] ? 0 : 1] ++;
+    job->state = IPP_JSTATE_COMPLETED;
+  }
+
+  if (counts[0] != 30 || counts[1] != 10)
+  {
+    testEndMessage(false, "got %u/%u jobs, expected 30/10", (unsigned)counts[0], (unsigned)counts[1]);
+    pass = false;
+  }
+  else
+  {
+    // Holding a job removes it from the queue...
+    job        = jobs[190];
+    job->state = IPP_JSTATE_HELD;
+    _papplPrinterUnqueueJobNoLock(printer, job);
+
+    if (job->sched_index)
+    {
+      testEndMessage(false, "held job still queued");
+      pass = false;
+    }
+  }
+
+  if (pass)
+  {
+    // Then the remaining jobs should all be selected...
+    for (i = 0; _papplPrinterDequeueJobNoLock(printer); i ++);
+
+    if (i != 159)
+    {
+      testEndMessage(false, "got %u remaining jobs, expected 159", (unsigned)i);
+      pass = false;
+    }
+    else
+    {
+      testEnd(true);
+    }
+  }
+
+  done:
+
+  delete_printer(printer);
+  delete_jobs(jobs, 200);
+
+  return (pass);
+}
+
+
+//
+// 'test_next_jobs()' - Test looking at the next jobs without removing them.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_next_jobs(void)
+{
+  bool			pass = true;	// Pass or fail
+  size_t		i,		// Looping var
+			count;		// Number of jobs
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		**jobs,		// Jobs
+			*next[10];	// Next jobs
+
+
+  testBegin("next jobs");
+
+  printer = create_printer(true, 0);
+  jobs    = create_jobs(100, 4, time(NULL));
+
+  for (i = 0; i < 100; i ++)
+    _papplPrinterQueueJobNoLock(printer, jobs[i]);
+
+  if ((count = _papplPrinterGetNextJobsNoLock(printer, 10, next)) != 10)
+  {
+    testEndMessage(false, "got %u jobs, expected 10", (unsigned)count);
+    pass = false;
+  }
+
+  for (i = 0; pass && i < count; i ++)
+  {
+    if (_papplPrinterDequeueJobNoLock(printer) != next[i])
+    {
+      testEndMessage(false, "job %u did not match", (unsigned)i);
+      pass = false;
+    }
+  }
+
+  if (pass)
+    testEnd(true);
+
+  delete_printer(printer);
+  delete_jobs(jobs, 100);
+
+  return (pass);
+}
+
+
+//
+// 'test_priority()' - Test "job-priority" ordering.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_priority(void)
+{
+  bool			pass = true;	// Pass or fail
+  size_t		i;		// Looping var
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		**jobs,		// Jobs
+			*job,		// Current job
+			*last = NULL;	// Previous job
+
+
+  testBegin("job-priority");
+
+  printer = create_printer(false, 0);
+  jobs    = create_jobs(1000, NUM_USERS, time(NULL));
+
+  for (i = 0; i < 1000; i ++)
+    _papplPrinterQueueJobNoLock(printer, jobs[i]);
+
+  // Cancel one of the jobs...
+  jobs[500]->state = IPP_JSTATE_CANCELED;
+  _papplPrinterUnqueueJobNoLock(printer, jobs[500]);
+
+  // Jobs must come out in priority order, and in submission order for the same
+  // priority...
+  for (i = 0; (job = _papplPrinterDequeueJobNoLock(printer)) != NULL; i ++, last = job)
+  {
+    if (last && (job->priority > last->priority || (job->priority == last->priority && job->job_id < last->job_id)))
+    {
+      testEndMessage(false, "job %d (priority %d) after job %d (priority %d)", job->job_id, job->priority, last->job_id, last->priority);
+      pass = false;
+      break;
+    }
+  }
+
+  if (pass && i != 999)
+  {
+    testEndMessage(false, "got %u jobs, expected 999", (unsigned)i);
+    pass = false;
+  }
+
+  if (pass)
+    testEnd(true);
+
+  delete_printer(printer);
+  delete_jobs(jobs, 1000);
+
+  return (pass);
+}
+
+
+//
+// 'test_timers()' - Test hold-until timers.
+//
+// One percent of the held jobs are due, so releasing them should only touch
+// those jobs and not the whole queue.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_timers(size_t num_jobs)		// I - Number of jobs
+{
+  bool			pass = true;	// Pass or fail
+  size_t		i,		// Looping var
+			num_due = 0;	// Number of jobs that are due
+  pappl_system_t	*system;	// System
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		**jobs;		// Jobs
+  time_t		curtime = time(NULL);
+					// Current time
+  double		start,		// Start time
+			run_time;	// Time to run timers
+  char			spooldir[256];	// Spool directory
+
+
+  testBegin("hold-until timers: %u jobs", (unsigned)num_jobs);
+
+  snprintf(spooldir, sizeof(spooldir), "%s/testsched%d", papplGetTempDir(), (int)getpid());
+
+  if ((system = papplSystemCreate(PAPPL_SOPTIONS_NO_DNS_SD, "Test Sched", 0, NULL, spooldir, "-", PAPPL_LOGLEVEL_ERROR, NULL, false)) == NULL)
+  {
+    testEndMessage(false, "unable to create system");
+    return (false);
+  }
+
+  printer = create_printer(false, 0);
+  jobs    = create_jobs(num_jobs, NUM_USERS, curtime);
+
+  printer->system = system;
+  printer->state  = IPP_PSTATE_STOPPED;	// Don't start released jobs
+
+  for (i = 0; i < num_jobs; i ++)
+  {
+    jobs[i]->printer    = printer;
+    jobs[i]->system     = system;
+    jobs[i]->state      = IPP_JSTATE_HELD;
+    jobs[i]->hold_until = (i % 100) == 0 ? curtime - 1 : curtime + 3600 + (time_t)i;
+
+    if (jobs[i]->hold_until <= curtime)
+      num_due ++;
+
+    _papplPrinterUpdateJobTimerNoLock(printer, jobs[i]);
+  }
+
+  if (_papplSystemSetWakeTime(system, curtime + 30) != curtime - 1)
+  {
+    testEndMessage(false, "wake time not set to first hold-until time");
+    pass = false;
+  }
+  else
+  {
+    start = testGetTime();
+    _papplPrinterRunTimersNoLock(printer, curtime);
+    run_time = testGetTime() - start;
+
+    if (_papplHeapGetCount(printer->pending_jobs) != num_due)
+    {
+      testEndMessage(false, "got %u released jobs, expected %u", (unsigned)_papplHeapGetCount(printer->pending_jobs), (unsigned)num_due);
+      pass = false;
+    }
+    else if (_papplHeapGetCount(printer->timer_jobs) != (num_jobs - num_due))
+    {
+      testEndMessage(false, "got %u held jobs, expected %u", (unsigned)_papplHeapGetCount(printer->timer_jobs), (unsigned)(num_jobs - num_due));
+      pass = false;
+    }
+    else if (num_jobs > num_due && printer->timer_time != (curtime + 3601))
+    {
+      testEndMessage(false, "got next timer %ld, expected %ld", (long)(printer->timer_time - curtime), 3601L);
+      pass = false;
+    }
+    else
+    {
+      testEndMessage(true, "released %u jobs in %.3fus/job", (unsigned)num_due, 1000000.0 * run_time / (num_due ? num_due : 1));
+    }
+  }
+
+  delete_printer(printer);
+  delete_jobs(jobs, num_jobs);
+
+  papplSystemDelete(system);
+  rmdir(spooldir);
+
+  return (pass);
+}
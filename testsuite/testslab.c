@@ -0,0 +1,313 @@
+//
+// Slab allocator unit tests and benchmark for the Printer Application
+// Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ./testslab [NUMBER-OF-JOBS]
+//
+// By default a quick stress test is run - specify 1000000 jobs or more to
+// measure the memory usage of a large job history.
+//
+
+#include <pappl/pappl-private.h>
+#include "testpappl.h"
+#include "test.h"
+#include <sys/resource.h>
+
+
+//
+// Constants...
+//
+
+#define MAX_COMPLETED	100		// Maximum number of completed jobs
+#define NUM_JOBS	10000		// Default number of jobs for benchmark
+#define NUM_USERS	10		// Number of users
+
+
+//
+// Local functions...
+//
+
+static bool		test_slab(void);
+static bool		test_str(void);
+static bool		test_stress(pappl_printer_t *printer, size_t num_jobs);
+
+
+//
+// 'main()' - Test the slab allocators and string pool.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  bool			pass = true;	// Pass or fail
+  size_t		num_jobs = NUM_JOBS;
+					// Number of jobs for benchmark
+  char			spooldir[1024];	// Spool directory
+  pappl_system_t	*system;	// System
+  pappl_printer_t	*printer;	// Printer
+
+
+  if (argc > 1 && (num_jobs = (size_t)strtol(argv[1], NULL, 10)) < 1)
+  {
+    fprintf(stderr, "Usage: %s [NUMBER-OF-JOBS]\n", argv[0]);
+    return (1);
+  }
+
+  // Test the allocators directly...
+  pass &= test_slab();
+  pass &= test_str();
+
+  // Create and clean a lot of jobs...
+  snprintf(spooldir, sizeof(spooldir), "%s/testslab%d", papplGetTempDir(), (int)getpid());
+
+  testBegin("papplSystemCreate");
+
+  if ((system = papplSystemCreate(PAPPL_SOPTIONS_MULTI_QUEUE | PAPPL_SOPTIONS_NO_DNS_SD, "Test Slab", 0, NULL, spooldir, "-", PAPPL_LOGLEVEL_ERROR, NULL, false)) == NULL)
+  {
+    testEndMessage(false, "unable to create system");
+    return (1);
+  }
+
+  papplSystemSetPrinterDrivers(system, sizeof(pwg_drivers) / sizeof(pwg_drivers[0]), pwg_drivers, pwg_autoadd, /*create_cb*/NULL, pwg_callback, "testpappl");
+
+  if ((printer = papplPrinterCreate(system, 0, "Slab Printer", "pwg_common-300dpi-srgb_8", "MFG:PWG;MDL:Office;", "file:///dev/null")) == NULL)
+  {
+    testEndMessage(false, "unable to create printer: %s", strerror(errno));
+    papplSystemDelete(system);
+    return (1);
+  }
+
+  testEnd(true);
+
+  pass &= test_stress(printer, num_jobs);
+
+  papplSystemDelete(system);
+  rmdir(spooldir);
+
+  return (pass ? 0 : 1);
+}
+
+
+//
+// 'test_slab()' - Test allocating and freeing objects.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_slab(void)
+{
+  pappl_subscription_t	*a,		// First object
+			*b;		// Second object
+  size_t		num_used,	// Number of objects in use
+			num_allocs;	// Number of chunks allocated
+
+
+  testBegin("_papplSlabAlloc(_PAPPL_SLAB_SUBSCRIPTION)");
+
+  num_used = _papplSlabGetStats(_PAPPL_SLAB_SUBSCRIPTION, NULL);
+
+  if ((a = (pappl_subscription_t *)_papplSlabAlloc(_PAPPL_SLAB_SUBSCRIPTION)) == NULL)
+  {
+    testEndMessage(false, "unable to allocate object");
+    return (false);
+  }
+  else if (_papplSlabGetStats(_PAPPL_SLAB_SUBSCRIPTION, &num_allocs) != (num_used + 1) || num_allocs == 0)
+  {
+    testEndMessage(false, "object not counted");
+    return (false);
+  }
+
+  a->subscription_id = 42;
+
+  testEnd(true);
+
+  testBegin("_papplSlabFree(_PAPPL_SLAB_SUBSCRIPTION)");
+
+  _papplSlabFree(_PAPPL_SLAB_SUBSCRIPTION, a);
+
+  if (_papplSlabGetStats(_PAPPL_SLAB_SUBSCRIPTION, NULL) != num_used)
+  {
+    testEndMessage(false, "object still in use");
+    return (false);
+  }
+  else if ((b = (pappl_subscription_t *)_papplSlabAlloc(_PAPPL_SLAB_SUBSCRIPTION)) != a)
+  {
+    testEndMessage(false, "object not reused");
+    _papplSlabFree(_PAPPL_SLAB_SUBSCRIPTION, b);
+    return (false);
+  }
+  else if (b->subscription_id != 0)
+  {
+    testEndMessage(false, "object not cleared");
+    _papplSlabFree(_PAPPL_SLAB_SUBSCRIPTION, b);
+    return (false);
+  }
+
+  _papplSlabFree(_PAPPL_SLAB_SUBSCRIPTION, b);
+
+  testEnd(true);
+
+  return (true);
+}
+
+
+//
+// 'test_str()' - Test the string pool.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_str(void)
+{
+  const char	*a,			// First string
+		*b;			// Second string
+  char		buffer[256];		// String buffer
+  size_t	num_strings;		// Number of pooled strings
+
+
+  testBegin("_papplStrAlloc");
+
+  num_strings = _papplStrGetStats(NULL);
+
+  cupsCopyString(buffer, "test-user", sizeof(buffer));
+
+  if ((a = _papplStrAlloc("test-user")) == NULL || (b = _papplStrAlloc(buffer)) == NULL)
+  {
+    testEndMessage(false, "unable to allocate string");
+    return (false);
+  }
+  else if (a != b || strcmp(a, "test-user"))
+  {
+    testEndMessage(false, "strings not shared");
+    return (false);
+  }
+  else if (_papplStrGetStats(NULL) != (num_strings + 1))
+  {
+    testEndMessage(false, "got %u strings, expected %u", (unsigned)_papplStrGetStats(NULL), (unsigned)num_strings + 1);
+    return (false);
+  }
+
+  testEnd(true);
+
+  testBegin("_papplStrFree");
+
+  _papplStrFree(buffer);
+  _papplStrFree(a);
+
+  if (_papplStrGetStats(NULL) != (num_strings + 1))
+  {
+    testEndMessage(false, "string freed with references");
+    return (false);
+  }
+
+  _papplStrFree(b);
+
+  if (_papplStrGetStats(NULL) != num_strings)
+  {
+    testEndMessage(false, "string not freed");
+    return (false);
+  }
+
+  testEnd(true);
+
+  return (true);
+}
+
+
+//
+// 'test_stress()' - Create and clean a lot of jobs.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_stress(pappl_printer_t *printer,	// I - Printer
+            size_t          num_jobs)	// I - Number of jobs
+{
+  size_t	i;			// Looping var
+  pappl_job_t	*job;			// Current job
+  _pappl_doc_t	*doc;			// Document
+  char		username[64];		// Username
+  time_t	completed = time(NULL) - 120;
+					// Completion time
+  double	start,			// Start time
+		elapsed;		// Elapsed time
+  size_t	job_used,		// Number of jobs in use
+		job_allocs,		// Number of job chunks
+		doc_used,		// Number of documents in use
+		doc_allocs,		// Number of document chunks
+		num_strings,		// Number of pooled strings
+		str_allocs;		// Number of strings allocated
+  struct rusage	usage;			// Resource usage
+
+
+  testBegin("stress: %u jobs", (unsigned)num_jobs);
+
+  start = testGetTime();
+
+  for (i = 0; i < num_jobs; i ++)
+  {
+    snprintf(username, sizeof(username), "user%u", (unsigned)(i % NUM_USERS));
+
+    if ((job = _papplJobCreate(printer, 0, username, "Stress", NULL)) == NULL || (doc = _papplJobAddDocumentNoLock(job)) == NULL)
+    {
+      testEndMessage(false, "unable to create job %u", (unsigned)i + 1);
+      return (false);
+    }
+
+    doc->format = _papplStrAlloc("application/pdf");
+    doc->state  = IPP_DSTATE_COMPLETED;
+
+    _papplRWLockWrite(printer);
+
+    job->num_documents = 1;
+    job->state         = IPP_JSTATE_COMPLETED;
+    job->completed     = completed;
+
+    cupsArrayRemove(printer->active_jobs, job);
+    cupsArrayAdd(printer->completed_jobs, job);
+
+    if ((i % MAX_COMPLETED) == (MAX_COMPLETED - 1))
+    {
+      printer->max_completed_jobs = MAX_COMPLETED;
+      _papplPrinterCleanJobsNoLock(printer);
+      printer->max_completed_jobs = 0;
+    }
+
+    _papplRWUnlock(printer);
+  }
+
+  elapsed = testGetTime() - start;
+
+  job_used    = _papplSlabGetStats(_PAPPL_SLAB_JOB, &job_allocs);
+  doc_used    = _papplSlabGetStats(_PAPPL_SLAB_DOCUMENT, &doc_allocs);
+  num_strings = _papplStrGetStats(&str_allocs);
+
+  getrusage(RUSAGE_SELF, &usage);
+
+  if (job_used > (2 * MAX_COMPLETED) || doc_used > (2 * MAX_COMPLETED))
+  {
+    testEndMessage(false, "%u jobs and %u documents still in use", (unsigned)job_used, (unsigned)doc_used);
+    return (false);
+  }
+  else if (num_strings > (2 * NUM_USERS))
+  {
+    testEndMessage(false, "%u strings in pool", (unsigned)num_strings);
+    return (false);
+  }
+
+  testEndMessage(true, "%.3fus/job", 1000000.0 * elapsed / num_jobs);
+
+  testBegin("benchmark: %u jobs", (unsigned)num_jobs);
+#ifdef __APPLE__
+  testEndMessage(true, "%u job chunks, %u document chunks, %u strings allocated, %ldKB RSS", (unsigned)job_allocs, (unsigned)doc_allocs, (unsigned)str_allocs, (long)usage.ru_maxrss / 1024);
+#else
+  testEndMessage(true, "%u job chunks, %u document chunks, %u strings allocated, %ldKB RSS", (unsigned)job_allocs, (unsigned)doc_allocs, (unsigned)str_allocs, (long)usage.ru_maxrss);
+#endif // __APPLE__
+
+  return (true);
+}
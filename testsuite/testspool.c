@@ -0,0 +1,1063 @@
+//
+// Job spool unit tests and benchmark for the Printer Application Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ./testspool [NUMBER-OF-DOCUMENTS]
+//   ./testspool upload [SIZE-IN-MB]
+//
+
+#include <pappl/pappl-private.h>
+#include "testpappl.h"
+#include "test.h"
+
+
+//
+// Constants...
+//
+
+#define COMPRESS_SIZE	16777216	// Size of document for compression benchmark
+#define DOC_SIZE	4096		// Size of small documents
+#define MAX_SIZE	65536		// Maximum size of memory-spooled documents
+#define MAX_TOTAL	262144		// Maximum size of all memory-spooled documents
+#define NUM_DOCS	10000		// Default number of documents for benchmark
+#define NUM_JOBS	1000		// Number of jobs for clean benchmark
+#define UPLOAD_SIZE	16		// Default upload size in MB for unit tests
+#define UPLOAD_BENCH	1024		// Default upload size in MB for benchmark
+
+
+//
+// Local types...
+//
+
+typedef struct _pappl_testupload_s	// Upload test data
+{
+  int		sock;			// Sending socket
+  size_t	length;			// Number of bytes to send
+} _pappl_testupload_t;
+
+
+//
+// Local functions...
+//
+
+static void		clean_directory(const char *dirname);
+static unsigned		read_document(const char *filename, size_t *length);
+static bool		run_benchmark(pappl_printer_t *printer, size_t num_docs, double *doc_time);
+static void		*send_data(_pappl_testupload_t *upload);
+static bool		spool_document(pappl_job_t *job, size_t length);
+static bool		test_compress(pappl_printer_t *printer, size_t length);
+static bool		test_limits(pappl_printer_t *printer);
+static bool		test_reap(pappl_printer_t *printer, size_t num_jobs, bool background, double *lock_time);
+static bool		test_share(pappl_printer_t *printer);
+static bool		test_spill(pappl_printer_t *printer);
+static bool		test_upload(pappl_printer_t *printer, size_t length, bool use_spool, double *rate);
+
+
+//
+// 'main()' - Test the job spool functions.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  bool			pass = true;	// Pass or fail
+  size_t		num_docs = NUM_DOCS,
+					// Number of documents for benchmark
+			upload_mb = UPLOAD_SIZE;
+					// Upload size in MB
+  bool			upload_only = false;
+					// Only run the upload benchmark?
+  char			spooldir[1024],	// Spool directory
+			memdir[1024];	// Memory spool directory
+  pappl_system_t	*system;	// System
+  pappl_printer_t	*printer;	// Printer
+  size_t		max_total;	// Maximum total size
+  double		disk_time,	// Time per document on disk
+			memory_time,	// Time per document in memory
+			copy_rate,	// Upload rate with copy loop
+			spool_rate,	// Upload rate with spool writer
+			inline_time,	// Lock time removing jobs inline
+			reap_time;	// Lock time removing jobs in the background
+
+
+  if (argc > 1 && (num_docs = (size_t)strtol(argv[1], NULL, 10)) < 1)
+  {
+    fprintf(stderr, "Usage: %s [NUMBER-OF-DOCUMENTS]\n", argv[0]);
+    return (1);
+  }
+
+  snprintf(spooldir, sizeof(spooldir), "%s/testspool%d", papplGetTempDir(), (int)getpid());
+  snprintf(memdir, sizeof(memdir), "%s/testspool%d.mem", papplGetTempDir(), (int)getpid());
+
+  if (mkdir(memdir, 0700) && errno != EEXIST)
+  {
+    perror(memdir);
+    return (1);
+  }
+
+  // Create a system and printer...
+  testBegin("papplSystemCreate");
+  if ((system = papplSystemCreate(PAPPL_SOPTIONS_MULTI_DOCUMENT_JOBS | PAPPL_SOPTIONS_MULTI_QUEUE | PAPPL_SOPTIONS_NO_DNS_SD, "Test Spool", 0, NULL, spooldir, "-", PAPPL_LOGLEVEL_ERROR, NULL, false)) == NULL)
+  {
+    testEndMessage(false, "unable to create system");
+    return (1);
+  }
+
+  papplSystemSetPrinterDrivers(system, sizeof(pwg_drivers) / sizeof(pwg_drivers[0]), pwg_drivers, pwg_autoadd, /*create_cb*/NULL, pwg_callback, "testpappl");
+
+  if ((printer = papplPrinterCreate(system, 0, "Test Printer", "pwg_common-300dpi-srgb_8", "MFG:PWG;MDL:Office;", "file:///dev/null")) == NULL)
+  {
+    testEndMessage(false, "unable to create printer: %s", strerror(errno));
+    return (1);
+  }
+
+  testEnd(true);
+
+  // Benchmark large uploads with a simple copy loop and the spool writer...
+  pass &= test_upload(printer, upload_mb * 1048576, false, &copy_rate);
+  pass &= test_upload(printer, upload_mb * 1048576, true, &spool_rate);
+
+  testBegin("benchmark: %u MB upload", (unsigned)upload_mb);
+  testEndMessage(pass, "copy %.1fMB/s, spool %.1fMB/s", copy_rate, spool_rate);
+
+  if (upload_only)
+    goto done;
+
+  // Test the synchronization policy...
+  testBegin("papplSystemSetSpoolSync(PAPPL_SPOOL_SYNC_CLOSE)");
+  papplSystemSetSpoolSync(system, PAPPL_SPOOL_SYNC_CLOSE);
+  if (papplSystemGetSpoolSync(system) != PAPPL_SPOOL_SYNC_CLOSE)
+  {
+    testEndMessage(false, "got %d", (int)papplSystemGetSpoolSync(system));
+    pass = false;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  pass &= test_upload(printer, 1048576, true, &spool_rate);
+
+  papplSystemSetSpoolSync(system, PAPPL_SPOOL_SYNC_NONE);
+
+  // Test sharing identical documents...
+  pass &= test_share(printer);
+
+  // Test compressing the documents of completed jobs...
+  pass &= test_compress(printer, COMPRESS_SIZE);
+
+  // Benchmark removing old jobs inline and in the background...
+  pass &= test_reap(printer, NUM_JOBS, false, &inline_time);
+  pass &= test_reap(printer, NUM_JOBS, true, &reap_time);
+
+  testBegin("benchmark: clean %u jobs", NUM_JOBS);
+  testEndMessage(pass, "inline %.3fms, background %.3fms with printer locked", 1000.0 * inline_time, 1000.0 * reap_time);
+
+  // Benchmark the spool directory...
+  pass &= run_benchmark(printer, num_docs, &disk_time);
+
+  // Enable the memory spool...
+  testBegin("papplSystemSetMemorySpool(%s, %u, %u)", memdir, MAX_SIZE, MAX_TOTAL);
+  if (!papplSystemSetMemorySpool(system, memdir, MAX_SIZE, MAX_TOTAL))
+  {
+    testEndMessage(false, "unable to enable memory spool");
+    pass = false;
+  }
+  else if (papplSystemGetMemorySpool(system, &max_total) != MAX_SIZE || max_total != MAX_TOTAL)
+  {
+    testEndMessage(false, "got %u and %u", (unsigned)papplSystemGetMemorySpool(system, NULL), (unsigned)max_total);
+    pass = false;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  pass &= test_limits(printer);
+  pass &= test_spill(printer);
+
+  // Benchmark the memory spool, using "/dev/shm" when it is available...
+  if (!access("/dev/shm", W_OK))
+    papplSystemSetMemorySpool(system, "/dev/shm", MAX_SIZE, (size_t)num_docs * DOC_SIZE);
+  else
+    papplSystemSetMemorySpool(system, memdir, MAX_SIZE, (size_t)num_docs * DOC_SIZE);
+
+  pass &= run_benchmark(printer, num_docs, &memory_time);
+
+  testBegin("benchmark: %u %u byte documents", (unsigned)num_docs, DOC_SIZE);
+  testEndMessage(pass, "disk %.3fus/doc, memory %.3fus/doc", 1000000.0 * disk_time, 1000000.0 * memory_time);
+
+  // Clean up...
+  done:
+
+  papplSystemSetMemorySpool(system, NULL, 0, 0);
+  papplSystemDelete(system);
+
+  clean_directory(spooldir);
+  clean_directory(memdir);
+
+  return (pass ? 0 : 1);
+}
+
+
+//
+// 'clean_directory()' - Remove a directory and its files.
+//
+
+static void
+clean_directory(const char *dirname)	// I - Directory
+{
+  cups_dir_t	*dir;			// Directory
+  cups_dentry_t	*dent;			// Directory entry
+  char		filename[1024];		// Filename
+
+
+  if ((dir = cupsDirOpen(dirname)) != NULL)
+  {
+    while ((dent = cupsDirRead(dir)) != NULL)
+    {
+      snprintf(filename, sizeof(filename), "%s/%s", dirname, dent->filename);
+
+      if (S_ISDIR(dent->fileinfo.st_mode))
+        clean_directory(filename);
+      else
+        unlink(filename);
+    }
+
+    cupsDirClose(dir);
+  }
+
+  rmdir(dirname);
+}
+
+
+//
+// 'read_document()' - Read a document file, decompressing as needed.
+//
+
+static unsigned				// O - Checksum
+read_document(const char *filename,	// I - Document file
+              size_t     *length)	// O - Number of bytes read
+{
+  cups_file_t	*fp;			// File
+  unsigned char	buffer[65536];		// Read buffer
+  ssize_t	i,			// Looping var
+		bytes;			// Bytes read
+  unsigned	sum = 0;		// Checksum
+
+
+  *length = 0;
+
+  if ((fp = cupsFileOpen(filename, "r")) == NULL)
+    return (0);
+
+  while ((bytes = cupsFileRead(fp, (char *)buffer, sizeof(buffer))) > 0)
+  {
+    for (i = 0; i < bytes; i ++)
+      sum = sum * 31 + buffer[i];
+
+    *length += (size_t)bytes;
+  }
+
+  cupsFileClose(fp);
+
+  return (sum);
+}
+
+//
+// 'run_benchmark()' - Spool and remove a number of small documents.
+//
+
+static bool				// O - `true` on success, `false` on failure
+run_benchmark(pappl_printer_t *printer,	// I - Printer
+              size_t          num_docs,	// I - Number of documents
+              double          *doc_time)// O - Time per document
+{
+  bool		pass = true;		// Pass or fail
+  size_t	i;			// Looping var
+  pappl_job_t	*job;			// Job
+  double	start;			// Start time
+
+
+  testBegin("spool: %u %u byte documents", (unsigned)num_docs, DOC_SIZE);
+
+  *doc_time = 0.0;
+
+  if ((job = _papplJobCreate(printer, 0, "user", "Benchmark", NULL)) == NULL)
+  {
+    testEndMessage(false, "unable to create job");
+    return (false);
+  }
+
+  start = testGetTime();
+
+  for (i = 0; i < num_docs && pass; i ++)
+  {
+    // Spool the document, read it back like a filter, and remove it...
+    int		fd;			// Document file
+    char	buffer[DOC_SIZE];	// Read buffer
+
+    if (!spool_document(job, DOC_SIZE))
+    {
+      pass = false;
+      break;
+    }
+
+    if ((fd = open(job->documents[0].filename, O_RDONLY)) < 0 || read(fd, buffer, sizeof(buffer)) != DOC_SIZE)
+      pass = false;
+
+    if (fd >= 0)
+      close(fd);
+
+    _papplJobRemoveFiles(job);
+  }
+
+  *doc_time = (testGetTime() - start) / (double)num_docs;
+
+  testEndMessage(pass, "%.3fus/doc", 1000000.0 * *doc_time);
+
+  return (pass);
+}
+
+
+//
+// 'send_data()' - Send document data to a socket.
+//
+
+static void *				// O - Thread exit status (unused)
+send_data(_pappl_testupload_t *upload)	// I - Upload test data
+{
+  char		buffer[65536];		// Data buffer
+  size_t	remaining = upload->length,
+					// Bytes remaining
+		bytes;			// Bytes to send
+  ssize_t	sent;			// Bytes sent
+
+
+  memset(buffer, 'A', sizeof(buffer));
+
+  while (remaining > 0)
+  {
+    if ((bytes = remaining) > sizeof(buffer))
+      bytes = sizeof(buffer);
+
+    if ((sent = send(upload->sock, buffer, bytes, 0)) < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN)
+        continue;
+
+      break;
+    }
+
+    remaining -= (size_t)sent;
+  }
+
+  close(upload->sock);
+
+  return (NULL);
+}
+
+
+//
+// 'spool_document()' - Spool a document for a job.
+//
+
+static bool				// O - `true` on success, `false` on failure
+spool_document(pappl_job_t *job,	// I - Job
+               size_t      length)	// I - Length of document
+{
+  _pappl_spool_t	spool;		// Spool file
+  _pappl_doc_t		*doc;		// Document
+  char			buffer[4096];	// Document data
+  size_t		bytes;		// Bytes to write
+
+
+  memset(buffer, 'A', sizeof(buffer));
+
+  if (!_papplJobSpoolOpen(&spool, job, job->num_documents + 1, "text/plain", length))
+    return (false);
+
+  for (; length > 0; length -= bytes)
+  {
+    if ((bytes = length) > sizeof(buffer))
+      bytes = sizeof(buffer);
+
+    if (!_papplJobSpoolWrite(&spool, buffer, bytes))
+    {
+      _papplJobSpoolAbort(&spool);
+      return (false);
+    }
+  }
+
+  if (!_papplJobSpoolClose(&spool) || (doc = _papplJobAddDocumentNoLock(job)) == NULL)
+    return (false);
+
+  doc->filename = strdup(spool.filename);
+  doc->format   = "text/plain";
+  doc->state    = IPP_DSTATE_PENDING;
+
+  job->num_documents ++;
+
+  return (true);
+}
+
+
+//
+// 'test_compress()' - Test compressing the documents of a completed job.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_compress(pappl_printer_t *printer,	// I - Printer
+              size_t          length)	// I - Length of document
+{
+  bool		pass = true;		// Pass or fail
+  pappl_job_t	*job;			// Job
+  _pappl_spool_t spool;			// Spool file
+  _pappl_doc_t	*doc;			// Document
+  char		line[256];		// Line of text
+  size_t	total,			// Total bytes written
+		bytes,			// Bytes in line
+		raw_total,		// Bytes read from original file
+		gz_total;		// Bytes read from compressed file
+  unsigned	raw_sum,		// Checksum of original file
+		gz_sum;			// Checksum of compressed file
+  double	start,			// Start time
+		raw_time,		// Time to read original file
+		gz_time,		// Time to read compressed file
+		compress_time;		// Time to compress file
+  struct stat	fileinfo;		// Compressed file information
+
+
+  testBegin("_papplSystemCompressJob: %u MB text document", (unsigned)(length / 1048576));
+
+  if ((job = _papplJobCreate(printer, 0, "user", "Compress", NULL)) == NULL)
+  {
+    testEndMessage(false, "unable to create job");
+    return (false);
+  }
+
+  // Spool a text document...
+  if (!_papplJobSpoolOpen(&spool, job, 1, "text/plain", length))
+  {
+    testEndMessage(false, "unable to create spool file: %s", strerror(errno));
+    return (false);
+  }
+
+  for (total = 0; total < length; total += bytes)
+  {
+    snprintf(line, sizeof(line), "%08u: Invoice line item %u, quantity %u, price $%u.%02u\n", (unsigned)total, (unsigned)(total / 64) % 997, (unsigned)(total % 13), (unsigned)(total % 1000), (unsigned)(total % 100));
+
+    if ((bytes = strlen(line)) > (length - total))
+      bytes = length - total;
+
+    if (!_papplJobSpoolWrite(&spool, line, bytes))
+    {
+      _papplJobSpoolAbort(&spool);
+      testEndMessage(false, "unable to write spool file: %s", strerror(errno));
+      return (false);
+    }
+  }
+
+  if (!_papplJobSpoolClose(&spool) || (doc = _papplJobAddDocumentNoLock(job)) == NULL)
+  {
+    testEndMessage(false, "unable to close spool file: %s", strerror(errno));
+    return (false);
+  }
+
+  doc->filename = strdup(spool.filename);
+  doc->format   = "text/plain";
+  doc->state    = IPP_DSTATE_COMPLETED;
+
+  job->num_documents = 1;
+  job->state         = IPP_JSTATE_COMPLETED;
+
+  // Read the original file, compress it, and read it again...
+  start    = testGetTime();
+  raw_sum  = read_document(doc->filename, &raw_total);
+  raw_time = testGetTime() - start;
+
+  start = testGetTime();
+  if (!_papplSystemCompressJob(printer->system, printer->printer_id, job->job_id))
+  {
+    testEndMessage(false, "unable to compress document");
+    pass = false;
+  }
+  compress_time = testGetTime() - start;
+
+  start   = testGetTime();
+  gz_sum  = read_document(doc->filename, &gz_total);
+  gz_time = testGetTime() - start;
+
+  if (!pass)
+  {
+    // Already reported failure
+  }
+  else if (strlen(doc->filename) < 3 || strcmp(doc->filename + strlen(doc->filename) - 3, ".gz"))
+  {
+    testEndMessage(false, "document not compressed, filename is '%s'", doc->filename);
+    pass = false;
+  }
+  else if (stat(doc->filename, &fileinfo) || (size_t)fileinfo.st_size >= length)
+  {
+    testEndMessage(false, "compressed document is not smaller");
+    pass = false;
+  }
+  else if (raw_total != length || gz_total != length || raw_sum != gz_sum)
+  {
+    testEndMessage(false, "got %lu bytes (checksum %08x), expected %lu bytes (checksum %08x)", (unsigned long)gz_total, gz_sum, (unsigned long)raw_total, raw_sum);
+    pass = false;
+  }
+  else
+  {
+    testEndMessage(true, "%.1f:1, compress %.1fMB/s, read %.1fMB/s raw, %.1fMB/s compressed", (double)length / (double)fileinfo.st_size, (double)length / 1048576.0 / compress_time, (double)length / 1048576.0 / raw_time, (double)length / 1048576.0 / gz_time);
+  }
+
+  _papplJobRemoveFiles(job);
+
+  return (pass);
+}
+
+//
+// 'test_limits()' - Test the memory spool size limits.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_limits(pappl_printer_t *printer)	// I - Printer
+{
+  bool		pass = true;		// Pass or fail
+  pappl_system_t *system = printer->system;
+					// System
+  pappl_job_t	*job;			// Job
+  int		i;			// Looping var
+  size_t	memdirlen = strlen(system->spool_memdir);
+					// Length of memory spool directory
+
+
+  testBegin("spool: small document in memory");
+
+  if ((job = _papplJobCreate(printer, 0, "user", "Limits", NULL)) == NULL)
+  {
+    testEndMessage(false, "unable to create job");
+    return (false);
+  }
+
+  if (!spool_document(job, DOC_SIZE))
+  {
+    testEndMessage(false, "unable to spool document: %s", strerror(errno));
+    return (false);
+  }
+  else if (strncmp(job->documents[0].filename, system->spool_memdir, memdirlen))
+  {
+    testEndMessage(false, "document spooled to '%s'", job->documents[0].filename);
+    pass = false;
+  }
+  else if (system->spool_memused != DOC_SIZE)
+  {
+    testEndMessage(false, "got %u bytes in memory, expected %u", (unsigned)system->spool_memused, DOC_SIZE);
+    pass = false;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  _papplJobRemoveFiles(job);
+
+  testBegin("spool: large document on disk");
+
+  if (!spool_document(job, MAX_SIZE + 1))
+  {
+    testEndMessage(false, "unable to spool document: %s", strerror(errno));
+    return (false);
+  }
+  else if (!strncmp(job->documents[0].filename, system->spool_memdir, memdirlen))
+  {
+    testEndMessage(false, "document spooled to '%s'", job->documents[0].filename);
+    pass = false;
+  }
+  else if (system->spool_memused != 0)
+  {
+    testEndMessage(false, "got %u bytes in memory, expected 0", (unsigned)system->spool_memused);
+    pass = false;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  _papplJobRemoveFiles(job);
+
+  testBegin("spool: total memory limit");
+
+  for (i = 0; i <= (MAX_TOTAL / MAX_SIZE); i ++)
+  {
+    if (!spool_document(job, MAX_SIZE))
+    {
+      testEndMessage(false, "unable to spool document: %s", strerror(errno));
+      return (false);
+    }
+  }
+
+  if (system->spool_memused != MAX_TOTAL)
+  {
+    testEndMessage(false, "got %u bytes in memory, expected %u", (unsigned)system->spool_memused, MAX_TOTAL);
+    pass = false;
+  }
+  else if (!strncmp(job->documents[i - 1].filename, system->spool_memdir, memdirlen))
+  {
+    testEndMessage(false, "last document spooled to '%s'", job->documents[i - 1].filename);
+    pass = false;
+  }
+
+  _papplJobRemoveFiles(job);
+
+  if (pass)
+  {
+    if (system->spool_memused != 0)
+    {
+      testEndMessage(false, "got %u bytes in memory after removing files", (unsigned)system->spool_memused);
+      pass = false;
+    }
+    else
+    {
+      testEnd(true);
+    }
+  }
+
+  return (pass);
+}
+
+
+//
+// 'test_reap()' - Test removing old jobs inline or in the background.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_reap(pappl_printer_t *printer,	// I - Printer
+          size_t          num_jobs,	// I - Number of jobs
+          bool            background,	// I - Remove jobs in the background?
+          double          *lock_time)	// O - Time printer lock is held
+{
+  pappl_system_t *system = printer->system;
+					// System
+  size_t	i;			// Looping var
+  pappl_job_t	*job;			// Current job
+  int		first_id = 0;		// First job ID
+  _pappl_spool_t spool;			// Spool file
+  _pappl_doc_t	*doc;			// Document
+  char		line[DOC_SIZE],		// Document data
+		filename[1024];		// First document file
+  cups_thread_t	thread = CUPS_THREAD_INVALID;
+					// Spool thread
+  time_t	completed = time(NULL) - 120;
+					// Completion time
+  double	start;			// Start time
+
+
+  testBegin("clean: %u jobs %s", (unsigned)num_jobs, background ? "in the background" : "inline");
+
+  *lock_time = 0.0;
+  filename[0] = '\0';
+
+  // Create completed jobs with unique documents...
+  for (i = 0; i < num_jobs; i ++)
+  {
+    if ((job = _papplJobCreate(printer, 0, "user", "Reap", NULL)) == NULL)
+    {
+      testEndMessage(false, "unable to create job %u", (unsigned)i + 1);
+      return (false);
+    }
+
+    snprintf(line, sizeof(line), "Document for job %d.\n", job->job_id);
+
+    if (!_papplJobSpoolOpen(&spool, job, 1, "text/plain", strlen(line)) || !_papplJobSpoolWrite(&spool, line, strlen(line)) || !_papplJobSpoolClose(&spool) || (doc = _papplJobAddDocumentNoLock(job)) == NULL)
+    {
+      testEndMessage(false, "unable to spool document: %s", strerror(errno));
+      return (false);
+    }
+
+    doc->filename = strdup(spool.filename);
+    doc->format   = "text/plain";
+    doc->state    = IPP_DSTATE_COMPLETED;
+
+    if (!first_id)
+    {
+      first_id = job->job_id;
+      cupsCopyString(filename, doc->filename, sizeof(filename));
+    }
+
+    _papplRWLockWrite(printer);
+
+    job->num_documents = 1;
+    job->state         = IPP_JSTATE_COMPLETED;
+    job->completed     = completed;
+
+    cupsArrayRemove(printer->active_jobs, job);
+    cupsArrayAdd(printer->completed_jobs, job);
+
+    _papplRWUnlock(printer);
+  }
+
+  // Start the spool thread as needed...
+  if (background)
+  {
+    cupsMutexLock(&system->config_mutex);
+    system->spool_running = true;
+    cupsMutexUnlock(&system->config_mutex);
+
+    if ((thread = cupsThreadCreate((void *(*)(void *))_papplSystemRunSpool, system)) == CUPS_THREAD_INVALID)
+    {
+      testEndMessage(false, "unable to create spool thread: %s", strerror(errno));
+      return (false);
+    }
+  }
+
+  // Remove all but the newest job, timing how long the printer is locked...
+  _papplRWLockWrite(printer);
+
+  printer->max_completed_jobs = 1;
+
+  start = testGetTime();
+  _papplPrinterCleanJobsNoLock(printer);
+  *lock_time = testGetTime() - start;
+
+  printer->max_completed_jobs = 0;
+
+  _papplRWUnlock(printer);
+
+  // Stop the spool thread, which finishes removing the queued jobs...
+  if (background)
+  {
+    cupsMutexLock(&system->config_mutex);
+    system->spool_running = false;
+    cupsCondBroadcast(&system->spool_cond);
+    cupsMutexUnlock(&system->config_mutex);
+
+    cupsThreadWait(thread);
+  }
+
+  if (papplPrinterFindJob(printer, first_id))
+  {
+    testEndMessage(false, "job %d not removed", first_id);
+    return (false);
+  }
+  else if (!access(filename, 0))
+  {
+    testEndMessage(false, "'%s' not removed", filename);
+    return (false);
+  }
+  else if (system->spool_reap_files || system->spool_reap_jobs)
+  {
+    testEndMessage(false, "jobs still queued");
+    return (false);
+  }
+
+  testEndMessage(true, "%.3fms with printer locked", 1000.0 * *lock_time);
+
+  return (true);
+}
+
+
+//
+// 'test_share()' - Test sharing identical documents between jobs.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_share(pappl_printer_t *printer)	// I - Printer
+{
+  bool		pass = true;		// Pass or fail
+  pappl_job_t	*job1,			// First job
+		*job2;			// Second job
+  char		filename[1024];		// Shared filename
+  int		impressions = 0,	// Shared impressions
+		impcolor = 0;		// Shared color impressions
+
+
+  testBegin("spool: identical documents");
+
+  if ((job1 = _papplJobCreate(printer, 0, "user", "Share 1", NULL)) == NULL || (job2 = _papplJobCreate(printer, 0, "user", "Share 2", NULL)) == NULL)
+  {
+    testEndMessage(false, "unable to create jobs");
+    return (false);
+  }
+
+  if (!spool_document(job1, DOC_SIZE) || !spool_document(job2, DOC_SIZE) || !spool_document(job2, DOC_SIZE + 1))
+  {
+    testEndMessage(false, "unable to spool documents: %s", strerror(errno));
+    return (false);
+  }
+
+  cupsCopyString(filename, job1->documents[0].filename, sizeof(filename));
+
+  if (strcmp(filename, job2->documents[0].filename))
+  {
+    testEndMessage(false, "got '%s' and '%s'", filename, job2->documents[0].filename);
+    pass = false;
+  }
+  else if (!strcmp(filename, job2->documents[1].filename))
+  {
+    testEndMessage(false, "different document shares '%s'", filename);
+    pass = false;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  testBegin("_papplJobGet/SetSharedImpressions");
+
+  _papplJobSetSharedImpressions(job1, filename, 3, 1);
+
+  if (!_papplJobGetSharedImpressions(job2, job2->documents[0].filename, &impressions, &impcolor) || impressions != 3 || impcolor != 1)
+  {
+    testEndMessage(false, "got %d and %d", impressions, impcolor);
+    pass = false;
+  }
+  else if (_papplJobGetSharedImpressions(job2, job2->documents[1].filename, &impressions, &impcolor))
+  {
+    testEndMessage(false, "uninspected document has impressions");
+    pass = false;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  testBegin("_papplJobRemoveFiles");
+
+  _papplJobRemoveFiles(job1);
+
+  if (access(filename, 0))
+  {
+    testEndMessage(false, "shared file removed with first job");
+    pass = false;
+  }
+  else
+  {
+    _papplJobRemoveFiles(job2);
+
+    if (!access(filename, 0))
+    {
+      testEndMessage(false, "shared file not removed with last job");
+      pass = false;
+    }
+    else
+    {
+      testEnd(true);
+    }
+  }
+
+  return (pass);
+}
+
+//
+// 'test_spill()' - Test moving documents from memory to the spool directory.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_spill(pappl_printer_t *printer)	// I - Printer
+{
+  bool		pass = true;		// Pass or fail
+  pappl_system_t *system = printer->system;
+					// System
+  pappl_job_t	*job;			// Job
+  struct stat	fileinfo;		// Document file information
+
+
+  testBegin("_papplJobSpillFilesNoLock");
+
+  if ((job = _papplJobCreate(printer, 0, "user", "Spill", NULL)) == NULL)
+  {
+    testEndMessage(false, "unable to create job");
+    return (false);
+  }
+
+  if (!spool_document(job, DOC_SIZE))
+  {
+    testEndMessage(false, "unable to spool document: %s", strerror(errno));
+    return (false);
+  }
+
+  _papplRWLockWrite(job);
+  pass = _papplJobSpillFilesNoLock(job);
+  _papplRWUnlock(job);
+
+  if (!pass)
+  {
+    testEndMessage(false, "unable to move document");
+  }
+  else if (strncmp(job->documents[0].filename, system->directory, strlen(system->directory)))
+  {
+    testEndMessage(false, "document moved to '%s'", job->documents[0].filename);
+    pass = false;
+  }
+  else if (stat(job->documents[0].filename, &fileinfo) || fileinfo.st_size != DOC_SIZE)
+  {
+    testEndMessage(false, "document not copied");
+    pass = false;
+  }
+  else if (system->spool_memused != 0)
+  {
+    testEndMessage(false, "got %u bytes in memory, expected 0", (unsigned)system->spool_memused);
+    pass = false;
+  }
+  else
+  {
+    testEnd(true);
+  }
+
+  _papplJobRemoveFiles(job);
+
+  return (pass);
+}
+
+
+//
+// 'test_upload()' - Test receiving a large document from a socket.
+//
+// The data is received using a simple 8k copy loop or the spool writer, which
+// uses a large buffer and moves the data directly to the spool file when
+// possible.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_upload(pappl_printer_t *printer,	// I - Printer
+            size_t          length,	// I - Number of bytes
+            bool            use_spool,	// I - Use the spool writer?
+            double          *rate)	// O - Upload rate in MB/s
+{
+  bool			pass = true;	// Pass or fail
+  pappl_job_t		*job;		// Job
+  int			fds[2];		// Socket pair
+  cups_thread_t		tid;		// Sending thread
+  _pappl_testupload_t	upload;		// Upload test data
+  _pappl_spool_t	spool;		// Spool file
+  int			fd = -1;	// Copy file
+  char			filename[1024],	// Document filename
+			buffer[8192];	// Copy buffer
+  ssize_t		bytes;		// Bytes received
+  size_t		total = 0;	// Total bytes received
+  double		start,		// Start time
+			elapsed;	// Elapsed time
+  struct stat		fileinfo;	// Document file information
+
+
+  testBegin("upload: %u MB with %s", (unsigned)(length / 1048576), use_spool ? "_papplJobSpoolRecv" : "recv+write");
+
+  *rate = 0.0;
+
+  if ((job = _papplJobCreate(printer, 0, "user", "Upload", NULL)) == NULL)
+  {
+    testEndMessage(false, "unable to create job");
+    return (false);
+  }
+
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds))
+  {
+    testEndMessage(false, "unable to create sockets: %s", strerror(errno));
+    return (false);
+  }
+
+  if (use_spool)
+  {
+    if (!_papplJobSpoolOpen(&spool, job, 0, "text/plain", length))
+    {
+      testEndMessage(false, "unable to create spool file: %s", strerror(errno));
+      pass = false;
+    }
+  }
+  else if ((fd = papplJobOpenFile(job, 0, filename, sizeof(filename), printer->system->directory, /*ext*/NULL, "text/plain", "w")) < 0)
+  {
+    testEndMessage(false, "unable to create file: %s", strerror(errno));
+    pass = false;
+  }
+
+  if (!pass)
+  {
+    close(fds[0]);
+    close(fds[1]);
+    return (false);
+  }
+
+  upload.sock   = fds[1];
+  upload.length = length;
+
+  start = testGetTime();
+
+  if ((tid = cupsThreadCreate((cups_thread_func_t)send_data, &upload)) == CUPS_THREAD_INVALID)
+  {
+    testEndMessage(false, "unable to create thread: %s", strerror(errno));
+    close(fds[0]);
+    close(fds[1]);
+    return (false);
+  }
+
+  if (use_spool)
+  {
+    while ((bytes = _papplJobSpoolRecv(&spool, fds[0], _PAPPL_SPOOL_BUFSIZE)) > 0)
+      total += (size_t)bytes;
+
+    if (bytes < 0)
+      _papplJobSpoolAbort(&spool);
+    else if (!_papplJobSpoolClose(&spool))
+      bytes = -1;
+
+    cupsCopyString(filename, spool.filename, sizeof(filename));
+  }
+  else
+  {
+    while ((bytes = recv(fds[0], buffer, sizeof(buffer), 0)) > 0)
+    {
+      if (write(fd, buffer, (size_t)bytes) != bytes)
+      {
+        bytes = -1;
+        break;
+      }
+
+      total += (size_t)bytes;
+    }
+
+    if (close(fd))
+      bytes = -1;
+  }
+
+  elapsed = testGetTime() - start;
+
+  cupsThreadWait(tid);
+  close(fds[0]);
+
+  if (bytes < 0)
+  {
+    testEndMessage(false, "unable to receive data: %s", strerror(errno));
+    pass = false;
+  }
+  else if (total != length)
+  {
+    testEndMessage(false, "got %lu bytes, expected %lu", (unsigned long)total, (unsigned long)length);
+    pass = false;
+  }
+  else if (stat(filename, &fileinfo) || (size_t)fileinfo.st_size != length)
+  {
+    testEndMessage(false, "document file is %ld bytes, expected %lu", (long)fileinfo.st_size, (unsigned long)length);
+    pass = false;
+  }
+  else
+  {
+    if (elapsed > 0.0)
+      *rate = (double)length / 1048576.0 / elapsed;
+
+    testEndMessage(true, "%.1fMB/s", *rate);
+  }
+
+  if (!_papplJobReleaseSharedFile(job, filename))
+    unlink(filename);
+
+  return (pass);
+}
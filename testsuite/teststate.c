@@ -0,0 +1,367 @@
+//
+// System state unit tests and benchmark for the Printer Application Framework
+//
+// Copyright © 2026 by Michael R Sweet.
+//
+// Licensed under Apache License v2.0.  See the file "LICENSE" for more
+// information.
+//
+// Usage:
+//
+//   ./teststate [NUMBER-OF-JOBS]
+//
+
+#include <pappl/pappl-private.h>
+#include "testpappl.h"
+#include "test.h"
+
+
+//
+// Constants...
+//
+
+#define DOCUMENT	"portrait-color-letter.pdf"
+					// Document file (not in the spool directory)
+#define NUM_JOBS	20000		// Default number of jobs for benchmark
+#define NUM_PRINTERS	10		// Number of printers
+
+
+//
+// Local functions...
+//
+
+static pappl_system_t	*create_system(const char *spooldir);
+static bool		test_evict(pappl_printer_t *printer);
+static bool		test_load(const char *spooldir, const char *filename, size_t num_jobs, double *load_time);
+static bool		test_save(pappl_system_t *system, const char *filename, bool binary);
+
+
+//
+// 'main()' - Test loading and saving the system state.
+//
+
+int					// O - Exit status
+main(int  argc,				// I - Number of command-line arguments
+     char *argv[])			// I - Command-line arguments
+{
+  bool			pass = true;	// Pass or fail
+  size_t		i,		// Looping var
+			num_jobs = NUM_JOBS;
+					// Number of jobs for benchmark
+  char			spooldir[1024],	// Spool directory
+			textfile[1024],	// Text state file
+			binfile[1024],	// Binary state file
+			name[256];	// Job name
+  pappl_system_t	*system;	// System
+  pappl_printer_t	*printers[NUM_PRINTERS];
+					// Printers
+  pappl_job_t		*job;		// Current job
+  _pappl_doc_t		*doc;		// Current document
+  time_t		curtime;	// Current time
+  cups_dir_t		*dir;		// Spool directory
+  cups_dentry_t		*dent;		// Spool directory entry
+  double		text_time,	// Time to load text state
+			binary_time;	// Time to load binary state
+
+
+  if (argc > 1 && (num_jobs = (size_t)strtol(argv[1], NULL, 10)) < 1)
+  {
+    fprintf(stderr, "Usage: %s [NUMBER-OF-JOBS]\n", argv[0]);
+    return (1);
+  }
+
+  snprintf(spooldir, sizeof(spooldir), "%s/teststate%d", papplGetTempDir(), (int)getpid());
+  snprintf(textfile, sizeof(textfile), "%s/state.txt", spooldir);
+  snprintf(binfile, sizeof(binfile), "%s/state.bin", spooldir);
+
+  // Create a system with a long job history...
+  testBegin("create: %u printers, %u jobs", NUM_PRINTERS, (unsigned)num_jobs);
+
+  if ((system = create_system(spooldir)) == NULL)
+  {
+    testEndMessage(false, "unable to create system");
+    return (1);
+  }
+
+  for (i = 0; i < NUM_PRINTERS; i ++)
+  {
+    char	pname[64];		// Printer name
+
+    snprintf(pname, sizeof(pname), "Printer %u", (unsigned)i + 1);
+
+    if ((printers[i] = papplPrinterCreate(system, 0, pname, "pwg_common-300dpi-srgb_8", "MFG:PWG;MDL:Office;", "file:///dev/null")) == NULL)
+    {
+      testEndMessage(false, "unable to create printer: %s", strerror(errno));
+      return (1);
+    }
+
+    papplPrinterSetMaxCompletedJobs(printers[i], 0);
+  }
+
+  curtime = time(NULL) - (time_t)num_jobs;
+
+  for (i = 0; i < num_jobs; i ++)
+  {
+    snprintf(name, sizeof(name), "Job %u", (unsigned)i + 1);
+
+    if ((job = _papplJobCreate(printers[i % NUM_PRINTERS], (int)(i / NUM_PRINTERS) + 1, "user", name, NULL)) == NULL || (doc = _papplJobAddDocumentNoLock(job)) == NULL)
+    {
+      testEndMessage(false, "unable to create job %u", (unsigned)i + 1);
+      return (1);
+    }
+
+    doc->filename  = strdup(DOCUMENT);
+    doc->format    = "application/pdf";
+    doc->state     = IPP_DSTATE_COMPLETED;
+    doc->created   = curtime + (time_t)i;
+    doc->completed = curtime + (time_t)i;
+    doc->attrs     = ippNew();
+
+    ippAddString(doc->attrs, IPP_TAG_DOCUMENT, IPP_TAG_NAME, "document-name", NULL, name);
+    ippAddString(doc->attrs, IPP_TAG_DOCUMENT, IPP_TAG_MIMETYPE, "document-format", NULL, doc->format);
+
+    job->num_documents = 1;
+    job->state         = IPP_JSTATE_COMPLETED;
+    job->created       = curtime + (time_t)i;
+    job->completed     = curtime + (time_t)i;
+    job->impressions   = 1;
+    job->impcompleted  = 1;
+
+    cupsArrayAdd(job->printer->completed_jobs, job);
+  }
+
+  testEnd(true);
+
+  // Save the attributes of older jobs to the spool directory...
+  pass &= test_evict(printers[0]);
+
+  // Save and load the text and binary state files.  The original system is
+  // deleted last since deleting a system removes the document attribute files
+  // of completed jobs...
+  pass &= test_save(system, textfile, false);
+  pass &= test_save(system, binfile, true);
+  pass &= test_load(spooldir, textfile, num_jobs, &text_time);
+  pass &= test_load(spooldir, binfile, num_jobs, &binary_time);
+
+  papplSystemDelete(system);
+
+  testBegin("benchmark: %u jobs", (unsigned)num_jobs);
+  testEndMessage(pass, "text %.3fus/job, binary %.3fus/job", 1000000.0 * text_time / num_jobs, 1000000.0 * binary_time / num_jobs);
+
+  // Clean up...
+  if ((dir = cupsDirOpen(spooldir)) != NULL)
+  {
+    while ((dent = cupsDirRead(dir)) != NULL)
+    {
+      snprintf(name, sizeof(name), "%s/%s", spooldir, dent->filename);
+      unlink(name);
+    }
+
+    cupsDirClose(dir);
+  }
+
+  rmdir(spooldir);
+
+  return (pass ? 0 : 1);
+}
+
+
+//
+// 'create_system()' - Create a system object.
+//
+
+static pappl_system_t *			// O - System
+create_system(const char *spooldir)	// I - Spool directory
+{
+  pappl_system_t	*system;	// System
+
+
+  if ((system = papplSystemCreate(PAPPL_SOPTIONS_MULTI_QUEUE | PAPPL_SOPTIONS_NO_DNS_SD, "Test State", 0, NULL, spooldir, "-", PAPPL_LOGLEVEL_ERROR, NULL, false)) != NULL)
+    papplSystemSetPrinterDrivers(system, sizeof(pwg_drivers) / sizeof(pwg_drivers[0]), pwg_drivers, pwg_autoadd, /*create_cb*/NULL, pwg_callback, "testpappl");
+
+  return (system);
+}
+
+
+//
+// 'test_evict()' - Save the attributes of older jobs and load them again.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_evict(pappl_printer_t *printer)	// I - Printer
+{
+  pappl_job_t	*job;			// Current job
+  size_t	count = 0,		// Number of jobs
+		evicted = 0;		// Number of evicted jobs
+  const char	*name;			// Document name
+
+
+  testBegin("papplPrinterSetMaxResidentJobs(10)");
+
+  papplPrinterSetMaxResidentJobs(printer, 10);
+
+  _papplRWLockWrite(printer);
+
+  _papplPrinterCleanJobsNoLock(printer);
+
+  for (job = (pappl_job_t *)cupsArrayGetFirst(printer->completed_jobs); job; job = (pappl_job_t *)cupsArrayGetNext(printer->completed_jobs), count ++)
+  {
+    if (!job->is_evicted)
+      continue;
+
+    evicted ++;
+
+    if (count < 10 || job->attrs || job->documents[0].attrs)
+    {
+      _papplRWUnlock(printer);
+      testEndMessage(false, "job %d should not be evicted", job->job_id);
+      return (false);
+    }
+  }
+
+  _papplRWUnlock(printer);
+
+  if ((job = papplPrinterFindJob(printer, 1)) == NULL)
+  {
+    testEndMessage(false, "unable to find job 1");
+    return (false);
+  }
+  else if (job->is_evicted != (evicted > 0))
+  {
+    testEndMessage(false, "job 1 should %sbe evicted", evicted ? "" : "not ");
+    return (false);
+  }
+  else if (!papplJobGetAttribute(job, "job-uuid"))
+  {
+    testEndMessage(false, "unable to load job attributes");
+    return (false);
+  }
+  else if ((name = papplJobGetDocumentName(job, 1)) == NULL || strcmp(name, "Job 1"))
+  {
+    testEndMessage(false, "got document name '%s', expected 'Job 1'", name ? name : "(null)");
+    return (false);
+  }
+  else if (job->is_evicted || strcmp(papplJobGetName(job), "Job 1"))
+  {
+    testEndMessage(false, "job 1 not loaded");
+    return (false);
+  }
+
+  testEndMessage(true, "%u of %u jobs evicted", (unsigned)evicted, (unsigned)count);
+
+  papplPrinterSetMaxResidentJobs(printer, 0);
+
+  return (true);
+}
+
+
+//
+// 'test_load()' - Load a state file and verify the job history.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_load(const char *spooldir,		// I - Spool directory
+          const char *filename,		// I - State file
+          size_t     num_jobs,		// I - Expected number of jobs
+          double     *load_time)	// O - Time to load
+{
+  bool			pass = true;	// Pass or fail
+  pappl_system_t	*system;	// System
+  pappl_printer_t	*printer;	// Printer
+  pappl_job_t		*job;		// Job
+  size_t		count = 0;	// Number of jobs
+  int			i;		// Looping var
+  double		start;		// Start time
+  const char		*name;		// Document name
+
+
+  testBegin("papplSystemLoadState(%s)", filename);
+
+  *load_time = 0.0;
+
+  if ((system = create_system(spooldir)) == NULL)
+  {
+    testEndMessage(false, "unable to create system");
+    return (false);
+  }
+
+  start = testGetTime();
+
+  if (!papplSystemLoadState(system, filename))
+  {
+    testEndMessage(false, "unable to load state");
+    papplSystemDelete(system);
+    return (false);
+  }
+
+  *load_time = testGetTime() - start;
+
+  for (i = 1; i <= NUM_PRINTERS; i ++)
+  {
+    if ((printer = papplSystemFindPrinter(system, NULL, i, NULL)) != NULL)
+      count += (size_t)cupsArrayGetCount(printer->all_jobs);
+  }
+
+  if (count != num_jobs)
+  {
+    testEndMessage(false, "got %u jobs, expected %u", (unsigned)count, (unsigned)num_jobs);
+    pass = false;
+  }
+  else if ((printer = papplSystemFindPrinter(system, NULL, 1, NULL)) == NULL || (job = papplPrinterFindJob(printer, 1)) == NULL)
+  {
+    testEndMessage(false, "unable to find job 1");
+    pass = false;
+  }
+  else if ((name = papplJobGetDocumentName(job, 1)) == NULL || strcmp(name, "Job 1"))
+  {
+    testEndMessage(false, "got document name '%s', expected 'Job 1'", name ? name : "(null)");
+    pass = false;
+  }
+  else if (papplJobGetState(job) != IPP_JSTATE_COMPLETED || papplJobGetImpressionsCompleted(job) != 1)
+  {
+    testEndMessage(false, "bad job state or impressions");
+    pass = false;
+  }
+  else
+  {
+    testEndMessage(true, "%.3fs", *load_time);
+  }
+
+  papplSystemDelete(system);
+
+  return (pass);
+}
+
+
+//
+// 'test_save()' - Save a text or binary state file.
+//
+
+static bool				// O - `true` on success, `false` on failure
+test_save(pappl_system_t *system,	// I - System
+          const char     *filename,	// I - State file
+          bool           binary)	// I - Save a binary state file?
+{
+  double	start;			// Start time
+  struct stat	fileinfo;		// State file information
+
+
+  testBegin("papplSystemSaveState(%s)", filename);
+
+  if (binary)
+    system->options |= PAPPL_SOPTIONS_BINARY_STATE;
+  else
+    system->options &= (pappl_soptions_t)~PAPPL_SOPTIONS_BINARY_STATE;
+
+  start = testGetTime();
+
+  if (!papplSystemSaveState(system, filename) || stat(filename, &fileinfo))
+  {
+    testEnd(false);
+    return (false);
+  }
+
+  testEndMessage(true, "%.3fs, %ld bytes", testGetTime() - start, (long)fileinfo.st_size);
+
+  return (true);
+}